@@ -31,6 +31,9 @@
 
 
 BDEVINFO gaRedBdevInfo[REDCONF_VOLUME_COUNT];
+#if REDCONF_BDEV_STATS == 1
+BDEVSTATS gaRedBdevStats[REDCONF_VOLUME_COUNT];
+#endif
 
 
 /** @brief Initialize a block device.
@@ -229,6 +232,11 @@ REDSTATUS RedBDevRead(
     }
     else
     {
+      #if REDCONF_BDEV_STATS == 1
+        gaRedBdevStats[bVolNum].ullReads++;
+        gaRedBdevStats[bVolNum].ullSectorsRead += ulSectorCount;
+      #endif
+
         ret = RedOsBDevRead(bVolNum, ullSectorStart, ulSectorCount, pBuffer);
     }
 
@@ -272,6 +280,11 @@ REDSTATUS RedBDevWrite(
     }
     else
     {
+      #if REDCONF_BDEV_STATS == 1
+        gaRedBdevStats[bVolNum].ullWrites++;
+        gaRedBdevStats[bVolNum].ullSectorsWritten += ulSectorCount;
+      #endif
+
         ret = RedOsBDevWrite(bVolNum, ullSectorStart, ulSectorCount, pBuffer);
     }
 
@@ -311,9 +324,76 @@ REDSTATUS RedBDevFlush(
     }
     else
     {
+      #if REDCONF_BDEV_STATS == 1
+        gaRedBdevStats[bVolNum].ullFlushes++;
+      #endif
+
         ret = RedOsBDevFlush(bVolNum);
     }
 
     return ret;
 }
+
+
+/** @brief Write sectors to a physical block device with Force Unit Access.
+
+    Unlike RedBDevWrite(), the sectors must be committed to permanent storage by
+    the time this function returns, as if RedBDevFlush() had been called after
+    writing them.  Unlike RedBDevFlush(), sectors written previously need not be
+    committed.
+
+    The behavior of calling this function is undefined if the block device is
+    closed or if it was opened with ::BDEV_O_RDONLY.
+
+    @param bVolNum          The volume number of the volume whose block device
+                            is being written to.
+    @param ullSectorStart   The starting sector number.
+    @param ulSectorCount    The number of sectors to write.
+    @param pBuffer          The buffer from which to write the sector data.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0               Operation was successful.
+    @retval -RED_EINVAL     @p bVolNum is an invalid volume number, @p pBuffer
+                            is `NULL`, or @p ullStartSector and/or
+                            @p ulSectorCount refer to an invalid range of
+                            sectors.
+    @retval -RED_EIO        A disk I/O error occurred.
+    @retval -RED_ENOTSUPP   The block device does not support FUA writes.
+                            Nothing was written.
+*/
+REDSTATUS RedBDevWriteFua(
+    uint8_t     bVolNum,
+    uint64_t    ullSectorStart,
+    uint32_t    ulSectorCount,
+    const void *pBuffer)
+{
+    REDSTATUS   ret;
+
+    if(    (bVolNum >= REDCONF_VOLUME_COUNT)
+        || !VOLUME_SECTOR_RANGE_IS_VALID(bVolNum, ullSectorStart, ulSectorCount)
+        || (pBuffer == NULL))
+    {
+        ret = -RED_EINVAL;
+    }
+    else
+    {
+      #if REDOSCONF_BDEV_WRITE_FUA == 1
+        ret = RedOsBDevWriteFua(bVolNum, ullSectorStart, ulSectorCount, pBuffer);
+
+      #if REDCONF_BDEV_STATS == 1
+        if(ret != -RED_ENOTSUPP)
+        {
+            gaRedBdevStats[bVolNum].ullWrites++;
+            gaRedBdevStats[bVolNum].ullSectorsWritten += ulSectorCount;
+            gaRedBdevStats[bVolNum].ullFuaWrites++;
+        }
+      #endif
+      #else
+        ret = -RED_ENOTSUPP;
+      #endif
+    }
+
+    return ret;
+}
 #endif /* REDCONF_READ_ONLY == 0 */
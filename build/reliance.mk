@@ -55,6 +55,7 @@ REDDRIVOBJ=\
 	$(P_BASEDIR)/os/$(P_OS)/services/osassert.$(B_OBJEXT) \
 	$(P_BASEDIR)/os/$(P_OS)/services/osbdev.$(B_OBJEXT) \
 	$(P_BASEDIR)/os/$(P_OS)/services/osclock.$(B_OBJEXT) \
+	$(P_BASEDIR)/os/$(P_OS)/services/osmemory.$(B_OBJEXT) \
 	$(P_BASEDIR)/os/$(P_OS)/services/osmutex.$(B_OBJEXT) \
 	$(P_BASEDIR)/os/$(P_OS)/services/osoutput.$(B_OBJEXT) \
 	$(P_BASEDIR)/os/$(P_OS)/services/ostask.$(B_OBJEXT) \
@@ -88,6 +89,7 @@ REDTESTOBJ=\
 	$(P_BASEDIR)/tests/util/printf.$(B_OBJEXT) \
 	$(P_BASEDIR)/tests/util/rand.$(B_OBJEXT)
 REDTESTOBJ += \
+	$(P_BASEDIR)/tests/posix/fsperf.$(B_OBJEXT) \
 	$(P_BASEDIR)/tests/posix/fsstress.$(B_OBJEXT)
 
 # The "sort" function is being used only for its side-effect of removing
@@ -158,6 +160,7 @@ $(P_BASEDIR)/fse/fse.$(B_OBJEXT):				$(P_BASEDIR)/fse/fse.c $(REDHDR)
 $(P_BASEDIR)/os/$(P_OS)/services/osassert.$(B_OBJEXT):		$(P_BASEDIR)/os/$(P_OS)/services/osassert.c $(REDHDR)
 $(P_BASEDIR)/os/$(P_OS)/services/osbdev.$(B_OBJEXT):		$(P_BASEDIR)/os/$(P_OS)/services/osbdev.c $(REDHDR)
 $(P_BASEDIR)/os/$(P_OS)/services/osclock.$(B_OBJEXT):		$(P_BASEDIR)/os/$(P_OS)/services/osclock.c $(REDHDR)
+$(P_BASEDIR)/os/$(P_OS)/services/osmemory.$(B_OBJEXT):		$(P_BASEDIR)/os/$(P_OS)/services/osmemory.c $(REDHDR)
 $(P_BASEDIR)/os/$(P_OS)/services/osmutex.$(B_OBJEXT):		$(P_BASEDIR)/os/$(P_OS)/services/osmutex.c $(REDHDR)
 $(P_BASEDIR)/os/$(P_OS)/services/osoutput.$(B_OBJEXT):		$(P_BASEDIR)/os/$(P_OS)/services/osoutput.c $(REDHDR)
 $(P_BASEDIR)/os/$(P_OS)/services/ostask.$(B_OBJEXT):		$(P_BASEDIR)/os/$(P_OS)/services/ostask.c $(REDHDR)
@@ -165,6 +168,7 @@ $(P_BASEDIR)/os/$(P_OS)/services/ostimestamp.$(B_OBJEXT):	$(P_BASEDIR)/os/$(P_OS
 $(P_BASEDIR)/os/$(P_OS)/services/osuidgid.$(B_OBJEXT):		$(P_BASEDIR)/os/$(P_OS)/services/osuidgid.c $(REDHDR)
 $(P_BASEDIR)/posix/path.$(B_OBJEXT):				$(P_BASEDIR)/posix/path.c $(REDHDR) $(P_BASEDIR)/include/redpath.h
 $(P_BASEDIR)/posix/posix.$(B_OBJEXT):				$(P_BASEDIR)/posix/posix.c $(REDHDR) $(P_BASEDIR)/include/redpath.h
+$(P_BASEDIR)/tests/posix/fsperf.$(B_OBJEXT):			$(P_BASEDIR)/tests/posix/fsperf.c $(REDHDR)
 $(P_BASEDIR)/tests/posix/fsstress.$(B_OBJEXT):			$(P_BASEDIR)/tests/posix/fsstress.c $(REDHDR) $(P_BASEDIR)/tests/posix/redposixcompat.h
 $(P_BASEDIR)/tests/posix/fmtopt.$(B_OBJEXT):			$(P_BASEDIR)/tests/posix/fmtopt.c $(REDHDR)
 $(P_BASEDIR)/tests/util/atoi.$(B_OBJEXT):			$(P_BASEDIR)/tests/util/atoi.c $(REDHDR)
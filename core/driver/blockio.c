@@ -195,4 +195,77 @@ REDSTATUS RedIoFlush(
 
     return ret;
 }
+
+
+/** @brief Write a range of logical blocks, committing them to permanent
+           storage before returning.
+
+    Only the blocks being written are committed: blocks written earlier may
+    still be in a cache beneath the file system.  If the block device supports
+    Force Unit Access writes, one is used; otherwise, the blocks are written and
+    then the block device is flushed.
+
+    @param bVolNum      The volume whose block device is being written to.
+    @param ulBlockStart The first block to write.
+    @param ulBlockCount The number of blocks to write.
+    @param pBuffer      The buffer containing the data to write.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EIO    A disk I/O error occurred.
+    @retval -RED_EINVAL Invalid parameters.
+*/
+REDSTATUS RedIoWriteFua(
+    uint8_t     bVolNum,
+    uint32_t    ulBlockStart,
+    uint32_t    ulBlockCount,
+    const void *pBuffer)
+{
+    REDSTATUS   ret = 0;
+
+    if(    (bVolNum >= REDCONF_VOLUME_COUNT)
+        || (ulBlockStart >= gaRedVolume[bVolNum].ulBlockCount)
+        || ((gaRedVolume[bVolNum].ulBlockCount - ulBlockStart) < ulBlockCount)
+        || (ulBlockCount == 0U)
+        || (pBuffer == NULL))
+    {
+        REDERROR();
+        ret = -RED_EINVAL;
+    }
+    else
+    {
+        uint8_t  bSectorShift = gaRedVolume[bVolNum].bBlockSectorShift;
+        uint64_t ullSectorStart = ((uint64_t)ulBlockStart << bSectorShift) + gaRedVolConf[bVolNum].ullSectorOffset;
+        uint32_t ulSectorCount = ulBlockCount << bSectorShift;
+        uint8_t  bRetryIdx;
+
+        REDASSERT(bSectorShift < 32U);
+        REDASSERT((ulSectorCount >> bSectorShift) == ulBlockCount);
+
+        for(bRetryIdx = 0U; bRetryIdx <= gaRedVolConf[bVolNum].bBlockIoRetries; bRetryIdx++)
+        {
+            ret = RedBDevWriteFua(bVolNum, ullSectorStart, ulSectorCount, pBuffer);
+
+            if((ret == 0) || (ret == -RED_ENOTSUPP))
+            {
+                break;
+            }
+        }
+
+        if(ret == -RED_ENOTSUPP)
+        {
+            ret = RedIoWrite(bVolNum, ulBlockStart, ulBlockCount, pBuffer);
+
+            if(ret == 0)
+            {
+                ret = RedIoFlush(bVolNum);
+            }
+        }
+    }
+
+    CRITICAL_ASSERT(ret == 0);
+
+    return ret;
+}
 #endif /* REDCONF_READ_ONLY == 0 */
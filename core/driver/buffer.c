@@ -39,14 +39,52 @@
 #if BUFFER_MODULE == BM_SIMPLE
 
 
-#if REDCONF_BUFFER_COUNT > 255U
-#error "REDCONF_BUFFER_COUNT cannot be greater than 255"
+/*  Buffer indices are stored as uint16_t, with UINT16_MAX reserved to mean "no
+    buffer".
+*/
+#define BUFFER_COUNT_MAX 65534U
+
+#if REDCONF_BUFFER_COUNT > BUFFER_COUNT_MAX
+#error "REDCONF_BUFFER_COUNT cannot be greater than 65534"
+#endif
+
+/*  When the OS services can allocate memory, the block buffers and the arrays
+    indexed by buffer are allocated at run time, and the number of buffers can
+    change; REDCONF_BUFFER_COUNT is only the initial number of buffers.
+    Otherwise, everything is statically sized by REDCONF_BUFFER_COUNT.
+*/
+#if REDOSCONF_BUFFER_ALLOC == 1
+  #define BUFFER_COUNT (gBufCtx.uBufferCount)
+#else
+  #define BUFFER_COUNT REDCONF_BUFFER_COUNT
 #endif
 
-/*  This implementation does not support the write-gather buffer.
+/*  The write-gather buffer, if enabled, is an array of whole blocks which
+    follows the block buffers in the heap.  Gathering only helps if at least two
+    blocks can be gathered.
 */
 #if REDCONF_BUFFER_WRITE_GATHER_SIZE_KB != 0U
-  #error "Configuration error: REDCONF_BUFFER_WRITE_GATHER_SIZE_KB must be zero"
+  #define WG_BLOCKS ((REDCONF_BUFFER_WRITE_GATHER_SIZE_KB * 1024U) / REDCONF_BLOCK_SIZE)
+  #if (WG_BLOCKS * REDCONF_BLOCK_SIZE) != (REDCONF_BUFFER_WRITE_GATHER_SIZE_KB * 1024U)
+    #error "Configuration error: REDCONF_BUFFER_WRITE_GATHER_SIZE_KB must be a multiple of the block size"
+  #endif
+  #if WG_BLOCKS < 2U
+    #error "Configuration error: REDCONF_BUFFER_WRITE_GATHER_SIZE_KB must be at least two blocks"
+  #endif
+#else
+  #define WG_BLOCKS 0U
+#endif
+
+/*  The read-ahead buffer, if enabled, follows the write-gather buffer.  Its
+    size in blocks is range checked in redconfigchk.h.
+*/
+#define RA_BLOCKS REDCONF_READ_AHEAD_BLOCKS
+
+/*  Offsets into the block buffer heap are computed with 32-bit arithmetic.  For
+    buffers allocated at run time, this is checked when they are allocated.
+*/
+#if ((REDCONF_BUFFER_COUNT + WG_BLOCKS + RA_BLOCKS) * REDCONF_BLOCK_SIZE) > 0x7FFFFFFFU
+#error "Configuration error: REDCONF_BUFFER_COUNT * REDCONF_BLOCK_SIZE must be less than 2 GB"
 #endif
 
 
@@ -54,6 +92,108 @@
 */
 #define BIDX2BUF(idx) (&gBufCtx.pbBlkBuf[(uint32_t)(idx) << BLOCK_SIZE_P2])
 
+#if REDCONF_BUFFER_WRITE_GATHER_SIZE_KB != 0U
+/** @brief Pointer to the write-gather buffer, which follows the block buffers.
+*/
+#define WGBUF (BIDX2BUF(BUFFER_COUNT))
+
+/** @brief Whether a buffer can be written out by the write-gather buffer.
+
+    Only dirty file data buffers are gathered: metadata buffers must be
+    finalized before they are written.  Referenced buffers are not gathered,
+    since their owner may still be modifying them.
+*/
+#define BUFFER_IS_GATHERABLE(idx) \
+    (    (gBufCtx.aHead[idx].bRefCount == 0U) \
+      && ((gBufCtx.aHead[idx].uFlags & (BFLAG_DIRTY | BFLAG_META)) == BFLAG_DIRTY))
+#endif
+
+#if REDCONF_READ_AHEAD_BLOCKS > 0U
+/** @brief Pointer to the read-ahead buffer, which follows the write-gather
+           buffer (if any).
+*/
+#define RABUF (BIDX2BUF(BUFFER_COUNT + WG_BLOCKS))
+
+/** @brief Bitmap with the low @p cnt bits set.
+*/
+#define RA_MASK(cnt) (((cnt) >= 32U) ? UINT32_MAX : ((1U << (cnt)) - 1U))
+#endif
+
+/** @brief The maximum number of unreferenced buffers, starting from the LRU
+           buffer, which are examined to find a clean buffer to repurpose.
+
+    Repurposing a dirty buffer means writing it out first, which delays the
+    caller, so a clean buffer is preferred even if it was used more recently.
+    The search is limited so that repurposing a buffer does not take time
+    proportional to the buffer count when most of the buffers are dirty.
+*/
+#define CLEAN_SCAN_MAX 16U
+
+/*  Lists of unreferenced buffers.  With the segmented LRU policy, metadata
+    buffers have a list of their own, the protected segment, so that streaming
+    through file data does not evict the metadata which most operations need.
+*/
+#define BLIST_GENERAL   0U
+#if BUFFER_POLICY == BP_SLRU
+  #define BLIST_PROTECTED 1U
+  #define BLIST_COUNT     2U
+#else
+  #define BLIST_COUNT     1U
+#endif
+
+#if BUFFER_POLICY == BP_SLRU
+/** @brief Whether a buffer belongs in the protected segment when unreferenced.
+
+    Directory data is excluded: a large directory scan should not evict the
+    inodes and other metadata nodes.
+*/
+#define BUFFER_IS_PROTECTED(idx) \
+    (    ((gBufCtx.aHead[idx].uFlags & BFLAG_META) != 0U) \
+      && ((gBufCtx.aHead[idx].uFlags & BFLAG_META_MASK) != BFLAG_META_DIRECTORY) \
+      && (gBufCtx.aHead[idx].ulBlock != BBLK_INVALID))
+
+/** @brief The list which an unreferenced buffer is in.
+*/
+#define BUFFER_LIST(idx) (gBufCtx.aHead[idx].bList)
+#else
+#define BUFFER_LIST(idx) BLIST_GENERAL
+#endif
+
+#if REDCONF_VOLUME_COUNT > 1U
+/** @brief Whether a buffer is held in reserve for a volume other than the
+           active volume.
+
+    A buffer is in reserve if its volume has no more buffers than its
+    VOLCONF::uBufferReserve, in which case repurposing it for the active volume
+    would shrink that volume below its reservation.
+*/
+#define BUFFER_IS_RESERVED(idx) \
+    (    (gBufCtx.aHead[idx].ulBlock != BBLK_INVALID) \
+      && (gBufCtx.aHead[idx].bVolNum != gbRedVolNum) \
+      && (gBufCtx.auVolBuffers[gBufCtx.aHead[idx].bVolNum] <= gaRedVolConf[gBufCtx.aHead[idx].bVolNum].uBufferReserve))
+#endif
+
+/** @brief An invalid buffer index.  Used to terminate the hash chains.
+*/
+#define BIDX_INVALID UINT16_MAX
+
+/** @brief Number of buckets in the buffer hash table.
+
+    With one bucket per buffer, the average chain length is at most one, so
+    finding a buffered block is a constant-time operation regardless of the
+    buffer count.
+*/
+#define BUFFER_HASH_BUCKETS BUFFER_COUNT
+
+/** @brief Compute the hash bucket for a volume and block number.
+
+    Blocks tend to be accessed in clusters, so the block number is used directly
+    to spread adjacent blocks across adjacent buckets.  The volume number is
+    multiplied by a large odd constant (derived from the golden ratio) so that
+    the same block number on different volumes maps to different buckets.
+*/
+#define BUFFER_HASH(vol, blk) ((uint16_t)((((uint32_t)(vol) * 0x9E3779B1U) + (uint32_t)(blk)) % BUFFER_HASH_BUCKETS))
+
 
 /** @brief Metadata stored for each block buffer.
 
@@ -66,6 +206,15 @@ typedef struct
     uint8_t     bVolNum;    /**< Volume the block resides on. */
     uint8_t     bRefCount;  /**< Number of references. */
     uint16_t    uFlags;     /**< Buffer flags: mask of BFLAG_* values. */
+    uint16_t    uHashNext;  /**< Next buffer in the same hash chain; BIDX_INVALID if last. */
+    uint16_t    uNewer;     /**< Next more recently used unreferenced buffer; BIDX_INVALID if MRU. */
+    uint16_t    uOlder;     /**< Next less recently used unreferenced buffer; BIDX_INVALID if LRU. */
+  #if BUFFER_POLICY == BP_SLRU
+    uint8_t     bList;      /**< BLIST_* value for the unreferenced buffer list the buffer is in. */
+  #endif
+  #if BUFFER_CRC_INCREMENTAL == 1
+    BUFFERCRC   crc;        /**< Modified ranges of a metadata buffer, for updating its CRC. */
+  #endif
 } BUFFERHEAD;
 
 
@@ -77,64 +226,281 @@ typedef struct
     */
     uint16_t    uNumUsed;
 
-    /** MRU array.  Each element of the array stores a buffer index; each buffer
-        index appears in the array once and only once.  The first element of the
-        array is the most-recently-used (MRU) buffer, followed by the next most
-        recently used, and so on, till the last element, which is the least-
-        recently-used (LRU) buffer.
+  #if REDOSCONF_BUFFER_ALLOC == 1
+    /** Number of block buffers.  The buffer heads, the hash table, and the
+        scratch array of dirty buffer indices are arrays of this size, which
+        are allocated along with the block buffers and follow the last block
+        buffer (or, if enabled, the read-ahead buffer) in that memory.
+    */
+    uint16_t    uBufferCount;
+  #endif
+
+    /** Number of buffers which are dirty (have BFLAG_DIRTY set).  Buffers
+        which are not associated with a block (BBLK_INVALID) are never dirty.
     */
-    uint8_t     abMRU[REDCONF_BUFFER_COUNT];
+    uint16_t    uNumDirty;
+
+    /** For each BLIST_* list, the index of the most-recently-used (MRU)
+        unreferenced buffer, or BIDX_INVALID if the list is empty.
+
+        The unreferenced buffers (those with a bRefCount of zero) are kept in
+        doubly-linked lists, linked via BUFFERHEAD::uNewer and
+        BUFFERHEAD::uOlder, ordered by when they were last used.  Referenced
+        buffers cannot be repurposed, so they are not in any list; a buffer is
+        removed from its list when it is first referenced and is added back as
+        the MRU buffer when its last reference is released.  Thus, the least-
+        recently-used (LRU) buffer in a list is always the buffer which should
+        be repurposed, without any searching.
+
+        With the segmented LRU policy, metadata buffers are added to the
+        protected list.  Once it holds more than #REDCONF_BUFFER_META_SEGMENT
+        buffers, its LRU buffer is moved to the general list as the MRU buffer.
+        Buffers are repurposed from the general list unless it is empty.
+    */
+    uint16_t    auMRU[BLIST_COUNT];
+
+    /** For each BLIST_* list, the index of the least-recently-used (LRU)
+        unreferenced buffer, or BIDX_INVALID if the list is empty.
+    */
+    uint16_t    auLRU[BLIST_COUNT];
+
+  #if BUFFER_POLICY == BP_SLRU
+    /** Number of buffers in the protected list.
+    */
+    uint16_t    uNumProtected;
+  #endif
 
     /** Buffer heads, storing metadata for each buffer.
     */
+  #if REDOSCONF_BUFFER_ALLOC == 1
+    BUFFERHEAD *aHead;
+  #else
     BUFFERHEAD  aHead[REDCONF_BUFFER_COUNT];
+  #endif
+
+    /** Hash table used to find the buffer for a given volume and block number.
+        Each element is the index of the first buffer in a chain of buffers
+        (linked via BUFFERHEAD::uHashNext) whose volume and block number hash
+        to that bucket, or BIDX_INVALID if the chain is empty.  Only buffers
+        which are associated with a block (ulBlock != BBLK_INVALID) are in the
+        hash table.
+    */
+  #if REDOSCONF_BUFFER_ALLOC == 1
+    uint16_t   *auHashHead;
+  #else
+    uint16_t    auHashHead[BUFFER_HASH_BUCKETS];
+  #endif
+
+  #if REDCONF_VOLUME_COUNT > 1U
+    /** Number of buffers associated with a block on each volume; that is,
+        the number of buffers in the hash table for each volume.  Used to honor
+        VOLCONF::uBufferReserve.
+    */
+    uint16_t    auVolBuffers[REDCONF_VOLUME_COUNT];
+  #endif
 
-    /** Byte array used as the heap for the block buffers.
+  #if REDCONF_READ_ONLY == 0
+    /** Scratch array of buffer indices, used to collect the dirty buffers
+        which are about to be written and put them in block order.
+    */
+  #if REDOSCONF_BUFFER_ALLOC == 1
+    uint16_t   *auDirty;
+  #else
+    uint16_t    auDirty[REDCONF_BUFFER_COUNT];
+  #endif
+  #endif
+
+  #if REDOSCONF_BUFFER_ALLOC == 0
+    /** Byte array used as the heap for the block buffers, the write-gather
+        buffer, and the read-ahead buffer.
     */
-    uint8_t     abBlkHeap[(REDCONF_BUFFER_ALIGNMENT - 1U) + (REDCONF_BUFFER_COUNT * REDCONF_BLOCK_SIZE)];
+    uint8_t     abBlkHeap[(REDCONF_BUFFER_ALIGNMENT - 1U) + ((REDCONF_BUFFER_COUNT + WG_BLOCKS + RA_BLOCKS) * REDCONF_BLOCK_SIZE)];
+
+  #endif
 
     /** Pointer to the start of the block buffers.  This points into the
         abBlkHeap array, skipping over the initial bytes if necessary for the
-        block buffers to be aligned.  Each block-sized chunk of this buffer
-        is associated with the corresponding element in the aHead array.
+        block buffers to be aligned, or to the memory from RedOsBufferAlloc().
+        Each block-sized chunk of this buffer is associated with the
+        corresponding element in the aHead array.  The write-gather buffer, if
+        enabled, follows the last block buffer, and the read-ahead buffer, if
+        enabled, follows that.
     */
     uint8_t    *pbBlkBuf;
+
+  #if REDCONF_READ_AHEAD_BLOCKS > 0U
+    /** Block number of the first block in the read-ahead buffer.
+    */
+    uint32_t    ulRaBlock;
+
+    /** Bitmap of the blocks in the read-ahead buffer which are valid: bit N is
+        set if block ulRaBlock + N is in the read-ahead buffer and has not
+        been invalidated since.
+    */
+    uint32_t    ulRaValid;
+
+    /** Bitmap of the valid blocks in the read-ahead buffer which have not yet
+        been used to satisfy a read.  Used to count wasted read-ahead.
+    */
+    uint32_t    ulRaUnused;
+
+    /** Volume number of the blocks in the read-ahead buffer.
+    */
+    uint8_t     bRaVolNum;
+  #endif
 } BUFFERCTX;
 
 
-static bool BufferToIdx(const void *pBuffer, uint8_t *pbIdx);
+#if REDOSCONF_BUFFER_ALLOC == 1
+static REDSTATUS BufferPoolAlloc(uint16_t uBufferCount);
+#endif
+static void BufferPoolReset(void);
+static bool BufferToIdx(const void *pBuffer, uint16_t *puIdx);
 #if REDCONF_READ_ONLY == 0
-static REDSTATUS BufferWrite(uint8_t bIdx);
+static REDSTATUS BufferWriteRun(const uint16_t *pauIdx, uint32_t ulCount, bool fEvict);
+static uint32_t BufferRunLength(const uint16_t *pauIdx, uint32_t ulCount);
+static void BufferSort(uint16_t *pauIdx, uint32_t ulCount);
+#if REDCONF_BUFFER_WRITE_GATHER_SIZE_KB != 0U
+static REDSTATUS BufferWriteGather(uint16_t uIdx);
+#endif
+#endif
+static uint16_t BufferVictim(void);
+static void BufferMakeLRU(uint16_t uIdx);
+static void BufferMakeMRU(uint16_t uIdx);
+static void BufferListAdd(uint16_t uIdx, uint8_t bList, bool fMRU);
+static void BufferUnlink(uint16_t uIdx);
+static bool BufferFind(uint32_t ulBlock, uint16_t *puIdx);
+#if REDCONF_API_POSIX_SNAPSHOT == 1
+static void BufferDiscardStale(uint32_t ulBlock);
+#endif
+static bool BufferRangeNext(uint32_t ulBlockStart, uint32_t ulBlockCount, uint32_t *pulPos, uint16_t *puIdx);
+static void BufferHashInsert(uint16_t uIdx);
+static void BufferHashRemove(uint16_t uIdx);
+#if REDCONF_READ_AHEAD_BLOCKS > 0U
+static bool BufferRaRead(uint32_t ulBlock, uint8_t *pbBuffer, bool fConsume);
+static void BufferRaInvalidate(uint32_t ulBlockStart, uint32_t ulBlockCount);
 #endif
-static void BufferMakeLRU(uint8_t bIdx);
-static void BufferMakeMRU(uint8_t bIdx);
-static bool BufferFind(uint32_t ulBlock, uint8_t *pbIdx);
 
 
 static BUFFERCTX gBufCtx;
 
 
 /** @brief Initialize the buffers.
+
+    @param uBufferCount The number of block buffers.  Unless the buffers are
+                        allocated at run time (#REDOSCONF_BUFFER_ALLOC), this
+                        must be #REDCONF_BUFFER_COUNT.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EINVAL @p uBufferCount is not a supported number of buffers.
+    @retval -RED_ENOMEM The buffers could not be allocated.
+*/
+REDSTATUS RedBufferInit(
+    uint16_t    uBufferCount)
+{
+    REDSTATUS   ret = 0;
+
+    if((uBufferCount < MINIMUM_BUFFER_COUNT) || (uBufferCount > BUFFER_COUNT_MAX))
+    {
+        REDERROR();
+        ret = -RED_EINVAL;
+    }
+  #if REDOSCONF_BUFFER_ALLOC == 0
+    else if(uBufferCount != REDCONF_BUFFER_COUNT)
+    {
+        REDERROR();
+        ret = -RED_EINVAL;
+    }
+  #endif
+    else
+    {
+        RedMemSet(&gBufCtx, 0U, sizeof(gBufCtx));
+
+      #if REDOSCONF_BUFFER_ALLOC == 1
+        ret = BufferPoolAlloc(uBufferCount);
+      #else
+        /*  Get an aligned pointer for the block buffers.
+        */
+        gBufCtx.pbBlkBuf = UINT8_PTR_ALIGN(gBufCtx.abBlkHeap, REDCONF_BUFFER_ALIGNMENT);
+      #endif
+
+        if(ret == 0)
+        {
+            BufferPoolReset();
+        }
+    }
+
+    return ret;
+}
+
+
+#if REDOSCONF_BUFFER_ALLOC == 1
+/** @brief Uninitialize the buffers, freeing the memory allocated for them.
+
+    All buffers are discarded, so any dirty buffers should have been written
+    beforehand.
 */
-void RedBufferInit(void)
+void RedBufferUninit(void)
 {
-    uint8_t bIdx;
+    REDASSERT(gBufCtx.uNumUsed == 0U);
+
+    if(gBufCtx.pbBlkBuf != NULL)
+    {
+        RedOsBufferFree(gBufCtx.pbBlkBuf);
+    }
 
     RedMemSet(&gBufCtx, 0U, sizeof(gBufCtx));
+}
+
+
+/** @brief Change the number of block buffers.
+
+    The existing buffers are discarded, so this can only be done when no buffer
+    is referenced or dirty: for example, after a transaction point on every
+    mounted volume.  The buffer contents are not preserved, so the cache will
+    be empty afterward.
+
+    @param uBufferCount The new number of block buffers.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EINVAL @p uBufferCount is less than the minimum number of
+                        buffers needed by the configuration, or too large.
+    @retval -RED_EBUSY  A buffer is referenced or dirty.
+    @retval -RED_ENOMEM The new buffers could not be allocated.  The existing
+                        buffers are still usable.
+*/
+REDSTATUS RedBufferResize(
+    uint16_t    uBufferCount)
+{
+    REDSTATUS   ret;
 
-    for(bIdx = 0U; bIdx < REDCONF_BUFFER_COUNT; bIdx++)
+    if((uBufferCount < MINIMUM_BUFFER_COUNT) || (uBufferCount > BUFFER_COUNT_MAX))
     {
-        /*  When the buffers have been freshly initialized, acquire the buffers
-            in the order in which they appear in the array.
-        */
-        gBufCtx.abMRU[bIdx] = (uint8_t)((REDCONF_BUFFER_COUNT - bIdx) - 1U);
-        gBufCtx.aHead[bIdx].ulBlock = BBLK_INVALID;
+        ret = -RED_EINVAL;
+    }
+    else if((gBufCtx.uNumUsed != 0U) || (gBufCtx.uNumDirty != 0U))
+    {
+        ret = -RED_EBUSY;
     }
+    else
+    {
+        uint8_t *pbOldBlkBuf = gBufCtx.pbBlkBuf;
 
-    /*  Get an aligned pointer for the block buffers.
-    */
-    gBufCtx.pbBlkBuf = UINT8_PTR_ALIGN(gBufCtx.abBlkHeap, REDCONF_BUFFER_ALIGNMENT);
+        ret = BufferPoolAlloc(uBufferCount);
+        if(ret == 0)
+        {
+            RedOsBufferFree(pbOldBlkBuf);
+            BufferPoolReset();
+        }
+    }
+
+    return ret;
 }
+#endif /* REDOSCONF_BUFFER_ALLOC == 1 */
 
 
 /** @brief Acquire a buffer.
@@ -156,7 +522,7 @@ REDSTATUS RedBufferGet(
     void      **ppBuffer)
 {
     REDSTATUS   ret = 0;
-    uint8_t     bIdx;
+    uint16_t    uIdx;
 
     if(    (ulBlock >= gpRedVolume->ulBlockCount)
         || ((uFlags & BFLAG_MASK) != uFlags)
@@ -169,8 +535,19 @@ REDSTATUS RedBufferGet(
     }
     else
     {
-        if(BufferFind(ulBlock, &bIdx))
+        BUFSTAT_ADD(gbRedVolNum, RedBufferStatType(uFlags), ullLookups, 1U);
+
+      #if REDCONF_API_POSIX_SNAPSHOT == 1
+        if((uFlags & BFLAG_NEW) != 0U)
+        {
+            BufferDiscardStale(ulBlock);
+        }
+      #endif
+
+        if(BufferFind(ulBlock, &uIdx))
         {
+            BUFSTAT_ADD(gbRedVolNum, RedBufferStatType(uFlags), ullHits, 1U);
+
             /*  Error if the buffer exists and BFLAG_NEW was specified, since
                 the new flag is used when a block is newly allocated/created, so
                 the block was previously free and and there should never be an
@@ -180,13 +557,13 @@ REDSTATUS RedBufferGet(
                 was requested.
             */
             if(    ((uFlags & BFLAG_NEW) != 0U)
-                || ((uFlags & BFLAG_META_MASK) != (gBufCtx.aHead[bIdx].uFlags & BFLAG_META_MASK)))
+                || ((uFlags & BFLAG_META_MASK) != (gBufCtx.aHead[uIdx].uFlags & BFLAG_META_MASK)))
             {
                 CRITICAL_ERROR();
                 ret = -RED_EFUBAR;
             }
         }
-        else if(gBufCtx.uNumUsed == REDCONF_BUFFER_COUNT)
+        else if(gBufCtx.uNumUsed == BUFFER_COUNT)
         {
             /*  The MINIMUM_BUFFER_COUNT is supposed to ensure that no operation
                 ever runs out of buffers, so this should never happen.
@@ -198,32 +575,27 @@ REDSTATUS RedBufferGet(
         {
             BUFFERHEAD *pHead;
 
-            /*  Search for the least recently used buffer which is not
-                referenced.
+            /*  Use the least recently used buffer which is not referenced,
+                preferring one which is clean.
             */
-            for(bIdx = (uint8_t)(REDCONF_BUFFER_COUNT - 1U); bIdx > 0U; bIdx--)
-            {
-                if(gBufCtx.aHead[gBufCtx.abMRU[bIdx]].bRefCount == 0U)
-                {
-                    break;
-                }
-            }
-
-            bIdx = gBufCtx.abMRU[bIdx];
-            pHead = &gBufCtx.aHead[bIdx];
+            uIdx = BufferVictim();
+            pHead = (uIdx == BIDX_INVALID) ? NULL : &gBufCtx.aHead[uIdx];
 
-            if(pHead->bRefCount == 0U)
+            if((pHead != NULL) && (pHead->bRefCount == 0U))
             {
-                /*  If the LRU buffer is valid and dirty, write it out before
-                    repurposing it.
+                /*  If the buffer is valid and dirty, write it out before
+                    repurposing it.  If it holds file data, dirty data buffers
+                    for adjacent blocks are written along with it.
                 */
                 if(((pHead->uFlags & BFLAG_DIRTY) != 0U) && (pHead->ulBlock != BBLK_INVALID))
                 {
                   #if REDCONF_READ_ONLY == 1
                     CRITICAL_ERROR();
                     ret = -RED_EFUBAR;
+                  #elif REDCONF_BUFFER_WRITE_GATHER_SIZE_KB != 0U
+                    ret = BufferWriteGather(uIdx);
                   #else
-                    ret = BufferWrite(bIdx);
+                    ret = BufferWriteRun(&uIdx, 1U, true);
                   #endif
                 }
             }
@@ -238,22 +610,50 @@ REDSTATUS RedBufferGet(
 
             if(ret == 0)
             {
-                uint8_t *pbBuffer = BIDX2BUF(bIdx);
+                uint8_t *pbBuffer = BIDX2BUF(uIdx);
+
+                /*  Invalidate the buffer.  If the read fails, we do not
+                    want the buffer head to continue to refer to the old block
+                    number, since the read, even if it fails, may have partially
+                    overwritten the buffer data (consider the case where block
+                    size exceeds sector size, and some but not all of the
+                    sectors are read successfully), and if the buffer were to
+                    be used subsequently with its partially erroneous contents,
+                    bad things could happen.
+                */
+                if(pHead->ulBlock != BBLK_INVALID)
+                {
+                    BUFSTAT_ADD(pHead->bVolNum, RedBufferStatType(pHead->uFlags), ullEvictions, 1U);
+
+                    BufferHashRemove(uIdx);
+                    pHead->ulBlock = BBLK_INVALID;
+                }
+
+              #if REDCONF_READ_AHEAD_BLOCKS > 0U
+                /*  A new block was free, so any copy of it in the read-ahead
+                    buffer is stale.  Otherwise, the read-ahead copy is moved
+                    into the buffer, since the buffer will be authoritative
+                    from now on.
+                */
+                if((uFlags & BFLAG_NEW) != 0U)
+                {
+                    BufferRaInvalidate(ulBlock, 1U);
+                }
+              #endif
 
                 if((uFlags & BFLAG_NEW) == 0U)
                 {
-                    /*  Invalidate the LRU buffer.  If the read fails, we do not
-                        want the buffer head to continue to refer to the old
-                        block number, since the read, even if it fails, may have
-                        partially overwritten the buffer data (consider the case
-                        where block size exceeds sector size, and some but not
-                        all of the sectors are read successfully), and if the
-                        buffer were to be used subsequently with its partially
-                        erroneous contents, bad things could happen.
-                    */
-                    pHead->ulBlock = BBLK_INVALID;
+                    BUFSTAT_ADD(gbRedVolNum, RedBufferStatType(uFlags), ullMisses, 1U);
+
+                  #if REDCONF_READ_AHEAD_BLOCKS > 0U
+                    if(!BufferRaRead(ulBlock, pbBuffer, true))
+                  #endif
+                    {
+                        BUFSTAT_ADD(gbRedVolNum, RedBufferStatType(uFlags), ullIoReads, 1U);
+                        BUFSTAT_ADD(gbRedVolNum, RedBufferStatType(uFlags), ullIoReadBlocks, 1U);
 
-                    ret = RedIoRead(gbRedVolNum, ulBlock, 1U, pbBuffer);
+                        ret = RedIoRead(gbRedVolNum, ulBlock, 1U, pbBuffer);
+                    }
 
                     if((ret == 0) && ((uFlags & BFLAG_META) != 0U))
                     {
@@ -288,23 +688,42 @@ REDSTATUS RedBufferGet(
                 pHead->bVolNum = gbRedVolNum;
                 pHead->ulBlock = ulBlock;
                 pHead->uFlags = 0U;
+
+              #if BUFFER_CRC_INCREMENTAL == 1
+                /*  The stored CRC of a metadata node which was just read and
+                    validated is correct, so it can be updated incrementally.
+                    New buffers have no CRC yet.
+                */
+                RedBufferCrcReset(&pHead->crc, (uFlags & (BFLAG_META | BFLAG_NEW)) == BFLAG_META);
+              #endif
+
+                BufferHashInsert(uIdx);
             }
         }
 
-        /*  Reference the buffer, update its flags, and promote it to MRU.  This
-            happens both when BufferFind() found an existing buffer for the
-            block and when the LRU buffer was repurposed to create a buffer for
-            the block.
+        /*  Reference the buffer and update its flags.  This happens both when
+            BufferFind() found an existing buffer for the block and when the
+            LRU buffer was repurposed to create a buffer for the block.
         */
         if(ret == 0)
         {
-            BUFFERHEAD *pHead = &gBufCtx.aHead[bIdx];
+            BUFFERHEAD *pHead = &gBufCtx.aHead[uIdx];
+
+            if(pHead->bRefCount == 0U)
+            {
+                /*  Referenced buffers are not in the unreferenced buffer list;
+                    the buffer will be added back as the MRU buffer when it is
+                    released.
+                */
+                BufferUnlink(uIdx);
+                gBufCtx.uNumUsed++;
+            }
 
             pHead->bRefCount++;
 
-            if(pHead->bRefCount == 1U)
+            if(((uFlags & BFLAG_DIRTY) != 0U) && ((pHead->uFlags & BFLAG_DIRTY) == 0U))
             {
-                gBufCtx.uNumUsed++;
+                gBufCtx.uNumDirty++;
             }
 
             /*  BFLAG_NEW tells this function to zero the buffer instead of
@@ -313,9 +732,7 @@ REDSTATUS RedBufferGet(
             */
             pHead->uFlags |= (uFlags & (~BFLAG_NEW));
 
-            BufferMakeMRU(bIdx);
-
-            *ppBuffer = BIDX2BUF(bIdx);
+            *ppBuffer = BIDX2BUF(uIdx);
         }
     }
 
@@ -330,21 +747,23 @@ REDSTATUS RedBufferGet(
 void RedBufferPut(
     const void *pBuffer)
 {
-    uint8_t     bIdx;
+    uint16_t    uIdx;
 
-    if(!BufferToIdx(pBuffer, &bIdx))
+    if(!BufferToIdx(pBuffer, &uIdx))
     {
         REDERROR();
     }
     else
     {
-        REDASSERT(gBufCtx.aHead[bIdx].bRefCount > 0U);
-        gBufCtx.aHead[bIdx].bRefCount--;
+        REDASSERT(gBufCtx.aHead[uIdx].bRefCount > 0U);
+        gBufCtx.aHead[uIdx].bRefCount--;
 
-        if(gBufCtx.aHead[bIdx].bRefCount == 0U)
+        if(gBufCtx.aHead[uIdx].bRefCount == 0U)
         {
             REDASSERT(gBufCtx.uNumUsed > 0U);
             gBufCtx.uNumUsed--;
+
+            BufferMakeMRU(uIdx);
         }
     }
 }
@@ -353,6 +772,11 @@ void RedBufferPut(
 #if REDCONF_READ_ONLY == 0
 /** @brief Flush all buffers for the active volume in the given range of blocks.
 
+    The dirty buffers are written in order of block number, and buffers for
+    consecutive blocks are written together when possible (see
+    BufferRunLength()), so that flushing many buffers, as happens when the
+    volume is transacted, needs as few I/O requests as possible.
+
     @param ulBlockStart Starting block number to flush.
     @param ulBlockCount Count of blocks, starting at @p ulBlockStart, to flush.
                         Must not be zero.
@@ -378,34 +802,105 @@ REDSTATUS RedBufferFlushRange(
     }
     else
     {
-        uint8_t bIdx;
+        uint32_t ulPos = 0U;
+        uint32_t ulDirty = 0U;
+        uint16_t uIdx;
 
-        for(bIdx = 0U; bIdx < REDCONF_BUFFER_COUNT; bIdx++)
+        while(BufferRangeNext(ulBlockStart, ulBlockCount, &ulPos, &uIdx))
         {
-            BUFFERHEAD *pHead = &gBufCtx.aHead[bIdx];
+            if((gBufCtx.aHead[uIdx].uFlags & BFLAG_DIRTY) != 0U)
+            {
+                gBufCtx.auDirty[ulDirty] = uIdx;
+                ulDirty++;
+            }
+        }
 
-            if(    (pHead->bVolNum == gbRedVolNum)
-                && (pHead->ulBlock != BBLK_INVALID)
-                && ((pHead->uFlags & BFLAG_DIRTY) != 0U)
-                && (pHead->ulBlock >= ulBlockStart)
-                && (pHead->ulBlock < (ulBlockStart + ulBlockCount)))
+        BufferSort(gBufCtx.auDirty, ulDirty);
+
+        ulPos = 0U;
+        while((ret == 0) && (ulPos < ulDirty))
+        {
+            uint32_t ulRunLen = BufferRunLength(&gBufCtx.auDirty[ulPos], ulDirty - ulPos);
+
+            ret = BufferWriteRun(&gBufCtx.auDirty[ulPos], ulRunLen, false);
+
+            ulPos += ulRunLen;
+        }
+    }
+
+    return ret;
+}
+
+
+#if REDCONF_BUFFER_CLEAN_LOW_WATER > 0U
+/** @brief Write out dirty buffers so that enough buffers are clean.
+
+    This is done ahead of time, in between file system operations, so that
+    repurposing a buffer rarely requires writing it first.  Dirty buffers for
+    the active volume are written, starting with the least recently used, until
+    at least @p uLowWater buffers are clean.  Like RedBufferFlushRange(), the
+    buffers are sorted so that consecutive blocks are written together.
+
+    The written buffers remain valid, and are dirtied again if modified before
+    the next transaction point.  Since the written blocks are part of the
+    working state, this does not affect the committed state.
+
+    @param uLowWater    The number of clean buffers desired.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EIO    A disk I/O error occurred.
+*/
+REDSTATUS RedBufferWriteBack(
+    uint16_t    uLowWater)
+{
+    REDSTATUS   ret = 0;
+    uint16_t    uNumClean = BUFFER_COUNT - gBufCtx.uNumDirty;
+
+    if(uNumClean < uLowWater)
+    {
+        uint32_t ulNeeded = (uint32_t)uLowWater - uNumClean;
+        uint32_t ulDirty = 0U;
+        uint32_t ulPos = 0U;
+        uint8_t  bList;
+
+        /*  Buffers in the general list are written first, since they are the
+            first to be repurposed.
+        */
+        for(bList = 0U; bList < BLIST_COUNT; bList++)
+        {
+            uint16_t uIdx = gBufCtx.auLRU[bList];
+
+            while((uIdx != BIDX_INVALID) && (ulDirty < ulNeeded))
             {
-                ret = BufferWrite(bIdx);
+                const BUFFERHEAD *pHead = &gBufCtx.aHead[uIdx];
 
-                if(ret == 0)
-                {
-                    pHead->uFlags &= (~BFLAG_DIRTY);
-                }
-                else
+                if(((pHead->uFlags & BFLAG_DIRTY) != 0U) && (pHead->bVolNum == gbRedVolNum))
                 {
-                    break;
+                    gBufCtx.auDirty[ulDirty] = uIdx;
+                    ulDirty++;
                 }
+
+                uIdx = pHead->uNewer;
             }
         }
+
+        BufferSort(gBufCtx.auDirty, ulDirty);
+
+        while((ret == 0) && (ulPos < ulDirty))
+        {
+            uint32_t ulRunLen = BufferRunLength(&gBufCtx.auDirty[ulPos], ulDirty - ulPos);
+
+            ret = BufferWriteRun(&gBufCtx.auDirty[ulPos], ulRunLen, false);
+
+            ulPos += ulRunLen;
+        }
     }
 
     return ret;
 }
+#endif /* REDCONF_BUFFER_CLEAN_LOW_WATER > 0U */
 
 
 /** @brief Mark a buffer dirty.
@@ -415,17 +910,21 @@ REDSTATUS RedBufferFlushRange(
 void RedBufferDirty(
     const void *pBuffer)
 {
-    uint8_t     bIdx;
+    uint16_t    uIdx;
 
-    if(!BufferToIdx(pBuffer, &bIdx))
+    if(!BufferToIdx(pBuffer, &uIdx))
     {
         REDERROR();
     }
     else
     {
-        REDASSERT(gBufCtx.aHead[bIdx].bRefCount > 0U);
+        REDASSERT(gBufCtx.aHead[uIdx].bRefCount > 0U);
 
-        gBufCtx.aHead[bIdx].uFlags |= BFLAG_DIRTY;
+        if((gBufCtx.aHead[uIdx].uFlags & BFLAG_DIRTY) == 0U)
+        {
+            gBufCtx.aHead[uIdx].uFlags |= BFLAG_DIRTY;
+            gBufCtx.uNumDirty++;
+        }
     }
 }
 
@@ -439,24 +938,79 @@ void RedBufferBranch(
     const void *pBuffer,
     uint32_t    ulBlockNew)
 {
-    uint8_t     bIdx;
+    uint16_t    uIdx;
 
-    if(    !BufferToIdx(pBuffer, &bIdx)
+    if(    !BufferToIdx(pBuffer, &uIdx)
         || (ulBlockNew >= gpRedVolume->ulBlockCount))
     {
         REDERROR();
     }
     else
     {
-        BUFFERHEAD *pHead = &gBufCtx.aHead[bIdx];
+        BUFFERHEAD *pHead = &gBufCtx.aHead[uIdx];
 
         REDASSERT(pHead->bRefCount > 0U);
         REDASSERT((pHead->uFlags & BFLAG_DIRTY) == 0U);
 
+      #if REDCONF_API_POSIX_SNAPSHOT == 1
+        BufferDiscardStale(ulBlockNew);
+      #endif
+
         pHead->uFlags |= BFLAG_DIRTY;
+        gBufCtx.uNumDirty++;
+
+        BufferHashRemove(uIdx);
         pHead->ulBlock = ulBlockNew;
+        BufferHashInsert(uIdx);
+
+      #if REDCONF_READ_AHEAD_BLOCKS > 0U
+        BufferRaInvalidate(ulBlockNew, 1U);
+      #endif
+    }
+}
+
+
+#if BUFFER_CRC_INCREMENTAL == 1
+/** @brief Declare that part of a metadata buffer is about to be modified.
+
+    Must be called before the bytes are changed.  This allows the CRC of the
+    node to be updated, when the buffer is written, from only the modified
+    bytes, rather than recomputed over the whole node.  Does nothing for file
+    data buffers.
+
+    @param pBuffer  The buffer which will be modified.
+    @param pData    Pointer to the first byte which will be modified, within
+                    @p pBuffer.
+    @param ulLength The number of bytes which will be modified.
+*/
+void RedBufferModify(
+    const void *pBuffer,
+    const void *pData,
+    uint32_t    ulLength)
+{
+    uint16_t    uIdx;
+
+    if(    !BufferToIdx(pBuffer, &uIdx)
+        || (pData == NULL)
+        || ((const uint8_t *)pData < (const uint8_t *)pBuffer))
+    {
+        REDERROR();
+    }
+    else
+    {
+        const uint8_t *pbBuffer = pBuffer;
+
+        REDASSERT(gBufCtx.aHead[uIdx].bRefCount > 0U);
+
+        /*  File data buffers have no CRC, so there is nothing to track.
+        */
+        if((gBufCtx.aHead[uIdx].uFlags & BFLAG_META) != 0U)
+        {
+            RedBufferCrcModify(&gBufCtx.aHead[uIdx].crc, pbBuffer, (uint32_t)((const uint8_t *)pData - pbBuffer), ulLength);
+        }
     }
 }
+#endif
 #endif /* REDCONF_READ_ONLY == 0 */
 
 
@@ -467,23 +1021,31 @@ void RedBufferBranch(
 void RedBufferDiscard(
     const void *pBuffer)
 {
-    uint8_t     bIdx;
+    uint16_t    uIdx;
 
-    if(!BufferToIdx(pBuffer, &bIdx))
+    if(!BufferToIdx(pBuffer, &uIdx))
     {
         REDERROR();
     }
     else
     {
-        REDASSERT(gBufCtx.aHead[bIdx].bRefCount == 1U);
+        REDASSERT(gBufCtx.aHead[uIdx].bRefCount == 1U);
         REDASSERT(gBufCtx.uNumUsed > 0U);
 
-        gBufCtx.aHead[bIdx].bRefCount = 0U;
-        gBufCtx.aHead[bIdx].ulBlock = BBLK_INVALID;
+        BufferHashRemove(uIdx);
+
+        if((gBufCtx.aHead[uIdx].uFlags & BFLAG_DIRTY) != 0U)
+        {
+            gBufCtx.aHead[uIdx].uFlags &= (~BFLAG_DIRTY);
+            gBufCtx.uNumDirty--;
+        }
+
+        gBufCtx.aHead[uIdx].bRefCount = 0U;
+        gBufCtx.aHead[uIdx].ulBlock = BBLK_INVALID;
 
         gBufCtx.uNumUsed--;
 
-        BufferMakeLRU(bIdx);
+        BufferMakeLRU(uIdx);
     }
 }
 
@@ -515,43 +1077,49 @@ REDSTATUS RedBufferDiscardRange(
     }
     else
     {
-        uint8_t bIdx;
+        uint32_t ulPos = 0U;
+        uint16_t uIdx;
+
+      #if REDCONF_READ_AHEAD_BLOCKS > 0U
+        BufferRaInvalidate(ulBlockStart, ulBlockCount);
+      #endif
 
-        for(bIdx = 0U; bIdx < REDCONF_BUFFER_COUNT; bIdx++)
+        while(BufferRangeNext(ulBlockStart, ulBlockCount, &ulPos, &uIdx))
         {
-            BUFFERHEAD *pHead = &gBufCtx.aHead[bIdx];
+            BUFFERHEAD *pHead = &gBufCtx.aHead[uIdx];
 
-            if(    (pHead->bVolNum == gbRedVolNum)
-                && (pHead->ulBlock != BBLK_INVALID)
-                && (pHead->ulBlock >= ulBlockStart)
-                && (pHead->ulBlock < (ulBlockStart + ulBlockCount)))
+            if(pHead->bRefCount == 0U)
             {
-                if(pHead->bRefCount == 0U)
-                {
-                    pHead->ulBlock = BBLK_INVALID;
+                BufferHashRemove(uIdx);
+                pHead->ulBlock = BBLK_INVALID;
 
-                    BufferMakeLRU(bIdx);
-                }
-                else
+                if((pHead->uFlags & BFLAG_DIRTY) != 0U)
                 {
-                    /*  This should never happen.  There are three general cases
-                        when this function is used:
-
-                        1) Discarding every block, as happens during unmount
-                           and at the end of format.  There should no longer be
-                           any referenced buffers at those points.
-                        2) Discarding a block which has become free.  All
-                           buffers for such blocks should be put or branched
-                           beforehand.
-                        3) Discarding of blocks that were just written straight
-                           to disk, leaving stale data in the buffer.  The write
-                           code should never reference buffers for these blocks,
-                           since they would not be needed or used.
-                    */
-                    CRITICAL_ERROR();
-                    ret = -RED_EBUSY;
-                    break;
+                    pHead->uFlags &= (~BFLAG_DIRTY);
+                    gBufCtx.uNumDirty--;
                 }
+
+                BufferUnlink(uIdx);
+                BufferMakeLRU(uIdx);
+            }
+            else
+            {
+                /*  This should never happen.  There are three general cases
+                    when this function is used:
+
+                    1) Discarding every block, as happens during unmount and
+                       at the end of format.  There should no longer be any
+                       referenced buffers at those points.
+                    2) Discarding a block which has become free.  All buffers
+                       for such blocks should be put or branched beforehand.
+                    3) Discarding of blocks that were just written straight to
+                       disk, leaving stale data in the buffer.  The write code
+                       should never reference buffers for these blocks, since
+                       they would not be needed or used.
+                */
+                CRITICAL_ERROR();
+                ret = -RED_EBUSY;
+                break;
             }
         }
     }
@@ -599,15 +1167,138 @@ REDSTATUS RedBufferReadRange(
         if(ret == 0)
       #endif
         {
+          #if REDCONF_READ_AHEAD_BLOCKS > 0U
+            uint32_t ulIdx = 0U;
+
+            /*  Blocks in the read-ahead buffer are copied from there; the
+                other blocks are read directly from disk, bypassing the
+                buffers.
+            */
+            while((ret == 0) && (ulIdx < ulBlockCount))
+            {
+                if(BufferRaRead(ulBlockStart + ulIdx, &pbDataBuffer[ulIdx << BLOCK_SIZE_P2], false))
+                {
+                    ulIdx++;
+                }
+                else
+                {
+                    uint32_t ulRunLen = 1U;
+
+                    while(    ((ulIdx + ulRunLen) < ulBlockCount)
+                           && !BufferRaRead(ulBlockStart + ulIdx + ulRunLen, NULL, false))
+                    {
+                        ulRunLen++;
+                    }
+
+                    BUFSTAT_ADD(gbRedVolNum, RED_BUFSTAT_DATA, ullIoReads, 1U);
+                    BUFSTAT_ADD(gbRedVolNum, RED_BUFSTAT_DATA, ullIoReadBlocks, ulRunLen);
+
+                    ret = RedIoRead(gbRedVolNum, ulBlockStart + ulIdx, ulRunLen, &pbDataBuffer[ulIdx << BLOCK_SIZE_P2]);
+
+                    ulIdx += ulRunLen;
+                }
+            }
+          #else
             /*  This implementation always reads directly from disk, bypassing
                 the buffers.
             */
+            BUFSTAT_ADD(gbRedVolNum, RED_BUFSTAT_DATA, ullIoReads, 1U);
+            BUFSTAT_ADD(gbRedVolNum, RED_BUFSTAT_DATA, ullIoReadBlocks, ulBlockCount);
+
             ret = RedIoRead(gbRedVolNum, ulBlockStart, ulBlockCount, pbDataBuffer);
+          #endif
+        }
+    }
+
+    return ret;
+}
+
+
+#if REDCONF_READ_AHEAD_BLOCKS > 0U
+/** @brief Read blocks into the read-ahead buffer.
+
+    This is used for blocks which are expected to be read soon, typically the
+    file data which follows a sequential read.  The blocks are read with a
+    single I/O request into a dedicated read-ahead buffer, rather than into the
+    block buffers, so that reading ahead never evicts buffered metadata.  A
+    later RedBufferGet() or RedBufferReadRange() for the blocks copies them
+    from the read-ahead buffer instead of reading them from disk.
+
+    Blocks which are already buffered are never read ahead, since the buffer
+    might hold newer data than the disk.  Reading ahead stops at the first
+    such block.  The previous contents of the read-ahead buffer are discarded.
+
+    @param ulBlockStart The first block number to read ahead.
+    @param ulBlockCount The number of blocks, starting at @p ulBlockStart, to
+                        read ahead.  Must not be zero.  If larger than
+                        #REDCONF_READ_AHEAD_BLOCKS, fewer blocks are read.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EINVAL Invalid parameters.
+    @retval -RED_EIO    A disk I/O error occurred.
+*/
+REDSTATUS RedBufferReadAhead(
+    uint32_t    ulBlockStart,
+    uint32_t    ulBlockCount)
+{
+    REDSTATUS   ret = 0;
+
+    if(    (ulBlockStart >= gpRedVolume->ulBlockCount)
+        || ((gpRedVolume->ulBlockCount - ulBlockStart) < ulBlockCount)
+        || (ulBlockCount == 0U))
+    {
+        REDERROR();
+        ret = -RED_EINVAL;
+    }
+    else
+    {
+        uint32_t ulCount = REDMIN(ulBlockCount, RA_BLOCKS);
+        uint32_t ulIdx;
+        uint16_t uIdx;
+
+        for(ulIdx = 0U; ulIdx < ulCount; ulIdx++)
+        {
+            if(BufferFind(ulBlockStart + ulIdx, &uIdx))
+            {
+                ulCount = ulIdx;
+                break;
+            }
+        }
+
+        if(ulCount > 0U)
+        {
+            /*  The read-ahead buffer is about to be overwritten: any blocks in
+                it which were never used were read ahead for nothing.
+            */
+            while(gBufCtx.ulRaUnused != 0U)
+            {
+                gaRedCoreVol[gBufCtx.bRaVolNum].ullReadAheadWasted++;
+                gBufCtx.ulRaUnused &= gBufCtx.ulRaUnused - 1U; /* Clear the lowest set bit. */
+            }
+
+            gBufCtx.ulRaValid = 0U;
+
+            BUFSTAT_ADD(gbRedVolNum, RED_BUFSTAT_DATA, ullIoReads, 1U);
+            BUFSTAT_ADD(gbRedVolNum, RED_BUFSTAT_DATA, ullIoReadBlocks, ulCount);
+
+            ret = RedIoRead(gbRedVolNum, ulBlockStart, ulCount, RABUF);
+            if(ret == 0)
+            {
+                gBufCtx.bRaVolNum = gbRedVolNum;
+                gBufCtx.ulRaBlock = ulBlockStart;
+                gBufCtx.ulRaValid = RA_MASK(ulCount);
+                gBufCtx.ulRaUnused = gBufCtx.ulRaValid;
+
+                gpRedCoreVol->ullReadAheadBlocks += ulCount;
+            }
         }
     }
 
     return ret;
 }
+#endif /* REDCONF_READ_AHEAD_BLOCKS > 0U */
 
 
 #if REDCONF_READ_ONLY == 0
@@ -645,6 +1336,10 @@ REDSTATUS RedBufferWriteRange(
         /*  This implementation always writes directly to disk, bypassing the
             buffers.
         */
+        BUFSTAT_ADD(gbRedVolNum, RED_BUFSTAT_DATA, ullIoWrites, 1U);
+        BUFSTAT_ADD(gbRedVolNum, RED_BUFSTAT_DATA, ullIoWriteBlocks, ulBlockCount);
+        TRANSTAT_ADD(gbRedVolNum, aulWritten[RED_BUFSTAT_DATA], ulBlockCount);
+
         ret = RedIoWrite(gbRedVolNum, ulBlockStart, ulBlockCount, pbDataBuffer);
         if(ret == 0)
         {
@@ -660,10 +1355,127 @@ REDSTATUS RedBufferWriteRange(
 #endif
 
 
+#if REDOSCONF_BUFFER_ALLOC == 1
+/** @brief Allocate memory for the block buffers and the arrays indexed by
+           buffer.
+
+    On success, the buffer context refers to the new memory, and the buffers
+    must be reset with BufferPoolReset().  On failure, the buffer context is
+    unchanged.
+
+    @param uBufferCount The number of block buffers to allocate.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EINVAL @p uBufferCount is too large.
+    @retval -RED_ENOMEM The memory could not be allocated.
+*/
+static REDSTATUS BufferPoolAlloc(
+    uint16_t    uBufferCount)
+{
+    REDSTATUS   ret = 0;
+    uint64_t    ullBlkBytes = ((uint64_t)uBufferCount + WG_BLOCKS + RA_BLOCKS) << BLOCK_SIZE_P2;
+    uint32_t    ulHeadBytes = (uint32_t)uBufferCount * (uint32_t)sizeof(BUFFERHEAD);
+    uint32_t    ulIdxBytes = (uint32_t)uBufferCount * (uint32_t)sizeof(uint16_t);
+    uint64_t    ullSize = ullBlkBytes + ulHeadBytes + ulIdxBytes;
+
+  #if REDCONF_READ_ONLY == 0
+    ullSize += ulIdxBytes;
+  #endif
+
+    /*  Offsets into the block buffer heap are computed with 32-bit arithmetic.
+    */
+    if(ullSize > 0x7FFFFFFFU)
+    {
+        ret = -RED_EINVAL;
+    }
+    else
+    {
+        uint8_t *pbPool = RedOsBufferAlloc((uint32_t)ullSize, REDCONF_BUFFER_ALIGNMENT);
+
+        if(pbPool == NULL)
+        {
+            ret = -RED_ENOMEM;
+        }
+        else
+        {
+            uint32_t ulOffset = (uint32_t)ullBlkBytes;
+
+            /*  The block buffers come first, so that they are aligned.  Since
+                the block size is at least 128 bytes, the arrays which follow
+                are also suitably aligned.
+            */
+            gBufCtx.pbBlkBuf = pbPool;
+            gBufCtx.aHead = (BUFFERHEAD *)(void *)&pbPool[ulOffset];
+            ulOffset += ulHeadBytes;
+            gBufCtx.auHashHead = (uint16_t *)(void *)&pbPool[ulOffset];
+          #if REDCONF_READ_ONLY == 0
+            ulOffset += ulIdxBytes;
+            gBufCtx.auDirty = (uint16_t *)(void *)&pbPool[ulOffset];
+          #endif
+            gBufCtx.uBufferCount = uBufferCount;
+        }
+    }
+
+    return ret;
+}
+#endif /* REDOSCONF_BUFFER_ALLOC == 1 */
+
+
+/** @brief Reset the buffers to their initial state: unreferenced, not
+           associated with any block, and in array order in the general list.
+
+    Must only be used when no buffers are referenced or dirty.
+*/
+static void BufferPoolReset(void)
+{
+    uint16_t    uIdx;
+
+    REDASSERT(gBufCtx.uNumUsed == 0U);
+    REDASSERT(gBufCtx.uNumDirty == 0U);
+
+  #if BUFFER_POLICY == BP_SLRU
+    gBufCtx.uNumProtected = 0U;
+  #endif
+  #if REDCONF_VOLUME_COUNT > 1U
+    RedMemSet(gBufCtx.auVolBuffers, 0U, sizeof(gBufCtx.auVolBuffers));
+  #endif
+  #if REDCONF_READ_AHEAD_BLOCKS > 0U
+    gBufCtx.ulRaValid = 0U;
+    gBufCtx.ulRaUnused = 0U;
+  #endif
+
+    RedMemSet(gBufCtx.aHead, 0U, (uint32_t)BUFFER_COUNT * (uint32_t)sizeof(gBufCtx.aHead[0U]));
+
+    for(uIdx = 0U; uIdx < BLIST_COUNT; uIdx++)
+    {
+        gBufCtx.auMRU[uIdx] = BIDX_INVALID;
+        gBufCtx.auLRU[uIdx] = BIDX_INVALID;
+    }
+
+    for(uIdx = 0U; uIdx < BUFFER_COUNT; uIdx++)
+    {
+        gBufCtx.aHead[uIdx].ulBlock = BBLK_INVALID;
+        gBufCtx.aHead[uIdx].uHashNext = BIDX_INVALID;
+
+        /*  When the buffers have been freshly initialized, acquire the buffers
+            in the order in which they appear in the array.
+        */
+        BufferMakeMRU(uIdx);
+    }
+
+    for(uIdx = 0U; uIdx < BUFFER_HASH_BUCKETS; uIdx++)
+    {
+        gBufCtx.auHashHead[uIdx] = BIDX_INVALID;
+    }
+}
+
+
 /** @brief Derive the index of the buffer.
 
     @param pBuffer  The buffer to derive the index of.
-    @param pbIdx    On success, populated with the index of the buffer.
+    @param puIdx    On success, populated with the index of the buffer.
 
     @return Boolean indicating result.
 
@@ -672,27 +1484,27 @@ REDSTATUS RedBufferWriteRange(
 */
 static bool BufferToIdx(
     const void *pBuffer,
-    uint8_t    *pbIdx)
+    uint16_t   *puIdx)
 {
     bool        fRet = false;
 
-    if(    PTR_IS_ARRAY_ELEMENT(pBuffer, gBufCtx.pbBlkBuf, REDCONF_BUFFER_COUNT << BLOCK_SIZE_P2, REDCONF_BLOCK_SIZE)
-        && (pbIdx != NULL))
+    if(    PTR_IS_ARRAY_ELEMENT(pBuffer, gBufCtx.pbBlkBuf, (uint32_t)BUFFER_COUNT << BLOCK_SIZE_P2, REDCONF_BLOCK_SIZE)
+        && (puIdx != NULL))
     {
-        uint8_t bIdx = (uint8_t)(((uintptr_t)pBuffer - (uintptr_t)gBufCtx.pbBlkBuf) >> BLOCK_SIZE_P2);
+        uint16_t uIdx = (uint16_t)(((uintptr_t)pBuffer - (uintptr_t)gBufCtx.pbBlkBuf) >> BLOCK_SIZE_P2);
 
         /*  This should be guaranteed, since PTR_IS_ARRAY_ELEMENT() was true.
         */
-        REDASSERT(bIdx < REDCONF_BUFFER_COUNT);
+        REDASSERT(uIdx < BUFFER_COUNT);
 
         /*  At this point, we know the buffer pointer refers to a valid buffer.
             However, if the corresponding buffer head isn't an in-use buffer for
             the current volume, then something is wrong.
         */
-        if(    (gBufCtx.aHead[bIdx].ulBlock != BBLK_INVALID)
-            && (gBufCtx.aHead[bIdx].bVolNum == gbRedVolNum))
+        if(    (gBufCtx.aHead[uIdx].ulBlock != BBLK_INVALID)
+            && (gBufCtx.aHead[uIdx].bVolNum == gbRedVolNum))
         {
-            *pbIdx = bIdx;
+            *puIdx = uIdx;
             fRet = true;
         }
     }
@@ -702,189 +1514,886 @@ static bool BufferToIdx(
 
 
 #if REDCONF_READ_ONLY == 0
-/** @brief Write out a dirty buffer.
+/** @brief Write out dirty buffers for a run of consecutive blocks.
+
+    The buffers are written with a single I/O request.  If they are also
+    consecutive in memory, they are written in place; otherwise, they are
+    copied into the write-gather buffer, which must be large enough.
 
-    @param bIdx The index of the buffer to write.
+    @param pauIdx   Array of buffer indices, in order of block number.  The
+                    buffers must be dirty and must be for consecutive blocks on
+                    the same volume.
+    @param ulCount  The number of elements in @p pauIdx.  Must not be zero.
+    @param fEvict   Whether the buffers are being written to make room for
+                    another block, rather than flushed.  Only used to update
+                    the buffer statistics.
 
     @return A negated ::REDSTATUS code indicating the operation result.
 
-    @retval 0           Operation was successful.
+    @retval 0           Operation was successful.  The buffers are no longer
+                        dirty.
     @retval -RED_EIO    A disk I/O error occurred.
     @retval -RED_EINVAL Invalid parameters.
 */
-static REDSTATUS BufferWrite(
-    uint8_t     bIdx)
+static REDSTATUS BufferWriteRun(
+    const uint16_t *pauIdx,
+    uint32_t        ulCount,
+    bool            fEvict)
 {
-    REDSTATUS   ret = 0;
+    REDSTATUS       ret = 0;
 
-    if(bIdx < REDCONF_BUFFER_COUNT)
+    if((pauIdx == NULL) || (ulCount == 0U) || (ulCount > BUFFER_COUNT))
     {
-        const BUFFERHEAD   *pHead = &gBufCtx.aHead[bIdx];
-        uint8_t            *pbBuffer = BIDX2BUF(bIdx);
-
-        REDASSERT((pHead->uFlags & BFLAG_DIRTY) != 0U);
+        REDERROR();
+        ret = -RED_EINVAL;
+    }
+    else
+    {
+        const BUFFERHEAD   *pFirst = &gBufCtx.aHead[pauIdx[0U]];
+        bool                fInPlace = true;
+        uint8_t            *pbData;
+        uint32_t            ulOffset;
 
-        if((pHead->uFlags & BFLAG_META) != 0U)
+        for(ulOffset = 0U; ulOffset < ulCount; ulOffset++)
         {
-            ret = RedBufferFinalize(pbBuffer, pHead->bVolNum, pHead->uFlags);
+            const BUFFERHEAD *pHead = &gBufCtx.aHead[pauIdx[ulOffset]];
+
+            REDASSERT((pHead->uFlags & BFLAG_DIRTY) != 0U);
+            REDASSERT(pHead->bVolNum == pFirst->bVolNum);
+            REDASSERT(pHead->ulBlock == (pFirst->ulBlock + ulOffset));
+
+            if(pauIdx[ulOffset] != (pauIdx[0U] + ulOffset))
+            {
+                fInPlace = false;
+            }
+
+            if((pHead->uFlags & BFLAG_META) != 0U)
+            {
+              #if BUFFER_CRC_INCREMENTAL == 1
+                ret = RedBufferFinalize(BIDX2BUF(pauIdx[ulOffset]), pHead->bVolNum, pHead->uFlags, &gBufCtx.aHead[pauIdx[ulOffset]].crc);
+              #else
+                ret = RedBufferFinalize(BIDX2BUF(pauIdx[ulOffset]), pHead->bVolNum, pHead->uFlags, NULL);
+              #endif
+                if(ret != 0)
+                {
+                    break;
+                }
+            }
         }
 
-        if(ret == 0)
+        if(ret != 0)
         {
-            ret = RedIoWrite(pHead->bVolNum, pHead->ulBlock, 1U, pbBuffer);
+          #ifdef REDCONF_ENDIAN_SWAP
+            /*  Swap back the metadata buffers which were finalized before the
+                one which failed.
+            */
+            while(ulOffset > 0U)
+            {
+                ulOffset--;
+                RedBufferEndianSwap(BIDX2BUF(pauIdx[ulOffset]), gBufCtx.aHead[pauIdx[ulOffset]].uFlags);
+            }
+          #endif
+        }
+        else
+        {
+            if(fInPlace)
+            {
+                pbData = BIDX2BUF(pauIdx[0U]);
+            }
+            else
+            {
+              #if REDCONF_BUFFER_WRITE_GATHER_SIZE_KB != 0U
+                REDASSERT(ulCount <= WG_BLOCKS);
+
+                for(ulOffset = 0U; ulOffset < ulCount; ulOffset++)
+                {
+                    RedMemCpy(&WGBUF[ulOffset << BLOCK_SIZE_P2], BIDX2BUF(pauIdx[ulOffset]), REDCONF_BLOCK_SIZE);
+                }
+
+                pbData = WGBUF;
+              #else
+                REDERROR();
+                ret = -RED_EINVAL;
+                pbData = NULL;
+              #endif
+            }
+
+            if(ret == 0)
+            {
+              #if (REDCONF_BUFFER_STATS == 1) || (REDCONF_TRANSACT_STATS == 1)
+                BUFSTAT_ADD(pFirst->bVolNum, RedBufferStatType(pFirst->uFlags), ullIoWrites, 1U);
+
+                for(ulOffset = 0U; ulOffset < ulCount; ulOffset++)
+                {
+                    uint8_t bType = RedBufferStatType(gBufCtx.aHead[pauIdx[ulOffset]].uFlags);
+
+                    BUFSTAT_ADD(pFirst->bVolNum, bType, ullIoWriteBlocks, 1U);
+                    TRANSTAT_ADD(pFirst->bVolNum, aulWritten[bType], 1U);
+
+                    if(fEvict)
+                    {
+                        BUFSTAT_ADD(pFirst->bVolNum, bType, ullEvictWrites, 1U);
+                    }
+                    else
+                    {
+                        BUFSTAT_ADD(pFirst->bVolNum, bType, ullFlushWrites, 1U);
+                    }
+                }
+              #else
+                (void)fEvict;
+              #endif
+
+                ret = RedIoWrite(pFirst->bVolNum, pFirst->ulBlock, ulCount, pbData);
+            }
 
           #ifdef REDCONF_ENDIAN_SWAP
-            RedBufferEndianSwap(pbBuffer, pHead->uFlags);
+            for(ulOffset = 0U; ulOffset < ulCount; ulOffset++)
+            {
+                RedBufferEndianSwap(BIDX2BUF(pauIdx[ulOffset]), gBufCtx.aHead[pauIdx[ulOffset]].uFlags);
+            }
           #endif
         }
-    }
-    else
-    {
-        REDERROR();
-        ret = -RED_EINVAL;
+
+        if(ret == 0)
+        {
+            for(ulOffset = 0U; ulOffset < ulCount; ulOffset++)
+            {
+                gBufCtx.aHead[pauIdx[ulOffset]].uFlags &= (~BFLAG_DIRTY);
+            }
+
+            REDASSERT(gBufCtx.uNumDirty >= ulCount);
+            gBufCtx.uNumDirty -= (uint16_t)ulCount;
+        }
     }
 
     return ret;
 }
-#endif /* REDCONF_READ_ONLY == 0 */
 
 
-/** @brief Mark a buffer as least recently used.
+/** @brief Determine how many dirty buffers can be written together.
+
+    Buffers for consecutive blocks can be written with one I/O request if they
+    are also consecutive in memory, or if they fit into the write-gather
+    buffer.
+
+    @param pauIdx   Array of dirty buffer indices for the active volume, sorted
+                    by block number.
+    @param ulCount  The number of elements in @p pauIdx.  Must not be zero.
 
-    @param bIdx The index of the buffer to make LRU.
+    @return The number of buffers, starting with the first element of
+            @p pauIdx, which can be written by one call to BufferWriteRun().
 */
-static void BufferMakeLRU(
-    uint8_t bIdx)
+static uint32_t BufferRunLength(
+    const uint16_t *pauIdx,
+    uint32_t        ulCount)
 {
-    if(bIdx >= REDCONF_BUFFER_COUNT)
-    {
-        REDERROR();
-    }
-    else if(bIdx != gBufCtx.abMRU[REDCONF_BUFFER_COUNT - 1U])
+    uint32_t        ulLen = 1U;
+    bool            fInPlace = true;
+
+    while(ulLen < ulCount)
     {
-        uint8_t bMruIdx;
+        const BUFFERHEAD *pPrev = &gBufCtx.aHead[pauIdx[ulLen - 1U]];
 
-        /*  Find the current position of the buffer in the MRU array.  We do not
-            need to check the last slot, since we already know from the above
-            check that the index is not there.
-        */
-        for(bMruIdx = 0U; bMruIdx < (REDCONF_BUFFER_COUNT - 1U); bMruIdx++)
+        if(gBufCtx.aHead[pauIdx[ulLen]].ulBlock != (pPrev->ulBlock + 1U))
         {
-            if(bIdx == gBufCtx.abMRU[bMruIdx])
-            {
-                break;
-            }
+            break;
         }
 
-        if(bMruIdx < (REDCONF_BUFFER_COUNT - 1U))
+        if(pauIdx[ulLen] != (pauIdx[ulLen - 1U] + 1U))
         {
-            /*  Move the buffer index to the back of the MRU array, making it
-                the LRU buffer.
-            */
-            RedMemMove(&gBufCtx.abMRU[bMruIdx], &gBufCtx.abMRU[bMruIdx + 1U], REDCONF_BUFFER_COUNT - ((uint32_t)bMruIdx + 1U));
-            gBufCtx.abMRU[REDCONF_BUFFER_COUNT - 1U] = bIdx;
+            fInPlace = false;
         }
-        else
+
+        if(!fInPlace && (ulLen >= WG_BLOCKS))
         {
-            REDERROR();
+            break;
         }
+
+        ulLen++;
     }
-    else
-    {
-        /*  Buffer already LRU, nothing to do.
-        */
-    }
+
+    return ulLen;
 }
 
 
-/** @brief Mark a buffer as most recently used.
+/** @brief Sort an array of buffer indices by block number.
+
+    This is a heapsort, which needs no additional memory or recursion, and
+    takes O(n log n) time even in the worst case.
 
-    @param bIdx The index of the buffer to make MRU.
+    @param pauIdx   Array of buffer indices to sort.  The buffers must be for
+                    the same volume.
+    @param ulCount  The number of elements in @p pauIdx.
 */
-static void BufferMakeMRU(
-    uint8_t bIdx)
+static void BufferSort(
+    uint16_t   *pauIdx,
+    uint32_t    ulCount)
 {
-    if(bIdx >= REDCONF_BUFFER_COUNT)
-    {
-        REDERROR();
-    }
-    else if(bIdx != gBufCtx.abMRU[0U])
+    uint32_t    ulHeapSize = ulCount;
+    uint32_t    ulNextParent = ulCount / 2U;
+
+    /*  First the array is arranged into a max-heap, by sifting down each parent
+        node, starting with the last.  Then, the largest remaining element is
+        repeatedly moved from the root to the end of the shrinking heap, and the
+        new root is sifted down.
+    */
+    while(ulHeapSize > 1U)
     {
-        uint8_t bMruIdx;
+        uint32_t ulRoot;
+        uint16_t uTmp;
 
-        /*  Find the current position of the buffer in the MRU array.  We do not
-            need to check the first slot, since we already know from the above
-            check that the index is not there.
-        */
-        for(bMruIdx = 1U; bMruIdx < REDCONF_BUFFER_COUNT; bMruIdx++)
+        if(ulNextParent > 0U)
         {
-            if(bIdx == gBufCtx.abMRU[bMruIdx])
-            {
-                break;
-            }
+            ulNextParent--;
+            ulRoot = ulNextParent;
         }
-
-        if(bMruIdx < REDCONF_BUFFER_COUNT)
+        else
         {
-            /*  Move the buffer index to the front of the MRU array, making it
-                the MRU buffer.
-            */
-            RedMemMove(&gBufCtx.abMRU[1U], &gBufCtx.abMRU[0U], bMruIdx);
-            gBufCtx.abMRU[0U] = bIdx;
+            ulHeapSize--;
+            uTmp = pauIdx[0U];
+            pauIdx[0U] = pauIdx[ulHeapSize];
+            pauIdx[ulHeapSize] = uTmp;
+            ulRoot = 0U;
         }
-        else
+
+        while(((ulRoot * 2U) + 1U) < ulHeapSize)
         {
-            REDERROR();
+            uint32_t ulChild = (ulRoot * 2U) + 1U;
+
+            if(    ((ulChild + 1U) < ulHeapSize)
+                && (gBufCtx.aHead[pauIdx[ulChild + 1U]].ulBlock > gBufCtx.aHead[pauIdx[ulChild]].ulBlock))
+            {
+                ulChild++;
+            }
+
+            if(gBufCtx.aHead[pauIdx[ulRoot]].ulBlock >= gBufCtx.aHead[pauIdx[ulChild]].ulBlock)
+            {
+                break;
+            }
+
+            uTmp = pauIdx[ulRoot];
+            pauIdx[ulRoot] = pauIdx[ulChild];
+            pauIdx[ulChild] = uTmp;
+            ulRoot = ulChild;
         }
     }
-    else
-    {
-        /*  Buffer already MRU, nothing to do.
-        */
-    }
+}
+
+
+#if REDCONF_BUFFER_WRITE_GATHER_SIZE_KB != 0U
+/** @brief Write out a dirty buffer, along with dirty buffers for the blocks
+           adjacent to it.
+
+    If the buffer holds file data, the buffers for the blocks immediately
+    before and after it are examined: as long as those are also dirty,
+    unreferenced file data buffers, the run is extended, up to the size of the
+    write-gather buffer, and the whole run is written with one I/O request.
+    For example, a file which was appended to in small increments will often
+    have many dirty buffers for consecutive blocks, which this writes in one
+    request rather than one request per block.
+
+    @param uIdx The index of the buffer to write.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.  The buffers which were
+                        written are no longer dirty.
+    @retval -RED_EIO    A disk I/O error occurred.
+    @retval -RED_EINVAL Invalid parameters.
+*/
+static REDSTATUS BufferWriteGather(
+    uint16_t    uIdx)
+{
+    REDSTATUS   ret = 0;
+
+    if(uIdx >= BUFFER_COUNT)
+    {
+        REDERROR();
+        ret = -RED_EINVAL;
+    }
+    else if(!BUFFER_IS_GATHERABLE(uIdx) || (gBufCtx.aHead[uIdx].bVolNum != gbRedVolNum))
+    {
+        /*  Adjacent blocks are only looked for on the active volume.  A buffer
+            for another volume can be repurposed, but it is rare enough that
+            gathering is not worth the extra complexity.
+        */
+        ret = BufferWriteRun(&uIdx, 1U, true);
+    }
+    else
+    {
+        uint32_t    ulBlock = gBufCtx.aHead[uIdx].ulBlock;
+        uint32_t    ulFirst = ulBlock;
+        uint32_t    ulCount = 0U;
+        uint16_t    uAdjIdx;
+
+        while(    ((ulBlock - ulFirst) < (WG_BLOCKS - 1U))
+               && (ulFirst > 0U)
+               && BufferFind(ulFirst - 1U, &uAdjIdx)
+               && BUFFER_IS_GATHERABLE(uAdjIdx))
+        {
+            ulFirst--;
+        }
+
+        /*  This includes the buffer at uIdx, which is known to be gatherable.
+        */
+        while(    (ulCount < WG_BLOCKS)
+               && ((ulFirst + ulCount) < gpRedVolume->ulBlockCount)
+               && BufferFind(ulFirst + ulCount, &uAdjIdx)
+               && BUFFER_IS_GATHERABLE(uAdjIdx))
+        {
+            gBufCtx.auDirty[ulCount] = uAdjIdx;
+            ulCount++;
+        }
+
+        ret = BufferWriteRun(gBufCtx.auDirty, ulCount, true);
+    }
+
+    return ret;
+}
+#endif /* REDCONF_BUFFER_WRITE_GATHER_SIZE_KB != 0U */
+#endif /* REDCONF_READ_ONLY == 0 */
+
+
+/** @brief Choose the unreferenced buffer to repurpose.
+
+    This is the least recently used clean buffer among the CLEAN_SCAN_MAX least
+    recently used buffers, or, if they are all dirty, the LRU buffer.  Buffers
+    which are not associated with a block are never dirty.  With the segmented
+    LRU policy, the protected list is used only if the general list is empty.
+
+    Buffers held in reserve for other volumes (see VOLCONF::uBufferReserve) are
+    skipped, and do not count toward the CLEAN_SCAN_MAX limit.  If every
+    unreferenced buffer is in reserve, the reservations are not honored, since
+    the operation must not run out of buffers.
+
+    @return The index of the buffer to repurpose, or BIDX_INVALID if all buffers
+            are referenced.
+*/
+static uint16_t BufferVictim(void)
+{
+    uint16_t    uIdx = BIDX_INVALID;
+  #if REDCONF_VOLUME_COUNT > 1U
+    uint16_t    uReservedIdx = BIDX_INVALID;
+  #endif
+    uint8_t     bList;
+
+    for(bList = 0U; (bList < BLIST_COUNT) && (uIdx == BIDX_INVALID); bList++)
+    {
+        uint16_t    uScanIdx = gBufCtx.auLRU[bList];
+        uint32_t    ulScanned = 0U;
+
+        while((uScanIdx != BIDX_INVALID) && (ulScanned < CLEAN_SCAN_MAX))
+        {
+          #if REDCONF_VOLUME_COUNT > 1U
+            if(BUFFER_IS_RESERVED(uScanIdx))
+            {
+                if(uReservedIdx == BIDX_INVALID)
+                {
+                    uReservedIdx = uScanIdx;
+                }
+            }
+            else
+          #endif
+            {
+                if(uIdx == BIDX_INVALID)
+                {
+                    uIdx = uScanIdx;
+                }
+
+                if((gBufCtx.uNumDirty == 0U) || ((gBufCtx.aHead[uScanIdx].uFlags & BFLAG_DIRTY) == 0U))
+                {
+                    uIdx = uScanIdx;
+                    break;
+                }
+
+                ulScanned++;
+            }
+
+            uScanIdx = gBufCtx.aHead[uScanIdx].uNewer;
+        }
+    }
+
+  #if REDCONF_VOLUME_COUNT > 1U
+    if(uIdx == BIDX_INVALID)
+    {
+        uIdx = uReservedIdx;
+    }
+  #endif
+
+    return uIdx;
+}
+
+
+/** @brief Add an unreferenced buffer to the general list as least recently
+           used.
+
+    Used for buffers which no longer hold useful data, so that they are the
+    first to be repurposed.
+
+    @param uIdx The index of the buffer to make LRU.  Must not be in an
+                unreferenced buffer list.
+*/
+static void BufferMakeLRU(
+    uint16_t    uIdx)
+{
+    BufferListAdd(uIdx, BLIST_GENERAL, false);
+}
+
+
+/** @brief Add an unreferenced buffer to its list as most recently used.
+
+    With the segmented LRU policy, metadata buffers are added to the protected
+    list, and if that makes the protected list too long, its LRU buffer is
+    moved to the general list.  Otherwise, all buffers go in the general list.
+
+    @param uIdx The index of the buffer to make MRU.  Must not be in an
+                unreferenced buffer list.
+*/
+static void BufferMakeMRU(
+    uint16_t    uIdx)
+{
+  #if BUFFER_POLICY == BP_SLRU
+    if((uIdx < BUFFER_COUNT) && BUFFER_IS_PROTECTED(uIdx))
+    {
+        BufferListAdd(uIdx, BLIST_PROTECTED, true);
+
+        if(gBufCtx.uNumProtected > REDCONF_BUFFER_META_SEGMENT)
+        {
+            uint16_t uDemoteIdx = gBufCtx.auLRU[BLIST_PROTECTED];
+
+            BufferUnlink(uDemoteIdx);
+            BufferListAdd(uDemoteIdx, BLIST_GENERAL, true);
+        }
+    }
+    else
+  #endif
+    {
+        BufferListAdd(uIdx, BLIST_GENERAL, true);
+    }
+}
+
+
+/** @brief Add an unreferenced buffer to an unreferenced buffer list.
+
+    @param uIdx     The index of the buffer to add.  Must not be in an
+                    unreferenced buffer list.
+    @param bList    The BLIST_* value for the list to add it to.
+    @param fMRU     Whether to add the buffer as the most recently used buffer
+                    in the list; otherwise, it is added as the least recently
+                    used.
+*/
+static void BufferListAdd(
+    uint16_t    uIdx,
+    uint8_t     bList,
+    bool        fMRU)
+{
+    if((uIdx >= BUFFER_COUNT) || (bList >= BLIST_COUNT))
+    {
+        REDERROR();
+    }
+    else
+    {
+        BUFFERHEAD *pHead = &gBufCtx.aHead[uIdx];
+
+        REDASSERT(pHead->bRefCount == 0U);
+
+        if(fMRU)
+        {
+            pHead->uNewer = BIDX_INVALID;
+            pHead->uOlder = gBufCtx.auMRU[bList];
+
+            if(gBufCtx.auMRU[bList] == BIDX_INVALID)
+            {
+                gBufCtx.auLRU[bList] = uIdx;
+            }
+            else
+            {
+                gBufCtx.aHead[gBufCtx.auMRU[bList]].uNewer = uIdx;
+            }
+
+            gBufCtx.auMRU[bList] = uIdx;
+        }
+        else
+        {
+            pHead->uNewer = gBufCtx.auLRU[bList];
+            pHead->uOlder = BIDX_INVALID;
+
+            if(gBufCtx.auLRU[bList] == BIDX_INVALID)
+            {
+                gBufCtx.auMRU[bList] = uIdx;
+            }
+            else
+            {
+                gBufCtx.aHead[gBufCtx.auLRU[bList]].uOlder = uIdx;
+            }
+
+            gBufCtx.auLRU[bList] = uIdx;
+        }
+
+      #if BUFFER_POLICY == BP_SLRU
+        pHead->bList = bList;
+
+        if(bList == BLIST_PROTECTED)
+        {
+            gBufCtx.uNumProtected++;
+        }
+      #endif
+    }
+}
+
+
+/** @brief Remove a buffer from its unreferenced buffer list.
+
+    @param uIdx The index of the buffer to remove.  Must be in an unreferenced
+                buffer list.
+*/
+static void BufferUnlink(
+    uint16_t    uIdx)
+{
+    if(uIdx >= BUFFER_COUNT)
+    {
+        REDERROR();
+    }
+    else
+    {
+        BUFFERHEAD *pHead = &gBufCtx.aHead[uIdx];
+        uint8_t     bList = BUFFER_LIST(uIdx);
+
+        if(pHead->uNewer == BIDX_INVALID)
+        {
+            REDASSERT(gBufCtx.auMRU[bList] == uIdx);
+            gBufCtx.auMRU[bList] = pHead->uOlder;
+        }
+        else
+        {
+            gBufCtx.aHead[pHead->uNewer].uOlder = pHead->uOlder;
+        }
+
+        if(pHead->uOlder == BIDX_INVALID)
+        {
+            REDASSERT(gBufCtx.auLRU[bList] == uIdx);
+            gBufCtx.auLRU[bList] = pHead->uNewer;
+        }
+        else
+        {
+            gBufCtx.aHead[pHead->uOlder].uNewer = pHead->uNewer;
+        }
+
+        pHead->uNewer = BIDX_INVALID;
+        pHead->uOlder = BIDX_INVALID;
+
+      #if BUFFER_POLICY == BP_SLRU
+        if(bList == BLIST_PROTECTED)
+        {
+            REDASSERT(gBufCtx.uNumProtected > 0U);
+            gBufCtx.uNumProtected--;
+        }
+      #endif
+    }
 }
 
 
 /** @brief Find a block in the buffers.
 
     @param ulBlock  The block number to find.
-    @param pbIdx    If the block is buffered (true is returned), populated with
+    @param puIdx    If the block is buffered (true is returned), populated with
                     the index of the buffer.
 
     @return Boolean indicating whether or not the block is buffered.
 
     @retval true    @p ulBlock is buffered, and its index has been stored in
-                    @p pbIdx.
+                    @p puIdx.
     @retval false   @p ulBlock is not buffered.
 */
 static bool BufferFind(
     uint32_t ulBlock,
-    uint8_t *pbIdx)
+    uint16_t *puIdx)
 {
     bool     ret = false;
 
-    if((ulBlock >= gpRedVolume->ulBlockCount) || (pbIdx == NULL))
+    if((ulBlock >= gpRedVolume->ulBlockCount) || (puIdx == NULL))
     {
         REDERROR();
     }
     else
     {
-        uint8_t bIdx;
+        uint16_t uIdx = gBufCtx.auHashHead[BUFFER_HASH(gbRedVolNum, ulBlock)];
 
-        for(bIdx = 0U; bIdx < REDCONF_BUFFER_COUNT; bIdx++)
+        while(uIdx != BIDX_INVALID)
         {
-            const BUFFERHEAD *pHead = &gBufCtx.aHead[bIdx];
+            const BUFFERHEAD *pHead = &gBufCtx.aHead[uIdx];
 
             if((pHead->bVolNum == gbRedVolNum) && (pHead->ulBlock == ulBlock))
             {
-                *pbIdx = bIdx;
+                *puIdx = uIdx;
                 ret = true;
                 break;
             }
+
+            uIdx = pHead->uHashNext;
         }
     }
 
     return ret;
 }
 
+
+#if REDCONF_API_POSIX_SNAPSHOT == 1
+/** @brief Discard a stale buffer for a block which is about to be rewritten.
+
+    Reads in the view of the committed state can leave buffers for blocks which
+    are free in the working state.  Once the view releases them, the blocks may
+    be allocated again.  Such a buffer is clean and unreferenced, and is simply
+    dropped.  A dirty or referenced buffer is left alone, so that the caller
+    still treats it as an error.
+
+    @param ulBlock  The block which is about to be rewritten.
+*/
+static void BufferDiscardStale(
+    uint32_t    ulBlock)
+{
+    uint16_t    uIdx;
+
+    if(BufferFind(ulBlock, &uIdx))
+    {
+        BUFFERHEAD *pHead = &gBufCtx.aHead[uIdx];
+
+        if((pHead->bRefCount == 0U) && ((pHead->uFlags & BFLAG_DIRTY) == 0U))
+        {
+            BufferHashRemove(uIdx);
+            pHead->ulBlock = BBLK_INVALID;
+
+            BufferUnlink(uIdx);
+            BufferMakeLRU(uIdx);
+        }
+    }
+}
+#endif
+
+
+/** @brief Find the next buffer for the active volume in a range of blocks.
+
+    When the range is smaller than the number of buffers, each block in the
+    range is looked up in the hash table; otherwise, it is cheaper to examine
+    each buffer head.  Either way, the caller does not need to care: it simply
+    calls this function until it returns false.
+
+    The buffers are not returned in any particular order.  The caller may
+    invalidate the returned buffer before the next call.
+
+    @param ulBlockStart The first block number in the range.
+    @param ulBlockCount The number of blocks in the range.
+    @param pulPos       Iteration cursor.  Must be zero for the first call and
+                        is updated by each call.
+    @param puIdx        If a buffer is found (true is returned), populated with
+                        the index of the buffer.
+
+    @return Whether another buffer in the range was found.
+*/
+static bool BufferRangeNext(
+    uint32_t    ulBlockStart,
+    uint32_t    ulBlockCount,
+    uint32_t   *pulPos,
+    uint16_t   *puIdx)
+{
+    bool        fFound = false;
+
+    if((pulPos == NULL) || (puIdx == NULL))
+    {
+        REDERROR();
+    }
+    else if(ulBlockCount < BUFFER_COUNT)
+    {
+        while(!fFound && (*pulPos < ulBlockCount))
+        {
+            fFound = BufferFind(ulBlockStart + *pulPos, puIdx);
+            (*pulPos)++;
+        }
+    }
+    else
+    {
+        while(!fFound && (*pulPos < BUFFER_COUNT))
+        {
+            const BUFFERHEAD *pHead = &gBufCtx.aHead[*pulPos];
+
+            if(    (pHead->bVolNum == gbRedVolNum)
+                && (pHead->ulBlock != BBLK_INVALID)
+                && (pHead->ulBlock >= ulBlockStart)
+                && (pHead->ulBlock < (ulBlockStart + ulBlockCount)))
+            {
+                *puIdx = (uint16_t)*pulPos;
+                fFound = true;
+            }
+
+            (*pulPos)++;
+        }
+    }
+
+    return fFound;
+}
+
+
+/** @brief Add a buffer to the hash table.
+
+    @param uIdx The index of the buffer to add.  Its volume and block number
+                must already be populated.
+*/
+static void BufferHashInsert(
+    uint16_t    uIdx)
+{
+    if((uIdx >= BUFFER_COUNT) || (gBufCtx.aHead[uIdx].ulBlock == BBLK_INVALID))
+    {
+        REDERROR();
+    }
+    else
+    {
+        BUFFERHEAD *pHead = &gBufCtx.aHead[uIdx];
+        uint16_t    uBucket = BUFFER_HASH(pHead->bVolNum, pHead->ulBlock);
+
+        pHead->uHashNext = gBufCtx.auHashHead[uBucket];
+        gBufCtx.auHashHead[uBucket] = uIdx;
+
+      #if REDCONF_VOLUME_COUNT > 1U
+        gBufCtx.auVolBuffers[pHead->bVolNum]++;
+      #endif
+    }
+}
+
+
+#if REDCONF_READ_AHEAD_BLOCKS > 0U
+/** @brief Copy a block from the read-ahead buffer.
+
+    @param ulBlock  The block number, on the active volume, to look for.
+    @param pbBuffer If non-NULL and the block is in the read-ahead buffer,
+                    populated with the block data.  If NULL, the read-ahead
+                    buffer is only checked for the block.
+    @param fConsume Whether to invalidate the block in the read-ahead buffer
+                    after copying it.  This is done when the block is being
+                    copied into a block buffer, which from then on is the
+                    authoritative copy of the block.
+
+    @return Whether the block is in the read-ahead buffer.
+*/
+static bool BufferRaRead(
+    uint32_t    ulBlock,
+    uint8_t    *pbBuffer,
+    bool        fConsume)
+{
+    bool        fFound = false;
+
+    if(    (gBufCtx.ulRaValid != 0U)
+        && (gBufCtx.bRaVolNum == gbRedVolNum)
+        && (ulBlock >= gBufCtx.ulRaBlock)
+        && ((ulBlock - gBufCtx.ulRaBlock) < RA_BLOCKS))
+    {
+        uint32_t ulOffset = ulBlock - gBufCtx.ulRaBlock;
+        uint32_t ulBit = 1U << ulOffset;
+
+        if((gBufCtx.ulRaValid & ulBit) != 0U)
+        {
+            fFound = true;
+
+            if(pbBuffer != NULL)
+            {
+                RedMemCpy(pbBuffer, &RABUF[ulOffset << BLOCK_SIZE_P2], REDCONF_BLOCK_SIZE);
+
+                gBufCtx.ulRaUnused &= ~ulBit;
+                if(fConsume)
+                {
+                    gBufCtx.ulRaValid &= ~ulBit;
+                }
+
+                gpRedCoreVol->ullReadAheadHits++;
+            }
+        }
+    }
+
+    return fFound;
+}
+
+
+/** @brief Invalidate a range of blocks in the read-ahead buffer.
+
+    This must be done whenever the disk contents of a block might change
+    without the block being read through RedBufferGet(): the read-ahead buffer
+    must never supply stale data.
+
+    @param ulBlockStart The first block number, on the volume of the blocks in
+                        the read-ahead buffer, to invalidate.
+    @param ulBlockCount The number of blocks to invalidate.
+*/
+static void BufferRaInvalidate(
+    uint32_t    ulBlockStart,
+    uint32_t    ulBlockCount)
+{
+    if((gBufCtx.ulRaValid != 0U) && (gBufCtx.bRaVolNum == gbRedVolNum))
+    {
+        uint32_t ulOffset;
+
+        for(ulOffset = 0U; ulOffset < RA_BLOCKS; ulOffset++)
+        {
+            uint32_t ulBlock = gBufCtx.ulRaBlock + ulOffset;
+            uint32_t ulBit = 1U << ulOffset;
+
+            if(    ((gBufCtx.ulRaValid & ulBit) != 0U)
+                && (ulBlock >= ulBlockStart)
+                && ((ulBlock - ulBlockStart) < ulBlockCount))
+            {
+                if((gBufCtx.ulRaUnused & ulBit) != 0U)
+                {
+                    gaRedCoreVol[gBufCtx.bRaVolNum].ullReadAheadWasted++;
+                }
+
+                gBufCtx.ulRaValid &= ~ulBit;
+                gBufCtx.ulRaUnused &= ~ulBit;
+            }
+        }
+    }
+}
+#endif /* REDCONF_READ_AHEAD_BLOCKS > 0U */
+
+
+/** @brief Remove a buffer from the hash table.
+
+    This must be done before the volume or block number of the buffer changes,
+    since those determine the hash chain in which the buffer resides.
+
+    @param uIdx The index of the buffer to remove.
+*/
+static void BufferHashRemove(
+    uint16_t    uIdx)
+{
+    if((uIdx >= BUFFER_COUNT) || (gBufCtx.aHead[uIdx].ulBlock == BBLK_INVALID))
+    {
+        REDERROR();
+    }
+    else
+    {
+        const BUFFERHEAD   *pHead = &gBufCtx.aHead[uIdx];
+        uint16_t           *puLink = &gBufCtx.auHashHead[BUFFER_HASH(pHead->bVolNum, pHead->ulBlock)];
+
+        while((*puLink != BIDX_INVALID) && (*puLink != uIdx))
+        {
+            puLink = &gBufCtx.aHead[*puLink].uHashNext;
+        }
+
+        if(*puLink == uIdx)
+        {
+            *puLink = pHead->uHashNext;
+            gBufCtx.aHead[uIdx].uHashNext = BIDX_INVALID;
+
+          #if REDCONF_VOLUME_COUNT > 1U
+            REDASSERT(gBufCtx.auVolBuffers[pHead->bVolNum] > 0U);
+            gBufCtx.auVolBuffers[pHead->bVolNum]--;
+          #endif
+        }
+        else
+        {
+            /*  The buffer should have been in the hash table.
+            */
+            REDERROR();
+        }
+    }
+}
+
 #endif /* BUFFER_MODULE == BM_SIMPLE */
@@ -38,6 +38,9 @@ static void BufferEndianSwapInode(INODE *pInode);
 static void BufferEndianSwapIndir(INDIR *pIndir);
 #endif
 #endif
+#if BUFFER_CRC_INCREMENTAL == 1
+static uint32_t BufferCrcRangeDelta(const uint8_t *pbBuffer, const BUFFERCRC *pCrc, uint8_t bRange);
+#endif
 
 
 /** Determine whether a metadata buffer is valid.
@@ -127,6 +130,8 @@ bool RedBufferIsValid(
                 be unknown, and the check is skipped.
             */
             ulComputedCrc = RedCrcNode(pbBuffer);
+            BUFSTAT_ADD(gbRedVolNum, RedBufferStatType(uFlags), ullCrcChecks, 1U);
+
             if(pHdr->ulCRC != ulComputedCrc)
             {
                 fValid = false;
@@ -147,6 +152,49 @@ bool RedBufferIsValid(
 }
 
 
+#if (REDCONF_BUFFER_STATS == 1) || (REDCONF_TRANSACT_STATS == 1)
+/** @brief Determine the kind of block, for the buffer and transaction
+           statistics, from the buffer flags.
+
+    @param uFlags   The buffer flags.
+
+    @return The RED_BUFSTAT_* value for the kind of block.
+*/
+uint8_t RedBufferStatType(
+    uint16_t    uFlags)
+{
+    uint8_t     bType;
+
+    switch(uFlags & BFLAG_META_MASK)
+    {
+        case BFLAG_META_MASTER:
+            bType = RED_BUFSTAT_MASTER;
+            break;
+        case BFLAG_META_IMAP:
+            bType = RED_BUFSTAT_IMAP;
+            break;
+        case BFLAG_META_INODE:
+            bType = RED_BUFSTAT_INODE;
+            break;
+        case BFLAG_META_INDIR:
+            bType = RED_BUFSTAT_INDIR;
+            break;
+        case BFLAG_META_DINDIR:
+            bType = RED_BUFSTAT_DINDIR;
+            break;
+        case BFLAG_META_DIRECTORY:
+            bType = RED_BUFSTAT_DIRECTORY;
+            break;
+        default:
+            bType = RED_BUFSTAT_DATA;
+            break;
+    }
+
+    return bType;
+}
+#endif
+
+
 #if REDCONF_READ_ONLY == 0
 /** @brief Finalize a metadata buffer.
 
@@ -157,6 +205,11 @@ bool RedBufferIsValid(
     @param bVolNum  The volume number for the metadata buffer.
     @param uFlags   The associated buffer flags.  Used to determine the expected
                     signature.
+    @param pCrc     Tracks the parts of the buffer which were modified since its
+                    CRC was last known to be correct.  If NULL, or if the CRC
+                    is not known, the CRC is computed over the whole node.  On
+                    success, reset to indicate that the CRC is known and that
+                    nothing has been modified.
 
     @return A negated ::REDSTATUS code indicating the operation result.
 
@@ -166,7 +219,8 @@ bool RedBufferIsValid(
 REDSTATUS RedBufferFinalize(
     uint8_t    *pbBuffer,
     uint8_t     bVolNum,
-    uint16_t    uFlags)
+    uint16_t    uFlags,
+    BUFFERCRC  *pCrc)
 {
     REDSTATUS   ret = 0;
 
@@ -226,6 +280,13 @@ REDSTATUS RedBufferFinalize(
             {
                 uint32_t ulCrc;
 
+              #if BUFFER_CRC_INCREMENTAL == 1
+                if(pCrc != NULL)
+                {
+                    RedBufferCrcModify(pCrc, pbBuffer, NODEHEADER_OFFSET_SEQ, sizeof(ullSeqNum));
+                }
+              #endif
+
                 RedMemCpy(&pbBuffer[NODEHEADER_OFFSET_SIG], &ulSignature, sizeof(ulSignature));
                 RedMemCpy(&pbBuffer[NODEHEADER_OFFSET_SEQ], &ullSeqNum, sizeof(ullSeqNum));
 
@@ -233,11 +294,41 @@ REDSTATUS RedBufferFinalize(
                 RedBufferEndianSwap(pbBuffer, uFlags);
               #endif
 
-                ulCrc = RedCrcNode(pbBuffer);
+              #if BUFFER_CRC_INCREMENTAL == 1
+                if((pCrc != NULL) && (pCrc->bRanges != BCRC_FULL))
+                {
+                    uint8_t bIdx;
+
+                    RedMemCpy(&ulCrc, &pbBuffer[NODEHEADER_OFFSET_CRC], sizeof(ulCrc));
+
+                    for(bIdx = 0U; bIdx < pCrc->bRanges; bIdx++)
+                    {
+                        ulCrc ^= BufferCrcRangeDelta(pbBuffer, pCrc, bIdx);
+                    }
+
+                    REDASSERT(ulCrc == RedCrcNode(pbBuffer));
+                    BUFSTAT_ADD(bVolNum, RedBufferStatType(uFlags), ullCrcIncremental, 1U);
+                }
+                else
+              #endif
+                {
+                    ulCrc = RedCrcNode(pbBuffer);
+                    BUFSTAT_ADD(bVolNum, RedBufferStatType(uFlags), ullCrcFull, 1U);
+                }
+
               #ifdef REDCONF_ENDIAN_SWAP
                 ulCrc = RedRev32(ulCrc);
               #endif
                 RedMemCpy(&pbBuffer[NODEHEADER_OFFSET_CRC], &ulCrc, sizeof(ulCrc));
+
+              #if BUFFER_CRC_INCREMENTAL == 1
+                if(pCrc != NULL)
+                {
+                    RedBufferCrcReset(pCrc, true);
+                }
+              #else
+                (void)pCrc;
+              #endif
             }
         }
     }
@@ -247,6 +338,229 @@ REDSTATUS RedBufferFinalize(
 #endif /* REDCONF_READ_ONLY == 0 */
 
 
+#if BUFFER_CRC_INCREMENTAL == 1
+/** @brief Reset the CRC tracking state of a metadata buffer.
+
+    @param pCrc     The CRC tracking state to reset.
+    @param fKnown   Whether the CRC stored in the buffer is known to be correct
+                    for its current contents.  If false, the CRC will be
+                    computed over the whole node when the buffer is finalized.
+*/
+void RedBufferCrcReset(
+    BUFFERCRC  *pCrc,
+    bool        fKnown)
+{
+    if(pCrc == NULL)
+    {
+        REDERROR();
+    }
+    else
+    {
+        pCrc->bRanges = fKnown ? 0U : BCRC_FULL;
+    }
+}
+
+
+/** @brief Record that part of a metadata buffer is about to be modified.
+
+    This must be called _before_ the bytes are changed, since the CRC of their
+    original contents is computed here.  Bytes which were already recorded as
+    modified are not counted twice.
+
+    @param pCrc     The CRC tracking state for the buffer.
+    @param pbBuffer The metadata buffer, with its original contents.
+    @param ulOffset Offset of the first byte which will be modified.
+    @param ulLength Number of bytes which will be modified.
+*/
+void RedBufferCrcModify(
+    BUFFERCRC      *pCrc,
+    const uint8_t  *pbBuffer,
+    uint32_t        ulOffset,
+    uint32_t        ulLength)
+{
+    if(    (pCrc == NULL)
+        || (pbBuffer == NULL)
+        || (ulOffset < NODEHEADER_OFFSET_SEQ)
+        || (ulOffset > REDCONF_BLOCK_SIZE)
+        || (ulLength > (REDCONF_BLOCK_SIZE - ulOffset)))
+    {
+        REDERROR();
+    }
+    else if((pCrc->bRanges != BCRC_FULL) && (ulLength > 0U))
+    {
+        uint32_t    ulEnd = ulOffset + ulLength;
+        uint8_t     bFirst = 0U;
+        uint8_t     bLast;
+
+        /*  Find the existing ranges which overlap or abut the new range: these
+            are [bFirst, bLast).
+        */
+        while((bFirst < pCrc->bRanges) && (pCrc->aulEnd[bFirst] < ulOffset))
+        {
+            bFirst++;
+        }
+
+        bLast = bFirst;
+        while((bLast < pCrc->bRanges) && (pCrc->aulStart[bLast] <= ulEnd))
+        {
+            bLast++;
+        }
+
+        /*  Nothing to do if the bytes are already covered, which is common,
+            since the same fields tend to be updated repeatedly.
+        */
+        if(    (bLast != (bFirst + 1U))
+            || (pCrc->aulStart[bFirst] > ulOffset)
+            || (pCrc->aulEnd[bFirst] < ulEnd))
+        {
+            uint32_t    aulOldCrc[BCRC_RANGES + 1U];
+            uint32_t    aulStart[BCRC_RANGES + 1U];
+            uint32_t    aulEnd[BCRC_RANGES + 1U];
+            uint32_t    ulMergedStart = ulOffset;
+            uint32_t    ulMergedEnd = ulEnd;
+            uint32_t    ulMergedCrc = 0U;
+            uint32_t    ulPos;
+            uint32_t    ulBytes = 0U;
+            uint8_t     bCount = 0U;
+            uint8_t     bIdx;
+
+            if(bLast > bFirst)
+            {
+                ulMergedStart = REDMIN(ulOffset, pCrc->aulStart[bFirst]);
+                ulMergedEnd = REDMAX(ulEnd, pCrc->aulEnd[bLast - 1U]);
+            }
+
+            /*  Compute the CRC of the original contents of the merged range:
+                newly covered bytes are read from the buffer, and the saved CRCs
+                of the existing ranges are spliced in between them.
+            */
+            ulPos = ulMergedStart;
+            for(bIdx = bFirst; bIdx < bLast; bIdx++)
+            {
+                if(pCrc->aulStart[bIdx] > ulPos)
+                {
+                    ulMergedCrc = RedCrc32Update(ulMergedCrc, &pbBuffer[ulPos], pCrc->aulStart[bIdx] - ulPos);
+                }
+
+                ulMergedCrc = RedCrc32Combine(ulMergedCrc, pCrc->aulOldCrc[bIdx], pCrc->aulEnd[bIdx] - pCrc->aulStart[bIdx]);
+                ulPos = pCrc->aulEnd[bIdx];
+            }
+
+            if(ulMergedEnd > ulPos)
+            {
+                ulMergedCrc = RedCrc32Update(ulMergedCrc, &pbBuffer[ulPos], ulMergedEnd - ulPos);
+            }
+
+            /*  Rebuild the list, with the merged range replacing the ranges it
+                absorbed.
+            */
+            for(bIdx = 0U; bIdx < pCrc->bRanges; bIdx++)
+            {
+                if(bIdx == bFirst)
+                {
+                    aulOldCrc[bCount] = ulMergedCrc;
+                    aulStart[bCount] = ulMergedStart;
+                    aulEnd[bCount] = ulMergedEnd;
+                    bCount++;
+                }
+
+                if((bIdx < bFirst) || (bIdx >= bLast))
+                {
+                    aulOldCrc[bCount] = pCrc->aulOldCrc[bIdx];
+                    aulStart[bCount] = pCrc->aulStart[bIdx];
+                    aulEnd[bCount] = pCrc->aulEnd[bIdx];
+                    bCount++;
+                }
+            }
+
+            if(bFirst == pCrc->bRanges)
+            {
+                aulOldCrc[bCount] = ulMergedCrc;
+                aulStart[bCount] = ulMergedStart;
+                aulEnd[bCount] = ulMergedEnd;
+                bCount++;
+            }
+
+            /*  If there are too many ranges, coalesce the pair which are
+                closest together, along with the original contents of the gap
+                between them.
+            */
+            if(bCount > BCRC_RANGES)
+            {
+                uint8_t bClosest = 0U;
+
+                for(bIdx = 1U; bIdx < (bCount - 1U); bIdx++)
+                {
+                    if((aulStart[bIdx + 1U] - aulEnd[bIdx]) < (aulStart[bClosest + 1U] - aulEnd[bClosest]))
+                    {
+                        bClosest = bIdx;
+                    }
+                }
+
+                aulOldCrc[bClosest] = RedCrc32Update(aulOldCrc[bClosest], &pbBuffer[aulEnd[bClosest]], aulStart[bClosest + 1U] - aulEnd[bClosest]);
+                aulOldCrc[bClosest] = RedCrc32Combine(aulOldCrc[bClosest], aulOldCrc[bClosest + 1U], aulEnd[bClosest + 1U] - aulStart[bClosest + 1U]);
+                aulEnd[bClosest] = aulEnd[bClosest + 1U];
+
+                for(bIdx = bClosest + 1U; bIdx < (bCount - 1U); bIdx++)
+                {
+                    aulOldCrc[bIdx] = aulOldCrc[bIdx + 1U];
+                    aulStart[bIdx] = aulStart[bIdx + 1U];
+                    aulEnd[bIdx] = aulEnd[bIdx + 1U];
+                }
+
+                bCount--;
+            }
+
+            for(bIdx = 0U; bIdx < bCount; bIdx++)
+            {
+                pCrc->aulOldCrc[bIdx] = aulOldCrc[bIdx];
+                pCrc->aulStart[bIdx] = aulStart[bIdx];
+                pCrc->aulEnd[bIdx] = aulEnd[bIdx];
+                ulBytes += aulEnd[bIdx] - aulStart[bIdx];
+            }
+
+            pCrc->bRanges = (ulBytes > BCRC_MAX_BYTES) ? BCRC_FULL : bCount;
+        }
+    }
+    else
+    {
+        /*  Nothing to record.
+        */
+    }
+}
+
+
+/** @brief Compute the change to a node CRC caused by modifying a range.
+
+    @param pbBuffer The metadata buffer, with its new contents.
+    @param pCrc     The CRC tracking state for the buffer.
+    @param bRange   The index of the modified range in @p pCrc.
+
+    @return The value to XOR into the stored node CRC to account for the
+            changes to the range.
+*/
+static uint32_t BufferCrcRangeDelta(
+    const uint8_t      *pbBuffer,
+    const BUFFERCRC    *pCrc,
+    uint8_t             bRange)
+{
+    uint32_t            ulStart = pCrc->aulStart[bRange];
+    uint32_t            ulEnd = pCrc->aulEnd[bRange];
+    uint32_t            ulDelta;
+
+    REDASSERT((ulStart >= NODEHEADER_OFFSET_SEQ) && (ulStart < ulEnd) && (ulEnd <= REDCONF_BLOCK_SIZE));
+
+    /*  The old and new contents of the range have the same length, so the
+        difference between their CRCs is the same wherever the range is.  Shift
+        it by the number of bytes which follow the range in the node.
+    */
+    ulDelta = pCrc->aulOldCrc[bRange] ^ RedCrc32Update(0U, &pbBuffer[ulStart], ulEnd - ulStart);
+
+    return RedCrc32Combine(ulDelta, 0U, REDCONF_BLOCK_SIZE - ulEnd);
+}
+#endif /* BUFFER_CRC_INCREMENTAL == 1 */
+
+
 #ifdef REDCONF_ENDIAN_SWAP
 /** @brief Swap the byte order of a metadata buffer
 
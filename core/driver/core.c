@@ -53,6 +53,9 @@ static REDSTATUS CoreFileTruncate(uint32_t ulInode, uint64_t ullSize);
 #if (REDCONF_READ_ONLY == 0) && (REDCONF_API_POSIX == 1) && (REDCONF_API_POSIX_FRESERVE == 1)
 static REDSTATUS CoreFileReserve(uint32_t ulInode, uint64_t ullOffset, uint64_t ullLen);
 #endif
+#if (REDCONF_READ_ONLY == 0) && (REDCONF_API_POSIX == 1) && (REDCONF_API_POSIX_DEFRAG == 1)
+static REDSTATUS CoreFileDefrag(uint32_t ulInode);
+#endif
 
 #if REDCONF_READ_ONLY == 0
 static REDSTATUS CoreFull(void);
@@ -86,6 +89,7 @@ CONST_IF_ONE_VOLUME uint8_t gbRedVolNum;
 
     @retval 0           Operation was successful.
     @retval -RED_EINVAL Invalid configuration parameters.
+    @retval -RED_ENOMEM The block buffers could not be allocated.
 */
 REDSTATUS RedCoreInit(void)
 {
@@ -111,8 +115,6 @@ REDSTATUS RedCoreInit(void)
     RedMemSet(gaRedVolume, 0U, sizeof(gaRedVolume));
     RedMemSet(gaRedCoreVol, 0U, sizeof(gaRedCoreVol));
 
-    RedBufferInit();
-
     for(bVolNum = 0U; bVolNum < REDCONF_VOLUME_COUNT; bVolNum++)
     {
       #if REDCONF_API_POSIX == 1
@@ -153,6 +155,11 @@ REDSTATUS RedCoreInit(void)
 
       #if REDCONF_READ_ONLY == 0
         gaRedVolume[bVolNum].ulTransMask = REDCONF_TRANSACT_DEFAULT;
+      #endif
+      #if REDCONF_TRANSACT_AUTO == 1
+        gaRedVolume[bVolNum].transPolicy.ulDirtyBlocks = REDCONF_TRANSACT_DIRTY_BLOCKS;
+        gaRedVolume[bVolNum].transPolicy.ullWriteBytes = REDCONF_TRANSACT_WRITE_BYTES;
+        gaRedVolume[bVolNum].transPolicy.ulIntervalMs = REDCONF_TRANSACT_INTERVAL_MS;
       #endif
         gaRedVolume[bVolNum].ullMaxInodeSize = INODE_SIZE_MAX;
     }
@@ -177,6 +184,11 @@ REDSTATUS RedCoreInit(void)
         }
     }
 
+    if(ret == 0)
+    {
+        ret = RedBufferInit(REDCONF_BUFFER_COUNT);
+    }
+
     if(ret == 0)
     {
         ret = RedOsClockInit();
@@ -192,6 +204,13 @@ REDSTATUS RedCoreInit(void)
             }
         }
       #endif
+
+      #if REDOSCONF_BUFFER_ALLOC == 1
+        if(ret != 0)
+        {
+            RedBufferUninit();
+        }
+      #endif
     }
 
     return ret;
@@ -225,8 +244,53 @@ REDSTATUS RedCoreUninit(void)
         ret = RedOsClockUninit();
     }
 
+  #if REDOSCONF_BUFFER_ALLOC == 1
+    if(ret == 0)
+    {
+        RedBufferUninit();
+    }
+  #endif
+
+    return ret;
+}
+
+
+#if REDOSCONF_BUFFER_ALLOC == 1
+/** @brief Change the number of block buffers.
+
+    The buffers are reallocated, so this can only be done while no buffers are
+    dirty: that is, after a transaction point on every mounted volume (and
+    before any further changes).  The contents of the buffers are discarded.
+
+    @param ulBufferCount    The new number of block buffers.  Must be at least
+                            the minimum number of buffers needed by the
+                            configuration.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EBUSY  There are dirty buffers.
+    @retval -RED_EINVAL @p ulBufferCount is too small or too large.
+    @retval -RED_ENOMEM Insufficient memory for @p ulBufferCount buffers.  The
+                        existing buffers are unchanged.
+*/
+REDSTATUS RedCoreBufferResize(
+    uint32_t    ulBufferCount)
+{
+    REDSTATUS   ret;
+
+    if(ulBufferCount > UINT16_MAX)
+    {
+        ret = -RED_EINVAL;
+    }
+    else
+    {
+        ret = RedBufferResize((uint16_t)ulBufferCount);
+    }
+
     return ret;
 }
+#endif
 
 
 /** @brief Set the current volume.
@@ -257,7 +321,11 @@ REDSTATUS RedCoreVolSetCurrent(
         gpRedVolConf = &gaRedVolConf[bVolNum];
         gpRedVolume = &gaRedVolume[bVolNum];
         gpRedCoreVol = &gaRedCoreVol[bVolNum];
+      #if REDCONF_API_POSIX_SNAPSHOT == 1
+        gpRedMR = gpRedCoreVol->fViewEntered ? &gpRedCoreVol->ViewMR : &gpRedCoreVol->aMR[gpRedCoreVol->bCurMR];
+      #else
         gpRedMR = &gpRedCoreVol->aMR[gpRedCoreVol->bCurMR];
+      #endif
       #endif
 
         ret = 0;
@@ -433,6 +501,407 @@ REDSTATUS RedCoreVolRollback(void)
 
     return ret;
 }
+
+
+#if REDCONF_BUFFER_CLEAN_LOW_WATER > 0U
+/** @brief Write back dirty buffers ahead of the next transaction point.
+
+    Writes the least recently used dirty buffers of the volume until at least
+    #REDCONF_BUFFER_CLEAN_LOW_WATER buffers are clean, so that later operations
+    seldom have to wait for a dirty buffer to be written before they can reuse
+    it.  The written data is part of the working state: nothing is committed.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EINVAL The volume is not mounted.
+    @retval -RED_EIO    A disk I/O error occurred.
+    @retval -RED_EROFS  The file system volume is read-only.
+*/
+REDSTATUS RedCoreVolWriteBack(void)
+{
+    REDSTATUS ret;
+
+    if(!gpRedVolume->fMounted)
+    {
+        ret = -RED_EINVAL;
+    }
+    else if(gpRedVolume->fReadOnly)
+    {
+        ret = -RED_EROFS;
+    }
+    else
+    {
+        ret = RedBufferWriteBack(REDCONF_BUFFER_CLEAN_LOW_WATER);
+    }
+
+    return ret;
+}
+#endif /* REDCONF_BUFFER_CLEAN_LOW_WATER > 0U */
+
+
+#if REDCONF_TRANSACT_ASYNC == 1
+/** @brief Start an asynchronous transaction point.
+
+    The working state is written and the new metaroot is prepared, but the
+    metaroot is not written: RedCoreVolTransactCommit() does that, and may be
+    called without holding the file system mutex.  RedCoreVolTransactFinish()
+    must be called afterward.  Until then, the volume may be read but must not
+    be modified.
+
+    If the volume has no uncommitted changes, no commit is started; use
+    RedCoreVolCommitPending() to find out whether one was.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EBUSY  An asynchronous transaction point is already pending.
+    @retval -RED_EINVAL The volume is not mounted.
+    @retval -RED_EIO    A disk I/O error occurred.
+    @retval -RED_EROFS  The file system volume is read-only.
+*/
+REDSTATUS RedCoreVolTransactStart(void)
+{
+    REDSTATUS ret;
+
+    if(!gpRedVolume->fMounted)
+    {
+        ret = -RED_EINVAL;
+    }
+    else if(gpRedVolume->fReadOnly)
+    {
+        ret = -RED_EROFS;
+    }
+    else if(gpRedCoreVol->fCommitPending)
+    {
+        ret = -RED_EBUSY;
+    }
+    else
+    {
+        ret = RedVolTransactStart();
+    }
+
+    return ret;
+}
+
+
+/** @brief Write the metaroot of a pending asynchronous transaction point.
+
+    @param bVolNum  The volume number of the volume with the pending commit.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EINVAL @p bVolNum is not a volume with a pending commit.
+    @retval -RED_EIO    A disk I/O error occurred.
+*/
+REDSTATUS RedCoreVolTransactCommit(
+    uint8_t     bVolNum)
+{
+    REDSTATUS   ret;
+
+    if(!RedCoreVolCommitPending(bVolNum))
+    {
+        REDERROR();
+        ret = -RED_EINVAL;
+    }
+    else
+    {
+        ret = RedVolTransactCommit(bVolNum);
+    }
+
+    return ret;
+}
+
+
+/** @brief Finish a pending asynchronous transaction point.
+
+    @param iCommitRet   The value returned by RedCoreVolTransactCommit().
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EINVAL The volume has no pending commit.
+    @retval -RED_EIO    A disk I/O error occurred.
+*/
+REDSTATUS RedCoreVolTransactFinish(
+    REDSTATUS   iCommitRet)
+{
+    REDSTATUS   ret;
+
+    if(!gpRedCoreVol->fCommitPending)
+    {
+        REDERROR();
+        ret = -RED_EINVAL;
+    }
+    else
+    {
+        ret = RedVolTransactFinish(iCommitRet);
+    }
+
+    return ret;
+}
+
+
+/** @brief Determine whether a volume has a pending asynchronous transaction
+           point.
+
+    @param bVolNum  The volume number of the volume to check.
+
+    @return Whether RedCoreVolTransactStart() started a commit on the volume
+            which has not yet been finished by RedCoreVolTransactFinish().
+*/
+bool RedCoreVolCommitPending(
+    uint8_t bVolNum)
+{
+    return (bVolNum < REDCONF_VOLUME_COUNT) && gaRedCoreVol[bVolNum].fCommitPending;
+}
+#endif /* REDCONF_TRANSACT_ASYNC == 1 */
+
+
+#if (REDCONF_TRANSACT_GROUP == 1) || (REDCONF_TRANSACT_AUTO == 1)
+/** @brief Determine whether an inode, or the volume, has uncommitted changes.
+
+    An inode is branched when it, or the data or directory entries it points
+    at, has been modified since the last transaction point.  An inode which is
+    not branched needs no transaction point to make it durable.
+
+    @param ulInode      The inode number to check; or #INODE_INVALID to check
+                        whether anything on the volume has been modified since
+                        the last transaction point.
+    @param pfBranched   On successful return, populated with whether the inode
+                        or volume is branched.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EBADF  @p ulInode is not a valid inode.
+    @retval -RED_EINVAL The volume is not mounted; or @p pfBranched is `NULL`.
+    @retval -RED_EIO    A disk I/O error occurred.
+*/
+REDSTATUS RedCoreIsBranched(
+    uint32_t    ulInode,
+    bool       *pfBranched)
+{
+    REDSTATUS   ret = 0;
+
+    if(!gpRedVolume->fMounted || (pfBranched == NULL))
+    {
+        ret = -RED_EINVAL;
+    }
+    else if(ulInode == INODE_INVALID)
+    {
+        *pfBranched = gpRedCoreVol->fBranched;
+    }
+    else
+    {
+        CINODE ino;
+
+        ino.ulInode = ulInode;
+        ret = RedInodeMount(&ino, FTYPE_ANY, false);
+        if(ret == 0)
+        {
+            *pfBranched = ino.fBranched;
+
+            RedInodePut(&ino, 0U);
+        }
+    }
+
+    return ret;
+}
+#endif /* (REDCONF_TRANSACT_GROUP == 1) || (REDCONF_TRANSACT_AUTO == 1) */
+
+
+#if REDCONF_API_POSIX_SNAPSHOT == 1
+/** @brief Open a handle in the view of the committed state of the volume.
+
+    The first handle takes a copy of the committed state metaroot: the view is
+    the committed state as of that moment, and all handles in the view share it
+    until the last one is closed.  Transaction points go on being made while
+    the view is open.  Blocks which the view uses are held rather than becoming
+    free, and inodes and imap nodes of the view are pinned, that is, copied
+    elsewhere, before the working state overwrites them.  #REDCONF_SNAPSHOT_PINS
+    blocks are set aside for the copies when the view is opened.  If more are
+    needed, the view is abandoned: its blocks are released, and reads in it
+    fail with #RED_EIO until its last handle is closed.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EBUSY  An asynchronous transaction point is pending.
+    @retval -RED_EINVAL The volume is not mounted.
+    @retval -RED_EIO    The open view was abandoned.
+    @retval -RED_ENOSPC There are not enough free blocks to set aside for
+                        pinning.
+*/
+REDSTATUS RedCoreViewOpen(void)
+{
+    REDSTATUS ret;
+
+    if(!gpRedVolume->fMounted)
+    {
+        ret = -RED_EINVAL;
+    }
+    else if(gpRedCoreVol->ulViewRefs > 0U)
+    {
+        if(gpRedCoreVol->fViewLost)
+        {
+            ret = -RED_EIO;
+        }
+        else
+        {
+            gpRedCoreVol->ulViewRefs++;
+            ret = 0;
+        }
+    }
+  #if REDCONF_TRANSACT_ASYNC == 1
+    else if(gpRedCoreVol->fCommitPending)
+    {
+        /*  Until the metaroot is written, the committed state is still the
+            previous one.
+        */
+        ret = -RED_EBUSY;
+    }
+  #endif
+    else if(RedVolFreeBlockCount() < REDCONF_SNAPSHOT_PINS)
+    {
+        ret = -RED_ENOSPC;
+    }
+    else
+    {
+        gpRedCoreVol->ViewMR = gpRedCoreVol->aMR[1U - gpRedCoreVol->bCurMR];
+
+        /*  Almost free blocks are used by the committed state, and thus by the
+            view.
+        */
+        gpRedCoreVol->ulViewAlmostFree = gpRedCoreVol->ulAlmostFreeBlocks;
+        gpRedCoreVol->ulViewHeld = REDCONF_SNAPSHOT_PINS;
+
+        /*  Inode slots freed since the last transaction point were not
+            recorded, so if the volume is branched, all of them must be
+            examined at the next transaction point.
+        */
+        gpRedCoreVol->ulViewFreedSlots = 0U;
+        gpRedCoreVol->fViewSlotScan = gpRedCoreVol->fBranched;
+        gpRedCoreVol->ulViewRefs = 1U;
+        ret = 0;
+    }
+
+    return ret;
+}
+
+
+/** @brief Close a handle in the view of the committed state of the volume.
+
+    Once the last handle is closed, the blocks held for the view can be
+    allocated again.
+*/
+void RedCoreViewClose(void)
+{
+    if(gpRedCoreVol->ulViewRefs == 0U)
+    {
+        REDERROR();
+    }
+    else
+    {
+        gpRedCoreVol->ulViewRefs--;
+
+        if(gpRedCoreVol->ulViewRefs == 0U)
+        {
+            RedImapViewRelease();
+            gpRedCoreVol->fViewLost = false;
+        }
+    }
+}
+
+
+/** @brief Make the view of the committed state of a volume current, so that
+           core operations on it see the view.
+
+    The metaroot of the view replaces the working state metaroot, and the
+    volume is made read-only, so that nothing is modified until
+    RedCoreViewLeave() is called.  Does nothing if the view has already been
+    entered.
+
+    @param bVolNum  The volume number of the volume.
+*/
+void RedCoreViewEnter(
+    uint8_t     bVolNum)
+{
+    if(bVolNum >= REDCONF_VOLUME_COUNT)
+    {
+        REDERROR();
+    }
+    else if(!gaRedCoreVol[bVolNum].fViewEntered)
+    {
+        COREVOLUME *pCoreVol = &gaRedCoreVol[bVolNum];
+        VOLUME     *pVolume = &gaRedVolume[bVolNum];
+
+        pCoreVol->fViewReadOnly = pVolume->fReadOnly;
+        pVolume->fReadOnly = true;
+        pCoreVol->fViewEntered = true;
+
+        if(bVolNum == gbRedVolNum)
+        {
+            gpRedMR = &pCoreVol->ViewMR;
+        }
+    }
+    else
+    {
+        /*  Already entered.
+        */
+    }
+}
+
+
+/** @brief Make the working state of a volume current again, after
+           RedCoreViewEnter().
+
+    Does nothing if the view has not been entered.
+
+    @param bVolNum  The volume number of the volume.
+*/
+void RedCoreViewLeave(
+    uint8_t     bVolNum)
+{
+    if(bVolNum >= REDCONF_VOLUME_COUNT)
+    {
+        REDERROR();
+    }
+    else if(gaRedCoreVol[bVolNum].fViewEntered)
+    {
+        COREVOLUME *pCoreVol = &gaRedCoreVol[bVolNum];
+
+        gaRedVolume[bVolNum].fReadOnly = pCoreVol->fViewReadOnly;
+        pCoreVol->fViewEntered = false;
+
+        if(bVolNum == gbRedVolNum)
+        {
+            gpRedMR = &pCoreVol->aMR[pCoreVol->bCurMR];
+        }
+    }
+    else
+    {
+        /*  Not entered.
+        */
+    }
+}
+
+
+/** @brief Determine whether the view of the committed state of a volume is
+           current.
+
+    @param bVolNum  The volume number of the volume to check.
+
+    @return Whether RedCoreViewEnter() has been called for the volume, and
+            RedCoreViewLeave() has not been called since.
+*/
+bool RedCoreViewIsEntered(
+    uint8_t bVolNum)
+{
+    return (bVolNum < REDCONF_VOLUME_COUNT) && gaRedCoreVol[bVolNum].fViewEntered;
+}
+#endif /* REDCONF_API_POSIX_SNAPSHOT == 1 */
 #endif /* REDCONF_READ_ONLY == 0 */
 
 
@@ -495,6 +964,73 @@ REDSTATUS RedCoreVolStat(
 }
 
 
+#if REDCONF_BUFFER_STATS == 1
+/** @brief Get the buffer statistics for the current volume.
+
+    The counters accumulate from the time the driver is initialized; they are
+    not reset by mount or unmount, so the volume need not be mounted.
+
+    @param pStats   Populated with the buffer statistics for the volume.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EINVAL @p pStats is `NULL`.
+*/
+REDSTATUS RedCoreBufferStats(
+    REDBUFSTATS    *pStats)
+{
+    REDSTATUS       ret;
+
+    if(pStats == NULL)
+    {
+        ret = -RED_EINVAL;
+    }
+    else
+    {
+        RedMemCpy(pStats, &gpRedCoreVol->bufStats, sizeof(*pStats));
+        ret = 0;
+    }
+
+    return ret;
+}
+#endif
+
+
+#if REDCONF_TRANSACT_STATS == 1
+/** @brief Get the write amplification statistics for the most recent
+           transaction point on the current volume.
+
+    The statistics are all zero until the first transaction point after the
+    driver is initialized.  They are not reset by mount or unmount.
+
+    @param pStats   Populated with the transaction statistics for the volume.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EINVAL @p pStats is `NULL`.
+*/
+REDSTATUS RedCoreTransactStats(
+    REDTRANSTATS   *pStats)
+{
+    REDSTATUS       ret;
+
+    if(pStats == NULL)
+    {
+        ret = -RED_EINVAL;
+    }
+    else
+    {
+        RedMemCpy(pStats, &gpRedCoreVol->lastTransStats, sizeof(*pStats));
+        ret = 0;
+    }
+
+    return ret;
+}
+#endif
+
+
 #if DELETE_SUPPORTED && (REDCONF_DELETE_OPEN == 1)
 /** @brief Free inodes which were orphaned prior to the most recent mount of the
            volume (defunct orphans).
@@ -646,6 +1182,73 @@ REDSTATUS RedCoreTransMaskGet(
 #endif
 
 
+#if REDCONF_TRANSACT_AUTO == 1
+/** @brief Set the automatic transaction policy.
+
+    The policy supplements the transaction mask: a transaction point is made
+    when any of its thresholds is reached, even if the operation which reached
+    it is not in the transaction mask.
+
+    @param pPolicy  The automatic transaction policy to set.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EINVAL The volume is not mounted; or @p pPolicy is `NULL`.
+    @retval -RED_EROFS  The file system volume is read-only.
+*/
+REDSTATUS RedCoreTransPolicySet(
+    const REDTRANSPOLICY   *pPolicy)
+{
+    REDSTATUS               ret;
+
+    if(!gpRedVolume->fMounted || (pPolicy == NULL))
+    {
+        ret = -RED_EINVAL;
+    }
+    else if(gpRedVolume->fReadOnly)
+    {
+        ret = -RED_EROFS;
+    }
+    else
+    {
+        gpRedVolume->transPolicy = *pPolicy;
+        ret = 0;
+    }
+
+    return ret;
+}
+
+
+/** @brief Read the automatic transaction policy.
+
+    @param pPolicy  Populated with the current automatic transaction policy.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EINVAL The volume is not mounted; or @p pPolicy is `NULL`.
+*/
+REDSTATUS RedCoreTransPolicyGet(
+    REDTRANSPOLICY *pPolicy)
+{
+    REDSTATUS       ret;
+
+    if(!gpRedVolume->fMounted || (pPolicy == NULL))
+    {
+        ret = -RED_EINVAL;
+    }
+    else
+    {
+        *pPolicy = gpRedVolume->transPolicy;
+        ret = 0;
+    }
+
+    return ret;
+}
+#endif
+
+
 #if (REDCONF_READ_ONLY == 0) && (REDCONF_API_POSIX == 1)
 /** @brief Create a file or directory.
 
@@ -2194,6 +2797,10 @@ REDSTATUS RedCoreFileWrite(
 
         if(ret == 0)
         {
+          #if REDCONF_TRANSACT_AUTO == 1
+            gpRedCoreVol->ullAutoBytes += *pulLen;
+          #endif
+
             ret = CoreAutoTransact(RED_TRANSACT_WRITE);
         }
     }
@@ -2585,6 +3192,152 @@ REDSTATUS RedCoreFileUnreserve(
 #endif /* (REDCONF_READ_ONLY == 0) && (REDCONF_API_POSIX == 1) && (REDCONF_API_POSIX_FRESERVE == 1) */
 
 
+#if (REDCONF_API_POSIX == 1) && (REDCONF_API_POSIX_DEFRAG == 1)
+/** @brief Count the extents of the data of a file.
+
+    @param ulInode      The inode of the file.
+    @param pulExtents   On successful return, populated with the number of runs
+                        of file blocks which are contiguous on disk.
+    @param pulBlocks    On successful return, populated with the number of
+                        allocated data blocks.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0               Operation was successful.
+    @retval -RED_EBADF      @p ulInode is not a valid inode number.
+    @retval -RED_EINVAL     The volume is not mounted; or @p pulExtents or
+                            @p pulBlocks is `NULL`.
+    @retval -RED_EIO        A disk I/O error occurred.
+    @retval -RED_EISDIR     @p ulInode is a directory inode.
+    @retval -RED_ENOLINK    #REDCONF_API_POSIX_SYMLINK is enabled and @p ulInode
+                            is a symbolic link.
+*/
+REDSTATUS RedCoreFileExtents(
+    uint32_t    ulInode,
+    uint32_t   *pulExtents,
+    uint32_t   *pulBlocks)
+{
+    REDSTATUS   ret;
+
+    if(!gpRedVolume->fMounted || (pulExtents == NULL) || (pulBlocks == NULL))
+    {
+        ret = -RED_EINVAL;
+    }
+    else
+    {
+        CINODE ino;
+
+        ino.ulInode = ulInode;
+        ret = RedInodeMount(&ino, FTYPE_FILE, false);
+        if(ret == 0)
+        {
+            ret = RedInodeDataExtents(&ino, pulExtents, pulBlocks);
+
+            RedInodePut(&ino, 0U);
+        }
+    }
+
+    return ret;
+}
+
+
+#if REDCONF_READ_ONLY == 0
+/** @brief Move the data of a file into contiguous blocks.
+
+    The file data is unchanged, so the file timestamps are not updated.  For
+    automatic transactions, this counts as a write.
+
+    @param ulInode  The inode of the file to defragment.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0               Operation was successful.
+    @retval -RED_EBADF      @p ulInode is not a valid inode number.
+    @retval -RED_EINVAL     The volume is not mounted.
+    @retval -RED_EIO        A disk I/O error occurred.
+    @retval -RED_EISDIR     @p ulInode is a directory inode.
+    @retval -RED_ENOLINK    #REDCONF_API_POSIX_SYMLINK is enabled and @p ulInode
+                            is a symbolic link.
+    @retval -RED_ENOSPC     There is not enough free space for a second copy of
+                            the file data.
+    @retval -RED_EROFS      The file system volume is read-only.
+*/
+REDSTATUS RedCoreFileDefrag(
+    uint32_t    ulInode)
+{
+    REDSTATUS   ret;
+
+    if(!gpRedVolume->fMounted)
+    {
+        ret = -RED_EINVAL;
+    }
+    else if(gpRedVolume->fReadOnly)
+    {
+        ret = -RED_EROFS;
+    }
+    else
+    {
+        ret = CoreFileDefrag(ulInode);
+
+        /*  Nothing was moved if there was not enough free space, so it is safe
+            to try again after freeing up the almost free blocks.
+        */
+        if(ret == -RED_ENOSPC)
+        {
+            ret = CoreFull();
+
+            if(ret == 0)
+            {
+                ret = CoreFileDefrag(ulInode);
+            }
+        }
+
+        if(ret == 0)
+        {
+            ret = CoreAutoTransact(RED_TRANSACT_WRITE);
+        }
+    }
+
+    return ret;
+}
+
+
+/** @brief Move the data of a file into contiguous blocks.
+
+    @param ulInode  The inode of the file to defragment.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0               Operation was successful.
+    @retval -RED_EBADF      @p ulInode is not a valid inode number.
+    @retval -RED_EIO        A disk I/O error occurred.
+    @retval -RED_EISDIR     @p ulInode is a directory inode.
+    @retval -RED_ENOLINK    #REDCONF_API_POSIX_SYMLINK is enabled and @p ulInode
+                            is a symbolic link.
+    @retval -RED_ENOSPC     There is not enough free space for a second copy of
+                            the file data.
+*/
+static REDSTATUS CoreFileDefrag(
+    uint32_t    ulInode)
+{
+    CINODE      ino;
+    REDSTATUS   ret;
+
+    ino.ulInode = ulInode;
+    ret = RedInodeMount(&ino, FTYPE_FILE, false);
+    if(ret == 0)
+    {
+        ret = RedInodeDataDefrag(&ino);
+
+        RedInodePut(&ino, 0U);
+    }
+
+    return ret;
+}
+#endif /* REDCONF_READ_ONLY == 0 */
+#endif /* (REDCONF_API_POSIX == 1) && (REDCONF_API_POSIX_DEFRAG == 1) */
+
+
 #if REDCONF_API_POSIX == 1
 /** @brief Read from a directory.
 
@@ -2733,6 +3486,13 @@ static REDSTATUS CoreFull(void)
     {
         uint32_t ulFreeBlocks = gpRedMR->ulFreeBlocks;
 
+      #if REDCONF_API_POSIX_SNAPSHOT == 1
+        /*  Blocks which a transaction point frees, but which are held for the
+            view of the committed state, cannot be allocated.
+        */
+        ulFreeBlocks -= gpRedCoreVol->ulViewHeld;
+      #endif
+
       #if DELETE_SUPPORTED && (REDCONF_DELETE_OPEN == 1)
         if(gpRedMR->ulDefunctOrphanHead != INODE_INVALID)
         {
@@ -2751,7 +3511,11 @@ static REDSTATUS CoreFull(void)
         /*  A transaction or finishing deletions may have succeeded without
             freeing any blocks.
         */
+      #if REDCONF_API_POSIX_SNAPSHOT == 1
+        if((ret == 0) && ((gpRedMR->ulFreeBlocks - gpRedCoreVol->ulViewHeld) <= ulFreeBlocks))
+      #else
         if((ret == 0) && (gpRedMR->ulFreeBlocks <= ulFreeBlocks))
+      #endif
         {
             ret = -RED_ENOSPC;
         }
@@ -2767,6 +3531,10 @@ static REDSTATUS CoreFull(void)
 
 /** @brief Perform an automatic transaction, if appropriate.
 
+    A transaction point is made if @p ulTransFlag is in the transaction mask,
+    or if one of the block or byte thresholds in the transaction policy has
+    been reached.
+
     @param  ulTransFlag The RED_TRANSACT_* flag of the completed operation.
 
     @return A negated ::REDSTATUS code indicating the operation result.
@@ -2783,6 +3551,18 @@ static REDSTATUS CoreAutoTransact(
     {
         ret = RedVolTransact();
     }
+  #if REDCONF_TRANSACT_AUTO == 1
+    else
+    {
+        const REDTRANSPOLICY *pPolicy = &gpRedVolume->transPolicy;
+
+        if(    ((pPolicy->ulDirtyBlocks > 0U) && (gpRedCoreVol->ulAutoBlocks >= pPolicy->ulDirtyBlocks))
+            || ((pPolicy->ullWriteBytes > 0U) && (gpRedCoreVol->ullAutoBytes >= pPolicy->ullWriteBytes)))
+        {
+            ret = RedVolTransact();
+        }
+    }
+  #endif
 
     return ret;
 }
@@ -33,6 +33,32 @@
 #include <redcore.h>
 
 
+#if REDCONF_READ_ONLY == 0
+/*  When a goal block is given to RedImapAllocExtent() but is not free, the
+    next allocation is moved this many blocks beyond the one which is made
+    instead, so that files which are written at the same time do not
+    interleave their blocks.
+*/
+#define ALLOC_GOAL_WINDOW 64U
+
+
+static uint32_t ImapFreeBlocks(void);
+static REDSTATUS ImapFindFree(uint32_t ulBlock, uint32_t *pulFreeBlock);
+static REDSTATUS ImapFindFreeBlock(uint32_t ulBlock, uint32_t *pulFreeBlock);
+static REDSTATUS ImapFreeRun(uint32_t ulBlock, uint32_t ulMaxLen, uint32_t *pulLen);
+#if REDCONF_API_POSIX_SNAPSHOT == 1
+static void ImapViewInodeFreed(uint32_t ulStart, uint32_t ulCount);
+static REDSTATUS ImapViewInodeTransact(void);
+static REDSTATUS ImapViewInodeScan(void);
+static REDSTATUS ImapViewInodePin(uint32_t ulBlock);
+static REDSTATUS ImapViewRun(uint32_t ulBlock, uint32_t ulMaxLen, bool fUsed, uint32_t *pulLen);
+static REDSTATUS ImapViewCount(uint32_t ulStart, uint32_t ulCount, uint32_t *pulUsed);
+static REDSTATUS ImapViewHeldRun(uint32_t ulBlock, uint32_t ulMaxLen, uint32_t *pulLen);
+static REDSTATUS ImapViewClampRun(uint32_t ulBlock, uint32_t *pulLen);
+#endif
+#endif
+
+
 /** @brief Get the allocation bit of a block from either metaroot.
 
     Will pass the call down either to the inline imap or to the external imap
@@ -90,9 +116,6 @@ REDSTATUS RedImapBlockGet(
 #if REDCONF_READ_ONLY == 0
 /** @brief Set the allocation bit of a block in the working metaroot.
 
-    Will pass the call down either to the inline imap or to the external imap
-    implementation, whichever is appropriate for the current volume.
-
     @param ulBlock      The block number to allocate or free.
     @param fAllocated   Whether to allocate the block (true) or free it (false).
 
@@ -106,21 +129,55 @@ REDSTATUS RedImapBlockGet(
 REDSTATUS RedImapBlockSet(
     uint32_t    ulBlock,
     bool        fAllocated)
+{
+    return RedImapBlockRangeSet(ulBlock, 1U, fAllocated);
+}
+
+
+/** @brief Set the allocation bits of a range of blocks in the working
+           metaroot.
+
+    Will pass the call down either to the inline imap or to the external imap
+    implementation, whichever is appropriate for the current volume.  The bits
+    are updated a byte at a time, and each external imap node which the range
+    covers is branched and buffered only once, so freeing a large run of blocks
+    costs far less than freeing them one at a time.
+
+    @param ulStart      The first block to allocate or free.
+    @param ulCount      The number of blocks to allocate or free.  The blocks
+                        must be either all allocable or all unallocable.
+    @param fAllocated   Whether to allocate the blocks (true) or free them
+                        (false).
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EINVAL The range is out of range or empty; or the range
+                        includes both allocable and unallocable blocks.
+    @retval -RED_EIO    A disk I/O error occurred.
+*/
+REDSTATUS RedImapBlockRangeSet(
+    uint32_t    ulStart,
+    uint32_t    ulCount,
+    bool        fAllocated)
 {
     REDSTATUS   ret;
 
-    if(    (ulBlock < gpRedCoreVol->ulInodeTableStartBN)
-        || (ulBlock >= gpRedVolume->ulBlockCount))
+    if(    (ulStart < gpRedCoreVol->ulInodeTableStartBN)
+        || (ulStart >= gpRedVolume->ulBlockCount)
+        || (ulCount == 0U)
+        || (ulCount > (gpRedVolume->ulBlockCount - ulStart))
+        || ((ulStart < gpRedCoreVol->ulFirstAllocableBN) && ((ulStart + ulCount) > gpRedCoreVol->ulFirstAllocableBN)))
     {
         REDERROR();
         ret = -RED_EINVAL;
     }
-    else if(    (ulBlock >= gpRedCoreVol->ulFirstAllocableBN)
-             && (    (fAllocated && (gpRedMR->ulFreeBlocks == 0U))
-                  || ((!fAllocated) && (gpRedMR->ulFreeBlocks >= gpRedVolume->ulBlocksAllocable))))
+    else if(    (ulStart >= gpRedCoreVol->ulFirstAllocableBN)
+             && (    (fAllocated && (gpRedMR->ulFreeBlocks < ulCount))
+                  || ((!fAllocated) && ((gpRedVolume->ulBlocksAllocable - gpRedMR->ulFreeBlocks) < ulCount))))
     {
         /*  Attempting either to free more blocks than are allocable, or
-            allocate a block when there are none available.  This could indicate
+            allocate more blocks than are available.  This could indicate
             metadata corruption.
         */
         CRITICAL_ERROR();
@@ -128,65 +185,84 @@ REDSTATUS RedImapBlockSet(
     }
     else
     {
+        uint32_t ulCommitted = 0U;
+
       #if (REDCONF_IMAP_INLINE == 1) && (REDCONF_IMAP_EXTERNAL == 1)
         if(gpRedCoreVol->fImapInline)
         {
-            ret = RedImapIBlockSet(ulBlock, fAllocated);
+            ret = RedImapIBlockRangeSet(ulStart, ulCount, fAllocated, &ulCommitted);
         }
         else
         {
-            ret = RedImapEBlockSet(ulBlock, fAllocated);
+            ret = RedImapEBlockRangeSet(ulStart, ulCount, fAllocated, &ulCommitted);
         }
       #elif REDCONF_IMAP_INLINE == 1
-        ret = RedImapIBlockSet(ulBlock, fAllocated);
+        ret = RedImapIBlockRangeSet(ulStart, ulCount, fAllocated, &ulCommitted);
       #else
-        ret = RedImapEBlockSet(ulBlock, fAllocated);
+        ret = RedImapEBlockRangeSet(ulStart, ulCount, fAllocated, &ulCommitted);
       #endif
 
         /*  Any change to the allocation state of a block indicates that the
             volume is now branched.
         */
         gpRedCoreVol->fBranched = true;
-    }
-
-    /*  If a block was marked as no longer in use, discard it from the buffers.
-    */
-    if((ret == 0) && (!fAllocated))
-    {
-        ret = RedBufferDiscardRange(ulBlock, 1U);
-        CRITICAL_ASSERT(ret == 0);
-    }
 
-    /*  Adjust the free/almost free block count if the block was allocable.
-        Discard the block if required.
-    */
-    if((ret == 0) && (ulBlock >= gpRedCoreVol->ulFirstAllocableBN))
-    {
-        if(fAllocated)
+        /*  If blocks were marked as no longer in use, discard them from the
+            buffers.
+        */
+        if((ret == 0) && (!fAllocated))
         {
-            gpRedMR->ulFreeBlocks--;
+            ret = RedBufferDiscardRange(ulStart, ulCount);
+            CRITICAL_ASSERT(ret == 0);
         }
-        else
-        {
-            bool fWasAllocated;
 
-            /*  Whether the block became free or almost free depends on its
-                previous allocation state.  If it was used, then it is now
-                almost free.  Otherwise, it was new and is now free.
-            */
-            ret = RedImapBlockGet(1U - gpRedCoreVol->bCurMR, ulBlock, &fWasAllocated);
-            CRITICAL_ASSERT(ret == 0);
+      #if REDCONF_API_POSIX_SNAPSHOT == 1
+        if((ret == 0) && !fAllocated && (ulStart < gpRedCoreVol->ulFirstAllocableBN))
+        {
+            ImapViewInodeFreed(ulStart, ulCount);
+        }
+      #endif
 
-            if(ret == 0)
+        /*  Adjust the free/almost free block count if the blocks were
+            allocable.
+        */
+        if((ret == 0) && (ulStart >= gpRedCoreVol->ulFirstAllocableBN))
+        {
+            if(fAllocated)
             {
-                if(fWasAllocated)
-                {
-                    gpRedCoreVol->ulAlmostFreeBlocks++;
-                }
-                else
+                gpRedMR->ulFreeBlocks -= ulCount;
+              #if REDCONF_TRANSACT_AUTO == 1
+                gpRedCoreVol->ulAutoBlocks += ulCount;
+              #endif
+            }
+            else
+            {
+                /*  Whether a block became free or almost free depends on its
+                    previous allocation state.  If it was used, then it is now
+                    almost free.  Otherwise, it was new and is now free.
+                */
+                gpRedCoreVol->ulAlmostFreeBlocks += ulCommitted;
+                TRANSTAT_ADD(gbRedVolNum, ulAlmostFreeBlocks, ulCommitted);
+                gpRedMR->ulFreeBlocks += ulCount - ulCommitted;
+
+              #if REDCONF_API_POSIX_SNAPSHOT == 1
+                /*  Blocks which the view of the committed state uses will be
+                    held at the next transaction point, rather than becoming
+                    free.  Until a transaction point has been made, the view
+                    is the committed state.
+                */
+                if((gpRedCoreVol->ulViewRefs > 0U) && !gpRedCoreVol->fViewLost)
                 {
-                    gpRedMR->ulFreeBlocks++;
+                    uint32_t ulViewUsed = ulCommitted;
+
+                    if(gpRedCoreVol->fViewPinned)
+                    {
+                        ret = ImapViewCount(ulStart, ulCount, &ulViewUsed);
+                    }
+
+                    gpRedCoreVol->ulViewAlmostFree += ulViewUsed;
                 }
+              #endif
             }
         }
     }
@@ -197,6 +273,8 @@ REDSTATUS RedImapBlockSet(
 
 /** @brief Allocate one block.
 
+    @param ulGoal   The block which is preferred, if it is free; see
+                    RedImapAllocExtent().
     @param pulBlock On successful return, populated with the allocated block
                     number.
 
@@ -208,50 +286,137 @@ REDSTATUS RedImapBlockSet(
     @retval -RED_ENOSPC Insufficient free space to perform the allocation.
 */
 REDSTATUS RedImapAllocBlock(
+    uint32_t    ulGoal,
     uint32_t   *pulBlock)
+{
+    uint32_t    ulLen;
+
+    return RedImapAllocExtent(ulGoal, 1U, pulBlock, &ulLen);
+}
+
+
+/** @brief Allocate a run of contiguous blocks.
+
+    If @p ulGoal is free, the run starts with it; this is how a file which is
+    being appended to stays contiguous.  Otherwise, the imap is searched for
+    the first free block following the end of the last allocation.  As many of
+    the free blocks which follow the start of the run as are wanted are
+    allocated; fewer blocks than wanted are allocated if the run of free blocks
+    is shorter.
+
+    When @p ulGoal was given but is no longer free, another file is being
+    written to the blocks which follow the last allocation.  The next
+    allocation is then moved ::ALLOC_GOAL_WINDOW blocks beyond this one, which
+    leaves room for this file to grow contiguously before it runs into the
+    next file.
+
+    @param ulGoal   The block which is preferred, if it is free.  If this is
+                    not an allocable block, e.g. ::BLOCK_SPARSE, there is no
+                    preference.
+    @param ulWanted The maximum number of blocks to allocate.
+    @param pulStart On successful return, populated with the first allocated
+                    block.
+    @param pulLen   On successful return, populated with the number of blocks
+                    allocated: at least one, and at most @p ulWanted.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EINVAL @p ulWanted is zero; or @p pulStart or @p pulLen is
+                        `NULL`.
+    @retval -RED_EIO    A disk I/O error occurred.
+    @retval -RED_ENOSPC Insufficient free space to perform the allocation.
+*/
+REDSTATUS RedImapAllocExtent(
+    uint32_t    ulGoal,
+    uint32_t    ulWanted,
+    uint32_t   *pulStart,
+    uint32_t   *pulLen)
 {
     REDSTATUS   ret;
 
-    if(pulBlock == NULL)
+    if((ulWanted == 0U) || (pulStart == NULL) || (pulLen == NULL))
     {
         REDERROR();
         ret = -RED_EINVAL;
     }
-    else if(gpRedMR->ulFreeBlocks == 0U)
+    else if(ImapFreeBlocks() == 0U)
     {
         ret = -RED_ENOSPC;
     }
     else
     {
-        /*  Scan the imap for a block which is free.
+        uint32_t    ulMaxLen = REDMIN(ulWanted, ImapFreeBlocks());
+        bool        fHaveGoal = (ulGoal >= gpRedCoreVol->ulFirstAllocableBN) && (ulGoal < gpRedVolume->ulBlockCount);
+        uint32_t    ulStart = ulGoal;
+        uint32_t    ulLen = 0U;
+
+        ret = 0;
+
+        /*  A run which starts with a block that is not free has length zero.
         */
-      #if (REDCONF_IMAP_INLINE == 1) && (REDCONF_IMAP_EXTERNAL == 1)
-        if(gpRedCoreVol->fImapInline)
+        if(fHaveGoal)
         {
-            ret = RedImapIBlockFindFree(gpRedMR->ulAllocNextBlock, pulBlock);
+            ret = ImapFreeRun(ulStart, ulMaxLen, &ulLen);
         }
-        else
+
+        if((ret == 0) && (ulLen == 0U))
         {
-            ret = RedImapEBlockFindFree(gpRedMR->ulAllocNextBlock, pulBlock);
-        }
-      #elif REDCONF_IMAP_INLINE == 1
-        ret = RedImapIBlockFindFree(gpRedMR->ulAllocNextBlock, pulBlock);
-      #else
-        ret = RedImapEBlockFindFree(gpRedMR->ulAllocNextBlock, pulBlock);
-      #endif
+            ret = ImapFindFree(gpRedMR->ulAllocNextBlock, &ulStart);
+            if(ret == 0)
+            {
+                ret = ImapFreeRun(ulStart, ulMaxLen, &ulLen);
+            }
 
-        if(ret == 0)
+            if(ret == 0)
+            {
+                uint32_t ulNext = ulStart + ulLen;
+
+                REDASSERT(ulLen > 0U);
+
+                if(fHaveGoal && ((gpRedVolume->ulBlockCount - ulNext) > ALLOC_GOAL_WINDOW))
+                {
+                    ulNext += ALLOC_GOAL_WINDOW;
+                }
+
+                if(ulNext == gpRedVolume->ulBlockCount)
+                {
+                    ulNext = gpRedCoreVol->ulFirstAllocableBN;
+                }
+
+                gpRedMR->ulAllocNextBlock = ulNext;
+            }
+        }
+        else if((ret == 0) && (gpRedMR->ulAllocNextBlock >= ulStart) && ((gpRedMR->ulAllocNextBlock - ulStart) < ulLen))
         {
-            gpRedMR->ulAllocNextBlock = *pulBlock + 1U;
+            /*  The goal run covered the block where the next allocation would
+                have started: move it past the run.
+            */
+            gpRedMR->ulAllocNextBlock = ulStart + ulLen;
             if(gpRedMR->ulAllocNextBlock == gpRedVolume->ulBlockCount)
             {
                 gpRedMR->ulAllocNextBlock = gpRedCoreVol->ulFirstAllocableBN;
             }
+        }
+        else
+        {
+            /*  The goal run was allocated without moving the next allocation,
+                or an error occurred.
+            */
+        }
 
-            /*  Mark the free block as allocated.
+        if(ret == 0)
+        {
+            /*  Mark the free blocks as allocated.
             */
-            ret = RedImapBlockSet(*pulBlock, true);
+            ret = RedImapBlockRangeSet(ulStart, ulLen, true);
             CRITICAL_ASSERT(ret == 0);
+
+            if(ret == 0)
+            {
+                *pulStart = ulStart;
+                *pulLen = ulLen;
+            }
         }
         else if(ret == -RED_ENOSPC)
         {
@@ -271,6 +436,183 @@ REDSTATUS RedImapAllocBlock(
 
     return ret;
 }
+
+
+/** @brief Free the unused tail of a run of blocks allocated by
+           RedImapAllocExtent().
+
+    The blocks are free again, and if the next allocation would have started
+    after them, it starts with them instead, so that they are not skipped.
+
+    @param ulStart  The first block to free.
+    @param ulLen    The number of blocks to free.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EINVAL The blocks are out of range.
+    @retval -RED_EIO    A disk I/O error occurred.
+*/
+REDSTATUS RedImapFreeExtent(
+    uint32_t    ulStart,
+    uint32_t    ulLen)
+{
+    REDSTATUS   ret = 0;
+
+    if(    (ulStart < gpRedCoreVol->ulFirstAllocableBN)
+        || (ulStart >= gpRedVolume->ulBlockCount)
+        || (ulLen > (gpRedVolume->ulBlockCount - ulStart)))
+    {
+        REDERROR();
+        ret = -RED_EINVAL;
+    }
+    else if(ulLen > 0U)
+    {
+        uint32_t ulEnd = ulStart + ulLen;
+
+        ret = RedImapBlockRangeSet(ulStart, ulLen, false);
+
+        if(ret == 0)
+        {
+            if(ulEnd == gpRedVolume->ulBlockCount)
+            {
+                ulEnd = gpRedCoreVol->ulFirstAllocableBN;
+            }
+
+            if(gpRedMR->ulAllocNextBlock == ulEnd)
+            {
+                gpRedMR->ulAllocNextBlock = ulStart;
+            }
+        }
+    }
+    else
+    {
+        /*  Nothing to free.
+        */
+    }
+
+    return ret;
+}
+
+
+#if (REDCONF_API_POSIX == 1) && (REDCONF_API_POSIX_DEFRAG == 1)
+/** @brief Find a run of free blocks which is long enough for an extent.
+
+    The imap is searched from where the last allocation ended, wrapping around
+    to the start of the volume, for the first run of at least @p ulWanted free
+    blocks.  If there is no such run, the longest run is found instead.  No
+    blocks are allocated: the run is meant to be used as the goal for
+    RedImapAllocExtent().
+
+    @param ulWanted The number of blocks wanted.
+    @param pulStart On successful return, populated with the first block of
+                    the run.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EINVAL @p ulWanted is zero; or @p pulStart is `NULL`.
+    @retval -RED_EIO    A disk I/O error occurred.
+    @retval -RED_ENOSPC There are no free blocks.
+*/
+REDSTATUS RedImapFindExtent(
+    uint32_t    ulWanted,
+    uint32_t   *pulStart)
+{
+    REDSTATUS   ret = 0;
+
+    if((ulWanted == 0U) || (pulStart == NULL))
+    {
+        REDERROR();
+        ret = -RED_EINVAL;
+    }
+    else if(ImapFreeBlocks() == 0U)
+    {
+        ret = -RED_ENOSPC;
+    }
+    else
+    {
+        uint32_t    ulCursor = gpRedMR->ulAllocNextBlock;
+        uint32_t    ulSearch = ulCursor;
+        uint32_t    ulBestStart = 0U; /* Init'd to quiet warnings. */
+        uint32_t    ulBestLen = 0U;
+        bool        fWrapped = false;
+        bool        fDone = false;
+
+        while((ret == 0) && !fDone)
+        {
+            uint32_t ulStart;
+            uint32_t ulLen = 0U;
+
+            ret = ImapFindFree(ulSearch, &ulStart);
+
+            if(ret == 0)
+            {
+                /*  Stop once the search has come back around to where it
+                    started.
+                */
+                if(ulStart < ulSearch)
+                {
+                    fDone = fWrapped;
+                    fWrapped = true;
+                }
+
+                if(fWrapped && (ulStart >= ulCursor))
+                {
+                    fDone = true;
+                }
+            }
+
+            if((ret == 0) && !fDone)
+            {
+                ret = ImapFreeRun(ulStart, ulWanted, &ulLen);
+            }
+
+            if((ret == 0) && !fDone)
+            {
+                REDASSERT(ulLen > 0U);
+
+                if(ulLen > ulBestLen)
+                {
+                    ulBestStart = ulStart;
+                    ulBestLen = ulLen;
+                }
+
+                fDone = ulBestLen >= ulWanted;
+
+                ulSearch = ulStart + ulLen;
+                if(ulSearch == gpRedVolume->ulBlockCount)
+                {
+                    ulSearch = gpRedCoreVol->ulFirstAllocableBN;
+                    fDone = fDone || fWrapped;
+                    fWrapped = true;
+                }
+            }
+        }
+
+        if(ret == 0)
+        {
+            REDASSERT(ulBestLen > 0U);
+            *pulStart = ulBestStart;
+        }
+        else if(ret == -RED_ENOSPC)
+        {
+            /*  As with RedImapAllocExtent(), this indicates metadata
+                corruption.
+            */
+            CRITICAL_ERROR();
+            ret = -RED_EIO;
+        }
+        else
+        {
+            /*  Other errors are propagated.
+            */
+        }
+    }
+
+    return ret;
+}
+#endif /* (REDCONF_API_POSIX == 1) && (REDCONF_API_POSIX_DEFRAG == 1) */
 #endif /* REDCONF_READ_ONLY == 0 */
 
 
@@ -348,3 +690,745 @@ REDSTATUS RedImapBlockState(
 
     return ret;
 }
+
+
+#if REDCONF_READ_ONLY == 0
+#if REDCONF_API_POSIX_SNAPSHOT == 1
+/** @brief Move the view of the committed state past a transaction point.
+
+    Must be called before a transaction point is made.  Inodes and imap nodes
+    of the view which the transaction point would make writeable are pinned,
+    and blocks of the view which were freed since the last transaction point
+    are held.  From then on, the view is no longer the committed state.
+
+    Pinning is done here, rather than when the working state is about to
+    overwrite a node, because no buffers are held at a transaction point.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EIO    A disk I/O error occurred.
+*/
+REDSTATUS RedImapViewTransact(void)
+{
+    REDSTATUS ret = 0;
+
+    if((gpRedCoreVol->ulViewRefs > 0U) && !gpRedCoreVol->fViewLost)
+    {
+        ret = ImapViewInodeTransact();
+
+      #if REDCONF_IMAP_EXTERNAL == 1
+        if((ret == 0) && !gpRedCoreVol->fImapInline)
+        {
+            ret = RedImapEViewTransact();
+        }
+      #endif
+
+        /*  Pinning abandons the view if there is no room for another pin.
+        */
+        if((ret == 0) && !gpRedCoreVol->fViewLost)
+        {
+            gpRedCoreVol->ulViewHeld += gpRedCoreVol->ulViewAlmostFree;
+            gpRedCoreVol->ulViewAlmostFree = 0U;
+            gpRedCoreVol->fViewPinned = true;
+        }
+    }
+
+    return ret;
+}
+
+
+/** @brief Record inode slots which the working state freed, so that the next
+           transaction point can pin those which the view uses.
+
+    @param ulStart  The first inode slot freed.
+    @param ulCount  The number of inode slots freed.
+*/
+static void ImapViewInodeFreed(
+    uint32_t    ulStart,
+    uint32_t    ulCount)
+{
+    if((gpRedCoreVol->ulViewRefs > 0U) && !gpRedCoreVol->fViewLost && !gpRedCoreVol->fViewSlotScan)
+    {
+        uint32_t ulBlock;
+
+        for(ulBlock = ulStart; (ulBlock < (ulStart + ulCount)) && !gpRedCoreVol->fViewSlotScan; ulBlock++)
+        {
+            /*  A slot which was pinned already needs no other pin.
+            */
+            if(RedImapViewBlock(ulBlock) != ulBlock)
+            {
+                /*  Nothing to record.
+                */
+            }
+            else if(gpRedCoreVol->ulViewFreedSlots == ARRAY_SIZE(gpRedCoreVol->aulViewFreedSlot))
+            {
+                gpRedCoreVol->fViewSlotScan = true;
+            }
+            else
+            {
+                gpRedCoreVol->aulViewFreedSlot[gpRedCoreVol->ulViewFreedSlots] = ulBlock;
+                gpRedCoreVol->ulViewFreedSlots++;
+            }
+        }
+    }
+}
+
+
+/** @brief Pin the inodes of the view of the committed state which a
+           transaction point would make writeable.
+
+    An inode slot which the view uses, but which is free in the working state,
+    will be free in the committed state after the transaction point, so the
+    working state may then write to it.  Only the slots freed since the last
+    transaction point are examined, unless there were too many to record.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EIO    A disk I/O error occurred.
+*/
+static REDSTATUS ImapViewInodeTransact(void)
+{
+    REDSTATUS   ret = 0;
+
+    if(gpRedCoreVol->fViewSlotScan)
+    {
+        ret = ImapViewInodeScan();
+    }
+    else
+    {
+        uint32_t ulIdx;
+
+        for(ulIdx = 0U; (ret == 0) && !gpRedCoreVol->fViewLost && (ulIdx < gpRedCoreVol->ulViewFreedSlots); ulIdx++)
+        {
+            uint32_t ulBlock = gpRedCoreVol->aulViewFreedSlot[ulIdx];
+            uint32_t ulLen;
+
+            ret = ImapViewRun(ulBlock, 1U, true, &ulLen);
+
+            if((ret == 0) && (ulLen > 0U))
+            {
+                ret = ImapViewInodePin(ulBlock);
+            }
+        }
+    }
+
+    if(ret == 0)
+    {
+        gpRedCoreVol->ulViewFreedSlots = 0U;
+        gpRedCoreVol->fViewSlotScan = false;
+    }
+
+    return ret;
+}
+
+
+/** @brief Examine every inode slot of the view of the committed state, and pin
+           those which are free in the working state.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EIO    A disk I/O error occurred.
+*/
+static REDSTATUS ImapViewInodeScan(void)
+{
+    REDSTATUS   ret = 0;
+    uint32_t    ulBlock = gpRedCoreVol->ulInodeTableStartBN;
+    uint32_t    ulEnd = ulBlock + (gpRedCoreVol->ulInodeCount * 2U);
+
+    while((ret == 0) && !gpRedCoreVol->fViewLost && (ulBlock < ulEnd))
+    {
+        uint32_t ulLen;
+
+        /*  Skip the slots which the view does not use, then examine each slot
+            in the following run of slots which it does use.
+        */
+        ret = ImapViewRun(ulBlock, ulEnd - ulBlock, false, &ulLen);
+
+        if(ret == 0)
+        {
+            ulBlock += ulLen;
+        }
+
+        if((ret == 0) && (ulBlock < ulEnd))
+        {
+            ret = ImapViewRun(ulBlock, ulEnd - ulBlock, true, &ulLen);
+
+            while((ret == 0) && !gpRedCoreVol->fViewLost && (ulLen > 0U))
+            {
+                ret = ImapViewInodePin(ulBlock);
+
+                ulBlock++;
+                ulLen--;
+            }
+        }
+    }
+
+    return ret;
+}
+
+
+/** @brief Pin an inode slot which the view of the committed state uses, if it
+           is free in the working state.
+
+    @param ulBlock  The inode slot.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EIO    A disk I/O error occurred.
+*/
+static REDSTATUS ImapViewInodePin(
+    uint32_t    ulBlock)
+{
+    bool        fAllocated;
+    REDSTATUS   ret;
+
+    ret = RedImapBlockGet(gpRedCoreVol->bCurMR, ulBlock, &fAllocated);
+
+    if((ret == 0) && !fAllocated)
+    {
+        ret = RedImapViewPin(ulBlock, BFLAG_META_INODE);
+    }
+
+    return ret;
+}
+
+
+/** @brief Pin a node of the view of the committed state.
+
+    The node is copied to one of the blocks set aside for pinning when the view
+    was opened, and from then on, the view reads the copy.  Does nothing if the
+    node is already pinned.  If all #REDCONF_SNAPSHOT_PINS pins are in use, the
+    view is abandoned instead, rather than holding up the working state: its
+    blocks are released, and its handles can only be closed.
+
+    @param ulBlock  The block where the node is in the view.
+    @param uFlags   The buffer type of the node: #BFLAG_META_INODE or
+                    #BFLAG_META_IMAP.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EIO    A disk I/O error occurred.
+*/
+REDSTATUS RedImapViewPin(
+    uint32_t    ulBlock,
+    uint16_t    uFlags)
+{
+    REDSTATUS   ret = 0;
+
+    if(gpRedCoreVol->fViewLost || (RedImapViewBlock(ulBlock) != ulBlock))
+    {
+        /*  Abandoned or already pinned: nothing to do.
+        */
+    }
+    else if(gpRedCoreVol->ulViewPins == REDCONF_SNAPSHOT_PINS)
+    {
+        RedImapViewRelease();
+        gpRedCoreVol->fViewLost = true;
+    }
+    else
+    {
+        uint32_t ulPinBlock;
+
+        /*  The search skips the blocks held for the view, including the
+            earlier pins, and there are still blocks set aside for pinning.
+        */
+        ret = ImapFindFree(gpRedMR->ulAllocNextBlock, &ulPinBlock);
+
+        if(ret == 0)
+        {
+            void *pBuffer;
+
+            ret = RedBufferGet(ulBlock, uFlags, &pBuffer);
+
+            if(ret == 0)
+            {
+                RedBufferBranch(pBuffer, ulPinBlock);
+                RedBufferPut(pBuffer);
+
+                /*  Write the copy right away: it is not part of the working
+                    state, so it must not be discarded by a rollback.
+                */
+                ret = RedBufferFlushRange(ulPinBlock, 1U);
+            }
+        }
+        else if(ret == -RED_ENOSPC)
+        {
+            /*  As with RedImapAllocExtent(), this indicates metadata
+                corruption.
+            */
+            CRITICAL_ERROR();
+            ret = -RED_EIO;
+        }
+        else
+        {
+            /*  Other errors are propagated.
+            */
+        }
+
+        if(ret == 0)
+        {
+            gpRedCoreVol->aViewPin[gpRedCoreVol->ulViewPins].ulBlock = ulBlock;
+            gpRedCoreVol->aViewPin[gpRedCoreVol->ulViewPins].ulPinBlock = ulPinBlock;
+            gpRedCoreVol->ulViewPins++;
+        }
+    }
+
+    return ret;
+}
+
+
+/** @brief Release the blocks held for the view of the committed state.
+
+    Called when the view is closed or abandoned.  Its pins are forgotten, and
+    the blocks which it held can be allocated again.
+*/
+void RedImapViewRelease(void)
+{
+    gpRedCoreVol->fViewPinned = false;
+    gpRedCoreVol->ulViewAlmostFree = 0U;
+    gpRedCoreVol->ulViewHeld = 0U;
+    gpRedCoreVol->ulViewPins = 0U;
+    gpRedCoreVol->ulViewFreedSlots = 0U;
+    gpRedCoreVol->fViewSlotScan = false;
+}
+
+
+/** @brief Find where the view of the committed state reads a node.
+
+    @param ulBlock  The block where the node is in the view.
+
+    @return The block of the copy of the node, if it was pinned; otherwise,
+            @p ulBlock.
+*/
+uint32_t RedImapViewBlock(
+    uint32_t    ulBlock)
+{
+    uint32_t    ulViewBlock = ulBlock;
+    uint32_t    ulIdx;
+
+    for(ulIdx = 0U; ulIdx < gpRedCoreVol->ulViewPins; ulIdx++)
+    {
+        if(gpRedCoreVol->aViewPin[ulIdx].ulBlock == ulBlock)
+        {
+            ulViewBlock = gpRedCoreVol->aViewPin[ulIdx].ulPinBlock;
+            break;
+        }
+    }
+
+    return ulViewBlock;
+}
+#endif /* REDCONF_API_POSIX_SNAPSHOT == 1 */
+
+
+/** @brief Get the number of free blocks which can be allocated.
+
+    @return The number of blocks which are free in both the working state and
+            the committed state, less those held for the view of the committed
+            state.
+*/
+static uint32_t ImapFreeBlocks(void)
+{
+    uint32_t ulFreeBlocks = gpRedMR->ulFreeBlocks;
+
+  #if REDCONF_API_POSIX_SNAPSHOT == 1
+    REDASSERT(ulFreeBlocks >= gpRedCoreVol->ulViewHeld);
+    ulFreeBlocks -= gpRedCoreVol->ulViewHeld;
+  #endif
+
+    return ulFreeBlocks;
+}
+
+
+/** @brief Find the first free block at or after a given block, wrapping
+           around to the start of the volume.
+
+    Free blocks which are held for the view of the committed state are
+    skipped.
+
+    @param ulBlock      The block at which to start searching.
+    @param pulFreeBlock On successful return, populated with the free block.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EINVAL @p ulBlock is out of range; or @p pulFreeBlock is
+                        `NULL`.
+    @retval -RED_EIO    A disk I/O error occurred.
+    @retval -RED_ENOSPC No free block was found.
+*/
+static REDSTATUS ImapFindFree(
+    uint32_t    ulBlock,
+    uint32_t   *pulFreeBlock)
+{
+    REDSTATUS   ret;
+
+  #if REDCONF_API_POSIX_SNAPSHOT == 1
+    uint32_t    ulSearch = ulBlock;
+    bool        fWrapped = false;
+    bool        fDone = false;
+
+    /*  Each free block found is checked against the blocks held for the view,
+        and the search resumes after a run of held blocks, until it comes back
+        around to where it started.
+    */
+    while(!fDone)
+    {
+        uint32_t ulFree = 0U; /* Init'd to quiet warnings. */
+        uint32_t ulHeld = 0U;
+
+        ret = ImapFindFreeBlock(ulSearch, &ulFree);
+
+        if((ret == 0) && (ulFree < ulSearch))
+        {
+            if(fWrapped)
+            {
+                ret = -RED_ENOSPC;
+            }
+
+            fWrapped = true;
+        }
+
+        if((ret == 0) && fWrapped && (ulFree >= ulBlock))
+        {
+            ret = -RED_ENOSPC;
+        }
+
+        if(ret == 0)
+        {
+            uint32_t ulLimit = fWrapped ? ulBlock : gpRedVolume->ulBlockCount;
+
+            ret = ImapViewHeldRun(ulFree, ulLimit - ulFree, &ulHeld);
+        }
+
+        if(ret != 0)
+        {
+            fDone = true;
+        }
+        else if(ulHeld == 0U)
+        {
+            *pulFreeBlock = ulFree;
+            fDone = true;
+        }
+        else
+        {
+            ulSearch = ulFree + ulHeld;
+
+            if(ulSearch == gpRedVolume->ulBlockCount)
+            {
+                ulSearch = gpRedCoreVol->ulFirstAllocableBN;
+                fWrapped = true;
+            }
+
+            if(fWrapped && (ulSearch == ulBlock))
+            {
+                ret = -RED_ENOSPC;
+                fDone = true;
+            }
+        }
+    }
+  #else
+    ret = ImapFindFreeBlock(ulBlock, pulFreeBlock);
+  #endif
+
+    return ret;
+}
+
+
+/** @brief Find the first block at or after a given block which is free in both
+           the working state and the committed state, wrapping around to the
+           start of the volume.
+
+    Will pass the call down either to the inline imap or to the external imap
+    implementation, whichever is appropriate for the current volume.
+
+    @param ulBlock      The block at which to start searching.
+    @param pulFreeBlock On successful return, populated with the free block.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EINVAL @p ulBlock is out of range; or @p pulFreeBlock is
+                        `NULL`.
+    @retval -RED_EIO    A disk I/O error occurred.
+    @retval -RED_ENOSPC No free block was found.
+*/
+static REDSTATUS ImapFindFreeBlock(
+    uint32_t    ulBlock,
+    uint32_t   *pulFreeBlock)
+{
+    REDSTATUS   ret;
+
+  #if (REDCONF_IMAP_INLINE == 1) && (REDCONF_IMAP_EXTERNAL == 1)
+    if(gpRedCoreVol->fImapInline)
+    {
+        ret = RedImapIBlockFindFree(ulBlock, pulFreeBlock);
+    }
+    else
+    {
+        ret = RedImapEBlockFindFree(ulBlock, pulFreeBlock);
+    }
+  #elif REDCONF_IMAP_INLINE == 1
+    ret = RedImapIBlockFindFree(ulBlock, pulFreeBlock);
+  #else
+    ret = RedImapEBlockFindFree(ulBlock, pulFreeBlock);
+  #endif
+
+    return ret;
+}
+
+
+/** @brief Measure a run of free blocks.
+
+    Will pass the call down either to the inline imap or to the external imap
+    implementation, whichever is appropriate for the current volume.  The run
+    ends at the first block which is held for the view of the committed state.
+
+    @param ulBlock  The first block of the run.
+    @param ulMaxLen The maximum length of the run.
+    @param pulLen   On success, populated with the number of consecutive blocks,
+                    starting with @p ulBlock, which are free; this is zero if
+                    @p ulBlock is not free, and at most @p ulMaxLen.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EINVAL @p ulBlock is out of range; or @p ulMaxLen is zero; or
+                        @p pulLen is `NULL`.
+    @retval -RED_EIO    A disk I/O error occurred.
+*/
+static REDSTATUS ImapFreeRun(
+    uint32_t    ulBlock,
+    uint32_t    ulMaxLen,
+    uint32_t   *pulLen)
+{
+    REDSTATUS   ret;
+
+  #if (REDCONF_IMAP_INLINE == 1) && (REDCONF_IMAP_EXTERNAL == 1)
+    if(gpRedCoreVol->fImapInline)
+    {
+        ret = RedImapIBlockFreeRun(ulBlock, ulMaxLen, pulLen);
+    }
+    else
+    {
+        ret = RedImapEBlockFreeRun(ulBlock, ulMaxLen, pulLen);
+    }
+  #elif REDCONF_IMAP_INLINE == 1
+    ret = RedImapIBlockFreeRun(ulBlock, ulMaxLen, pulLen);
+  #else
+    ret = RedImapEBlockFreeRun(ulBlock, ulMaxLen, pulLen);
+  #endif
+
+  #if REDCONF_API_POSIX_SNAPSHOT == 1
+    if((ret == 0) && (*pulLen > 0U))
+    {
+        ret = ImapViewClampRun(ulBlock, pulLen);
+    }
+  #endif
+
+    return ret;
+}
+
+
+#if REDCONF_API_POSIX_SNAPSHOT == 1
+/** @brief Measure a run of blocks which are all used, or all unused, by the
+           view of the committed state.
+
+    Will pass the call down either to the inline imap or to the external imap
+    implementation, whichever is appropriate for the current volume.
+
+    @param ulBlock  The first block of the run.
+    @param ulMaxLen The maximum length of the run.
+    @param fUsed    Whether to measure a run of blocks which the view uses
+                    (true) or does not use (false).
+    @param pulLen   On success, populated with the length of the run; this is
+                    zero if @p ulBlock does not match @p fUsed.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EINVAL @p ulBlock is out of range; or @p ulMaxLen is zero; or
+                        @p pulLen is `NULL`.
+    @retval -RED_EIO    A disk I/O error occurred.
+*/
+static REDSTATUS ImapViewRun(
+    uint32_t    ulBlock,
+    uint32_t    ulMaxLen,
+    bool        fUsed,
+    uint32_t   *pulLen)
+{
+    REDSTATUS   ret;
+
+  #if (REDCONF_IMAP_INLINE == 1) && (REDCONF_IMAP_EXTERNAL == 1)
+    if(gpRedCoreVol->fImapInline)
+    {
+        ret = RedImapIViewRun(ulBlock, ulMaxLen, fUsed, pulLen);
+    }
+    else
+    {
+        ret = RedImapEViewRun(ulBlock, ulMaxLen, fUsed, pulLen);
+    }
+  #elif REDCONF_IMAP_INLINE == 1
+    ret = RedImapIViewRun(ulBlock, ulMaxLen, fUsed, pulLen);
+  #else
+    ret = RedImapEViewRun(ulBlock, ulMaxLen, fUsed, pulLen);
+  #endif
+
+    return ret;
+}
+
+
+/** @brief Count the blocks in a range which the view of the committed state
+           uses.
+
+    @param ulStart  The first block of the range.
+    @param ulCount  The number of blocks in the range.
+    @param pulUsed  On success, populated with the number of blocks in the range
+                    which the view uses.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EIO    A disk I/O error occurred.
+*/
+static REDSTATUS ImapViewCount(
+    uint32_t    ulStart,
+    uint32_t    ulCount,
+    uint32_t   *pulUsed)
+{
+    REDSTATUS   ret = 0;
+    uint32_t    ulPos = 0U;
+    uint32_t    ulUsed = 0U;
+    bool        fUsed = true;
+
+    /*  Runs of used and unused blocks alternate.
+    */
+    while((ret == 0) && (ulPos < ulCount))
+    {
+        uint32_t ulLen;
+
+        ret = ImapViewRun(ulStart + ulPos, ulCount - ulPos, fUsed, &ulLen);
+
+        if(ret == 0)
+        {
+            if(fUsed)
+            {
+                ulUsed += ulLen;
+            }
+
+            ulPos += ulLen;
+            fUsed = !fUsed;
+        }
+    }
+
+    if(ret == 0)
+    {
+        *pulUsed = ulUsed;
+    }
+
+    return ret;
+}
+
+
+/** @brief Measure a run of blocks which are held for the view of the committed
+           state: blocks which the view uses, and pinned copies of its nodes.
+
+    @param ulBlock  The first block of the run.
+    @param ulMaxLen The maximum length of the run.
+    @param pulLen   On success, populated with the length of the run; this is
+                    zero if @p ulBlock is not held.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EIO    A disk I/O error occurred.
+*/
+static REDSTATUS ImapViewHeldRun(
+    uint32_t    ulBlock,
+    uint32_t    ulMaxLen,
+    uint32_t   *pulLen)
+{
+    REDSTATUS   ret = 0;
+    uint32_t    ulLen = 0U;
+    bool        fDone = false;
+
+    while((ret == 0) && !fDone && (ulLen < ulMaxLen))
+    {
+        uint32_t ulRun = 0U;
+        uint32_t ulIdx;
+
+        for(ulIdx = 0U; ulIdx < gpRedCoreVol->ulViewPins; ulIdx++)
+        {
+            if(gpRedCoreVol->aViewPin[ulIdx].ulPinBlock == (ulBlock + ulLen))
+            {
+                ulRun = 1U;
+                break;
+            }
+        }
+
+        if((ulRun == 0U) && gpRedCoreVol->fViewPinned)
+        {
+            ret = ImapViewRun(ulBlock + ulLen, ulMaxLen - ulLen, true, &ulRun);
+        }
+
+        if(ulRun == 0U)
+        {
+            fDone = true;
+        }
+        else
+        {
+            ulLen += ulRun;
+        }
+    }
+
+    if(ret == 0)
+    {
+        *pulLen = ulLen;
+    }
+
+    return ret;
+}
+
+
+/** @brief Shorten a run of free blocks so that it ends before the first block
+           held for the view of the committed state.
+
+    @param ulBlock  The first block of the run.
+    @param pulLen   On entry, the length of the run.  On success, populated with
+                    the length of the run which precedes the first held block.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EIO    A disk I/O error occurred.
+*/
+static REDSTATUS ImapViewClampRun(
+    uint32_t    ulBlock,
+    uint32_t   *pulLen)
+{
+    REDSTATUS   ret = 0;
+    uint32_t    ulIdx;
+
+    if(gpRedCoreVol->fViewPinned)
+    {
+        ret = ImapViewRun(ulBlock, *pulLen, false, pulLen);
+    }
+
+    for(ulIdx = 0U; (ret == 0) && (ulIdx < gpRedCoreVol->ulViewPins); ulIdx++)
+    {
+        uint32_t ulPinBlock = gpRedCoreVol->aViewPin[ulIdx].ulPinBlock;
+
+        if((ulPinBlock >= ulBlock) && ((ulPinBlock - ulBlock) < *pulLen))
+        {
+            *pulLen = ulPinBlock - ulBlock;
+        }
+    }
+
+    return ret;
+}
+#endif /* REDCONF_API_POSIX_SNAPSHOT == 1 */
+#endif /* REDCONF_READ_ONLY == 0 */
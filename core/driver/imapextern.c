@@ -42,10 +42,26 @@
 */
 #define IMAPNODEIDX_IS_VALID(imapnode) ((imapnode) < REDMIN(gpRedCoreVol->ulImapNodeCount, METAROOT_ENTRIES))
 
+/*  When searching a branched imap node for a free block, the working state
+    bitmap is copied this many bytes at a time, so that it can be compared with
+    the committed state bitmap without holding two imap buffers.  Must be a
+    multiple of eight.
+*/
+#define IMAP_SCAN_BYTES 64U
+
 
 #if REDCONF_READ_ONLY == 0
+static REDSTATUS ImapFindFree(uint32_t ulStartIdx, uint32_t ulEndIdx, uint32_t *pulFreeIdx);
+static REDSTATUS ImapNodeFindFree(uint32_t ulImapNode, uint32_t ulStartEntry, uint32_t ulEndEntry, uint32_t *pulFreeEntry);
+static REDSTATUS ImapNodeFindUsed(uint32_t ulImapNode, uint32_t ulStartEntry, uint32_t ulEndEntry, uint32_t *pulUsedEntry);
 static REDSTATUS ImapNodeBranch(uint32_t ulImapNode, IMAPNODE **ppImap);
 static bool ImapNodeIsBranched(uint32_t ulImapNode);
+#if REDCONF_API_POSIX_SNAPSHOT == 1
+static uint32_t ImapNodeViewBlock(uint32_t ulImapNode);
+#endif
+#if IMAP_SUMMARY == 1
+static void ImapSummaryUpdate(uint32_t ulImapNode, uint32_t ulCount, bool fAllocated, uint32_t ulCommitted);
+#endif
 #endif
 
 
@@ -85,6 +101,7 @@ REDSTATUS RedImapEBlockGet(
         uint32_t    ulOffset = ulBlock - gpRedCoreVol->ulInodeTableStartBN;
         uint32_t    ulImapNode = ulOffset / IMAPNODE_ENTRIES;
         uint8_t     bMRToRead = bMR;
+        uint32_t    ulImapBlock;
         IMAPNODE   *pImap;
 
       #if REDCONF_READ_ONLY == 0
@@ -101,7 +118,19 @@ REDSTATUS RedImapEBlockGet(
         }
       #endif
 
-        ret = RedBufferGet(RedImapNodeBlock(bMRToRead, ulImapNode), BFLAG_META_IMAP, (void **)&pImap);
+        ulImapBlock = RedImapNodeBlock(bMRToRead, ulImapNode);
+
+      #if REDCONF_API_POSIX_SNAPSHOT == 1
+        /*  The view of the committed state reads a copy of the imap node if it
+            was pinned.
+        */
+        if(gpRedCoreVol->fViewEntered)
+        {
+            ulImapBlock = RedImapViewBlock(ulImapBlock);
+        }
+      #endif
+
+        ret = RedBufferGet(ulImapBlock, BFLAG_META_IMAP, (void **)&pImap);
 
         if(ret == 0)
         {
@@ -116,62 +145,139 @@ REDSTATUS RedImapEBlockGet(
 
 
 #if REDCONF_READ_ONLY == 0
-/** @brief Set the allocation bit of a block in the working-state imap.
+/** @brief Set the allocation bits of a range of blocks in the working-state
+           imap.
+
+    Each imap node which the range covers is branched and buffered once, and
+    its bits are updated a byte at a time.
 
-    @param ulBlock      The block number to allocate or free.
-    @param fAllocated   Whether to allocate the block (true) or free it (false).
+    @param ulStart      The first block to allocate or free.
+    @param ulCount      The number of blocks to allocate or free.
+    @param fAllocated   Whether to allocate the blocks (true) or free them
+                        (false).
+    @param pulCommitted On successful return, populated with the number of
+                        blocks in the range which are allocated in the
+                        committed state.  Only computed when freeing; zero when
+                        allocating.
 
     @return A negated ::REDSTATUS code indicating the operation result.
 
     @retval 0           Operation was successful.
-    @retval -RED_EINVAL @p ulBlock is out of range.
+    @retval -RED_EINVAL The range is out of range or empty; or @p pulCommitted
+                        is `NULL`.
     @retval -RED_EIO    A disk I/O error occurred.
 */
-REDSTATUS RedImapEBlockSet(
-    uint32_t    ulBlock,
-    bool        fAllocated)
+REDSTATUS RedImapEBlockRangeSet(
+    uint32_t    ulStart,
+    uint32_t    ulCount,
+    bool        fAllocated,
+    uint32_t   *pulCommitted)
 {
-    REDSTATUS   ret;
+    REDSTATUS   ret = 0;
 
     if(    gpRedCoreVol->fImapInline
-        || (ulBlock < gpRedCoreVol->ulInodeTableStartBN)
-        || (ulBlock >= gpRedVolume->ulBlockCount))
+        || (ulStart < gpRedCoreVol->ulInodeTableStartBN)
+        || (ulStart >= gpRedVolume->ulBlockCount)
+        || (ulCount == 0U)
+        || (ulCount > (gpRedVolume->ulBlockCount - ulStart))
+        || (pulCommitted == NULL))
     {
         REDERROR();
         ret = -RED_EINVAL;
     }
     else
     {
-        uint32_t    ulOffset = ulBlock - gpRedCoreVol->ulInodeTableStartBN;
-        uint32_t    ulImapNode = ulOffset / IMAPNODE_ENTRIES;
-        IMAPNODE   *pImap;
-
-        ret = ImapNodeBranch(ulImapNode, &pImap);
+        uint32_t    ulIdx = ulStart - gpRedCoreVol->ulInodeTableStartBN;
+        uint32_t    ulEndIdx = ulIdx + ulCount;
+        uint32_t    ulCommitted = 0U;
 
-        if(ret == 0)
+        while((ret == 0) && (ulIdx < ulEndIdx))
         {
-            uint32_t ulImapEntry = ulOffset % IMAPNODE_ENTRIES;
-
-            if(RedBitGet(pImap->abEntries, ulImapEntry) == fAllocated)
+            uint32_t    ulImapNode = ulIdx / IMAPNODE_ENTRIES;
+            uint32_t    ulNodeStartIdx = ulImapNode * IMAPNODE_ENTRIES;
+            uint32_t    ulEntry = ulIdx - ulNodeStartIdx;
+            uint32_t    ulEndEntry = REDMIN(ulEndIdx - ulNodeStartIdx, IMAPNODE_ENTRIES);
+            uint32_t    ulNodeCommitted = 0U;
+            bool        fWasBranched = ImapNodeIsBranched(ulImapNode);
+            IMAPNODE   *pImap;
+
+            ret = ImapNodeBranch(ulImapNode, &pImap);
+            if(ret == 0)
             {
-                /*  The driver shouldn't ever set a bit in the imap to its
-                    current value.  That shouldn't ever be needed, and it
-                    indicates that the driver is doing unnecessary I/O, or
-                    that the imap is corrupt.
+                uint32_t ulSameEntry;
+
+                /*  Find the first bit which already has the new value, if any.
                 */
-                CRITICAL_ERROR();
-                ret = -RED_EFUBAR;
+                if(fAllocated)
+                {
+                    ulSameEntry = RedBitFindSet(pImap->abEntries, NULL, ulEntry, ulEndEntry);
+                }
+                else
+                {
+                    ulSameEntry = RedBitFindClear(pImap->abEntries, NULL, ulEntry, ulEndEntry);
+                }
+
+                if(ulSameEntry != ulEndEntry)
+                {
+                    /*  The driver shouldn't ever set a bit in the imap to its
+                        current value.  That shouldn't ever be needed, and it
+                        indicates that the driver is doing unnecessary I/O, or
+                        that the imap is corrupt.
+                    */
+                    CRITICAL_ERROR();
+                    ret = -RED_EFUBAR;
+                }
+                else
+                {
+                    RedBufferModify(pImap, &pImap->abEntries[ulEntry >> 3U], ((ulEndEntry - 1U) >> 3U) - (ulEntry >> 3U) + 1U);
+                    RedBitRangeSet(pImap->abEntries, ulEntry, ulEndEntry, fAllocated);
+                }
+
+                RedBufferPut(pImap);
             }
-            else if(fAllocated)
+
+            /*  When freeing, count the blocks which are allocated in the
+                committed state.  If the node was not branched, the committed
+                state was the same as the working state, in which all of the
+                blocks were allocated.  Otherwise, the committed copy must be
+                examined; only one imap buffer can be held at a time, so this
+                is done after the working copy is released.
+            */
+            if((ret == 0) && !fAllocated)
             {
-                RedBitSet(pImap->abEntries, ulImapEntry);
+                if(!fWasBranched)
+                {
+                    ulNodeCommitted = ulEndEntry - ulEntry;
+                }
+                else
+                {
+                    const IMAPNODE *pImapCommitted;
+
+                    ret = RedBufferGet(RedImapNodeBlock(1U - gpRedCoreVol->bCurMR, ulImapNode), BFLAG_META_IMAP, (void **)&pImapCommitted);
+                    if(ret == 0)
+                    {
+                        ulNodeCommitted = RedBitCount(pImapCommitted->abEntries, ulEntry, ulEndEntry);
+
+                        RedBufferPut(pImapCommitted);
+                    }
+                }
+
+                ulCommitted += ulNodeCommitted;
             }
-            else
+
+          #if IMAP_SUMMARY == 1
+            if((ret == 0) && (ulStart >= gpRedCoreVol->ulFirstAllocableBN))
             {
-                RedBitClear(pImap->abEntries, ulImapEntry);
+                ImapSummaryUpdate(ulImapNode, ulEndEntry - ulEntry, fAllocated, ulNodeCommitted);
             }
+          #endif
 
-            RedBufferPut(pImap);
+            ulIdx = ulNodeStartIdx + ulEndEntry;
+        }
+
+        if(ret == 0)
+        {
+            *pulCommitted = ulCommitted;
         }
     }
 
@@ -208,114 +314,364 @@ REDSTATUS RedImapEBlockFindFree(
     }
     else
     {
-        bool        fFoundFree = false;
-        uint32_t    ulSearchBlock = ulBlock;
-        uint32_t    ulPrevImapNode = 0U; /* Init'd to suppress warnings */
-        IMAPNODE   *pImap = NULL; /* No imap buffer to start with */
+        /*  Blocks before the inode table aren't included in the bitmap.
+        */
+        uint32_t    ulStartIdx = ulBlock - gpRedCoreVol->ulInodeTableStartBN;
+        uint32_t    ulFreeIdx = 0U; /* Init'd to suppress warnings */
 
-        do
+        /*  Search from the starting block to the end of the volume, then wrap
+            around to the first allocable block.
+        */
+        ret = ImapFindFree(ulStartIdx, gpRedVolume->ulBlockCount - gpRedCoreVol->ulInodeTableStartBN, &ulFreeIdx);
+        if(ret == -RED_ENOSPC)
         {
-            /*  Blocks before the inode table aren't included in the bitmap.
-            */
-            uint32_t ulBmpIdx = ulSearchBlock - gpRedCoreVol->ulInodeTableStartBN;
+            ret = ImapFindFree(gpRedCoreVol->ulFirstAllocableBN - gpRedCoreVol->ulInodeTableStartBN, ulStartIdx, &ulFreeIdx);
+        }
 
-            /*  Compute which imap node we need and the index within that node.
-            */
-            uint32_t ulImapNode = ulBmpIdx / IMAPNODE_ENTRIES;
-            uint32_t ulImapIdx = ulBmpIdx % IMAPNODE_ENTRIES;
+        if(ret == 0)
+        {
+            *pulFreeBlock = ulFreeIdx + gpRedCoreVol->ulInodeTableStartBN;
+        }
+    }
 
-            /*  If we have an imap node buffered but it isn't the one we want,
-                release that buffer.
-            */
-            if((pImap != NULL) && (ulImapNode != ulPrevImapNode))
+    return ret;
+}
+
+
+/** @brief Measure a run of free blocks.
+
+    @param ulBlock  The first block of the run.
+    @param ulMaxLen The maximum length of the run.
+    @param pulLen   On success, populated with the number of consecutive blocks,
+                    starting with @p ulBlock, which are free; this is zero if
+                    @p ulBlock is not free, and at most @p ulMaxLen.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EINVAL @p ulBlock is out of range; or @p ulMaxLen is zero; or
+                        @p pulLen is `NULL`.
+    @retval -RED_EIO    A disk I/O error occurred.
+*/
+REDSTATUS RedImapEBlockFreeRun(
+    uint32_t    ulBlock,
+    uint32_t    ulMaxLen,
+    uint32_t   *pulLen)
+{
+    REDSTATUS   ret = 0;
+
+    if(    gpRedCoreVol->fImapInline
+        || (ulBlock < gpRedCoreVol->ulFirstAllocableBN)
+        || (ulBlock >= gpRedVolume->ulBlockCount)
+        || (ulMaxLen == 0U)
+        || (pulLen == NULL))
+    {
+        REDERROR();
+        ret = -RED_EINVAL;
+    }
+    else
+    {
+        uint32_t    ulStartIdx = ulBlock - gpRedCoreVol->ulInodeTableStartBN;
+        uint32_t    ulEndIdx = ulStartIdx + REDMIN(ulMaxLen, gpRedVolume->ulBlockCount - ulBlock);
+        uint32_t    ulIdx = ulStartIdx;
+        bool        fRunEnded = false;
+
+        while((ret == 0) && !fRunEnded && (ulIdx < ulEndIdx))
+        {
+            uint32_t ulImapNode = ulIdx / IMAPNODE_ENTRIES;
+            uint32_t ulNodeStartIdx = ulImapNode * IMAPNODE_ENTRIES;
+            uint32_t ulEndEntry = REDMIN(ulEndIdx - ulNodeStartIdx, IMAPNODE_ENTRIES);
+            uint32_t ulUsedEntry;
+
+            ret = ImapNodeFindUsed(ulImapNode, ulIdx - ulNodeStartIdx, ulEndEntry, &ulUsedEntry);
+            if(ret == 0)
             {
-                RedBufferPut(pImap);
-                pImap = NULL;
+                fRunEnded = ulUsedEntry < ulEndEntry;
+                ulIdx = ulNodeStartIdx + ulUsedEntry;
             }
+        }
 
-            /*  Get the imap node buffer if we don't have it already.
-            */
-            if(pImap == NULL)
-            {
-                ulPrevImapNode = ulImapNode;
+        if(ret == 0)
+        {
+            *pulLen = ulIdx - ulStartIdx;
+        }
+    }
+
+    return ret;
+}
+
+
+#if IMAP_SUMMARY == 1
+/** @brief Count the free blocks in each imap node.
+
+    Must be called when the volume is mounted or rolled back, when the working
+    state and committed state are the same.
 
-                ret = RedBufferGet(RedImapNodeBlock(gpRedCoreVol->bCurMR, ulImapNode),
-                    BFLAG_META_IMAP, (void **)&pImap);
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EIO    A disk I/O error occurred.
+*/
+REDSTATUS RedImapESummaryInit(void)
+{
+    uint32_t    ulFirstIdx = gpRedCoreVol->ulFirstAllocableBN - gpRedCoreVol->ulInodeTableStartBN;
+    uint32_t    ulEndIdx = gpRedVolume->ulBlockCount - gpRedCoreVol->ulInodeTableStartBN;
+    uint32_t    ulNodes = REDMIN(gpRedCoreVol->ulImapNodeCount, REDCONF_IMAP_SUMMARY_NODES);
+    uint32_t    ulImapNode;
+    REDSTATUS   ret = 0;
+
+    for(ulImapNode = 0U; (ret == 0) && (ulImapNode < ulNodes); ulImapNode++)
+    {
+        const IMAPNODE *pImap;
+
+        ret = RedBufferGet(RedImapNodeBlock(gpRedCoreVol->bCurMR, ulImapNode), BFLAG_META_IMAP, (void **)&pImap);
+        if(ret == 0)
+        {
+            uint32_t    ulNodeStartIdx = ulImapNode * IMAPNODE_ENTRIES;
+            uint32_t    ulEntry = (ulFirstIdx > ulNodeStartIdx) ? REDMIN(ulFirstIdx - ulNodeStartIdx, IMAPNODE_ENTRIES) : 0U;
+            uint32_t    ulEndEntry = REDMIN(ulEndIdx - ulNodeStartIdx, IMAPNODE_ENTRIES);
+            uint32_t    ulFree = 0U;
+
+            while(ulEntry < ulEndEntry)
+            {
+                ulEntry = RedBitFindClear(pImap->abEntries, NULL, ulEntry, ulEndEntry);
+                if(ulEntry < ulEndEntry)
+                {
+                    ulFree++;
+                    ulEntry++;
+                }
             }
 
+            RedBufferPut(pImap);
+
+            gpRedCoreVol->aulImapFreeWorking[ulImapNode] = ulFree;
+            gpRedCoreVol->aulImapFree[ulImapNode] = ulFree;
+        }
+    }
+
+    return ret;
+}
+
+
+/** @brief Update the free block counts of the imap nodes when a transaction
+           point is committed.
+
+    Committing makes the committed state the same as the working state, so
+    the almost free blocks become free.
+*/
+void RedImapESummaryTransact(void)
+{
+    if(!gpRedCoreVol->fImapInline)
+    {
+        uint32_t ulNodes = REDMIN(gpRedCoreVol->ulImapNodeCount, REDCONF_IMAP_SUMMARY_NODES);
+
+        RedMemCpy(gpRedCoreVol->aulImapFree, gpRedCoreVol->aulImapFreeWorking, ulNodes * sizeof(gpRedCoreVol->aulImapFree[0U]));
+    }
+}
+#endif /* IMAP_SUMMARY == 1 */
+
+
+/** @brief Search a range of the imap for a free block.
+
+    @param ulStartIdx   The first imap entry to examine.
+    @param ulEndIdx     The imap entry following the last one to examine.
+    @param pulFreeIdx   On success, populated with the imap entry of the free
+                        block.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EIO    A disk I/O error occurred.
+    @retval -RED_ENOSPC No free block was found in the range.
+*/
+static REDSTATUS ImapFindFree(
+    uint32_t    ulStartIdx,
+    uint32_t    ulEndIdx,
+    uint32_t   *pulFreeIdx)
+{
+    REDSTATUS   ret = -RED_ENOSPC;
+    uint32_t    ulIdx = ulStartIdx;
+
+    while((ret == -RED_ENOSPC) && (ulIdx < ulEndIdx))
+    {
+        uint32_t ulImapNode = ulIdx / IMAPNODE_ENTRIES;
+        uint32_t ulNodeStartIdx = ulImapNode * IMAPNODE_ENTRIES;
+        uint32_t ulEndEntry = REDMIN(ulEndIdx - ulNodeStartIdx, IMAPNODE_ENTRIES);
+        uint32_t ulFreeEntry;
+
+      #if IMAP_SUMMARY == 1
+        if((ulImapNode < REDCONF_IMAP_SUMMARY_NODES) && (gpRedCoreVol->aulImapFree[ulImapNode] == 0U))
+        {
+            /*  None of the blocks in this imap node can be allocated, so there
+                is no need to read it.
+            */
+        }
+        else
+      #endif
+        {
+            ret = ImapNodeFindFree(ulImapNode, ulIdx - ulNodeStartIdx, ulEndEntry, &ulFreeEntry);
             if(ret == 0)
             {
-                /*  As an optimization to reduce the number of RedBitGet()
-                    calls, if all eight blocks in the current byte are
-                    allocated, then skip to the next byte.
+                *pulFreeIdx = ulNodeStartIdx + ulFreeEntry;
+            }
+        }
+
+        ulIdx = ulNodeStartIdx + ulEndEntry;
+    }
+
+    return ret;
+}
+
+
+/** @brief Search a range of an imap node for a free block.
+
+    A block is free if it is free in both the working state and the committed
+    state.  If the imap node is not branched, the two states are the same node,
+    so only one bitmap needs to be examined.
+
+    @param ulImapNode   The imap node to search.
+    @param ulStartEntry The first entry in the node to examine.
+    @param ulEndEntry   The entry following the last one to examine.
+    @param pulFreeEntry On success, populated with the entry of the free block.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EIO    A disk I/O error occurred.
+    @retval -RED_ENOSPC No free block was found in the range.
+*/
+static REDSTATUS ImapNodeFindFree(
+    uint32_t    ulImapNode,
+    uint32_t    ulStartEntry,
+    uint32_t    ulEndEntry,
+    uint32_t   *pulFreeEntry)
+{
+    bool        fBranched = ImapNodeIsBranched(ulImapNode);
+    uint32_t    ulEntry = ulStartEntry;
+    REDSTATUS   ret = -RED_ENOSPC;
+
+    while((ret == -RED_ENOSPC) && (ulEntry < ulEndEntry))
+    {
+        const IMAPNODE *pImap;
+        REDSTATUS       getRet;
+
+        getRet = RedBufferGet(RedImapNodeBlock(gpRedCoreVol->bCurMR, ulImapNode), BFLAG_META_IMAP, (void **)&pImap);
+        if(getRet != 0)
+        {
+            ret = getRet;
+        }
+        else
+        {
+            /*  Skip to the next block which is free in the working state.
+            */
+            ulEntry = RedBitFindClear(pImap->abEntries, NULL, ulEntry, ulEndEntry);
+
+            if(ulEntry == ulEndEntry)
+            {
+                RedBufferPut(pImap);
+            }
+            else if(!fBranched)
+            {
+                RedBufferPut(pImap);
+                ret = 0;
+            }
+            else
+            {
+                uint8_t     abWorking[IMAP_SCAN_BYTES];
+                uint32_t    ulWinByte = (ulEntry >> 3U) & ~7U;
+                uint32_t    ulWinEnd = REDMIN(ulEndEntry, (ulWinByte + IMAP_SCAN_BYTES) << 3U);
+
+                /*  We aren't allowed to hold multiple imap buffers at the same
+                    time, since doing so would increase the minimum buffer
+                    count.  Copy part of the working state bitmap, then compare
+                    it with the committed state bitmap.
                 */
-                if(((ulImapIdx & 7U) == 0U) && (pImap->abEntries[ulImapIdx >> 3U] == UINT8_MAX))
+                RedMemCpy(abWorking, &pImap->abEntries[ulWinByte], ((ulWinEnd + 7U) >> 3U) - ulWinByte);
+                RedBufferPut(pImap);
+
+                getRet = RedBufferGet(RedImapNodeBlock(1U - gpRedCoreVol->bCurMR, ulImapNode), BFLAG_META_IMAP, (void **)&pImap);
+                if(getRet != 0)
                 {
-                    ulSearchBlock += REDMIN(8U, gpRedVolume->ulBlockCount - ulSearchBlock);
+                    ret = getRet;
                 }
                 else
                 {
-                    /*  If the block is free in the working state...
-                    */
-                    if(!RedBitGet(pImap->abEntries, ulImapIdx))
-                    {
-                        /*  We aren't allowed to hold multiple imap buffers at
-                            the same time, since doing so would increase the
-                            minimum buffer count.
-                        */
-                        RedBufferPut(pImap);
-                        pImap = NULL;
-
-                        /*  Get the buffer for the committed state imap.
-                        */
-                        ret = RedBufferGet(RedImapNodeBlock(1U - gpRedCoreVol->bCurMR, ulImapNode),
-                            BFLAG_META_IMAP, (void **)&pImap);
-                        if(ret == 0)
-                        {
-                            /*  If the block is free in the committed state...
-                            */
-                            if(!RedBitGet(pImap->abEntries, ulImapIdx))
-                            {
-                                /*  Found a free block.
-                                */
-                                fFoundFree = true;
-                                *pulFreeBlock = ulSearchBlock;
-                                break;
-                            }
-
-                            /*  Release the committed state imap buffer so we
-                                can reacquire the working state imap buffer on
-                                the next loop iteration.
-                            */
-                            RedBufferPut(pImap);
-                            pImap = NULL;
-                        }
-                    }
+                    uint32_t ulWinBit = ulWinByte << 3U;
+                    uint32_t ulFound = RedBitFindClear(&pImap->abEntries[ulWinByte], abWorking, ulEntry - ulWinBit, ulWinEnd - ulWinBit);
 
-                    ulSearchBlock++;
-                }
+                    RedBufferPut(pImap);
 
-                if(ulSearchBlock == gpRedVolume->ulBlockCount)
-                {
-                    ulSearchBlock = gpRedCoreVol->ulFirstAllocableBN;
+                    ulEntry = ulWinBit + ulFound;
+                    if(ulEntry < ulWinEnd)
+                    {
+                        ret = 0;
+                    }
                 }
             }
-        } while((ret == 0) && (ulSearchBlock != ulBlock));
-
-        if(pImap != NULL)
-        {
-            RedBufferPut(pImap);
         }
+    }
+
+    if(ret == 0)
+    {
+        *pulFreeEntry = ulEntry;
+    }
+
+    return ret;
+}
 
-        /*  If we searched every allocable block without finding a free block,
-            return an ENOSPC error.
+
+/** @brief Search a range of an imap node for a block which is not free.
+
+    @param ulImapNode   The imap node to search.
+    @param ulStartEntry The first entry in the node to examine.
+    @param ulEndEntry   The entry following the last one to examine.
+    @param pulUsedEntry On success, populated with the first entry in the range
+                        which is allocated in either the working state or the
+                        committed state; or @p ulEndEntry if there is none.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EIO    A disk I/O error occurred.
+*/
+static REDSTATUS ImapNodeFindUsed(
+    uint32_t        ulImapNode,
+    uint32_t        ulStartEntry,
+    uint32_t        ulEndEntry,
+    uint32_t       *pulUsedEntry)
+{
+    const IMAPNODE *pImap;
+    uint32_t        ulUsedEntry = ulEndEntry;
+    REDSTATUS       ret;
+
+    ret = RedBufferGet(RedImapNodeBlock(gpRedCoreVol->bCurMR, ulImapNode), BFLAG_META_IMAP, (void **)&pImap);
+    if(ret == 0)
+    {
+        ulUsedEntry = RedBitFindSet(pImap->abEntries, NULL, ulStartEntry, ulEndEntry);
+
+        RedBufferPut(pImap);
+
+        /*  Only one imap buffer can be held at a time, so the committed state
+            is searched separately, up to the first entry used in the working
+            state.
         */
-        if((ret == 0) && !fFoundFree)
+        if((ulUsedEntry > ulStartEntry) && ImapNodeIsBranched(ulImapNode))
         {
-            ret = -RED_ENOSPC;
+            ret = RedBufferGet(RedImapNodeBlock(1U - gpRedCoreVol->bCurMR, ulImapNode), BFLAG_META_IMAP, (void **)&pImap);
+            if(ret == 0)
+            {
+                ulUsedEntry = RedBitFindSet(pImap->abEntries, NULL, ulStartEntry, ulUsedEntry);
+
+                RedBufferPut(pImap);
+            }
         }
     }
 
+    if(ret == 0)
+    {
+        *pulUsedEntry = ulUsedEntry;
+    }
+
     return ret;
 }
 
@@ -387,6 +743,8 @@ static REDSTATUS ImapNodeBranch(
             if(ret == 0)
             {
                 RedBufferBranch(*ppImap, ulBlockCurrent);
+
+                TRANSTAT_ADD(gbRedVolNum, aulBranched[RED_BUFSTAT_IMAP], 1U);
             }
         }
     }
@@ -421,6 +779,191 @@ static bool ImapNodeIsBranched(
 
     return fIsBranched;
 }
+
+
+#if IMAP_SUMMARY == 1
+/** @brief Update the free block counts of an imap node when the allocation
+           state of some of its allocable blocks changes.
+
+    @param ulImapNode   The imap node whose blocks were allocated or freed.
+    @param ulCount      The number of blocks which were allocated or freed.
+    @param fAllocated   Whether the blocks were allocated (true) or freed
+                        (false).
+    @param ulCommitted  The number of freed blocks which are allocated in the
+                        committed state.
+*/
+static void ImapSummaryUpdate(
+    uint32_t    ulImapNode,
+    uint32_t    ulCount,
+    bool        fAllocated,
+    uint32_t    ulCommitted)
+{
+    if(ulImapNode < REDCONF_IMAP_SUMMARY_NODES)
+    {
+        if(fAllocated)
+        {
+            /*  Only free blocks are allocated, so the blocks were free in the
+                committed state.
+            */
+            REDASSERT(gpRedCoreVol->aulImapFree[ulImapNode] >= ulCount);
+
+            gpRedCoreVol->aulImapFreeWorking[ulImapNode] -= ulCount;
+            gpRedCoreVol->aulImapFree[ulImapNode] -= ulCount;
+        }
+        else
+        {
+            gpRedCoreVol->aulImapFreeWorking[ulImapNode] += ulCount;
+
+            /*  A block which is allocated in the committed state is almost
+                free: it cannot be allocated until the next transaction.
+            */
+            gpRedCoreVol->aulImapFree[ulImapNode] += ulCount - ulCommitted;
+        }
+    }
+}
+#endif
+
+
+#if REDCONF_API_POSIX_SNAPSHOT == 1
+/** @brief Measure a run of blocks which are all used, or all unused, by the
+           view of the committed state.
+
+    @param ulBlock  The first block of the run.
+    @param ulMaxLen The maximum length of the run.
+    @param fUsed    Whether to measure a run of blocks which the view uses
+                    (true) or does not use (false).
+    @param pulLen   On success, populated with the length of the run; this is
+                    zero if @p ulBlock does not match @p fUsed, and at most
+                    @p ulMaxLen.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EINVAL @p ulBlock is out of range; or @p ulMaxLen is zero; or
+                        @p pulLen is `NULL`.
+    @retval -RED_EIO    A disk I/O error occurred.
+*/
+REDSTATUS RedImapEViewRun(
+    uint32_t    ulBlock,
+    uint32_t    ulMaxLen,
+    bool        fUsed,
+    uint32_t   *pulLen)
+{
+    REDSTATUS   ret = 0;
+
+    if(    gpRedCoreVol->fImapInline
+        || (ulBlock < gpRedCoreVol->ulInodeTableStartBN)
+        || (ulBlock >= gpRedVolume->ulBlockCount)
+        || (ulMaxLen == 0U)
+        || (pulLen == NULL))
+    {
+        REDERROR();
+        ret = -RED_EINVAL;
+    }
+    else
+    {
+        uint32_t    ulOffset = ulBlock - gpRedCoreVol->ulInodeTableStartBN;
+        uint32_t    ulEndOffset = ulOffset + REDMIN(ulMaxLen, gpRedVolume->ulBlockCount - ulBlock);
+        uint32_t    ulRunEnd = ulOffset;
+        bool        fDone = false;
+
+        /*  Each imap node which the run covers is buffered one at a time.
+        */
+        while((ret == 0) && !fDone && (ulRunEnd < ulEndOffset))
+        {
+            uint32_t        ulImapNode = ulRunEnd / IMAPNODE_ENTRIES;
+            uint32_t        ulEntry = ulRunEnd % IMAPNODE_ENTRIES;
+            uint32_t        ulEndEntry = REDMIN(IMAPNODE_ENTRIES, ulEntry + (ulEndOffset - ulRunEnd));
+            const IMAPNODE *pImap;
+
+            ret = RedBufferGet(ImapNodeViewBlock(ulImapNode), BFLAG_META_IMAP, (void **)&pImap);
+            if(ret == 0)
+            {
+                uint32_t ulFound;
+
+                if(fUsed)
+                {
+                    ulFound = RedBitFindClear(pImap->abEntries, NULL, ulEntry, ulEndEntry);
+                }
+                else
+                {
+                    ulFound = RedBitFindSet(pImap->abEntries, NULL, ulEntry, ulEndEntry);
+                }
+
+                RedBufferPut(pImap);
+
+                ulRunEnd += ulFound - ulEntry;
+                fDone = ulFound < ulEndEntry;
+            }
+        }
+
+        if(ret == 0)
+        {
+            *pulLen = ulRunEnd - ulOffset;
+        }
+    }
+
+    return ret;
+}
+
+
+/** @brief Pin the imap nodes of the view of the committed state which a
+           transaction point would make writeable.
+
+    After the transaction point, the working state writes an imap node which
+    is branched now to the location which is committed now.  If the view reads
+    that location, the node is pinned.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EIO    A disk I/O error occurred.
+*/
+REDSTATUS RedImapEViewTransact(void)
+{
+    REDSTATUS   ret = 0;
+    uint32_t    ulImapNode;
+
+    for(ulImapNode = 0U; (ret == 0) && !gpRedCoreVol->fViewLost && (ulImapNode < gpRedCoreVol->ulImapNodeCount); ulImapNode++)
+    {
+        if(ImapNodeIsBranched(ulImapNode))
+        {
+            uint32_t ulBlockCommitted = RedImapNodeBlock(1U - gpRedCoreVol->bCurMR, ulImapNode);
+
+            /*  Nothing to do if the view reads the other location, or if
+                the node is already pinned.
+            */
+            if(ulBlockCommitted == ImapNodeViewBlock(ulImapNode))
+            {
+                ret = RedImapViewPin(ulBlockCommitted, BFLAG_META_IMAP);
+            }
+        }
+    }
+
+    return ret;
+}
+
+
+/** @brief Calculate the block number where the view of the committed state
+           reads an imap node.
+
+    @param ulImapNode   The imap node for which to calculate the block number.
+
+    @return Block number of the imap node, or of its copy if it was pinned.
+*/
+static uint32_t ImapNodeViewBlock(
+    uint32_t    ulImapNode)
+{
+    uint32_t    ulBlock = gpRedCoreVol->ulImapStartBN + (ulImapNode * 2U);
+
+    if(RedBitGet(gpRedCoreVol->ViewMR.abEntries, ulImapNode))
+    {
+        ulBlock++;
+    }
+
+    return RedImapViewBlock(ulBlock);
+}
+#endif /* REDCONF_API_POSIX_SNAPSHOT == 1 */
 #endif /* REDCONF_READ_ONLY == 0 */
 
 
@@ -447,7 +990,7 @@ uint32_t RedImapNodeBlock(
     {
         REDERROR();
     }
-    else if(RedBitGet(gpRedCoreVol->aMR[bMR].abEntries, ulImapNode))
+    else if(RedBitGet(IMAP_MR(bMR)->abEntries, ulImapNode))
     {
         /*  Bit is set, so point ulBlock at the second copy of the node.
         */
@@ -67,7 +67,7 @@ REDSTATUS RedImapIBlockGet(
     }
     else
     {
-        *pfAllocated = RedBitGet(gpRedCoreVol->aMR[bMR].abEntries, ulBlock - gpRedCoreVol->ulInodeTableStartBN);
+        *pfAllocated = RedBitGet(IMAP_MR(bMR)->abEntries, ulBlock - gpRedCoreVol->ulInodeTableStartBN);
         ret = 0;
     }
 
@@ -76,35 +76,61 @@ REDSTATUS RedImapIBlockGet(
 
 
 #if REDCONF_READ_ONLY == 0
-/** @brief Set the allocation bit of a block in the working metaroot.
-
-    @param ulBlock      The block number to allocate or free.
-    @param fAllocated   Whether to allocate the block (true) or free it (false).
+/** @brief Set the allocation bits of a range of blocks in the working
+           metaroot.
+
+    @param ulStart      The first block to allocate or free.
+    @param ulCount      The number of blocks to allocate or free.
+    @param fAllocated   Whether to allocate the blocks (true) or free them
+                        (false).
+    @param pulCommitted On successful return, populated with the number of
+                        blocks in the range which are allocated in the
+                        committed state.  Only computed when freeing; zero when
+                        allocating.
 
     @return A negated ::REDSTATUS code indicating the operation result.
 
     @retval 0           Operation was successful.
-    @retval -RED_EINVAL @p ulBlock is out of range; or the current volume does
-                        not use the inline imap.
+    @retval -RED_EINVAL The range is out of range or empty; or @p pulCommitted
+                        is `NULL`; or the current volume does not use the
+                        inline imap.
 */
-REDSTATUS RedImapIBlockSet(
-    uint32_t    ulBlock,
-    bool        fAllocated)
+REDSTATUS RedImapIBlockRangeSet(
+    uint32_t    ulStart,
+    uint32_t    ulCount,
+    bool        fAllocated,
+    uint32_t   *pulCommitted)
 {
     REDSTATUS   ret;
 
     if(    (!gpRedCoreVol->fImapInline)
-        || (ulBlock < gpRedCoreVol->ulInodeTableStartBN)
-        || (ulBlock >= gpRedVolume->ulBlockCount))
+        || (ulStart < gpRedCoreVol->ulInodeTableStartBN)
+        || (ulStart >= gpRedVolume->ulBlockCount)
+        || (ulCount == 0U)
+        || (ulCount > (gpRedVolume->ulBlockCount - ulStart))
+        || (pulCommitted == NULL))
     {
         REDERROR();
         ret = -RED_EINVAL;
     }
     else
     {
-        uint32_t ulOffset = ulBlock - gpRedCoreVol->ulInodeTableStartBN;
+        uint32_t ulStartIdx = ulStart - gpRedCoreVol->ulInodeTableStartBN;
+        uint32_t ulEndIdx = ulStartIdx + ulCount;
+        uint32_t ulSameIdx;
 
-        if(RedBitGet(gpRedMR->abEntries, ulOffset) == fAllocated)
+        /*  Find the first bit which already has the new value, if any.
+        */
+        if(fAllocated)
+        {
+            ulSameIdx = RedBitFindSet(gpRedMR->abEntries, NULL, ulStartIdx, ulEndIdx);
+        }
+        else
+        {
+            ulSameIdx = RedBitFindClear(gpRedMR->abEntries, NULL, ulStartIdx, ulEndIdx);
+        }
+
+        if(ulSameIdx != ulEndIdx)
         {
             /*  The driver shouldn't ever set a bit in the imap to its current
                 value.  This is more of a problem with the external imap, but it
@@ -113,14 +139,18 @@ REDSTATUS RedImapIBlockSet(
             CRITICAL_ERROR();
             ret = -RED_EFUBAR;
         }
-        else if(fAllocated)
-        {
-            RedBitSet(gpRedMR->abEntries, ulOffset);
-            ret = 0;
-        }
         else
         {
-            RedBitClear(gpRedMR->abEntries, ulOffset);
+            if(fAllocated)
+            {
+                *pulCommitted = 0U;
+            }
+            else
+            {
+                *pulCommitted = RedBitCount(gpRedCoreVol->aMR[1U - gpRedCoreVol->bCurMR].abEntries, ulStartIdx, ulEndIdx);
+            }
+
+            RedBitRangeSet(gpRedMR->abEntries, ulStartIdx, ulEndIdx, fAllocated);
             ret = 0;
         }
     }
@@ -159,57 +189,143 @@ REDSTATUS RedImapIBlockFindFree(
     {
         const uint8_t  *pbBmpCurMR = gpRedCoreVol->aMR[gpRedCoreVol->bCurMR].abEntries;
         const uint8_t  *pbBmpCmtMR = gpRedCoreVol->aMR[1U - gpRedCoreVol->bCurMR].abEntries;
-        uint32_t        ulSearchBlock = ulBlock;
 
-        /*  Default to an ENOSPC error, which will be returned if we search
-            every allocable block without finding a free block.
+        /*  Blocks before the inode table aren't included in the bitmap.
         */
-        ret = -RED_ENOSPC;
+        uint32_t        ulStartIdx = ulBlock - gpRedCoreVol->ulInodeTableStartBN;
+        uint32_t        ulEndIdx = gpRedVolume->ulBlockCount - gpRedCoreVol->ulInodeTableStartBN;
+        uint32_t        ulFreeIdx;
 
-        do
+        /*  A block is free if it is free in both the working state and the
+            committed state.  Search from the starting block to the end of the
+            volume, then wrap around to the first allocable block.
+        */
+        ulFreeIdx = RedBitFindClear(pbBmpCurMR, pbBmpCmtMR, ulStartIdx, ulEndIdx);
+        if(ulFreeIdx == ulEndIdx)
         {
-            /*  Blocks before the inode table aren't included in the bitmap.
-            */
-            uint32_t ulBmpIdx = ulSearchBlock - gpRedCoreVol->ulInodeTableStartBN;
+            ulEndIdx = ulStartIdx;
+            ulFreeIdx = RedBitFindClear(pbBmpCurMR, pbBmpCmtMR, gpRedCoreVol->ulFirstAllocableBN - gpRedCoreVol->ulInodeTableStartBN, ulEndIdx);
+        }
 
-            /*  As an optimization to reduce the number of RedBitGet() calls, if
-                all eight blocks in the current byte are allocated, then skip
-                to the next byte.
-            */
-            if(((ulBmpIdx & 7U) == 0U) && (pbBmpCurMR[ulBmpIdx >> 3U] == UINT8_MAX))
-            {
-                ulSearchBlock += REDMIN(8U, gpRedVolume->ulBlockCount - ulSearchBlock);
-            }
-            else
-            {
-                /*  If the block is free in the working state...
-                */
-                if(!RedBitGet(pbBmpCurMR, ulBmpIdx))
-                {
-                    /*  If the block is free in the committed state...
-                    */
-                    if(!RedBitGet(pbBmpCmtMR, ulBmpIdx))
-                    {
-                        /*  Found a free block.
-                        */
-                        *pulFreeBlock = ulSearchBlock;
-                        ret = 0;
-                        break;
-                    }
-                }
-
-                ulSearchBlock++;
-            }
+        if(ulFreeIdx == ulEndIdx)
+        {
+            ret = -RED_ENOSPC;
+        }
+        else
+        {
+            *pulFreeBlock = ulFreeIdx + gpRedCoreVol->ulInodeTableStartBN;
+            ret = 0;
+        }
+    }
 
-            if(ulSearchBlock == gpRedVolume->ulBlockCount)
-            {
-                ulSearchBlock = gpRedCoreVol->ulFirstAllocableBN;
-            }
-        } while(ulSearchBlock != ulBlock);
+    return ret;
+}
+
+
+/** @brief Measure a run of free blocks.
+
+    @param ulBlock  The first block of the run.
+    @param ulMaxLen The maximum length of the run.
+    @param pulLen   On success, populated with the number of consecutive blocks,
+                    starting with @p ulBlock, which are free; this is zero if
+                    @p ulBlock is not free, and at most @p ulMaxLen.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EINVAL @p ulBlock is out of range; or @p ulMaxLen is zero; or
+                        @p pulLen is `NULL`; or the current volume does not
+                        use the inline imap.
+*/
+REDSTATUS RedImapIBlockFreeRun(
+    uint32_t    ulBlock,
+    uint32_t    ulMaxLen,
+    uint32_t   *pulLen)
+{
+    REDSTATUS   ret;
+
+    if(    (!gpRedCoreVol->fImapInline)
+        || (ulBlock < gpRedCoreVol->ulFirstAllocableBN)
+        || (ulBlock >= gpRedVolume->ulBlockCount)
+        || (ulMaxLen == 0U)
+        || (pulLen == NULL))
+    {
+        REDERROR();
+        ret = -RED_EINVAL;
+    }
+    else
+    {
+        uint32_t ulStartIdx = ulBlock - gpRedCoreVol->ulInodeTableStartBN;
+        uint32_t ulEndIdx = ulStartIdx + REDMIN(ulMaxLen, gpRedVolume->ulBlockCount - ulBlock);
+
+        /*  The run ends at the first block which is allocated in either the
+            working state or the committed state.
+        */
+        *pulLen = RedBitFindSet(gpRedCoreVol->aMR[gpRedCoreVol->bCurMR].abEntries, gpRedCoreVol->aMR[1U - gpRedCoreVol->bCurMR].abEntries, ulStartIdx, ulEndIdx) - ulStartIdx;
+        ret = 0;
+    }
+
+    return ret;
+}
+
+
+#if REDCONF_API_POSIX_SNAPSHOT == 1
+/** @brief Measure a run of blocks which are all used, or all unused, by the
+           view of the committed state.
+
+    @param ulBlock  The first block of the run.
+    @param ulMaxLen The maximum length of the run.
+    @param fUsed    Whether to measure a run of blocks which the view uses
+                    (true) or does not use (false).
+    @param pulLen   On success, populated with the length of the run; this is
+                    zero if @p ulBlock does not match @p fUsed, and at most
+                    @p ulMaxLen.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EINVAL @p ulBlock is out of range; or @p ulMaxLen is zero; or
+                        @p pulLen is `NULL`; or the current volume does not
+                        use the inline imap.
+*/
+REDSTATUS RedImapIViewRun(
+    uint32_t    ulBlock,
+    uint32_t    ulMaxLen,
+    bool        fUsed,
+    uint32_t   *pulLen)
+{
+    REDSTATUS   ret;
+
+    if(    (!gpRedCoreVol->fImapInline)
+        || (ulBlock < gpRedCoreVol->ulInodeTableStartBN)
+        || (ulBlock >= gpRedVolume->ulBlockCount)
+        || (ulMaxLen == 0U)
+        || (pulLen == NULL))
+    {
+        REDERROR();
+        ret = -RED_EINVAL;
+    }
+    else
+    {
+        const uint8_t  *pbBmpViewMR = gpRedCoreVol->ViewMR.abEntries;
+        uint32_t        ulStartIdx = ulBlock - gpRedCoreVol->ulInodeTableStartBN;
+        uint32_t        ulEndIdx = ulStartIdx + REDMIN(ulMaxLen, gpRedVolume->ulBlockCount - ulBlock);
+
+        if(fUsed)
+        {
+            *pulLen = RedBitFindClear(pbBmpViewMR, NULL, ulStartIdx, ulEndIdx) - ulStartIdx;
+        }
+        else
+        {
+            *pulLen = RedBitFindSet(pbBmpViewMR, NULL, ulStartIdx, ulEndIdx) - ulStartIdx;
+        }
+
+        ret = 0;
     }
 
     return ret;
 }
+#endif /* REDCONF_API_POSIX_SNAPSHOT == 1 */
 #endif /* REDCONF_READ_ONLY == 0 */
 
 #endif /* REDCONF_IMAP_INLINE == 1 */
@@ -116,11 +116,32 @@ REDSTATUS RedInodeMount(
         RedMemSet(pInode, 0U, sizeof(*pInode));
         pInode->ulInode = ulInode;
 
-        ret = InodeGetCurrentCopy(pInode->ulInode, &bWhich);
+      #if REDCONF_API_POSIX_SNAPSHOT == 1
+        if(gpRedCoreVol->fViewEntered && gpRedCoreVol->fViewLost)
+        {
+            /*  The view of the committed state was abandoned, so its inodes
+                may have been overwritten.
+            */
+            ret = -RED_EIO;
+        }
+        else
+      #endif
+        {
+            ret = InodeGetCurrentCopy(pInode->ulInode, &bWhich);
+        }
 
         if(ret == 0)
         {
-            ret = RedBufferGet(InodeBlock(pInode->ulInode, bWhich), BFLAG_META_INODE, (void **)&pInode->pInodeBuf);
+            uint32_t ulBlock = InodeBlock(pInode->ulInode, bWhich);
+
+          #if REDCONF_API_POSIX_SNAPSHOT == 1
+            if(gpRedCoreVol->fViewEntered)
+            {
+                ulBlock = RedImapViewBlock(ulBlock);
+            }
+          #endif
+
+            ret = RedBufferGet(ulBlock, BFLAG_META_INODE, (void **)&pInode->pInodeBuf);
         }
 
       #if REDCONF_READ_ONLY == 0
@@ -272,6 +293,8 @@ REDSTATUS RedInodeCreate(
 
                 if(ret == 0)
                 {
+                    TRANSTAT_ADD(gbRedVolNum, aulAllocated[RED_BUFSTAT_INODE], 1U);
+
                     /*  Mark the inode block as allocated.
                     */
                     ret = InodeBitSet(pInode->ulInode, bWriteableWhich, true);
@@ -341,6 +364,14 @@ REDSTATUS RedInodeCreate(
 
           #if REDCONF_API_POSIX == 1
             gpRedMR->ulFreeInodes--;
+
+            /*  If this was the lowest free inode, the lowest which might be
+                free is the next one.
+            */
+            if(pInode->ulInode == gpRedCoreVol->ulInodeFreeHint)
+            {
+                gpRedCoreVol->ulInodeFreeHint++;
+            }
           #endif
         }
     }
@@ -532,7 +563,8 @@ REDSTATUS RedInodeFree(
     }
     else
     {
-        bool fSlot0Allocated;
+        uint32_t    ulInode;
+        bool        fSlot0Allocated;
 
         RedBufferDiscard(pInode->pInodeBuf);
         pInode->pInodeBuf = NULL;
@@ -583,6 +615,7 @@ REDSTATUS RedInodeFree(
             }
         }
 
+        ulInode = pInode->ulInode;
         pInode->ulInode = INODE_INVALID;
 
         if(ret == 0)
@@ -595,6 +628,11 @@ REDSTATUS RedInodeFree(
             else
             {
                 gpRedMR->ulFreeInodes++;
+
+                if(ulInode < gpRedCoreVol->ulInodeFreeHint)
+                {
+                    gpRedCoreVol->ulInodeFreeHint = ulInode;
+                }
             }
         }
     }
@@ -852,40 +890,50 @@ REDSTATUS RedInodeBranch(
         REDERROR();
         ret = -RED_EINVAL;
     }
-    else if(!pInode->fBranched)
+    else
     {
-        uint8_t bWhich;
-
-        ret = InodeGetWriteableCopy(pInode->ulInode, &bWhich);
+        /*  The caller is about to update the inode header fields.  Changes to
+            the block pointers are declared separately, as they are made.
+        */
+        RedBufferModify(pInode->pInodeBuf, &((const uint8_t *)pInode->pInodeBuf)[NODEHEADER_SIZE], INODE_HEADER_SIZE - NODEHEADER_SIZE);
 
-        if(ret == 0)
+        if(!pInode->fBranched)
         {
-            RedBufferBranch(pInode->pInodeBuf, InodeBlock(pInode->ulInode, bWhich));
-            pInode->fBranched = true;
-            pInode->fDirty = true;
-        }
+            uint8_t bWhich;
 
-        /*  Toggle the inode slots: the old slot block becomes almost free
-            (still used by the committed state) and the new slot block becomes
-            new.
-        */
-        if(ret == 0)
-        {
-            ret = InodeBitSet(pInode->ulInode, 1U - bWhich, false);
-        }
+            ret = InodeGetWriteableCopy(pInode->ulInode, &bWhich);
 
-        if(ret == 0)
+            if(ret == 0)
+            {
+                RedBufferBranch(pInode->pInodeBuf, InodeBlock(pInode->ulInode, bWhich));
+                pInode->fBranched = true;
+                pInode->fDirty = true;
+
+                TRANSTAT_ADD(gbRedVolNum, aulBranched[RED_BUFSTAT_INODE], 1U);
+            }
+
+            /*  Toggle the inode slots: the old slot block becomes almost free
+                (still used by the committed state) and the new slot block
+                becomes new.
+            */
+            if(ret == 0)
+            {
+                ret = InodeBitSet(pInode->ulInode, 1U - bWhich, false);
+            }
+
+            if(ret == 0)
+            {
+                ret = InodeBitSet(pInode->ulInode, bWhich, true);
+            }
+
+            CRITICAL_ASSERT(ret == 0);
+        }
+        else
         {
-            ret = InodeBitSet(pInode->ulInode, bWhich, true);
+            RedBufferDirty(pInode->pInodeBuf);
+            pInode->fDirty = true;
+            ret = 0;
         }
-
-        CRITICAL_ASSERT(ret == 0);
-    }
-    else
-    {
-        RedBufferDirty(pInode->pInodeBuf);
-        pInode->fDirty = true;
-        ret = 0;
     }
 
     return ret;
@@ -896,6 +944,10 @@ REDSTATUS RedInodeBranch(
 #if (REDCONF_READ_ONLY == 0) && (REDCONF_API_POSIX == 1)
 /** @brief Find a free inode number.
 
+    Finds the lowest free inode number.  The search starts at
+    COREVOLUME::ulInodeFreeHint, since all inodes below it are known to be in
+    use, so creating files does not get slower as more inodes are used.
+
     @param pulInode On successful return, populated with a free inode number.
 
     @return A negated ::REDSTATUS code indicating the operation result.
@@ -925,7 +977,9 @@ static REDSTATUS InodeFindFree(
 
         ret = 0;
 
-        for(ulInode = INODE_FIRST_FREE; ulInode < (INODE_FIRST_VALID + gpRedCoreVol->ulInodeCount); ulInode++)
+        REDASSERT(gpRedCoreVol->ulInodeFreeHint >= INODE_FIRST_FREE);
+
+        for(ulInode = gpRedCoreVol->ulInodeFreeHint; ulInode < (INODE_FIRST_VALID + gpRedCoreVol->ulInodeCount); ulInode++)
         {
             bool fFree;
 
@@ -941,6 +995,9 @@ static REDSTATUS InodeFindFree(
         {
             if(ulInode < (INODE_FIRST_VALID + gpRedCoreVol->ulInodeCount))
             {
+                /*  The inodes which were skipped are in use.
+                */
+                gpRedCoreVol->ulInodeFreeHint = ulInode;
                 *pulInode = ulInode;
             }
             else
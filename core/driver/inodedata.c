@@ -61,6 +61,53 @@ typedef enum
     BRANCHDEPTH_MAX         = BRANCHDEPTH_FILE_DATA
 } BRANCHDEPTH;
 
+#if REDCONF_READ_AHEAD_BLOCKS > 0U
+/*  The number of inodes for which sequential reads are tracked at once.  When
+    more inodes than this are being read, the least recently tracked inode is
+    forgotten.
+*/
+#define RA_STREAMS 4U
+
+/** @brief Sequential read detection state for an inode.
+
+    The table of these is static and zero-initialized.  Since #INODE_INVALID is
+    zero, every entry starts out unused.  Entries are not cleared when a volume
+    is unmounted: a stale entry only affects how much is read ahead, and it is
+    replaced once other inodes are read.
+*/
+typedef struct
+{
+    uint32_t    ulInode;        /**< Inode number; INODE_INVALID (zero) if the entry has never been used. */
+    uint8_t     bVolNum;        /**< Volume number of the inode. */
+    uint64_t    ullNextOffset;  /**< File offset where the next sequential read would start. */
+    uint32_t    ulWindow;       /**< Read-ahead window, in blocks; zero if the reads are not sequential. */
+    uint32_t    ulRaNext;       /**< File block offset after the last block read ahead. */
+} RASTREAM;
+#endif
+
+#if REDCONF_READ_ONLY == 0
+/** @brief File data blocks allocated as an extent by WriteAligned(), which
+           BranchOneBlock() uses before allocating blocks one at a time.
+*/
+typedef struct
+{
+    uint32_t    ulWanted;   /**< Number of blocks the write may still allocate; zero when no write is in progress. */
+    uint32_t    ulNext;     /**< First allocated block which has not been used. */
+    uint32_t    ulLeft;     /**< Number of allocated blocks which have not been used. */
+} WRITEEXTENT;
+
+#if DELETE_SUPPORTED || TRUNCATE_SUPPORTED
+/** @brief A run of contiguous blocks freed by Shrink() whose imap bits have
+           not yet been cleared.
+*/
+typedef struct
+{
+    uint32_t    ulStart;    /**< First block of the run. */
+    uint32_t    ulCount;    /**< Number of blocks in the run; zero if there is no run. */
+} TRUNCRUN;
+#endif
+#endif
+
 
 #if REDCONF_READ_ONLY == 0
 #if DELETE_SUPPORTED || TRUNCATE_SUPPORTED
@@ -72,11 +119,16 @@ static REDSTATUS TruncDindir(CINODE *pInode, bool *pfFreed);
 static REDSTATUS TruncIndir(CINODE *pInode, bool *pfFreed);
 #endif
 static REDSTATUS TruncDataBlock(const CINODE *pInode, uint32_t *pulBlock, bool fPropagate);
+static REDSTATUS TruncFreeBlock(uint32_t ulBlock);
+static REDSTATUS TruncFlush(void);
 #endif
 static REDSTATUS ExpandPrepare(CINODE *pInode);
 #if (REDCONF_API_POSIX == 1) && (REDCONF_API_POSIX_FRESERVE == 1)
 static REDSTATUS CountSparseBlocks(CINODE *pInode, uint64_t ullOffset, uint64_t ullLen, uint32_t *pulSparseBlocks);
 #endif
+#if (REDCONF_API_POSIX == 1) && (REDCONF_API_POSIX_DEFRAG == 1)
+static REDSTATUS DefragBlock(CINODE *pInode, uint32_t ulBlock, bool *pfMoved);
+#endif
 #endif
 static REDSTATUS SeekInode(CINODE *pInode, uint32_t ulBlock);
 static void SeekCoord(CINODE *pInode, uint32_t ulBlock);
@@ -89,9 +141,27 @@ static REDSTATUS WriteAligned(CINODE *pInode, uint32_t ulBlockStart, uint32_t *p
 static REDSTATUS GetExtent(CINODE *pInode, uint32_t ulBlockStart, uint32_t *pulExtentStart, uint32_t *pulExtentLen);
 #if REDCONF_READ_ONLY == 0
 static REDSTATUS BranchBlock(CINODE *pInode, BRANCHDEPTH depth, bool fBuffer);
-static REDSTATUS BranchOneBlock(uint32_t *pulBlock, void **ppBuffer, uint16_t uBFlag);
+static uint32_t BranchDataGoal(const CINODE *pInode);
+static REDSTATUS BranchOneBlock(uint32_t *pulBlock, void **ppBuffer, uint16_t uBFlag, uint32_t ulGoal);
+static REDSTATUS BranchAllocBlock(uint32_t *pulBlock, uint16_t uBFlag, uint32_t ulGoal);
+static void BranchSetEntry(const void *pBuffer, uint32_t *pulEntry, uint32_t ulBlock);
 static REDSTATUS BranchBlockCost(const CINODE *pInode, BRANCHDEPTH depth, uint32_t *pulCost);
 #endif
+#if REDCONF_READ_AHEAD_BLOCKS > 0U
+static void ReadAhead(CINODE *pInode, uint64_t ullStart, uint32_t ulLen);
+#endif
+
+
+#if REDCONF_READ_AHEAD_BLOCKS > 0U
+static RASTREAM gaRaStream[RA_STREAMS];
+static uint32_t gulRaStreamNext;
+#endif
+#if REDCONF_READ_ONLY == 0
+static WRITEEXTENT gWriteExtent;
+#if DELETE_SUPPORTED || TRUNCATE_SUPPORTED
+static TRUNCRUN gTruncRun;
+#endif
+#endif
 
 
 /** @brief Read data from an inode.
@@ -197,6 +267,10 @@ REDSTATUS RedInodeDataRead(
         if(ret == 0)
         {
             *pulLen = ulLen;
+
+          #if REDCONF_READ_AHEAD_BLOCKS > 0U
+            ReadAhead(pInode, ullStart, ulLen);
+          #endif
         }
     }
 
@@ -450,6 +524,11 @@ static REDSTATUS Shrink(
         RedInodePutData(pInode);
 
       #if REDCONF_DIRECT_POINTERS > 0U
+        if(ulTruncBlock < REDCONF_DIRECT_POINTERS)
+        {
+            RedBufferModify(pInode->pInodeBuf, &pInode->pInodeBuf->aulEntries[ulTruncBlock], (REDCONF_DIRECT_POINTERS - ulTruncBlock) * sizeof(uint32_t));
+        }
+
         while(ulTruncBlock < REDCONF_DIRECT_POINTERS)
         {
             ret = TruncDataBlock(pInode, &pInode->pInodeBuf->aulEntries[ulTruncBlock], true);
@@ -478,6 +557,7 @@ static REDSTATUS Shrink(
                 {
                     if(fFreed)
                     {
+                        RedBufferModify(pInode->pInodeBuf, &pInode->pInodeBuf->aulEntries[pInode->uInodeEntry], sizeof(uint32_t));
                         pInode->pInodeBuf->aulEntries[pInode->uInodeEntry] = BLOCK_SPARSE;
                     }
 
@@ -515,6 +595,7 @@ static REDSTATUS Shrink(
 
                     if(fFreed)
                     {
+                        RedBufferModify(pInode->pInodeBuf, &pInode->pInodeBuf->aulEntries[uOrigInodeEntry], sizeof(uint32_t));
                         pInode->pInodeBuf->aulEntries[uOrigInodeEntry] = BLOCK_SPARSE;
                     }
 
@@ -536,6 +617,18 @@ static REDSTATUS Shrink(
             }
         }
       #endif
+
+        /*  Free the last run of blocks, even if an error occurred, so that the
+            blocks which were removed from the inode are not leaked.
+        */
+        {
+            REDSTATUS flushRet = TruncFlush();
+
+            if(ret == 0)
+            {
+                ret = flushRet;
+            }
+        }
     }
 
     return ret;
@@ -602,7 +695,15 @@ static REDSTATUS TruncDindir(
 
         if(fBranch)
         {
-            ret = BranchBlock(pInode, BRANCHDEPTH_DINDIR, false);
+            /*  Free the pending blocks first, so that they count toward the
+                free space available for branching.
+            */
+            ret = TruncFlush();
+
+            if(ret == 0)
+            {
+                ret = BranchBlock(pInode, BRANCHDEPTH_DINDIR, false);
+            }
         }
 
         if(ret == 0)
@@ -650,6 +751,7 @@ static REDSTATUS TruncDindir(
 
                         if(fBranch && fIndirFreed)
                         {
+                            RedBufferModify(pInode->pDindir, &pInode->pDindir->aulEntries[uEntry], sizeof(uint32_t));
                             pInode->pDindir->aulEntries[uEntry] = BLOCK_SPARSE;
                         }
                     }
@@ -671,7 +773,7 @@ static REDSTATUS TruncDindir(
                 {
                     RedInodePutDindir(pInode);
 
-                    ret = RedImapBlockSet(pInode->ulDindirBlock, false);
+                    ret = TruncFreeBlock(pInode->ulDindirBlock);
                 }
             }
         }
@@ -728,7 +830,15 @@ static REDSTATUS TruncIndir(
 
         if(fBranch)
         {
-            ret = BranchBlock(pInode, BRANCHDEPTH_INDIR, false);
+            /*  Free the pending blocks first, so that they count toward the
+                free space available for branching.
+            */
+            ret = TruncFlush();
+
+            if(ret == 0)
+            {
+                ret = BranchBlock(pInode, BRANCHDEPTH_INDIR, false);
+            }
         }
 
         if(ret == 0)
@@ -736,6 +846,11 @@ static REDSTATUS TruncIndir(
             uint32_t ulIndirEntriesMax = INODE_DATA_BLOCKS - (pInode->ulLogicalBlock - pInode->uIndirEntry);
             uint16_t uIndirEntries = (uint16_t)REDMIN(INDIR_ENTRIES, ulIndirEntriesMax);
 
+            if(fBranch && (pInode->uIndirEntry < uIndirEntries))
+            {
+                RedBufferModify(pInode->pIndir, &pInode->pIndir->aulEntries[pInode->uIndirEntry], ((uint32_t)uIndirEntries - pInode->uIndirEntry) * sizeof(uint32_t));
+            }
+
             for(uEntry = pInode->uIndirEntry; uEntry < uIndirEntries; uEntry++)
             {
                 ret = TruncDataBlock(pInode, &pInode->pIndir->aulEntries[uEntry], fBranch);
@@ -754,7 +869,7 @@ static REDSTATUS TruncIndir(
                 {
                     RedInodePutIndir(pInode);
 
-                    ret = RedImapBlockSet(pInode->ulIndirBlock, false);
+                    ret = TruncFreeBlock(pInode->ulIndirBlock);
                 }
             }
         }
@@ -793,7 +908,7 @@ static REDSTATUS TruncDataBlock(
     }
     else if(*pulBlock != BLOCK_SPARSE)
     {
-        ret = RedImapBlockSet(*pulBlock, false);
+        ret = TruncFreeBlock(*pulBlock);
 
       #if REDCONF_INODE_BLOCKS == 1
         if(ret == 0)
@@ -823,6 +938,72 @@ static REDSTATUS TruncDataBlock(
 
     return ret;
 }
+
+
+/** @brief Free a block which has been removed from an inode being truncated.
+
+    The imap is not updated right away: contiguous blocks are collected into a
+    run, which is freed all at once by TruncFlush() when a block which does not
+    extend it is freed, or when the truncate is done.
+
+    @param ulBlock  The block to free.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EIO    A disk I/O error occurred.
+    @retval -RED_EINVAL Invalid parameters.
+*/
+static REDSTATUS TruncFreeBlock(
+    uint32_t    ulBlock)
+{
+    REDSTATUS   ret = 0;
+
+    if((gTruncRun.ulCount > 0U) && (ulBlock == (gTruncRun.ulStart + gTruncRun.ulCount)))
+    {
+        gTruncRun.ulCount++;
+    }
+    else if((gTruncRun.ulCount > 0U) && ((ulBlock + 1U) == gTruncRun.ulStart))
+    {
+        gTruncRun.ulStart = ulBlock;
+        gTruncRun.ulCount++;
+    }
+    else
+    {
+        ret = TruncFlush();
+
+        if(ret == 0)
+        {
+            gTruncRun.ulStart = ulBlock;
+            gTruncRun.ulCount = 1U;
+        }
+    }
+
+    return ret;
+}
+
+
+/** @brief Free the run of blocks collected by TruncFreeBlock(), if any.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EIO    A disk I/O error occurred.
+    @retval -RED_EINVAL Invalid parameters.
+*/
+static REDSTATUS TruncFlush(void)
+{
+    REDSTATUS   ret = 0;
+
+    if(gTruncRun.ulCount > 0U)
+    {
+        ret = RedImapBlockRangeSet(gTruncRun.ulStart, gTruncRun.ulCount, false);
+
+        gTruncRun.ulCount = 0U;
+    }
+
+    return ret;
+}
 #endif /* DELETE_SUPPORTED || TRUNCATE_SUPPORTED */
 
 
@@ -871,6 +1052,7 @@ static REDSTATUS ExpandPrepare(
 
                 if(ret == 0)
                 {
+                    RedBufferModify(pInode->pbData, &pInode->pbData[ulOldSizeByteInBlock], REDCONF_BLOCK_SIZE - ulOldSizeByteInBlock);
                     RedMemSet(&pInode->pbData[ulOldSizeByteInBlock], 0U, REDCONF_BLOCK_SIZE - ulOldSizeByteInBlock);
                 }
             }
@@ -1156,6 +1338,293 @@ static REDSTATUS CountSparseBlocks(
 #endif /* (REDCONF_READ_ONLY == 0) && (REDCONF_API_POSIX == 1) && (REDCONF_API_POSIX_FRESERVE == 1) */
 
 
+#if (REDCONF_API_POSIX == 1) && (REDCONF_API_POSIX_DEFRAG == 1)
+/** @brief Count the extents of the data of an inode.
+
+    An extent is a run of file blocks which are contiguous on disk, and which
+    ReadAligned() can therefore read with a single block device request.
+    Sparse blocks are not part of any extent.
+
+    @param pInode       A pointer to the cached inode structure.
+    @param pulExtents   On successful return, populated with the number of
+                        extents.
+    @param pulBlocks    On successful return, populated with the number of
+                        allocated data blocks.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EINVAL @p pInode is not a mounted cached inode pointer; or
+                        @p pulExtents or @p pulBlocks is `NULL`.
+    @retval -RED_EIO    A disk I/O error occurred.
+*/
+REDSTATUS RedInodeDataExtents(
+    CINODE     *pInode,
+    uint32_t   *pulExtents,
+    uint32_t   *pulBlocks)
+{
+    REDSTATUS   ret = 0;
+
+    if(!CINODE_IS_MOUNTED(pInode) || (pulExtents == NULL) || (pulBlocks == NULL))
+    {
+        REDERROR();
+        ret = -RED_EINVAL;
+    }
+    else
+    {
+        uint32_t    ulFileBlocks = (uint32_t)((pInode->pInodeBuf->ullSize + (REDCONF_BLOCK_SIZE - 1U)) >> BLOCK_SIZE_P2);
+        uint32_t    ulBlock = 0U;
+        uint32_t    ulExtents = 0U;
+        uint32_t    ulBlocks = 0U;
+
+        while((ret == 0) && (ulBlock < ulFileBlocks))
+        {
+            uint32_t ulExtentStart;
+            uint32_t ulExtentLen = ulFileBlocks - ulBlock;
+
+            ret = GetExtent(pInode, ulBlock, &ulExtentStart, &ulExtentLen);
+            if(ret == 0)
+            {
+                ulExtents++;
+                ulBlocks += ulExtentLen;
+                ulBlock += ulExtentLen;
+            }
+            else if(ret == -RED_ENODATA)
+            {
+                ret = 0;
+                ulBlock++;
+            }
+            else
+            {
+                /*  Other errors are propagated.
+                */
+            }
+        }
+
+        RedInodePutData(pInode);
+
+        if(ret == 0)
+        {
+            *pulExtents = ulExtents;
+            *pulBlocks = ulBlocks;
+        }
+    }
+
+    return ret;
+}
+
+
+#if REDCONF_READ_ONLY == 0
+/** @brief Move the data of an inode into contiguous blocks.
+
+    Every allocated data block is copied into a new block, and the new blocks
+    are allocated as a single extent if there is a long enough run of free
+    blocks, or otherwise as few extents as the free space allows.  The old
+    blocks are freed: blocks from the committed state become free after the
+    next transaction point, so until then, the old layout of the file remains
+    intact on disk.  The file data is not changed.
+
+    Nothing is done if the data is already a single extent; otherwise, the
+    inode is branched.
+
+    @param pInode   A pointer to the cached inode structure.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EINVAL @p pInode is not a mounted cached inode pointer.
+    @retval -RED_EIO    A disk I/O error occurred.
+    @retval -RED_ENOSPC There is not enough free space for a second copy of
+                        the data.
+*/
+REDSTATUS RedInodeDataDefrag(
+    CINODE     *pInode)
+{
+    uint32_t    ulExtents = 0U;
+    uint32_t    ulBlocks = 0U;
+    REDSTATUS   ret;
+
+    ret = RedInodeDataExtents(pInode, &ulExtents, &ulBlocks);
+
+    if((ret == 0) && (ulExtents > 1U))
+    {
+        /*  Check up front that every block can be moved, as well as the
+            indirect nodes which are branched along the way, so that the file
+            is not left partly moved.
+        */
+        if(RedVolFreeBlockCount() < (ulBlocks + (ulBlocks / INDIR_ENTRIES) + INODE_MAX_DEPTH))
+        {
+            ret = -RED_ENOSPC;
+        }
+        else
+        {
+            ret = RedInodeBranch(pInode);
+        }
+
+        if(ret == 0)
+        {
+            uint32_t    ulFileBlocks = (uint32_t)((pInode->pInodeBuf->ullSize + (REDCONF_BLOCK_SIZE - 1U)) >> BLOCK_SIZE_P2);
+            uint32_t    ulBlock;
+
+            /*  The blocks which are still to be moved are the size of the
+                extent which BranchAllocBlock() allocates.
+            */
+            gWriteExtent.ulWanted = ulBlocks;
+
+            for(ulBlock = 0U; (ret == 0) && (ulBlock < ulFileBlocks); ulBlock++)
+            {
+                bool fMoved = false;
+
+                ret = DefragBlock(pInode, ulBlock, &fMoved);
+                if((ret == 0) && fMoved)
+                {
+                    gWriteExtent.ulWanted--;
+                }
+            }
+
+            gWriteExtent.ulWanted = 0U;
+
+            if(gWriteExtent.ulLeft > 0U)
+            {
+                REDSTATUS freeRet = RedImapFreeExtent(gWriteExtent.ulNext, gWriteExtent.ulLeft);
+
+                CRITICAL_ASSERT(freeRet == 0);
+                if(ret == 0)
+                {
+                    ret = freeRet;
+                }
+
+                gWriteExtent.ulLeft = 0U;
+            }
+        }
+    }
+
+    return ret;
+}
+
+
+/** @brief Move one data block of an inode for RedInodeDataDefrag().
+
+    The parent nodes of the block are branched, its data is copied to a newly
+    allocated block, and the old block is freed.
+
+    @param pInode   A pointer to the cached inode structure.
+    @param ulBlock  The file block offset of the block to move.
+    @param pfMoved  On successful return, populated with whether a block was
+                    moved: false if @p ulBlock is sparse.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EIO    A disk I/O error occurred.
+    @retval -RED_ENOSPC Insufficient free space to perform the allocation.
+*/
+static REDSTATUS DefragBlock(
+    CINODE     *pInode,
+    uint32_t    ulBlock,
+    bool       *pfMoved)
+{
+    REDSTATUS   ret;
+
+    ret = SeekInode(pInode, ulBlock);
+    if(ret == -RED_ENODATA)
+    {
+        ret = 0;
+        *pfMoved = false;
+    }
+    else if(ret == 0)
+    {
+        uint16_t    uBFlag = CINODE_DATA_BFLAG(pInode);
+        uint32_t    ulOldBlock = pInode->ulDataBlock;
+        uint32_t    ulNewBlock = BLOCK_SPARSE;
+        const void *pOld = NULL;
+
+        /*  Release the data buffer: the old block is freed below, and it
+            cannot be discarded while it is referenced.
+        */
+        RedInodePutData(pInode);
+
+        ret = BranchBlock(pInode, BRANCHDEPTH_INDIR, false);
+
+        if(ret == 0)
+        {
+            ret = RedBufferGet(ulOldBlock, uBFlag, (void **)&pOld);
+        }
+
+        if(ret == 0)
+        {
+            uint32_t    ulGoal = BranchDataGoal(pInode);
+            void       *pNew;
+
+            /*  When the current extent is used up, look for a free run which
+                can hold the rest of the file, rather than taking the first
+                free run: once part of the file has been moved, the blocks it
+                occupied leave behind many short free runs.
+            */
+            if(gWriteExtent.ulLeft == 0U)
+            {
+                ret = RedImapFindExtent(gWriteExtent.ulWanted, &ulGoal);
+            }
+
+            if(ret == 0)
+            {
+                ret = BranchAllocBlock(&ulNewBlock, uBFlag, ulGoal);
+            }
+
+            if(ret == 0)
+            {
+                ret = RedBufferGet(ulNewBlock, (uint16_t)((uint32_t)uBFlag | BFLAG_NEW | BFLAG_DIRTY), &pNew);
+            }
+
+            if(ret == 0)
+            {
+                RedMemCpy(pNew, pOld, REDCONF_BLOCK_SIZE);
+                RedBufferPut(pNew);
+            }
+
+            RedBufferPut(pOld);
+        }
+
+        if(ret == 0)
+        {
+          #if INDIRS_EXIST
+            if(pInode->uIndirEntry != COORD_ENTRY_INVALID)
+            {
+                BranchSetEntry(pInode->pIndir, &pInode->pIndir->aulEntries[pInode->uIndirEntry], ulNewBlock);
+            }
+            else
+          #endif
+            {
+                BranchSetEntry(pInode->pInodeBuf, &pInode->pInodeBuf->aulEntries[pInode->uInodeEntry], ulNewBlock);
+            }
+
+            pInode->ulDataBlock = ulNewBlock;
+
+            /*  Free the old block: if it is part of the committed state, it
+                becomes almost free.
+            */
+            ret = RedImapBlockSet(ulOldBlock, false);
+        }
+
+        CRITICAL_ASSERT(ret == 0);
+
+        if(ret == 0)
+        {
+            *pfMoved = true;
+        }
+    }
+    else
+    {
+        /*  Other errors are propagated.
+        */
+    }
+
+    return ret;
+}
+#endif /* REDCONF_READ_ONLY == 0 */
+#endif /* (REDCONF_API_POSIX == 1) && (REDCONF_API_POSIX_DEFRAG == 1) */
+
+
 /** @brief Seek to a given position within an inode, then buffer the data block.
 
     On successful return, pInode->pbData will be populated with a buffer
@@ -1599,6 +2068,7 @@ static REDSTATUS WriteUnaligned(
 
             if(ret == 0)
             {
+                RedBufferModify(pInode->pbData, &pInode->pbData[ullStart & (REDCONF_BLOCK_SIZE - 1U)], ulLen);
                 RedMemCpy(&pInode->pbData[ullStart & (REDCONF_BLOCK_SIZE - 1U)], pbBuffer, ulLen);
             }
         }
@@ -1675,9 +2145,13 @@ static REDSTATUS WriteAligned(
                     if((ret == 0) || (ret == -RED_ENODATA))
                     {
                         /*  Create or branch the parent nodes (if necessary) and
-                            allocate the file data block.
+                            allocate the file data block.  If the data block
+                            must be allocated, the blocks for the rest of the
+                            write are allocated with it, as an extent.
                         */
+                        gWriteExtent.ulWanted = ulBlockCount - i;
                         ret = BranchBlock(pInode, BRANCHDEPTH_FILE_DATA, false);
+                        gWriteExtent.ulWanted = 0U;
                     }
                 }
                 else
@@ -1746,6 +2220,23 @@ static REDSTATUS WriteAligned(
             }
         }
 
+        /*  Free the blocks of the extent which were not needed, because some
+            of the file blocks were already branched, or because the write
+            stopped early.
+        */
+        if(gWriteExtent.ulLeft > 0U)
+        {
+            REDSTATUS freeRet = RedImapFreeExtent(gWriteExtent.ulNext, gWriteExtent.ulLeft);
+
+            CRITICAL_ASSERT(freeRet == 0);
+            if(ret == 0)
+            {
+                ret = freeRet;
+            }
+
+            gWriteExtent.ulLeft = 0U;
+        }
+
         if((ret == -RED_ENOSPC) && (ulBlockIndex > 0U))
         {
             ret = 0;
@@ -1857,9 +2348,22 @@ static REDSTATUS BranchBlock(
 
     ret = BranchBlockCost(pInode, depth, &ulCost);
 
-    if((ret == 0) && (ulCost > RedVolFreeBlockCount()))
+    if(ret == 0)
     {
-        ret = -RED_ENOSPC;
+        uint32_t ulFree = RedVolFreeBlockCount();
+
+        /*  If the data block will come from an extent which is already
+            allocated, it doesn't need free space.
+        */
+        if((depth == BRANCHDEPTH_FILE_DATA) && (gWriteExtent.ulLeft > 0U))
+        {
+            ulFree++;
+        }
+
+        if(ulCost > ulFree)
+        {
+            ret = -RED_ENOSPC;
+        }
     }
 
     if(ret == 0)
@@ -1867,7 +2371,7 @@ static REDSTATUS BranchBlock(
       #if DINDIRS_EXIST
         if(pInode->uDindirEntry != COORD_ENTRY_INVALID)
         {
-            ret = BranchOneBlock(&pInode->ulDindirBlock, (void **)&pInode->pDindir, BFLAG_META_DINDIR);
+            ret = BranchOneBlock(&pInode->ulDindirBlock, (void **)&pInode->pDindir, BFLAG_META_DINDIR, BLOCK_SPARSE);
 
             if(ret == 0)
             {
@@ -1875,7 +2379,7 @@ static REDSTATUS BranchBlock(
                 */
                 pInode->pDindir->ulInode = pInode->ulInode;
 
-                pInode->pInodeBuf->aulEntries[pInode->uInodeEntry] = pInode->ulDindirBlock;
+                BranchSetEntry(pInode->pInodeBuf, &pInode->pInodeBuf->aulEntries[pInode->uInodeEntry], pInode->ulDindirBlock);
             }
         }
 
@@ -1885,7 +2389,7 @@ static REDSTATUS BranchBlock(
         {
             if((pInode->uIndirEntry != COORD_ENTRY_INVALID) && (depth >= BRANCHDEPTH_INDIR))
             {
-                ret = BranchOneBlock(&pInode->ulIndirBlock, (void **)&pInode->pIndir, BFLAG_META_INDIR);
+                ret = BranchOneBlock(&pInode->ulIndirBlock, (void **)&pInode->pIndir, BFLAG_META_INDIR, BLOCK_SPARSE);
 
                 if(ret == 0)
                 {
@@ -1896,12 +2400,12 @@ static REDSTATUS BranchBlock(
                   #if DINDIRS_EXIST
                     if(pInode->uDindirEntry != COORD_ENTRY_INVALID)
                     {
-                        pInode->pDindir->aulEntries[pInode->uDindirEntry] = pInode->ulIndirBlock;
+                        BranchSetEntry(pInode->pDindir, &pInode->pDindir->aulEntries[pInode->uDindirEntry], pInode->ulIndirBlock);
                     }
                     else
                   #endif
                     {
-                        pInode->pInodeBuf->aulEntries[pInode->uInodeEntry] = pInode->ulIndirBlock;
+                        BranchSetEntry(pInode->pInodeBuf, &pInode->pInodeBuf->aulEntries[pInode->uInodeEntry], pInode->ulIndirBlock);
                     }
                 }
             }
@@ -1917,19 +2421,19 @@ static REDSTATUS BranchBlock(
               #endif
                 void  **ppBufPtr = (fBuffer || (pInode->pbData != NULL)) ? (void **)&pInode->pbData : NULL;
 
-                ret = BranchOneBlock(&pInode->ulDataBlock, ppBufPtr, CINODE_DATA_BFLAG(pInode));
+                ret = BranchOneBlock(&pInode->ulDataBlock, ppBufPtr, CINODE_DATA_BFLAG(pInode), BranchDataGoal(pInode));
 
                 if(ret == 0)
                 {
                   #if INDIRS_EXIST
                     if(pInode->uIndirEntry != COORD_ENTRY_INVALID)
                     {
-                        pInode->pIndir->aulEntries[pInode->uIndirEntry] = pInode->ulDataBlock;
+                        BranchSetEntry(pInode->pIndir, &pInode->pIndir->aulEntries[pInode->uIndirEntry], pInode->ulDataBlock);
                     }
                     else
                   #endif
                     {
-                        pInode->pInodeBuf->aulEntries[pInode->uInodeEntry] = pInode->ulDataBlock;
+                        BranchSetEntry(pInode->pInodeBuf, &pInode->pInodeBuf->aulEntries[pInode->uInodeEntry], pInode->ulDataBlock);
                     }
 
                   #if REDCONF_INODE_BLOCKS == 1
@@ -1957,6 +2461,52 @@ static REDSTATUS BranchBlock(
 }
 
 
+/** @brief Get the preferred location for the data block which BranchBlock()
+           is about to allocate or branch.
+
+    This is the block following the file data block which precedes it in the
+    same indirect node (or the inode, for a direct block), so that a file which
+    is written sequentially is kept contiguous even while other files are being
+    written.  The previous block in a different node is not examined, since
+    that node is not buffered.
+
+    @param pInode   A pointer to the cached inode structure, which has been
+                    seeked to the data block.
+
+    @return The goal block, or ::BLOCK_SPARSE if there is none.
+*/
+static uint32_t BranchDataGoal(
+    const CINODE   *pInode)
+{
+    uint32_t        ulPrevBlock = BLOCK_SPARSE;
+    uint32_t        ulGoal = BLOCK_SPARSE;
+
+  #if INDIRS_EXIST
+    if(pInode->uIndirEntry != COORD_ENTRY_INVALID)
+    {
+        if(pInode->uIndirEntry > 0U)
+        {
+            ulPrevBlock = pInode->pIndir->aulEntries[pInode->uIndirEntry - 1U];
+        }
+    }
+    else
+  #endif
+    {
+        if(pInode->uInodeEntry > 0U)
+        {
+            ulPrevBlock = pInode->pInodeBuf->aulEntries[pInode->uInodeEntry - 1U];
+        }
+    }
+
+    if(ulPrevBlock != BLOCK_SPARSE)
+    {
+        ulGoal = ulPrevBlock + 1U;
+    }
+
+    return ulGoal;
+}
+
+
 /** @brief Branch a block.
 
     The block can be a double indirect, indirect, or file data block.
@@ -1979,6 +2529,8 @@ static REDSTATUS BranchBlock(
                     buffer for the block.
     @param uBFlag   The buffer type flags: BFLAG_META_DINDIR, BFLAG_META_INDIR,
                     or zero for file data.
+    @param ulGoal   The block to allocate, if it is free; see
+                    RedImapAllocExtent().
 
     @retval 0           Operation was successful.
     @retval -RED_EIO    A disk I/O error occurred.
@@ -1987,7 +2539,8 @@ static REDSTATUS BranchBlock(
 static REDSTATUS BranchOneBlock(
     uint32_t   *pulBlock,
     void      **ppBuffer,
-    uint16_t    uBFlag)
+    uint16_t    uBFlag,
+    uint32_t    ulGoal)
 {
     REDSTATUS   ret = 0;
 
@@ -2030,12 +2583,14 @@ static REDSTATUS BranchOneBlock(
                 /*  Block does not exist or is committed state, so allocate a
                     new block for the branch.
                 */
-                ret = RedImapAllocBlock(pulBlock);
+                ret = BranchAllocBlock(pulBlock, uBFlag, ulGoal);
 
                 if(ret == 0)
                 {
                     if(ulPrevBlock == BLOCK_SPARSE)
                     {
+                        TRANSTAT_ADD(gbRedVolNum, aulAllocated[RedBufferStatType(uBFlag)], 1U);
+
                       #if (REDCONF_API_POSIX == 1) && (REDCONF_API_POSIX_FRESERVE == 1)
                         if(gpRedCoreVol->fUseReservedInodeBlocks)
                         {
@@ -2072,6 +2627,8 @@ static REDSTATUS BranchOneBlock(
                     }
                     else
                     {
+                        TRANSTAT_ADD(gbRedVolNum, aulBranched[RedBufferStatType(uBFlag)], 1U);
+
                         /*  Branch the buffer for the committed state block to
                             the newly allocated location.
                         */
@@ -2104,6 +2661,92 @@ static REDSTATUS BranchOneBlock(
 }
 
 
+/** @brief Allocate a block for BranchOneBlock().
+
+    While WriteAligned() is writing, file data blocks are allocated as an
+    extent which is large enough for the rest of the write, so that the data
+    is contiguous even when indirect nodes must also be allocated, and the imap
+    is searched once for the extent rather than once for each block.
+
+    @param pulBlock On successful return, populated with the allocated block.
+    @param uBFlag   The buffer type flags of the block being branched.
+    @param ulGoal   The block to allocate, if it is free.  When an extent is
+                    allocated, this is the goal for its first block.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EIO    A disk I/O error occurred.
+    @retval -RED_ENOSPC Insufficient free space to perform the allocation.
+*/
+static REDSTATUS BranchAllocBlock(
+    uint32_t   *pulBlock,
+    uint16_t    uBFlag,
+    uint32_t    ulGoal)
+{
+    REDSTATUS   ret = 0;
+
+    if((gWriteExtent.ulWanted == 0U) || ((uBFlag & (BFLAG_META_INDIR | BFLAG_META_DINDIR)) != 0U))
+    {
+        ret = RedImapAllocBlock(ulGoal, pulBlock);
+    }
+    else
+    {
+        if(gWriteExtent.ulLeft == 0U)
+        {
+            uint32_t ulFree = RedVolFreeBlockCount();
+            uint32_t ulMeta = (gWriteExtent.ulWanted / INDIR_ENTRIES) + INODE_MAX_DEPTH;
+            uint32_t ulWanted = 1U;
+
+            /*  Leave enough free space to branch the indirect nodes which the
+                rest of the write might need.
+            */
+            if(ulFree > ulMeta)
+            {
+                ulWanted = REDMIN(gWriteExtent.ulWanted, ulFree - ulMeta);
+            }
+
+            ret = RedImapAllocExtent(ulGoal, ulWanted, &gWriteExtent.ulNext, &gWriteExtent.ulLeft);
+        }
+
+        if(ret == 0)
+        {
+            *pulBlock = gWriteExtent.ulNext;
+            gWriteExtent.ulNext++;
+            gWriteExtent.ulLeft--;
+        }
+    }
+
+    return ret;
+}
+
+
+/** @brief Point a block pointer in a branched node at a branched block.
+
+    The pointer is only written (and declared as modified, for the benefit of
+    the node CRC) if its value is changing, which is not the case when the
+    block was already branched.
+
+    @param pBuffer  The metadata buffer containing the block pointer.
+    @param pulEntry The block pointer to update.
+    @param ulBlock  The new block number.
+*/
+static void BranchSetEntry(
+    const void *pBuffer,
+    uint32_t   *pulEntry,
+    uint32_t    ulBlock)
+{
+    if(*pulEntry != ulBlock)
+    {
+        RedBufferModify(pBuffer, pulEntry, sizeof(*pulEntry));
+        *pulEntry = ulBlock;
+    }
+  #if BUFFER_CRC_INCREMENTAL == 0
+    (void)pBuffer;
+  #endif
+}
+
+
 /** @brief Compute the free space cost of branching a block.
 
     The caller must first use SeekInode() to the block to be branched.
@@ -2232,3 +2875,84 @@ static REDSTATUS BranchBlockCost(
     return ret;
 }
 #endif /* REDCONF_READ_ONLY == 0 */
+
+
+#if REDCONF_READ_AHEAD_BLOCKS > 0U
+/** @brief Detect sequential reads and read ahead of them.
+
+    Reads are sequential if each one starts where the previous read of the same
+    inode ended.  Once a sequential read reaches the blocks which have not been
+    read ahead, the next extent of the file is read into the read-ahead buffer.
+    The read-ahead window starts small and doubles on each such read, up to
+    #REDCONF_READ_AHEAD_BLOCKS; a non-sequential read resets it.
+
+    Errors are ignored: read-ahead is only an optimization, and if there is a
+    problem reading the blocks, it will be reported when they are actually read.
+
+    @param pInode   A pointer to the cached inode structure which was read.
+    @param ullStart The file offset at which the read started.
+    @param ulLen    The number of bytes which were read.
+*/
+static void ReadAhead(
+    CINODE     *pInode,
+    uint64_t    ullStart,
+    uint32_t    ulLen)
+{
+    RASTREAM   *pStream = NULL;
+    uint32_t    ulIdx;
+
+    for(ulIdx = 0U; ulIdx < RA_STREAMS; ulIdx++)
+    {
+        if((gaRaStream[ulIdx].ulInode == pInode->ulInode) && (gaRaStream[ulIdx].bVolNum == gbRedVolNum))
+        {
+            pStream = &gaRaStream[ulIdx];
+            break;
+        }
+    }
+
+    if(pStream == NULL)
+    {
+        pStream = &gaRaStream[gulRaStreamNext];
+        gulRaStreamNext = (gulRaStreamNext + 1U) % RA_STREAMS;
+
+        pStream->ulInode = pInode->ulInode;
+        pStream->bVolNum = gbRedVolNum;
+        pStream->ulWindow = 0U;
+        pStream->ulRaNext = 0U;
+    }
+    else if(ullStart != pStream->ullNextOffset)
+    {
+        pStream->ulWindow = 0U;
+        pStream->ulRaNext = 0U;
+    }
+    else
+    {
+        uint32_t ulNextBlock = (uint32_t)((ullStart + ulLen + (REDCONF_BLOCK_SIZE - 1U)) >> BLOCK_SIZE_P2);
+        uint32_t ulFileBlocks = (uint32_t)((pInode->pInodeBuf->ullSize + (REDCONF_BLOCK_SIZE - 1U)) >> BLOCK_SIZE_P2);
+
+        if((ulNextBlock >= pStream->ulRaNext) && (ulNextBlock < ulFileBlocks))
+        {
+            uint32_t ulExtentStart;
+            uint32_t ulExtentLen;
+
+            pStream->ulWindow = (pStream->ulWindow == 0U) ? 2U : REDMIN(pStream->ulWindow * 2U, REDCONF_READ_AHEAD_BLOCKS);
+            ulExtentLen = REDMIN(pStream->ulWindow, ulFileBlocks - ulNextBlock);
+
+            if(GetExtent(pInode, ulNextBlock, &ulExtentStart, &ulExtentLen) == 0)
+            {
+                (void)RedBufferReadAhead(ulExtentStart, ulExtentLen);
+                pStream->ulRaNext = ulNextBlock + ulExtentLen;
+            }
+            else
+            {
+                /*  Sparse or unreadable: nothing to read ahead at this block,
+                    try again after it.
+                */
+                pStream->ulRaNext = ulNextBlock + 1U;
+            }
+        }
+    }
+
+    pStream->ullNextOffset = ullStart + ulLen;
+}
+#endif /* REDCONF_READ_AHEAD_BLOCKS > 0U */
@@ -39,11 +39,12 @@
 */
 #define BM_ENHANCED 2U
 
-/*  GPL release only has the simple buffer module.
+/*  GPL release only has the simple buffer module, which supports the
+    write-gather buffer for file data.
 
     Commercial release has both, so:
-      - Only the enhanced buffer module supports the write-gather buffer, so
-        using enabling it automatically selects the enhanced buffer module.
+      - Enabling the write-gather buffer automatically selects the enhanced
+        buffer module, which can gather more kinds of writes.
       - Otherwise, the decision is based on a buffer count threshold, for now.
 */
 #if (RED_KIT == RED_KIT_GPL) || ((REDCONF_BUFFER_WRITE_GATHER_SIZE_KB == 0U) && (REDCONF_BUFFER_COUNT < 24U))
@@ -52,6 +53,22 @@
   #define BUFFER_MODULE BM_ENHANCED
 #endif
 
+/*  Replacement policies for the simple buffer module.  BP_LRU repurposes the
+    least recently used buffer.  BP_SLRU (segmented LRU) is the same, except
+    that unreferenced metadata buffers are kept in a protected segment, up to
+    REDCONF_BUFFER_META_SEGMENT of them, which is only used once no other
+    buffers are available.  This keeps large file data or directory reads from
+    evicting the inode, indirect, and imap nodes.
+*/
+#define BP_LRU  1U
+#define BP_SLRU 2U
+
+#if REDCONF_BUFFER_META_SEGMENT > 0U
+  #define BUFFER_POLICY BP_SLRU
+#else
+  #define BUFFER_POLICY BP_LRU
+#endif
+
 
 #if DINDIRS_EXIST
   #define INODE_META_BUFFERS 3U /* Inode, double indirect, indirect */
@@ -161,9 +178,46 @@
 #define BBLK_INVALID UINT32_MAX
 
 
+/*  Maximum number of separate modified byte ranges tracked for a metadata
+    buffer before the closest pair of ranges are coalesced.
+*/
+#define BCRC_RANGES 4U
+
+/*  If more than this many bytes in a node have been modified, computing the CRC
+    incrementally is no cheaper than computing it over the whole node.
+*/
+#define BCRC_MAX_BYTES (REDCONF_BLOCK_SIZE / 4U)
+
+/*  BUFFERCRC::bRanges value indicating that the CRC must be computed over the
+    whole node.
+*/
+#define BCRC_FULL UINT8_MAX
+
+/** @brief Tracks the modified parts of a metadata buffer, so that its CRC can
+           be updated without reading the whole node.
+
+    The CRC of a node is a linear function of its contents, so the new CRC is
+    the stored CRC, XORed with the change in the CRC of each modified range,
+    shifted by the number of bytes which follow the range (see
+    RedCrc32Combine()).  The CRC of the original contents of each range is
+    saved before the range is modified.
+*/
+typedef struct
+{
+    uint32_t    aulOldCrc[BCRC_RANGES]; /**< CRC of the original contents of each modified range. */
+    uint32_t    aulStart[BCRC_RANGES];  /**< Offset of the first byte of each modified range, in ascending order. */
+    uint32_t    aulEnd[BCRC_RANGES];    /**< Offset following the last byte of each modified range. */
+    uint8_t     bRanges;                /**< Number of modified ranges, or ::BCRC_FULL. */
+} BUFFERCRC;
+
+
 bool RedBufferIsValid(const uint8_t *pbBuffer, uint16_t uFlags);
 #if REDCONF_READ_ONLY == 0
-REDSTATUS RedBufferFinalize(uint8_t *pbBuffer, uint8_t bVolNum, uint16_t uFlags);
+REDSTATUS RedBufferFinalize(uint8_t *pbBuffer, uint8_t bVolNum, uint16_t uFlags, BUFFERCRC *pCrc);
+#endif
+#if BUFFER_CRC_INCREMENTAL == 1
+void RedBufferCrcReset(BUFFERCRC *pCrc, bool fKnown);
+void RedBufferCrcModify(BUFFERCRC *pCrc, const uint8_t *pbBuffer, uint32_t ulOffset, uint32_t ulLength);
 #endif
 #ifdef REDCONF_ENDIAN_SWAP
 void RedBufferEndianSwap(void *pBuffer, uint16_t uFlags);
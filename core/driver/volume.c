@@ -40,6 +40,10 @@
 static REDSTATUS RedVolMountMaster(uint32_t ulFlags);
 static REDSTATUS RedVolMountMetaroot(uint32_t ulFlags);
 static bool MetarootIsValid(METAROOT *pMR, bool *pfSectorCRCIsValid);
+#if REDCONF_READ_ONLY == 0
+static REDSTATUS TransactPrepare(void);
+static void TransactComplete(void);
+#endif
 #if DELETE_SUPPORTED && (REDCONF_DELETE_OPEN == 1)
 static REDSTATUS ConcatOrphanLists(void);
 #endif
@@ -441,6 +445,9 @@ static REDSTATUS RedVolMountMetaroot(
     REDSTATUS   retMR1;
     REDSTATUS   ret;
 
+    BUFSTAT_ADD(gbRedVolNum, RED_BUFSTAT_METAROOT, ullIoReads, 2U);
+    BUFSTAT_ADD(gbRedVolNum, RED_BUFSTAT_METAROOT, ullIoReadBlocks, 2U);
+
     retMR0 = RedIoRead(gbRedVolNum, BLOCK_NUM_FIRST_METAROOT, 1U, &gpRedCoreVol->aMR[0U]);
     retMR1 = RedIoRead(gbRedVolNum, BLOCK_NUM_FIRST_METAROOT + 1U, 1U, &gpRedCoreVol->aMR[1U]);
 
@@ -543,12 +550,32 @@ static REDSTATUS RedVolMountMetaroot(
         gpRedCoreVol->fUseReservedBlocks = false;
       #endif
         gpRedCoreVol->ulAlmostFreeBlocks = 0U;
+      #if (REDCONF_READ_ONLY == 0) && (REDCONF_API_POSIX == 1)
+        gpRedCoreVol->ulInodeFreeHint = INODE_FIRST_FREE;
+      #endif
+      #if REDCONF_TRANSACT_AUTO == 1
+        gpRedCoreVol->ulAutoBlocks = 0U;
+        gpRedCoreVol->ullAutoBytes = 0U;
+      #endif
+      #if REDCONF_API_POSIX_SNAPSHOT == 1
+        gpRedCoreVol->ulViewAlmostFree = 0U;
+      #endif
+      #if REDCONF_TRANSACT_STATS == 1
+        RedMemSet(&gpRedCoreVol->transStats, 0U, sizeof(gpRedCoreVol->transStats));
+      #endif
 
         gpRedCoreVol->aMR[1U - gpRedCoreVol->bCurMR] = *gpRedMR;
         gpRedCoreVol->bCurMR = 1U - gpRedCoreVol->bCurMR;
         gpRedMR = &gpRedCoreVol->aMR[gpRedCoreVol->bCurMR];
     }
 
+  #if IMAP_SUMMARY == 1
+    if((ret == 0) && !gpRedCoreVol->fImapInline && ((ulFlags & RED_MOUNT_READONLY) == 0U))
+    {
+        ret = RedImapESummaryInit();
+    }
+  #endif
+
     return ret;
 }
 
@@ -637,52 +664,23 @@ REDSTATUS RedVolTransact(void)
     REDSTATUS ret = 0;
 
     REDASSERT(!gpRedVolume->fReadOnly); /* Should be checked by caller. */
+  #if REDCONF_TRANSACT_ASYNC == 1
+    REDASSERT(!gpRedCoreVol->fCommitPending); /* Should be checked by caller. */
+  #endif
 
     if(gpRedCoreVol->fBranched)
     {
-        gpRedMR->ulFreeBlocks += gpRedCoreVol->ulAlmostFreeBlocks;
-        gpRedCoreVol->ulAlmostFreeBlocks = 0U;
-
-        ret = RedBufferFlushRange(0U, gpRedVolume->ulBlockCount);
+      #if REDCONF_API_POSIX_SNAPSHOT == 1
+        ret = RedImapViewTransact();
 
         if(ret == 0)
+      #endif
         {
-            gpRedMR->hdr.ulSignature = META_SIG_METAROOT;
-            gpRedMR->hdr.ullSequence = gpRedVolume->ullSequence;
-
-            ret = RedVolSeqNumIncrement(gbRedVolNum);
+            ret = TransactPrepare();
         }
 
         if(ret == 0)
         {
-            const uint8_t  *pbMR = (const uint8_t *)gpRedMR;
-            uint32_t        ulSectorSize = gaRedBdevInfo[gbRedVolNum].ulSectorSize;
-            uint32_t        ulSectorCRC;
-
-          #ifdef REDCONF_ENDIAN_SWAP
-            MetaRootEndianSwap(gpRedMR);
-          #endif
-
-            gpRedMR->ulSectorCRC = 0U;
-
-            ulSectorCRC = RedCrc32Update(0U, &pbMR[8U], ulSectorSize - 8U);
-
-            if(ulSectorSize < REDCONF_BLOCK_SIZE)
-            {
-                gpRedMR->hdr.ulCRC = RedCrc32Update(ulSectorCRC, &pbMR[ulSectorSize], REDCONF_BLOCK_SIZE - ulSectorSize);
-            }
-            else
-            {
-                gpRedMR->hdr.ulCRC = ulSectorCRC;
-            }
-
-            gpRedMR->ulSectorCRC = ulSectorCRC;
-
-          #ifdef REDCONF_ENDIAN_SWAP
-            gpRedMR->hdr.ulCRC = RedRev32(gpRedMR->hdr.ulCRC);
-            gpRedMR->ulSectorCRC = RedRev32(gpRedMR->ulSectorCRC);
-          #endif
-
             /*  Flush the block device before writing the metaroot, so that all
                 previously written blocks are guaranteed to be on the media before
                 the metaroot is written.  Otherwise, if the block device reorders
@@ -692,36 +690,75 @@ REDSTATUS RedVolTransact(void)
             ret = RedIoFlush(gbRedVolNum);
         }
 
+        /*  Force the metaroot write to the media, with a FUA write or a flush
+            after the write.  This guarantees the transaction point is really
+            complete before we return.
+        */
         if(ret == 0)
         {
-            ret = RedIoWrite(gbRedVolNum, BLOCK_NUM_FIRST_METAROOT + gpRedCoreVol->bCurMR, 1U, gpRedMR);
+            ret = RedIoWriteFua(gbRedVolNum, BLOCK_NUM_FIRST_METAROOT + gpRedCoreVol->bCurMR, 1U, gpRedMR);
 
           #ifdef REDCONF_ENDIAN_SWAP
             MetaRootEndianSwap(gpRedMR);
           #endif
         }
 
-        /*  Flush the block device to force the metaroot write to the media.  This
-            guarantees the transaction point is really complete before we return.
-        */
         if(ret == 0)
         {
-            ret = RedIoFlush(gbRedVolNum);
+            TransactComplete();
         }
 
-        /*  Toggle to the other metaroot buffer.  The working state and committed
-            state metaroot buffers exchange places.
-        */
+        CRITICAL_ASSERT(ret == 0);
+    }
+
+    return ret;
+}
+
+
+#if REDCONF_TRANSACT_ASYNC == 1
+/** @brief Start an asynchronous transaction point.
+
+    Does everything a transaction point does up to writing the metaroot: all
+    working state blocks are written, and a copy of the new metaroot is
+    prepared.  The metaroot is written by RedVolTransactCommit(), after which
+    RedVolTransactFinish() must be called.  In between, the working state must
+    not be modified: until the metaroot is on the media, the committed state is
+    still the previous one, and blocks which it uses must not be overwritten.
+
+    If the volume has not been branched, there is nothing to commit, and no
+    commit is started.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EIO    A disk I/O error occurred.
+*/
+REDSTATUS RedVolTransactStart(void)
+{
+    REDSTATUS ret = 0;
+
+    REDASSERT(!gpRedVolume->fReadOnly); /* Should be checked by caller. */
+    REDASSERT(!gpRedCoreVol->fCommitPending); /* Should be checked by caller. */
+
+    if(gpRedCoreVol->fBranched)
+    {
+      #if REDCONF_API_POSIX_SNAPSHOT == 1
+        ret = RedImapViewTransact();
+
         if(ret == 0)
+      #endif
         {
-            uint8_t bNextMR = 1U - gpRedCoreVol->bCurMR;
-
-            gpRedCoreVol->aMR[bNextMR] = *gpRedMR;
-            gpRedCoreVol->bCurMR = bNextMR;
+            ret = TransactPrepare();
+        }
 
-            gpRedMR = &gpRedCoreVol->aMR[gpRedCoreVol->bCurMR];
+        if(ret == 0)
+        {
+            gpRedCoreVol->CommitMR = *gpRedMR;
+            gpRedCoreVol->fCommitPending = true;
 
-            gpRedCoreVol->fBranched = false;
+          #ifdef REDCONF_ENDIAN_SWAP
+            MetaRootEndianSwap(gpRedMR);
+          #endif
         }
 
         CRITICAL_ASSERT(ret == 0);
@@ -731,6 +768,180 @@ REDSTATUS RedVolTransact(void)
 }
 
 
+/** @brief Write the metaroot of an asynchronous transaction point.
+
+    This only accesses the block device and the copy of the metaroot made by
+    RedVolTransactStart(), so it can be called without holding the file system
+    mutex, while other tasks read from the volume.  It must not be called
+    concurrently with anything which writes to the volume.
+
+    @param bVolNum  The volume number of the volume with the pending commit.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EIO    A disk I/O error occurred.
+*/
+REDSTATUS RedVolTransactCommit(
+    uint8_t     bVolNum)
+{
+    const COREVOLUME   *pCoreVol = &gaRedCoreVol[bVolNum];
+    REDSTATUS           ret;
+
+    REDASSERT(pCoreVol->fCommitPending);
+
+    /*  Flush before writing the metaroot, and force the metaroot to the media,
+        for the same reasons as in RedVolTransact().
+    */
+    ret = RedIoFlush(bVolNum);
+
+    if(ret == 0)
+    {
+        ret = RedIoWriteFua(bVolNum, BLOCK_NUM_FIRST_METAROOT + pCoreVol->bCurMR, 1U, &pCoreVol->CommitMR);
+    }
+
+    return ret;
+}
+
+
+/** @brief Finish an asynchronous transaction point.
+
+    Once this returns, the working state of the transaction point started by
+    RedVolTransactStart() has become the committed state.
+
+    @param iCommitRet   The value returned by RedVolTransactCommit().
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EIO    A disk I/O error occurred.
+*/
+REDSTATUS RedVolTransactFinish(
+    REDSTATUS   iCommitRet)
+{
+    REDSTATUS   ret = iCommitRet;
+
+    REDASSERT(gpRedCoreVol->fCommitPending);
+
+    gpRedCoreVol->fCommitPending = false;
+
+    if(ret == 0)
+    {
+        TransactComplete();
+    }
+
+    CRITICAL_ASSERT(ret == 0);
+
+    return ret;
+}
+#endif /* REDCONF_TRANSACT_ASYNC == 1 */
+
+
+/** @brief Write the working state and prepare the metaroot for a transaction
+           point.
+
+    When this returns successfully, the metaroot is ready to be written: its
+    CRCs have been computed and, if #REDCONF_ENDIAN_SWAP is defined, it has been
+    converted to on-disk byte order.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EIO    A disk I/O error occurred.
+*/
+static REDSTATUS TransactPrepare(void)
+{
+    REDSTATUS ret;
+
+    gpRedMR->ulFreeBlocks += gpRedCoreVol->ulAlmostFreeBlocks;
+    gpRedCoreVol->ulAlmostFreeBlocks = 0U;
+
+  #if IMAP_SUMMARY == 1
+    RedImapESummaryTransact();
+  #endif
+
+    ret = RedBufferFlushRange(0U, gpRedVolume->ulBlockCount);
+
+    if(ret == 0)
+    {
+        gpRedMR->hdr.ulSignature = META_SIG_METAROOT;
+        gpRedMR->hdr.ullSequence = gpRedVolume->ullSequence;
+
+        ret = RedVolSeqNumIncrement(gbRedVolNum);
+    }
+
+    if(ret == 0)
+    {
+        const uint8_t  *pbMR = (const uint8_t *)gpRedMR;
+        uint32_t        ulSectorSize = gaRedBdevInfo[gbRedVolNum].ulSectorSize;
+        uint32_t        ulSectorCRC;
+
+      #ifdef REDCONF_ENDIAN_SWAP
+        MetaRootEndianSwap(gpRedMR);
+      #endif
+
+        gpRedMR->ulSectorCRC = 0U;
+
+        ulSectorCRC = RedCrc32Update(0U, &pbMR[8U], ulSectorSize - 8U);
+
+        if(ulSectorSize < REDCONF_BLOCK_SIZE)
+        {
+            gpRedMR->hdr.ulCRC = RedCrc32Update(ulSectorCRC, &pbMR[ulSectorSize], REDCONF_BLOCK_SIZE - ulSectorSize);
+        }
+        else
+        {
+            gpRedMR->hdr.ulCRC = ulSectorCRC;
+        }
+
+        gpRedMR->ulSectorCRC = ulSectorCRC;
+
+      #ifdef REDCONF_ENDIAN_SWAP
+        gpRedMR->hdr.ulCRC = RedRev32(gpRedMR->hdr.ulCRC);
+        gpRedMR->ulSectorCRC = RedRev32(gpRedMR->ulSectorCRC);
+      #endif
+    }
+
+    return ret;
+}
+
+
+/** @brief Make the working state the committed state, after the metaroot of a
+           transaction point has been written.
+*/
+static void TransactComplete(void)
+{
+    uint8_t bNextMR = 1U - gpRedCoreVol->bCurMR;
+
+    BUFSTAT_ADD(gbRedVolNum, RED_BUFSTAT_METAROOT, ullIoWrites, 1U);
+    BUFSTAT_ADD(gbRedVolNum, RED_BUFSTAT_METAROOT, ullIoWriteBlocks, 1U);
+    BUFSTAT_ADD(gbRedVolNum, RED_BUFSTAT_METAROOT, ullFlushWrites, 1U);
+
+  #if REDCONF_TRANSACT_STATS == 1
+    TRANSTAT_ADD(gbRedVolNum, aulWritten[RED_BUFSTAT_METAROOT], 1U);
+    TRANSTAT_ADD(gbRedVolNum, ulMetarootBytes, REDCONF_BLOCK_SIZE);
+    gpRedCoreVol->transStats.ullSequence = gpRedMR->hdr.ullSequence;
+    gpRedCoreVol->lastTransStats = gpRedCoreVol->transStats;
+    RedMemSet(&gpRedCoreVol->transStats, 0U, sizeof(gpRedCoreVol->transStats));
+  #endif
+
+    /*  Toggle to the other metaroot buffer.  The working state and committed
+        state metaroot buffers exchange places.
+    */
+    gpRedCoreVol->aMR[bNextMR] = *gpRedMR;
+    gpRedCoreVol->bCurMR = bNextMR;
+
+    gpRedMR = &gpRedCoreVol->aMR[gpRedCoreVol->bCurMR];
+
+    gpRedCoreVol->fBranched = false;
+    gpRedVolume->ulTransactCount++;
+
+  #if REDCONF_TRANSACT_AUTO == 1
+    gpRedCoreVol->ulAutoBlocks = 0U;
+    gpRedCoreVol->ullAutoBytes = 0U;
+  #endif
+}
+
+
 /** @brief Rollback to the previous transaction point.
 
     @return A negated ::REDSTATUS code indicating the operation result.
@@ -785,6 +996,18 @@ uint32_t RedVolFreeBlockCount(void)
 {
     uint32_t ulFreeBlocks = gpRedMR->ulFreeBlocks;
 
+  #if REDCONF_API_POSIX_SNAPSHOT == 1
+    /*  Blocks held for the view of the committed state cannot be allocated.
+        While the view is entered, gpRedMR is the metaroot of the view, whose
+        free block count does not include them.
+    */
+    if(!gpRedCoreVol->fViewEntered)
+    {
+        REDASSERT(ulFreeBlocks >= gpRedCoreVol->ulViewHeld);
+        ulFreeBlocks -= gpRedCoreVol->ulViewHeld;
+    }
+  #endif
+
   #if RESERVED_BLOCKS > 0U
     if(!gpRedCoreVol->fUseReservedBlocks)
     {
@@ -1014,6 +1237,11 @@ void RedVolCriticalError(
   #if REDCONF_READ_ONLY == 0
     gpRedVolume->fReadOnly = true;
   #endif
+  #if REDCONF_API_POSIX_SNAPSHOT == 1
+    /*  Stay read-only after leaving the view of the committed state.
+    */
+    gpRedCoreVol->fViewReadOnly = true;
+  #endif
 
   #if REDCONF_ASSERTS == 1
     RedOsAssertFail(pszFileName, ulLineNum);
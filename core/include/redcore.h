@@ -49,6 +49,7 @@ REDSTATUS RedIoRead(uint8_t bVolNum, uint32_t ulBlockStart, uint32_t ulBlockCoun
 #if REDCONF_READ_ONLY == 0
 REDSTATUS RedIoWrite(uint8_t bVolNum, uint32_t ulBlockStart, uint32_t ulBlockCount, const void *pBuffer);
 REDSTATUS RedIoFlush(uint8_t bVolNum);
+REDSTATUS RedIoWriteFua(uint8_t bVolNum, uint32_t ulBlockStart, uint32_t ulBlockCount, const void *pBuffer);
 #endif
 
 
@@ -95,7 +96,55 @@ REDSTATUS RedIoFlush(uint8_t bVolNum);
 #define BFLAG_META              ((uint16_t) 0x8000U)
 
 
-void RedBufferInit(void);
+#if REDCONF_BUFFER_STATS == 1
+/** @brief Add to a buffer cache statistic.
+
+    Compiles to nothing when #REDCONF_BUFFER_STATS is disabled; the arguments
+    are not evaluated in that case.
+
+    @param vol      The volume number.
+    @param type     The RED_BUFSTAT_* kind of block.
+    @param field    The REDBUFTYPESTATS member to add to.
+    @param count    The amount to add.
+*/
+#define BUFSTAT_ADD(vol, type, field, count) (gaRedCoreVol[(vol)].bufStats.aType[(type)].field += (uint64_t)(count))
+#else
+#define BUFSTAT_ADD(vol, type, field, count) ((void)0)
+#endif
+
+#if (REDCONF_BUFFER_STATS == 1) || (REDCONF_TRANSACT_STATS == 1)
+uint8_t RedBufferStatType(uint16_t uFlags);
+#endif
+
+#if REDCONF_TRANSACT_STATS == 1
+/** @brief Add to a transaction statistic for the working state.
+
+    Compiles to nothing when #REDCONF_TRANSACT_STATS is disabled; the arguments
+    are not evaluated in that case.
+
+    @param vol      The volume number.
+    @param field    The REDTRANSTATS member to add to.
+    @param count    The amount to add.
+*/
+#define TRANSTAT_ADD(vol, field, count) (gaRedCoreVol[(vol)].transStats.field += (uint32_t)(count))
+#else
+#define TRANSTAT_ADD(vol, field, count) ((void)0)
+#endif
+
+/*  Metadata CRCs can only be updated incrementally if the buffers hold the
+    nodes in their on-disk byte order.
+*/
+#if (REDCONF_BUFFER_CRC_INCREMENTAL == 1) && (REDCONF_READ_ONLY == 0) && !defined(REDCONF_ENDIAN_SWAP)
+  #define BUFFER_CRC_INCREMENTAL 1
+#else
+  #define BUFFER_CRC_INCREMENTAL 0
+#endif
+
+REDSTATUS RedBufferInit(uint16_t uBufferCount);
+#if REDOSCONF_BUFFER_ALLOC == 1
+void RedBufferUninit(void);
+REDSTATUS RedBufferResize(uint16_t uBufferCount);
+#endif
 REDSTATUS RedBufferGet(uint32_t ulBlock, uint16_t uFlags, void **ppBuffer);
 void RedBufferPut(const void *pBuffer);
 #if REDCONF_READ_ONLY == 0
@@ -103,9 +152,20 @@ REDSTATUS RedBufferFlushRange(uint32_t ulBlockStart, uint32_t ulBlockCount);
 void RedBufferDirty(const void *pBuffer);
 void RedBufferBranch(const void *pBuffer, uint32_t ulBlockNew);
 #endif
+#if BUFFER_CRC_INCREMENTAL == 1
+void RedBufferModify(const void *pBuffer, const void *pData, uint32_t ulLength);
+#else
+#define RedBufferModify(pBuffer, pData, ulLength) ((void)0)
+#endif
+#if (REDCONF_READ_ONLY == 0) && (REDCONF_BUFFER_CLEAN_LOW_WATER > 0U)
+REDSTATUS RedBufferWriteBack(uint16_t uLowWater);
+#endif
 void RedBufferDiscard(const void *pBuffer);
 REDSTATUS RedBufferDiscardRange(uint32_t ulBlockStart, uint32_t ulBlockCount);
 REDSTATUS RedBufferReadRange(uint32_t ulBlockStart, uint32_t ulBlockCount, uint8_t *pbDataBuffer);
+#if REDCONF_READ_AHEAD_BLOCKS > 0U
+REDSTATUS RedBufferReadAhead(uint32_t ulBlockStart, uint32_t ulBlockCount);
+#endif
 #if REDCONF_READ_ONLY == 0
 REDSTATUS RedBufferWriteRange(uint32_t ulBlockStart, uint32_t ulBlockCount, const uint8_t *pbDataBuffer);
 #endif
@@ -124,23 +184,50 @@ typedef enum
 REDSTATUS RedImapBlockGet(uint8_t bMR, uint32_t ulBlock, bool *pfAllocated);
 #if REDCONF_READ_ONLY == 0
 REDSTATUS RedImapBlockSet(uint32_t ulBlock, bool fAllocated);
-REDSTATUS RedImapAllocBlock(uint32_t *pulBlock);
+REDSTATUS RedImapBlockRangeSet(uint32_t ulStart, uint32_t ulCount, bool fAllocated);
+REDSTATUS RedImapAllocBlock(uint32_t ulGoal, uint32_t *pulBlock);
+REDSTATUS RedImapAllocExtent(uint32_t ulGoal, uint32_t ulWanted, uint32_t *pulStart, uint32_t *pulLen);
+REDSTATUS RedImapFreeExtent(uint32_t ulStart, uint32_t ulLen);
+#if (REDCONF_API_POSIX == 1) && (REDCONF_API_POSIX_DEFRAG == 1)
+REDSTATUS RedImapFindExtent(uint32_t ulWanted, uint32_t *pulStart);
+#endif
 #endif
 REDSTATUS RedImapBlockState(uint32_t ulBlock, ALLOCSTATE *pState);
+#if REDCONF_API_POSIX_SNAPSHOT == 1
+#if REDCONF_READ_ONLY == 0
+REDSTATUS RedImapViewTransact(void);
+REDSTATUS RedImapViewPin(uint32_t ulBlock, uint16_t uFlags);
+void RedImapViewRelease(void);
+uint32_t RedImapViewBlock(uint32_t ulBlock);
+#endif
+#endif
 
 #if REDCONF_IMAP_INLINE == 1
 REDSTATUS RedImapIBlockGet(uint8_t bMR, uint32_t ulBlock, bool *pfAllocated);
 #if REDCONF_READ_ONLY == 0
-REDSTATUS RedImapIBlockSet(uint32_t ulBlock, bool fAllocated);
+REDSTATUS RedImapIBlockRangeSet(uint32_t ulStart, uint32_t ulCount, bool fAllocated, uint32_t *pulCommitted);
 REDSTATUS RedImapIBlockFindFree(uint32_t ulBlock, uint32_t *pulFreeBlock);
+REDSTATUS RedImapIBlockFreeRun(uint32_t ulBlock, uint32_t ulMaxLen, uint32_t *pulLen);
+#if REDCONF_API_POSIX_SNAPSHOT == 1
+REDSTATUS RedImapIViewRun(uint32_t ulBlock, uint32_t ulMaxLen, bool fUsed, uint32_t *pulLen);
+#endif
 #endif
 #endif
 
 #if REDCONF_IMAP_EXTERNAL == 1
 REDSTATUS RedImapEBlockGet(uint8_t bMR, uint32_t ulBlock, bool *pfAllocated);
 #if REDCONF_READ_ONLY == 0
-REDSTATUS RedImapEBlockSet(uint32_t ulBlock, bool fAllocated);
+REDSTATUS RedImapEBlockRangeSet(uint32_t ulStart, uint32_t ulCount, bool fAllocated, uint32_t *pulCommitted);
 REDSTATUS RedImapEBlockFindFree(uint32_t ulBlock, uint32_t *pulFreeBlock);
+REDSTATUS RedImapEBlockFreeRun(uint32_t ulBlock, uint32_t ulMaxLen, uint32_t *pulLen);
+#if REDCONF_API_POSIX_SNAPSHOT == 1
+REDSTATUS RedImapEViewRun(uint32_t ulBlock, uint32_t ulMaxLen, bool fUsed, uint32_t *pulLen);
+REDSTATUS RedImapEViewTransact(void);
+#endif
+#endif
+#if IMAP_SUMMARY == 1
+REDSTATUS RedImapESummaryInit(void);
+void RedImapESummaryTransact(void);
 #endif
 uint32_t RedImapNodeBlock(uint8_t bMR, uint32_t ulImapNode);
 #endif
@@ -227,6 +314,12 @@ REDSTATUS RedInodeDataReserve(CINODE *pInode, uint64_t ullOffset, uint64_t ullLe
 REDSTATUS RedInodeDataUnreserve(CINODE *pInode, uint64_t ullOffset);
 #endif
 #endif
+#if (REDCONF_API_POSIX == 1) && (REDCONF_API_POSIX_DEFRAG == 1)
+REDSTATUS RedInodeDataExtents(CINODE *pInode, uint32_t *pulExtents, uint32_t *pulBlocks);
+#if REDCONF_READ_ONLY == 0
+REDSTATUS RedInodeDataDefrag(CINODE *pInode);
+#endif
+#endif
 REDSTATUS RedInodeDataSeekAndRead(CINODE *pInode, uint32_t ulBlock);
 
 #if REDCONF_API_POSIX == 1
@@ -250,6 +343,11 @@ REDSTATUS RedVolMount(uint32_t ulFlags);
 REDSTATUS RedVolTransact(void);
 REDSTATUS RedVolRollback(void);
 #endif
+#if REDCONF_TRANSACT_ASYNC == 1
+REDSTATUS RedVolTransactStart(void);
+REDSTATUS RedVolTransactCommit(uint8_t bVolNum);
+REDSTATUS RedVolTransactFinish(REDSTATUS iCommitRet);
+#endif
 uint32_t RedVolFreeBlockCount(void);
 #if DELETE_SUPPORTED && (REDCONF_DELETE_OPEN == 1)
 REDSTATUS RedVolFreeOrphans(uint32_t ulCount);
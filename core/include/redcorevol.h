@@ -28,6 +28,30 @@
 #define REDCOREVOL_H
 
 
+/*  The free blocks in each external imap node are counted in RAM, so that the
+    allocator can skip imap nodes which have no free blocks without reading
+    them.
+*/
+#if (REDCONF_IMAP_EXTERNAL == 1) && (REDCONF_READ_ONLY == 0) && (REDCONF_IMAP_SUMMARY_NODES > 0U)
+  #define IMAP_SUMMARY 1
+#else
+  #define IMAP_SUMMARY 0
+#endif
+
+
+#if REDCONF_API_POSIX_SNAPSHOT == 1
+/** @brief A node of the view of the committed state which was copied to a
+           free block, because a transaction point let the working state
+           overwrite its location.
+*/
+typedef struct
+{
+    uint32_t    ulBlock;    /**< Where the node is in the view. */
+    uint32_t    ulPinBlock; /**< Where the copy of the node is. */
+} VIEWPIN;
+#endif
+
+
 /** @brief Per-volume run-time data specific to the core.
 */
 typedef struct
@@ -52,6 +76,21 @@ typedef struct
     uint32_t    ulImapNodeCount;
   #endif
 
+  #if IMAP_SUMMARY == 1
+    /** For each of the first #REDCONF_IMAP_SUMMARY_NODES imap nodes, the
+        number of allocable blocks in the node which are free in the working
+        state.  Valid only when fImapInline is false.
+    */
+    uint32_t    aulImapFreeWorking[REDCONF_IMAP_SUMMARY_NODES];
+
+    /** For each of the first #REDCONF_IMAP_SUMMARY_NODES imap nodes, the
+        number of allocable blocks in the node which are free in both the
+        working state and the committed state, and so can be allocated.  Valid
+        only when fImapInline is false.
+    */
+    uint32_t    aulImapFree[REDCONF_IMAP_SUMMARY_NODES];
+  #endif
+
     /** Block number where the inode table starts.
     */
     uint32_t    ulInodeTableStartBN;
@@ -63,6 +102,15 @@ typedef struct
     */
     uint32_t    ulInodeCount;
 
+  #if (REDCONF_READ_ONLY == 0) && (REDCONF_API_POSIX == 1)
+    /** The lowest inode number which might be free in the working state.  All
+        inodes below it are in use, so the search for a free inode starts here.
+        Reset when the metaroot is mounted, raised as inodes are allocated, and
+        lowered when an inode below it is freed.
+    */
+    uint32_t    ulInodeFreeHint;
+  #endif
+
     /** First block number that can be allocated.
     */
     uint32_t    ulFirstAllocableBN;
@@ -83,6 +131,102 @@ typedef struct
     */
     uint32_t    ulAlmostFreeBlocks;
 
+  #if REDCONF_TRANSACT_AUTO == 1
+    /** The number of blocks allocated since the last transaction point, for
+        VOLUME::transPolicy.
+    */
+    uint32_t    ulAutoBlocks;
+
+    /** The number of bytes of file data written since the last transaction
+        point, for VOLUME::transPolicy.
+    */
+    uint64_t    ullAutoBytes;
+  #endif
+
+  #if REDCONF_TRANSACT_ASYNC == 1
+    /** Whether an asynchronous transaction point has been started, but its
+        metaroot has not yet been written.
+    */
+    bool        fCommitPending;
+
+    /** The metaroot to be written by the pending asynchronous transaction
+        point, in on-disk byte order.
+    */
+    METAROOT    CommitMR;
+  #endif
+
+  #if REDCONF_API_POSIX_SNAPSHOT == 1
+    /** The number of open handles in the view of the committed state.
+    */
+    uint32_t    ulViewRefs;
+
+    /** The metaroot of the view: a copy of the committed state metaroot, made
+        when the first handle in the view was opened.
+    */
+    METAROOT    ViewMR;
+
+    /** Whether a transaction point has been made since the view was opened.
+        Until then, the view is the committed state.  Afterward, blocks which
+        the view uses are not allocated, and its inodes and imap nodes are
+        pinned at each transaction point which would let the working state
+        overwrite them.
+    */
+    bool        fViewPinned;
+
+    /** Whether a node of the view could not be pinned, because aViewPin was
+        full.  The view was abandoned, and its handles can only be closed.
+    */
+    bool        fViewLost;
+
+    /** The number of blocks used by the view which have been freed in the
+        working state since the last transaction point.  They are held at the
+        next transaction point, rather than becoming free.
+    */
+    uint32_t    ulViewAlmostFree;
+
+    /** The number of blocks which are free in both the working state and the
+        committed state, but which cannot be allocated while the view is open:
+        blocks which the view uses, plus #REDCONF_SNAPSHOT_PINS blocks set
+        aside for pinning, some of which may be in aViewPin.
+    */
+    uint32_t    ulViewHeld;
+
+    /** The number of entries in aViewPin.
+    */
+    uint32_t    ulViewPins;
+
+    /** The copies of inodes and imap nodes of the view which were moved out of
+        the way of the working state.
+    */
+    VIEWPIN     aViewPin[REDCONF_SNAPSHOT_PINS];
+
+    /** The number of entries in aulViewFreedSlot.
+    */
+    uint32_t    ulViewFreedSlots;
+
+    /** Inode slots which the working state freed since the last transaction
+        point, and which had not been pinned.  Those which the view uses are
+        pinned at the next transaction point.
+    */
+    uint32_t    aulViewFreedSlot[REDCONF_SNAPSHOT_PINS];
+
+    /** Whether every inode slot must be examined at the next transaction
+        point, rather than those in aulViewFreedSlot: aulViewFreedSlot was
+        full, or inodes were freed before the view was opened.
+    */
+    bool        fViewSlotScan;
+
+    /** Whether RedCoreViewEnter() has made the view current: gpRedMR points at
+        ViewMR, and the imap and pinned nodes of the view are read.
+    */
+    bool        fViewEntered;
+
+    /** Whether the volume was read-only before RedCoreViewEnter() made it
+        read-only, restored by RedCoreViewLeave().
+    */
+    bool        fViewReadOnly;
+  #endif
+
   #if RESERVED_BLOCKS > 0U
     /** Whether to use the blocks reserved for operations that create free
         space.
@@ -104,6 +248,38 @@ typedef struct
     */
     bool        fUseReservedInodeBlocks;
   #endif
+
+  #if REDCONF_BUFFER_STATS == 1
+    /** Buffer cache statistics for the volume, by kind of block.
+    */
+    REDBUFSTATS bufStats;
+  #endif
+
+  #if REDCONF_TRANSACT_STATS == 1
+    /** Transaction statistics for the working state, accumulated since the
+        last transaction point.
+    */
+    REDTRANSTATS transStats;
+
+    /** Transaction statistics for the most recent transaction point.
+    */
+    REDTRANSTATS lastTransStats;
+  #endif
+
+  #if REDCONF_READ_AHEAD_BLOCKS > 0U
+    /** The number of blocks read into the read-ahead buffer.
+    */
+    uint64_t    ullReadAheadBlocks;
+
+    /** The number of block reads satisfied from the read-ahead buffer.
+    */
+    uint64_t    ullReadAheadHits;
+
+    /** The number of blocks which were read ahead but discarded without being
+        used.
+    */
+    uint64_t    ullReadAheadWasted;
+  #endif
 } COREVOLUME;
 
 /*  Array of COREVOLUME structures.
@@ -120,5 +296,15 @@ extern COREVOLUME * CONST_IF_ONE_VOLUME gpRedCoreVol;
 */
 extern METAROOT   *gpRedMR;
 
+/*  The metaroot whose imap is read for the given metaroot index.  While the
+    view of the committed state is entered, both indexes read the imap of the
+    view.
+*/
+#if REDCONF_API_POSIX_SNAPSHOT == 1
+  #define IMAP_MR(bMR) (gpRedCoreVol->fViewEntered ? &gpRedCoreVol->ViewMR : &gpRedCoreVol->aMR[(bMR)])
+#else
+  #define IMAP_MR(bMR) (&gpRedCoreVol->aMR[(bMR)])
+#endif
+
 
 #endif
@@ -28,7 +28,29 @@
 #define REDBDEV_H
 
 
+#if REDCONF_BDEV_STATS == 1
+/** @brief Counts of the requests made to the block device of a volume.
+
+    Only kept when #REDCONF_BDEV_STATS is enabled.  The counts are never reset
+    by the file system; to measure an operation, compare the counts from before
+    and after it.
+*/
+typedef struct
+{
+    uint64_t    ullReads;           /**< Number of RedBDevRead() requests. */
+    uint64_t    ullSectorsRead;     /**< Number of sectors read by those requests. */
+    uint64_t    ullWrites;          /**< Number of RedBDevWrite() and RedBDevWriteFua() requests. */
+    uint64_t    ullSectorsWritten;  /**< Number of sectors written by those requests. */
+    uint64_t    ullFuaWrites;       /**< Number of those requests which were RedBDevWriteFua(). */
+    uint64_t    ullFlushes;         /**< Number of RedBDevFlush() requests. */
+} BDEVSTATS;
+#endif
+
+
 extern BDEVINFO gaRedBdevInfo[REDCONF_VOLUME_COUNT];
+#if REDCONF_BDEV_STATS == 1
+extern BDEVSTATS gaRedBdevStats[REDCONF_VOLUME_COUNT];
+#endif
 
 
 REDSTATUS RedBDevOpen(uint8_t bVolNum, BDEVOPENMODE mode);
@@ -38,6 +60,7 @@ REDSTATUS RedBDevRead(uint8_t bVolNum, uint64_t ullSectorStart, uint32_t ulSecto
 #if REDCONF_READ_ONLY == 0
 REDSTATUS RedBDevWrite(uint8_t bVolNum, uint64_t ullSectorStart, uint32_t ulSectorCount, const void *pBuffer);
 REDSTATUS RedBDevFlush(uint8_t bVolNum);
+REDSTATUS RedBDevWriteFua(uint8_t bVolNum, uint64_t ullSectorStart, uint32_t ulSectorCount, const void *pBuffer);
 #endif
 
 
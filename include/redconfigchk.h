@@ -193,6 +193,68 @@
   #error "Configuration error: REDCONF_CHECKER must be defined."
 #endif
 
+/*  The settings below are optional.  They are not generated by the
+    configuration utility, so defaults are supplied for those which redconf.h
+    does not define.  The defaults preserve the behavior of earlier releases.
+*/
+#ifndef REDCONF_READ_AHEAD_BLOCKS
+  #define REDCONF_READ_AHEAD_BLOCKS 0U
+#endif
+#ifndef REDCONF_BUFFER_CLEAN_LOW_WATER
+  #define REDCONF_BUFFER_CLEAN_LOW_WATER 0U
+#endif
+#ifndef REDCONF_BUFFER_WRITEBACK_INTERVAL_MS
+  #define REDCONF_BUFFER_WRITEBACK_INTERVAL_MS 100U
+#endif
+#ifndef REDCONF_BUFFER_META_SEGMENT
+  #define REDCONF_BUFFER_META_SEGMENT 0U
+#endif
+#ifndef REDCONF_BUFFER_STATS
+  #define REDCONF_BUFFER_STATS 0
+#endif
+#ifndef REDCONF_BDEV_STATS
+  #define REDCONF_BDEV_STATS 0
+#endif
+#ifndef REDCONF_TRANSACT_STATS
+  #define REDCONF_TRANSACT_STATS 0
+#endif
+#ifndef REDCONF_BUFFER_CRC_INCREMENTAL
+  #define REDCONF_BUFFER_CRC_INCREMENTAL 0
+#endif
+#ifndef REDCONF_IMAP_SUMMARY_NODES
+  #define REDCONF_IMAP_SUMMARY_NODES 0U
+#endif
+#ifndef REDCONF_API_POSIX_DEFRAG
+  #define REDCONF_API_POSIX_DEFRAG 0
+#endif
+#ifndef REDCONF_API_POSIX_SNAPSHOT
+  #define REDCONF_API_POSIX_SNAPSHOT 0
+#endif
+#ifndef REDCONF_SNAPSHOT_PINS
+  #define REDCONF_SNAPSHOT_PINS 64U
+#endif
+#ifndef REDCONF_TRANSACT_GROUP
+  #define REDCONF_TRANSACT_GROUP 0
+#endif
+#ifndef REDCONF_TRANSACT_GROUP_WINDOW_US
+  #define REDCONF_TRANSACT_GROUP_WINDOW_US 0U
+#endif
+#ifndef REDCONF_TRANSACT_ASYNC
+  #define REDCONF_TRANSACT_ASYNC 0
+#endif
+#ifndef REDCONF_TRANSACT_AUTO
+  #define REDCONF_TRANSACT_AUTO 0
+#endif
+#ifndef REDCONF_TRANSACT_DIRTY_BLOCKS
+  #define REDCONF_TRANSACT_DIRTY_BLOCKS 0U
+#endif
+#ifndef REDCONF_TRANSACT_WRITE_BYTES
+  #define REDCONF_TRANSACT_WRITE_BYTES 0U
+#endif
+#ifndef REDCONF_TRANSACT_INTERVAL_MS
+  #define REDCONF_TRANSACT_INTERVAL_MS 0U
+#endif
+
 #if (REDCONF_READ_ONLY != 0) && (REDCONF_READ_ONLY != 1)
   #error "Configuration error: REDCONF_READ_ONLY must be either 0 or 1"
 #endif
@@ -390,5 +452,101 @@
   #error "Configuration error: REDCONF_CHECKER must be either 0 or 1."
 #endif
 
+#if (REDCONF_READ_AHEAD_BLOCKS != 0U) && ((REDCONF_READ_AHEAD_BLOCKS < 2U) || (REDCONF_READ_AHEAD_BLOCKS > 32U))
+  #error "Configuration error: REDCONF_READ_AHEAD_BLOCKS must be zero or between 2 and 32."
+#endif
+
+#if REDCONF_BUFFER_CLEAN_LOW_WATER > REDCONF_BUFFER_COUNT
+  #error "Configuration error: REDCONF_BUFFER_CLEAN_LOW_WATER cannot exceed REDCONF_BUFFER_COUNT."
+#endif
+
+#if (REDCONF_BUFFER_CLEAN_LOW_WATER > 0U) && (REDCONF_READ_ONLY == 1)
+  #error "Configuration error: REDCONF_BUFFER_CLEAN_LOW_WATER must be zero if REDCONF_READ_ONLY is true."
+#endif
+
+#if REDCONF_BUFFER_WRITEBACK_INTERVAL_MS == 0U
+  #error "Configuration error: REDCONF_BUFFER_WRITEBACK_INTERVAL_MS must be nonzero."
+#endif
+
+#if REDCONF_BUFFER_META_SEGMENT >= REDCONF_BUFFER_COUNT
+  #error "Configuration error: REDCONF_BUFFER_META_SEGMENT must be less than REDCONF_BUFFER_COUNT."
+#endif
+
+#if (REDCONF_BUFFER_STATS != 0) && (REDCONF_BUFFER_STATS != 1)
+  #error "Configuration error: REDCONF_BUFFER_STATS must be either 0 or 1."
+#endif
+
+#if (REDCONF_BDEV_STATS != 0) && (REDCONF_BDEV_STATS != 1)
+  #error "Configuration error: REDCONF_BDEV_STATS must be either 0 or 1."
+#endif
+
+#if (REDCONF_TRANSACT_STATS != 0) && (REDCONF_TRANSACT_STATS != 1)
+  #error "Configuration error: REDCONF_TRANSACT_STATS must be either 0 or 1."
+#endif
+#if (REDCONF_TRANSACT_STATS == 1) && (REDCONF_READ_ONLY == 1)
+  #error "Configuration error: REDCONF_TRANSACT_STATS requires a writable configuration."
+#endif
+
+#if (REDCONF_BUFFER_CRC_INCREMENTAL != 0) && (REDCONF_BUFFER_CRC_INCREMENTAL != 1)
+  #error "Configuration error: REDCONF_BUFFER_CRC_INCREMENTAL must be either 0 or 1."
+#endif
+
+#if (REDCONF_IMAP_SUMMARY_NODES > 0U) && (REDCONF_IMAP_EXTERNAL == 0)
+  #error "Configuration error: REDCONF_IMAP_SUMMARY_NODES requires REDCONF_IMAP_EXTERNAL."
+#endif
+
+#if (REDCONF_API_POSIX_DEFRAG != 0) && (REDCONF_API_POSIX_DEFRAG != 1)
+  #error "Configuration error: REDCONF_API_POSIX_DEFRAG must be either 0 or 1."
+#endif
+#if (REDCONF_API_POSIX_DEFRAG == 1) && (REDCONF_API_POSIX == 0)
+  #error "Configuration error: REDCONF_API_POSIX_DEFRAG requires REDCONF_API_POSIX."
+#endif
+
+#if (REDCONF_API_POSIX_SNAPSHOT != 0) && (REDCONF_API_POSIX_SNAPSHOT != 1)
+  #error "Configuration error: REDCONF_API_POSIX_SNAPSHOT must be either 0 or 1."
+#endif
+#if (REDCONF_API_POSIX_SNAPSHOT == 1) && ((REDCONF_API_POSIX == 0) || (REDCONF_READ_ONLY == 1))
+  #error "Configuration error: REDCONF_API_POSIX_SNAPSHOT requires REDCONF_API_POSIX and a writable configuration."
+#endif
+#if (REDCONF_API_POSIX_SNAPSHOT == 1) && ((REDCONF_SNAPSHOT_PINS < 1U) || (REDCONF_SNAPSHOT_PINS > 65536U))
+  #error "Configuration error: REDCONF_SNAPSHOT_PINS must be between 1 and 65536."
+#endif
+
+#if (REDCONF_TRANSACT_GROUP != 0) && (REDCONF_TRANSACT_GROUP != 1)
+  #error "Configuration error: REDCONF_TRANSACT_GROUP must be either 0 or 1."
+#endif
+#if (REDCONF_TRANSACT_GROUP == 1) && ((REDCONF_API_POSIX == 0) || (REDCONF_READ_ONLY == 1))
+  #error "Configuration error: REDCONF_TRANSACT_GROUP requires REDCONF_API_POSIX and a writable configuration."
+#endif
+#if (REDCONF_TRANSACT_GROUP_WINDOW_US > 0U) && (REDCONF_TRANSACT_GROUP == 0)
+  #error "Configuration error: REDCONF_TRANSACT_GROUP_WINDOW_US requires REDCONF_TRANSACT_GROUP."
+#endif
+#if (REDCONF_TRANSACT_GROUP_WINDOW_US > 0U) && ((REDCONF_TASK_COUNT == 1U) || (REDOSCONF_TASK_SLEEP == 0))
+  #error "Configuration error: REDCONF_TRANSACT_GROUP_WINDOW_US requires REDCONF_TASK_COUNT > 1 and REDOSCONF_TASK_SLEEP."
+#endif
+
+#if (REDCONF_TRANSACT_ASYNC != 0) && (REDCONF_TRANSACT_ASYNC != 1)
+  #error "Configuration error: REDCONF_TRANSACT_ASYNC must be either 0 or 1."
+#endif
+#if (REDCONF_TRANSACT_ASYNC == 1) && ((REDCONF_API_POSIX == 0) || (REDCONF_READ_ONLY == 1))
+  #error "Configuration error: REDCONF_TRANSACT_ASYNC requires REDCONF_API_POSIX and a writable configuration."
+#endif
+#if (REDCONF_TRANSACT_ASYNC == 1) && ((REDCONF_TASK_COUNT == 1U) || (REDOSCONF_BACKGROUND_TASK == 0) || (REDOSCONF_TASK_SLEEP == 0))
+  #error "Configuration error: REDCONF_TRANSACT_ASYNC requires REDCONF_TASK_COUNT > 1, REDOSCONF_BACKGROUND_TASK, and REDOSCONF_TASK_SLEEP."
+#endif
+
+#if (REDCONF_TRANSACT_AUTO != 0) && (REDCONF_TRANSACT_AUTO != 1)
+  #error "Configuration error: REDCONF_TRANSACT_AUTO must be either 0 or 1."
+#endif
+#if (REDCONF_TRANSACT_AUTO == 1) && ((REDCONF_API_POSIX == 0) || (REDCONF_READ_ONLY == 1))
+  #error "Configuration error: REDCONF_TRANSACT_AUTO requires REDCONF_API_POSIX and a writable configuration."
+#endif
+#if (REDCONF_TRANSACT_AUTO == 1) && ((REDCONF_TASK_COUNT == 1U) || (REDOSCONF_BACKGROUND_TASK == 0))
+  #error "Configuration error: REDCONF_TRANSACT_AUTO requires REDCONF_TASK_COUNT > 1 and REDOSCONF_BACKGROUND_TASK."
+#endif
+#if ((REDCONF_TRANSACT_DIRTY_BLOCKS > 0U) || (REDCONF_TRANSACT_WRITE_BYTES > 0U) || (REDCONF_TRANSACT_INTERVAL_MS > 0U)) && (REDCONF_TRANSACT_AUTO == 0)
+  #error "Configuration error: REDCONF_TRANSACT_DIRTY_BLOCKS, REDCONF_TRANSACT_WRITE_BYTES, and REDCONF_TRANSACT_INTERVAL_MS require REDCONF_TRANSACT_AUTO."
+#endif
+
 
 #endif
@@ -34,6 +34,9 @@
 
 REDSTATUS RedCoreInit(void);
 REDSTATUS RedCoreUninit(void);
+#if REDOSCONF_BUFFER_ALLOC == 1
+REDSTATUS RedCoreBufferResize(uint32_t ulBufferCount);
+#endif
 
 REDSTATUS RedCoreVolSetCurrent(uint8_t bVolNum);
 
@@ -46,7 +49,32 @@ REDSTATUS RedCoreVolUnmount(void);
 REDSTATUS RedCoreVolTransact(void);
 REDSTATUS RedCoreVolRollback(void);
 #endif
+#if (REDCONF_READ_ONLY == 0) && (REDCONF_BUFFER_CLEAN_LOW_WATER > 0U)
+REDSTATUS RedCoreVolWriteBack(void);
+#endif
+#if REDCONF_TRANSACT_ASYNC == 1
+REDSTATUS RedCoreVolTransactStart(void);
+REDSTATUS RedCoreVolTransactCommit(uint8_t bVolNum);
+REDSTATUS RedCoreVolTransactFinish(REDSTATUS iCommitRet);
+bool RedCoreVolCommitPending(uint8_t bVolNum);
+#endif
+#if (REDCONF_TRANSACT_GROUP == 1) || (REDCONF_TRANSACT_AUTO == 1)
+REDSTATUS RedCoreIsBranched(uint32_t ulInode, bool *pfBranched);
+#endif
+#if REDCONF_API_POSIX_SNAPSHOT == 1
+REDSTATUS RedCoreViewOpen(void);
+void RedCoreViewClose(void);
+void RedCoreViewEnter(uint8_t bVolNum);
+void RedCoreViewLeave(uint8_t bVolNum);
+bool RedCoreViewIsEntered(uint8_t bVolNum);
+#endif
 REDSTATUS RedCoreVolStat(REDSTATFS *pStatFS);
+#if REDCONF_BUFFER_STATS == 1
+REDSTATUS RedCoreBufferStats(REDBUFSTATS *pStats);
+#endif
+#if REDCONF_TRANSACT_STATS == 1
+REDSTATUS RedCoreTransactStats(REDTRANSTATS *pStats);
+#endif
 #if DELETE_SUPPORTED && (REDCONF_DELETE_OPEN == 1)
 REDSTATUS RedCoreVolFreeOrphans(uint32_t ulCount);
 #endif
@@ -57,6 +85,10 @@ REDSTATUS RedCoreTransMaskSet(uint32_t ulEventMask);
 #if (REDCONF_API_POSIX == 1) || (REDCONF_API_FSE_TRANSMASKGET == 1)
 REDSTATUS RedCoreTransMaskGet(uint32_t *pulEventMask);
 #endif
+#if REDCONF_TRANSACT_AUTO == 1
+REDSTATUS RedCoreTransPolicySet(const REDTRANSPOLICY *pPolicy);
+REDSTATUS RedCoreTransPolicyGet(REDTRANSPOLICY *pPolicy);
+#endif
 
 #if (REDCONF_READ_ONLY == 0) && (REDCONF_API_POSIX == 1)
 REDSTATUS RedCoreCreate(uint32_t ulPInode, const char *pszName, uint16_t uMode, uint32_t *pulInode);
@@ -105,6 +137,12 @@ REDSTATUS RedCoreFileTruncate(uint32_t ulInode, uint64_t ullSize);
 REDSTATUS RedCoreFileReserve(uint32_t ulInode, uint64_t ullOffset, uint64_t ullLen);
 REDSTATUS RedCoreFileUnreserve(uint32_t ulInode, uint64_t ullOffset);
 #endif
+#if (REDCONF_API_POSIX == 1) && (REDCONF_API_POSIX_DEFRAG == 1)
+REDSTATUS RedCoreFileExtents(uint32_t ulInode, uint32_t *pulExtents, uint32_t *pulBlocks);
+#if REDCONF_READ_ONLY == 0
+REDSTATUS RedCoreFileDefrag(uint32_t ulInode);
+#endif
+#endif
 
 #if REDCONF_API_POSIX == 1
 REDSTATUS RedCoreDirRead(uint32_t ulInode, uint32_t *pulPos, char *pszName, uint32_t *pulInode);
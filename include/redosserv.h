@@ -68,6 +68,9 @@ REDSTATUS RedOsBDevRead(uint8_t bVolNum, uint64_t ullSectorStart, uint32_t ulSec
 #if REDCONF_READ_ONLY == 0
 REDSTATUS RedOsBDevWrite(uint8_t bVolNum, uint64_t ullSectorStart, uint32_t ulSectorCount, const void *pBuffer);
 REDSTATUS RedOsBDevFlush(uint8_t bVolNum);
+#if REDOSCONF_BDEV_WRITE_FUA == 1
+REDSTATUS RedOsBDevWriteFua(uint8_t bVolNum, uint64_t ullSectorStart, uint32_t ulSectorCount, const void *pBuffer);
+#endif
 #endif
 
 
@@ -82,6 +85,25 @@ void RedOsMutexRelease(void);
 uint32_t RedOsTaskId(void);
 #endif
 
+#if (REDCONF_TASK_COUNT > 1U) && (REDOSCONF_BACKGROUND_TASK == 1)
+/** @brief A function which is called periodically by the background task.
+*/
+typedef void (*REDBGTASKFN)(void);
+
+REDSTATUS RedOsBackgroundTaskStart(REDBGTASKFN pfnTask, uint32_t ulIntervalMs);
+void RedOsBackgroundTaskStop(void);
+void RedOsBackgroundTaskWake(void);
+#endif
+
+#if (REDCONF_TASK_COUNT > 1U) && (REDOSCONF_TASK_SLEEP == 1)
+void RedOsTaskSleep(uint32_t ulMicrosecs);
+#endif
+
+#if REDOSCONF_BUFFER_ALLOC == 1
+void *RedOsBufferAlloc(uint32_t ulSize, uint32_t ulAlignment);
+void RedOsBufferFree(void *pBuffer);
+#endif
+
 #if (REDCONF_API_POSIX == 1) && (REDCONF_POSIX_OWNER_PERM == 1)
 uint32_t RedOsUserId(void);
 uint32_t RedOsGroupId(void);
@@ -272,10 +272,21 @@ int32_t red_format2(const char *pszVolume, const REDFMTOPT *pOptions);
 int32_t red_transact(const char *pszVolume);
 int32_t red_rollback(const char *pszVolume);
 #endif
+#if REDCONF_TRANSACT_ASYNC == 1
+int32_t red_transact_async(const char *pszVolume);
+int32_t red_transact_poll(const char *pszVolume, bool fWait);
+#endif
+#if REDCONF_API_POSIX_SNAPSHOT == 1
+int32_t red_opensnapshot(const char *pszVolume);
+#endif
 #if REDCONF_READ_ONLY == 0
 int32_t red_settransmask(const char *pszVolume, uint32_t ulEventMask);
 #endif
 int32_t red_gettransmask(const char *pszVolume, uint32_t *pulEventMask);
+#if REDCONF_TRANSACT_AUTO == 1
+int32_t red_settranspolicy(const char *pszVolume, const REDTRANSPOLICY *pPolicy);
+int32_t red_gettranspolicy(const char *pszVolume, REDTRANSPOLICY *pPolicy);
+#endif
 int32_t red_statvfs(const char *pszVolume, REDSTATFS *pStatvfs);
 #if DELETE_SUPPORTED && (REDCONF_DELETE_OPEN == 1)
 int32_t red_freeorphans(const char *pszVolume, uint32_t ulMaxDeletions);
@@ -283,6 +294,15 @@ int32_t red_freeorphans(const char *pszVolume, uint32_t ulMaxDeletions);
 #if REDCONF_READ_ONLY == 0
 int32_t red_sync(void);
 #endif
+#if REDOSCONF_BUFFER_ALLOC == 1
+int32_t red_bufresize(uint32_t ulBufferCount);
+#endif
+#if REDCONF_BUFFER_STATS == 1
+int32_t red_bufstats(const char *pszVolume, REDBUFSTATS *pStats);
+#endif
+#if REDCONF_TRANSACT_STATS == 1
+int32_t red_transtats(const char *pszVolume, REDTRANSTATS *pStats);
+#endif
 int32_t red_open(const char *pszPath, uint32_t ulOpenMode);
 #if (REDCONF_READ_ONLY == 0) && (REDCONF_POSIX_OWNER_PERM == 1)
 int32_t red_open2(const char *pszPath, uint32_t ulOpenFlags, uint16_t uMode);
@@ -349,6 +369,12 @@ int32_t red_ftruncate(int32_t iFildes, uint64_t ullSize);
 #if (REDCONF_READ_ONLY == 0) && (REDCONF_API_POSIX == 1) && (REDCONF_API_POSIX_FRESERVE == 1)
 int32_t red_freserve(int32_t iFildes, uint64_t ullSize);
 #endif
+#if REDCONF_API_POSIX_DEFRAG == 1
+int32_t red_fragstat(int32_t iFildes, REDFRAGSTAT *pStat);
+#if REDCONF_READ_ONLY == 0
+int32_t red_defrag(int32_t iFildes);
+#endif
+#endif
 #if REDCONF_API_POSIX_READDIR == 1
 REDDIR *red_opendir(const char *pszPath);
 REDDIR *red_fdopendir(int32_t iFildes);
@@ -23,7 +23,8 @@
     Visit https://www.tuxera.com/products/tuxera-edge-fs/ for more information.
 */
 /** @file
-    @brief Defines macros and types for red_stat() and red_statvfs().
+    @brief Defines macros and types for red_stat(), red_statvfs(),
+           red_bufstats(), and red_fragstat().
 */
 #ifndef REDSTAT_H
 #define REDSTAT_H
@@ -191,4 +192,86 @@ typedef struct
 } REDSTATFS;
 
 
+#if (REDCONF_BUFFER_STATS == 1) || (REDCONF_TRANSACT_STATS == 1)
+/*  Kinds of blocks for which buffer and transaction statistics are kept:
+    indexes into REDBUFSTATS::aType and the arrays in ::REDTRANSTATS.  The
+    metaroot is never buffered, so only its I/O counts are used.
+*/
+#define RED_BUFSTAT_DATA        0U  /**< File data. */
+#define RED_BUFSTAT_MASTER      1U  /**< Master block. */
+#define RED_BUFSTAT_METAROOT    2U  /**< Metaroot. */
+#define RED_BUFSTAT_IMAP        3U  /**< Imap node. */
+#define RED_BUFSTAT_INODE       4U  /**< Inode. */
+#define RED_BUFSTAT_INDIR       5U  /**< Indirect node. */
+#define RED_BUFSTAT_DINDIR      6U  /**< Double indirect node. */
+#define RED_BUFSTAT_DIRECTORY   7U  /**< Directory data. */
+#define RED_BUFSTAT_TYPES       8U  /**< Number of kinds of blocks. */
+#endif
+
+
+#if REDCONF_BUFFER_STATS == 1
+
+/** @brief Buffer cache statistics for one kind of block on a volume.
+*/
+typedef struct
+{
+    uint64_t    ullLookups;         /**< Buffers requested. */
+    uint64_t    ullHits;            /**< Buffers requested which were already buffered. */
+    uint64_t    ullMisses;          /**< Buffers requested which had to be read. */
+    uint64_t    ullEvictions;       /**< Buffers repurposed for a different block. */
+    uint64_t    ullEvictWrites;     /**< Dirty buffers written so that a buffer could be repurposed. */
+    uint64_t    ullFlushWrites;     /**< Dirty buffers written by a flush, transaction, or write-back. */
+    uint64_t    ullIoReads;         /**< Block device read requests. */
+    uint64_t    ullIoReadBlocks;    /**< Blocks read by the read requests. */
+    uint64_t    ullIoWrites;        /**< Block device write requests. */
+    uint64_t    ullIoWriteBlocks;   /**< Blocks written by the write requests. */
+    uint64_t    ullCrcChecks;       /**< Metadata nodes whose CRC was validated after being read. */
+    uint64_t    ullCrcFull;         /**< Metadata nodes whose CRC was computed over the whole node before being written. */
+    uint64_t    ullCrcIncremental;  /**< Metadata nodes whose CRC was updated from only the modified ranges before being written. */
+} REDBUFTYPESTATS;
+
+/** @brief Buffer cache statistics for a file system volume.
+
+    The statistics accumulate from the time the driver is initialized.  Device
+    requests which include blocks of more than one kind are counted for the
+    kind of the first block, but the blocks are counted for their own kinds.
+*/
+typedef struct
+{
+    REDBUFTYPESTATS aType[RED_BUFSTAT_TYPES];   /**< Statistics by kind of block, indexed by RED_BUFSTAT_* values. */
+} REDBUFSTATS;
+#endif
+
+
+#if REDCONF_TRANSACT_STATS == 1
+/** @brief Write amplification statistics for one transaction point.
+
+    The counters cover everything done to the working state since the previous
+    transaction point, including blocks written when dirty buffers were evicted
+    before the transaction point began.  The arrays are indexed by the
+    `RED_BUFSTAT_*` kind of block.
+*/
+typedef struct
+{
+    uint64_t    ullSequence;                     /**< Sequence number of the metaroot written by the transaction point. */
+    uint32_t    aulBranched[RED_BUFSTAT_TYPES];  /**< Committed blocks copied to a new location before being modified.  For imap nodes, this is the number of nodes toggled to their alternate location. */
+    uint32_t    aulAllocated[RED_BUFSTAT_TYPES]; /**< Blocks allocated which did not exist in the committed state: new inodes, and file data, directory, indirect, and double indirect blocks which were sparse. */
+    uint32_t    aulWritten[RED_BUFSTAT_TYPES];   /**< Blocks written to the block device, including the metaroot. */
+    uint32_t    ulAlmostFreeBlocks;              /**< Committed blocks freed in the working state, which became free at the transaction point. */
+    uint32_t    ulMetarootBytes;                 /**< Bytes written to commit the metaroot. */
+} REDTRANSTATS;
+#endif
+
+
+#if REDCONF_API_POSIX_DEFRAG == 1
+/** @brief Fragmentation statistics for a file, from red_fragstat().
+*/
+typedef struct
+{
+    uint32_t    ulExtents;  /**< Runs of file blocks which are contiguous on disk. */
+    uint32_t    ulBlocks;   /**< Allocated data blocks. */
+} REDFRAGSTAT;
+#endif
+
+
 #endif
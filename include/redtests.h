@@ -46,6 +46,11 @@
       && (REDCONF_API_POSIX_RMDIR == 1) && (REDCONF_API_POSIX_RENAME == 1) && (REDCONF_API_POSIX_LINK == 1) \
       && (REDCONF_API_POSIX_FTRUNCATE == 1) && (REDCONF_API_POSIX_READDIR == 1) && (REDCONF_API_POSIX_CWD == 1))
 
+#define FSPERF_SUPPORTED \
+    (    ((RED_KIT == RED_KIT_GPL) || (RED_KIT == RED_KIT_SANDBOX)) \
+      && (REDCONF_OUTPUT == 1) && (REDCONF_READ_ONLY == 0) && (REDCONF_API_POSIX == 1) \
+      && (REDCONF_API_POSIX_FORMAT == 1) && (REDCONF_API_POSIX_UNLINK == 1))
+
 #define FSE_STRESS_TEST_SUPPORTED \
     (    ((RED_KIT == RED_KIT_COMMERCIAL) || (RED_KIT == RED_KIT_SANDBOX)) \
       && (REDCONF_OUTPUT == 1) && (REDCONF_READ_ONLY == 0) && (REDCONF_API_FSE == 1) \
@@ -101,12 +106,14 @@ typedef enum
 #if FSSTRESS_SUPPORTED
 typedef struct
 {
+    const char *pszVolume;  /**< Volume path prefix. */
     bool        fNoCleanup; /**< --no-cleanup */
     uint32_t    ulLoops;    /**< --loops */
     uint32_t    ulNops;     /**< --nops */
     bool        fNamePad;   /**< --namepad */
     uint32_t    ulSeed;     /**< --seed */
     bool        fVerbose;   /**< --verbose */
+    bool        fWriteAmp;  /**< --writeamp */
 } FSSTRESSPARAM;
 
 PARAMSTATUS FsstressParseParams(int argc, char *argv[], FSSTRESSPARAM *pParam, uint8_t *pbVolNum, const char **ppszDevice);
@@ -114,6 +121,21 @@ void FsstressDefaultParams(FSSTRESSPARAM *pParam);
 int FsstressStart(const FSSTRESSPARAM *pParam);
 #endif
 
+#if FSPERF_SUPPORTED
+typedef struct
+{
+    const char *pszVolume;      /**< Volume path prefix. */
+    uint32_t    ulTests;        /**< Tests selected by their options, one bit per test; zero selects all. */
+    uint32_t    ulBufferCount;  /**< --buffers */
+    uint32_t    ulIterations;   /**< --iterations */
+    uint32_t    ulSeed;         /**< --seed */
+} FSPERFPARAM;
+
+PARAMSTATUS FsperfParseParams(int argc, char *argv[], FSPERFPARAM *pParam, uint8_t *pbVolNum, const char **ppszDevice);
+void FsperfDefaultParams(FSPERFPARAM *pParam);
+int FsperfStart(const FSPERFPARAM *pParam);
+#endif
+
 #if STOCH_POSIX_TEST_SUPPORTED
 typedef struct
 {
@@ -23,7 +23,8 @@
     Visit https://www.tuxera.com/products/tuxera-edge-fs/ for more information.
 */
 /** @file
-    @brief Defines macros for the automatic transaction events.
+    @brief Defines macros for the automatic transaction events, and the
+           automatic transaction policy.
 */
 #ifndef REDTRANSACT_H
 #define REDTRANSACT_H
@@ -69,4 +70,33 @@
 #define RED_TRANSACT_SYNC       0x00000800U
 
 
+#if REDCONF_TRANSACT_AUTO == 1
+/** @brief Thresholds which trigger automatic transactions, independent of the
+           events in the transaction mask.
+
+    Each threshold is disabled if zero.  They bound how much uncommitted work
+    can be lost at power failure, without the cost of a transaction point after
+    every operation.
+*/
+typedef struct
+{
+    /** Transact once this many blocks have been allocated in the working state
+        since the last transaction point.
+    */
+    uint32_t    ulDirtyBlocks;
+
+    /** Transact once this many bytes of file data have been written since the
+        last transaction point.
+    */
+    uint64_t    ullWriteBytes;
+
+    /** Transact once the volume has had uncommitted changes for this many
+        milliseconds.  Checked by the background task, every
+        #REDCONF_BUFFER_WRITEBACK_INTERVAL_MS milliseconds.
+    */
+    uint32_t    ulIntervalMs;
+} REDTRANSPOLICY;
+#endif
+
+
 #endif
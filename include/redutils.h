@@ -48,6 +48,7 @@ int32_t RedStrNCmp(const char *pszStr1, const char *pszStr2, uint32_t ulLen);
 void RedStrNCpy(char *pszDst, const char *pszSrc, uint32_t ulLen);
 
 uint32_t RedCrc32Update(uint32_t ulInitCrc32, const void *pBuffer, uint32_t ulLength);
+uint32_t RedCrc32Combine(uint32_t ulCrc1, uint32_t ulCrc2, uint32_t ulLength2);
 uint32_t RedCrcNode(const void *pBuffer);
 
 #if REDCONF_API_POSIX == 1
@@ -57,6 +58,10 @@ uint32_t RedNameLen(const char *pszName);
 bool RedBitGet(const uint8_t *pbBitmap, uint32_t ulBit);
 void RedBitSet(uint8_t *pbBitmap, uint32_t ulBit);
 void RedBitClear(uint8_t *pbBitmap, uint32_t ulBit);
+uint32_t RedBitFindClear(const uint8_t *pbBitmap1, const uint8_t *pbBitmap2, uint32_t ulStart, uint32_t ulEnd);
+uint32_t RedBitFindSet(const uint8_t *pbBitmap1, const uint8_t *pbBitmap2, uint32_t ulStart, uint32_t ulEnd);
+void RedBitRangeSet(uint8_t *pbBitmap, uint32_t ulStart, uint32_t ulEnd, bool fSet);
+uint32_t RedBitCount(const uint8_t *pbBitmap, uint32_t ulStart, uint32_t ulEnd);
 
 #ifdef REDCONF_ENDIAN_SWAP
 uint64_t RedRev64(uint64_t ullToRev);
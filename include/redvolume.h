@@ -30,6 +30,7 @@
 
 #include "redexclude.h" /* for DISCARD_SUPPORTED */
 #include <redosconf.h> /* for REDOSCONF_MUTABLE_VOLCONF */
+#include "redtransact.h" /* for REDTRANSPOLICY */
 
 
 /** Indicates that the sector size should be queried from the block device.
@@ -104,6 +105,17 @@ typedef struct
     */
     const char *pszPathPrefix;
   #endif
+
+    /** The number of block buffers reserved for this volume.  Accessing other
+        volumes will not repurpose this volume's buffers while it has this many
+        buffers or fewer, unless no other buffer is available.  This keeps bulk
+        I/O on one volume from evicting the metadata of a volume which is
+        accessed less often.  Set this to 0 to disable the reservation.  Only
+        meaningful when #REDCONF_VOLUME_COUNT is greater than one.  The sum of
+        the reservations should leave at least the minimum number of buffers
+        required by the configuration for the other volumes.
+    */
+    uint16_t    uBufferReserve;
 } VOLCONF;
 
 #if REDOSCONF_MUTABLE_VOLCONF == 1
@@ -132,6 +144,18 @@ typedef struct
     /** The active automatic transaction mask.
     */
     uint32_t    ulTransMask;
+
+  #if REDCONF_TRANSACT_AUTO == 1
+    /** The active automatic transaction policy.
+    */
+    REDTRANSPOLICY transPolicy;
+  #endif
+
+    /** The number of transaction points committed.  Compared with an earlier
+        value, this tells whether a transaction point has been committed since
+        then.  It is allowed to wrap around.
+    */
+    uint32_t    ulTransactCount;
   #endif
 
     /** The power of 2 difference between sector size and block size.
@@ -6,7 +6,7 @@ P_CFLAGS += -D_FILE_OFFSET_BITS=64 -D_XOPEN_SOURCE=500 -D_POSIX_C_SOURCE=200809
 # Don't build edge-u by default since it relies on libfuse-dev,
 # but do build edge-u if "make all" is explicitly run.
 .PHONY: default
-default: redfmt redimgbld
+default: redfmt redimgbld reddefrag
 
 .PHONY: all
 all: default edge-u
@@ -35,6 +35,7 @@ IMGBLDOBJ=\
 REDPROJOBJ=\
 	$(IMGBLDOBJ) \
 	$(P_BASEDIR)/os/$(P_OS)/tools/$(REDTOOLPREFIX)chk.$(B_OBJEXT) \
+	$(P_BASEDIR)/os/$(P_OS)/tools/$(REDTOOLPREFIX)defrag.$(B_OBJEXT) \
 	$(P_BASEDIR)/os/$(P_OS)/tools/$(REDTOOLPREFIX)fmt.$(B_OBJEXT)
 
 $(P_BASEDIR)/tools/imgbld/ibcommon.$(B_OBJEXT):		$(P_BASEDIR)/tools/imgbld/ibcommon.c $(REDHDR) $(TOOLHDR)
@@ -53,6 +54,9 @@ $(P_PROJDIR)/redconf.$(B_OBJEXT):	$(P_CONFDIR)/redconf.c
 redfmt: $(P_BASEDIR)/os/$(P_OS)/tools/$(REDTOOLPREFIX)fmt.$(B_OBJEXT) $(REDDRIVOBJ) $(REDTOOLOBJ)
 	$(B_LDCMD)
 
+reddefrag: $(P_BASEDIR)/os/$(P_OS)/tools/$(REDTOOLPREFIX)defrag.$(B_OBJEXT) $(REDDRIVOBJ) $(REDTOOLOBJ)
+	$(B_LDCMD)
+
 redimgbld: $(IMGBLDOBJ) $(REDDRIVOBJ) $(REDTOOLOBJ)
 	$(B_LDCMD)
 
@@ -69,4 +73,4 @@ clean:
 	$(B_DEL) $(REDDRIVOBJ) $(REDTOOLOBJ) $(REDPROJOBJ)
 	$(B_DEL) $(P_BASEDIR)/os/$(P_OS)/tools/*.$(B_OBJEXT)
 	$(B_DEL) $(P_BASEDIR)/tools/*.$(B_OBJEXT)
-	$(B_DEL) edge-u redfmt redfuse redimgbld
+	$(B_DEL) edge-u reddefrag redfmt redfuse redimgbld
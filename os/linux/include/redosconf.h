@@ -73,5 +73,64 @@
 */
 #define REDOSCONF_FAKE_UID_GID 1
 
+/** @brief Whether RedOsBackgroundTaskStart(), RedOsBackgroundTaskStop(), and
+           RedOsBackgroundTaskWake() are implemented by the OS services.
+
+    If implemented, and the configuration calls for it (for example, if
+    #REDCONF_BUFFER_CLEAN_LOW_WATER is nonzero), the POSIX-like API starts a
+    background task which periodically does file system housekeeping, such as
+    writing back dirty buffers or finishing asynchronous transaction points.
+    Needs #REDCONF_TASK_COUNT to be greater than one, since the background task
+    uses the file system mutex.  The background task is not a file system user,
+    so it does not need a slot of its own in #REDCONF_TASK_COUNT.
+*/
+#define REDOSCONF_BACKGROUND_TASK 1
+
+/** @brief Whether RedOsBufferAlloc() and RedOsBufferFree() are implemented by
+           the OS services.
+
+    If implemented, the block buffers are allocated when the driver is
+    initialized, rather than being a static array, and the number of buffers can
+    be changed at run time via red_bufresize().  #REDCONF_BUFFER_COUNT is then
+    only the number of buffers allocated initially.
+*/
+#define REDOSCONF_BUFFER_ALLOC 1
+
+/** @brief Whether RedOsTaskSleep() is implemented by the OS services.
+
+    If implemented, #REDCONF_TRANSACT_GROUP_WINDOW_US can be nonzero: a task
+    requesting a transaction point sleeps for the window, so that requests from
+    other tasks can be committed along with it.  #REDCONF_TRANSACT_ASYNC also
+    needs it, to wait for asynchronous transaction points to finish.
+*/
+#define REDOSCONF_TASK_SLEEP 1
+
+/** @brief Whether RedOsBDevWriteFua() is implemented by the OS services.
+
+    If implemented, the metaroot is written with a Force Unit Access write,
+    which is on the media by the time it returns, rather than with a write
+    followed by a flush; this saves a flush per transaction point.  The
+    implementation may still return -RED_ENOTSUPP for block devices which
+    cannot do FUA writes, in which case the write and flush are used.
+*/
+#ifndef REDOSCONF_BDEV_WRITE_FUA
+#define REDOSCONF_BDEV_WRITE_FUA 1
+#endif
+
+/** @brief Whether file disks which are regular files are flushed.
+
+    File disks are used by the tools and tests, and the host is not expected to
+    crash, so by default only file disks which are block devices are flushed,
+    and FUA writes to regular files are ordinary writes: syncing every flush to
+    the host's storage would make the tests much slower.  Enable this to
+    include the cost of flushing when measuring performance with a file disk.
+
+    This and #REDOSCONF_BDEV_WRITE_FUA can be overridden on the compiler
+    command line, as the Linux performance test project does.
+*/
+#ifndef REDOSCONF_FILE_DISK_FLUSH
+#define REDOSCONF_FILE_DISK_FLUSH 0
+#endif
+
 
 #endif
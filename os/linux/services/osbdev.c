@@ -32,6 +32,9 @@
 #define _LARGEFILE64_SOURCE
 #define _FILE_OFFSET_BITS 64
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* For pwritev2(). */
+#endif
 #ifndef _POSIX_C_SOURCE
 #define _POSIX_C_SOURCE 200112L /* Ensure ftruncate() is available. */
 #endif
@@ -48,6 +51,7 @@
 #include <limits.h>
 #include <sys/stat.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
 #include <linux/fs.h>
 #include <strings.h>
 #include <inttypes.h>
@@ -57,6 +61,20 @@
 #include <redbdev.h>
 
 
+/*  FUA writes to file disks use pwritev2() with RWF_DSYNC, which syncs only the
+    data being written, if the C library has it (glibc 2.26 and newer);
+    otherwise, pwrite() followed by fdatasync().
+*/
+#if (REDCONF_READ_ONLY == 0) && (REDOSCONF_BDEV_WRITE_FUA == 1) && defined(__GLIBC__) && defined(RWF_DSYNC)
+  #if __GLIBC_PREREQ(2, 26)
+    #define FILE_DISK_RWF_DSYNC 1
+  #endif
+#endif
+#ifndef FILE_DISK_RWF_DSYNC
+  #define FILE_DISK_RWF_DSYNC 0
+#endif
+
+
 typedef enum
 {
     BDEVTYPE_RAM_DISK = 0,  /* Default: must be zero. */
@@ -73,6 +91,9 @@ typedef struct
     int             fd;             /* File descriptor for file disks. */
     bool            fIsBDev;        /* Whether file disk is a block device. */
     bool            fFsyncError;    /* Whether fsync() failed with an error. */
+  #if FILE_DISK_RWF_DSYNC == 1
+    bool            fNoRwfDsync;    /* Whether the kernel rejected RWF_DSYNC. */
+  #endif
 } LINUXBDEV;
 
 
@@ -91,6 +112,9 @@ static REDSTATUS FileDiskRead(uint8_t bVolNum, uint64_t ullSectorStart, uint32_t
 #if REDCONF_READ_ONLY == 0
 static REDSTATUS FileDiskWrite(uint8_t bVolNum, uint64_t ullSectorStart, uint32_t ulSectorCount, const void *pBuffer);
 static REDSTATUS FileDiskFlush(uint8_t bVolNum);
+#if REDOSCONF_BDEV_WRITE_FUA == 1
+static REDSTATUS FileDiskWriteFua(uint8_t bVolNum, uint64_t ullSectorStart, uint32_t ulSectorCount, const void *pBuffer);
+#endif
 #endif
 
 
@@ -500,6 +524,75 @@ REDSTATUS RedOsBDevFlush(
 
     return ret;
 }
+
+
+#if REDOSCONF_BDEV_WRITE_FUA == 1
+/** @brief Write sectors to a physical block device with Force Unit Access.
+
+    Unlike RedOsBDevWrite(), the sectors must be committed to permanent storage
+    by the time this function returns.  Unlike RedOsBDevFlush(), sectors written
+    previously need not be committed.
+
+    The behavior of calling this function is undefined if the block device is
+    closed or if it was opened with ::BDEV_O_RDONLY.
+
+    @param bVolNum          The volume number of the volume whose block device
+                            is being written to.
+    @param ullSectorStart   The starting sector number.
+    @param ulSectorCount    The number of sectors to write.
+    @param pBuffer          The buffer from which to write the sector data.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0               Operation was successful.
+    @retval -RED_EINVAL     @p bVolNum is an invalid volume number, @p pBuffer
+                            is `NULL`, or @p ullStartSector and/or
+                            @p ulSectorCount refer to an invalid range of
+                            sectors.
+    @retval -RED_EIO        A disk I/O error occurred.
+    @retval -RED_ENOTSUPP   The block device does not support FUA writes.
+*/
+REDSTATUS RedOsBDevWriteFua(
+    uint8_t     bVolNum,
+    uint64_t    ullSectorStart,
+    uint32_t    ulSectorCount,
+    const void *pBuffer)
+{
+    REDSTATUS   ret;
+
+    if(    (bVolNum >= REDCONF_VOLUME_COUNT)
+        || !gaDisk[bVolNum].fOpen
+        || (gaDisk[bVolNum].mode == BDEV_O_RDONLY)
+        || !VOLUME_SECTOR_RANGE_IS_VALID(bVolNum, ullSectorStart, ulSectorCount)
+        || (pBuffer == NULL))
+    {
+        ret = -RED_EINVAL;
+    }
+    else
+    {
+        switch(gaDisk[bVolNum].type)
+        {
+            case BDEVTYPE_RAM_DISK:
+                /*  The RAM disk has no cache, so every write is FUA.
+                */
+                ret = RamDiskWrite(bVolNum, ullSectorStart, ulSectorCount, pBuffer);
+                break;
+
+            case BDEVTYPE_FILE_DISK:
+                ret = FileDiskWriteFua(bVolNum, ullSectorStart, ulSectorCount, pBuffer);
+                break;
+
+            default:
+                REDERROR();
+                ret = -RED_EINVAL;
+                break;
+        }
+    }
+
+    return ret;
+}
+#endif
+
 #endif /* REDCONF_READ_ONLY == 0 */
 
 
@@ -1004,16 +1097,15 @@ static REDSTATUS FileDiskRead(
         */
         ret = -RED_EINVAL;
     }
-    else if(lseek(pDisk->fd, (off_t)(ullSectorStart * ulVolSecSize), SEEK_SET) == -1)
-    {
-        ret = -RED_EIO;
-    }
     else
     {
         size_t readlen = (size_t)(ulVolSecSize * ulSectorCount);
         ssize_t result;
 
-        result = read(pDisk->fd, pBuffer, readlen);
+        /*  Use positioned I/O, which does not move the file offset, so that
+            reads and writes from different tasks cannot interfere.
+        */
+        result = pread(pDisk->fd, pBuffer, readlen, (off_t)(ullSectorStart * ulVolSecSize));
 
         if(result != (ssize_t)readlen)
         {
@@ -1057,16 +1149,14 @@ static REDSTATUS FileDiskWrite(
         */
         ret = -RED_EINVAL;
     }
-    else if(lseek(pDisk->fd, (off_t)(ullSectorStart * ulVolSecSize), SEEK_SET) == -1)
-    {
-        ret = -RED_EIO;
-    }
     else
     {
         size_t writelen = (size_t)(ulVolSecSize * ulSectorCount);
         ssize_t result;
 
-        result = write(pDisk->fd, pBuffer, writelen);
+        /*  Positioned I/O, as in FileDiskRead().
+        */
+        result = pwrite(pDisk->fd, pBuffer, writelen, (off_t)(ullSectorStart * ulVolSecSize));
 
         if(result != (ssize_t)writelen)
         {
@@ -1102,9 +1192,10 @@ static REDSTATUS FileDiskFlush(
 
         The downside to flushing is that when testing a file disk, it makes the
         tests much slower since it generates lots of disk I/O on the host hard
-        drive.
+        drive.  REDOSCONF_FILE_DISK_FLUSH flushes them anyway, for measuring
+        the cost of flushing.
     */
-    if(pDisk->fIsBDev)
+    if(pDisk->fIsBDev || (REDOSCONF_FILE_DISK_FLUSH == 1))
     {
         if(pDisk->fFsyncError)
         {
@@ -1129,4 +1220,106 @@ static REDSTATUS FileDiskFlush(
 
     return ret;
 }
+
+
+#if REDOSCONF_BDEV_WRITE_FUA == 1
+/** @brief Write sectors to a file disk with Force Unit Access.
+
+    File disks which are not flushed, per FileDiskFlush(), get an ordinary
+    write.
+
+    @param bVolNum          The volume number of the volume whose block device
+                            is being written to.
+    @param ullSectorStart   The starting sector number.
+    @param ulSectorCount    The number of sectors to write.
+    @param pBuffer          The buffer from which to write the sector data.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EINVAL Write length too long.
+    @retval -RED_EIO    A disk I/O error occurred.
+*/
+static REDSTATUS FileDiskWriteFua(
+    uint8_t     bVolNum,
+    uint64_t    ullSectorStart,
+    uint32_t    ulSectorCount,
+    const void *pBuffer)
+{
+    LINUXBDEV  *pDisk = &gaDisk[bVolNum];
+    REDSTATUS   ret = 0;
+    bool        fDone = false;
+
+    if(!pDisk->fIsBDev && (REDOSCONF_FILE_DISK_FLUSH == 0))
+    {
+        ret = FileDiskWrite(bVolNum, ullSectorStart, ulSectorCount, pBuffer);
+        fDone = true;
+    }
+    else if(pDisk->fFsyncError)
+    {
+        /*  As in FileDiskFlush(), keep returning EIO after a sync error.
+        */
+        ret = -RED_EIO;
+        fDone = true;
+    }
+    else
+    {
+      #if FILE_DISK_RWF_DSYNC == 1
+        uint32_t ulVolSecSize = gaRedBdevInfo[bVolNum].ulSectorSize;
+
+        if(((uint64_t)ulVolSecSize * ulSectorCount) > (uint64_t)SSIZE_MAX)
+        {
+            ret = -RED_EINVAL;
+            fDone = true;
+        }
+        else if(!pDisk->fNoRwfDsync)
+        {
+            struct iovec    iov;
+            ssize_t         result;
+
+            iov.iov_base = (void *)pBuffer;
+            iov.iov_len = (size_t)(ulVolSecSize * ulSectorCount);
+
+            result = pwritev2(pDisk->fd, &iov, 1, (off_t)(ullSectorStart * ulVolSecSize), RWF_DSYNC);
+
+            if((result == -1) && ((errno == EOPNOTSUPP) || (errno == ENOSYS) || (errno == EINVAL)))
+            {
+                /*  Older kernel: fall back to fdatasync() from now on.
+                */
+                pDisk->fNoRwfDsync = true;
+            }
+            else
+            {
+                if(result != (ssize_t)iov.iov_len)
+                {
+                    ret = -RED_EIO;
+                    pDisk->fFsyncError = true;
+                }
+
+                fDone = true;
+            }
+        }
+        else
+        {
+            /*  The kernel does not support RWF_DSYNC.
+            */
+        }
+      #endif
+    }
+
+    if(!fDone)
+    {
+        ret = FileDiskWrite(bVolNum, ullSectorStart, ulSectorCount, pBuffer);
+
+        if((ret == 0) && (fdatasync(pDisk->fd) != 0))
+        {
+            ret = -RED_EIO;
+            pDisk->fFsyncError = true;
+        }
+    }
+
+    return ret;
+}
+#endif
+
 #endif /* REDCONF_READ_ONLY == 0 */
@@ -25,6 +25,10 @@
 /** @file
     @brief Implements task functions.
 */
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+
 #include <redfs.h>
 
 #if (REDCONF_TASK_COUNT > 1U) && (REDCONF_API_POSIX == 1)
@@ -44,3 +48,195 @@ uint32_t RedOsTaskId(void)
 }
 
 #endif
+
+
+#if (REDCONF_TASK_COUNT > 1U) && (REDOSCONF_BACKGROUND_TASK == 1)
+
+static void *BackgroundTask(void *pArg);
+
+static pthread_t gBgThread;
+static pthread_mutex_t gBgMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t gBgCond = PTHREAD_COND_INITIALIZER;
+static bool gfBgRunning;
+static bool gfBgStop;
+static bool gfBgWake;
+static REDBGTASKFN gpfnBgTask;
+static uint32_t gulBgIntervalMs;
+
+
+/** @brief Start the background task.
+
+    The background task is a thread which calls @p pfnTask every
+    @p ulIntervalMs milliseconds, until RedOsBackgroundTaskStop() is called.
+    Only one background task can be running at a time.
+
+    @param pfnTask      The function to call periodically.
+    @param ulIntervalMs The interval between calls, in milliseconds.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EBUSY  The background task is already running.
+    @retval -RED_EINVAL @p pfnTask is `NULL` or @p ulIntervalMs is zero.
+    @retval -RED_ENOMEM The thread could not be created.
+*/
+REDSTATUS RedOsBackgroundTaskStart(
+    REDBGTASKFN pfnTask,
+    uint32_t    ulIntervalMs)
+{
+    REDSTATUS   ret = 0;
+
+    if((pfnTask == NULL) || (ulIntervalMs == 0U))
+    {
+        REDERROR();
+        ret = -RED_EINVAL;
+    }
+    else if(gfBgRunning)
+    {
+        ret = -RED_EBUSY;
+    }
+    else
+    {
+        gpfnBgTask = pfnTask;
+        gulBgIntervalMs = ulIntervalMs;
+        gfBgStop = false;
+        gfBgWake = false;
+
+        if(pthread_create(&gBgThread, NULL, BackgroundTask, NULL) != 0)
+        {
+            ret = -RED_ENOMEM;
+        }
+        else
+        {
+            gfBgRunning = true;
+        }
+    }
+
+    return ret;
+}
+
+
+/** @brief Stop the background task.
+
+    Waits for the background task to finish the call which is in progress, if
+    any.  Does nothing if the background task is not running.
+*/
+void RedOsBackgroundTaskStop(void)
+{
+    if(gfBgRunning)
+    {
+        (void)pthread_mutex_lock(&gBgMutex);
+        gfBgStop = true;
+        (void)pthread_cond_signal(&gBgCond);
+        (void)pthread_mutex_unlock(&gBgMutex);
+
+        (void)pthread_join(gBgThread, NULL);
+
+        gfBgRunning = false;
+    }
+}
+
+
+/** @brief Wake the background task.
+
+    If the background task is waiting out its interval, it calls its function
+    right away, rather than at the end of the interval.  If the call is in
+    progress, another one is made as soon as it returns.  Does nothing if the
+    background task is not running.
+*/
+void RedOsBackgroundTaskWake(void)
+{
+    if(gfBgRunning)
+    {
+        (void)pthread_mutex_lock(&gBgMutex);
+        gfBgWake = true;
+        (void)pthread_cond_signal(&gBgCond);
+        (void)pthread_mutex_unlock(&gBgMutex);
+    }
+}
+
+
+/** @brief Thread function for the background task.
+
+    @param pArg Unused.
+
+    @return Always `NULL`.
+*/
+static void *BackgroundTask(
+    void   *pArg)
+{
+    (void)pArg;
+
+    (void)pthread_mutex_lock(&gBgMutex);
+
+    while(!gfBgStop)
+    {
+        struct timespec ts;
+        int             iErr = 0;
+
+        (void)clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += (time_t)(gulBgIntervalMs / 1000U);
+        ts.tv_nsec += (long)((gulBgIntervalMs % 1000U) * 1000000U);
+        if(ts.tv_nsec >= 1000000000L)
+        {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+        }
+
+        /*  Wait out the interval, unless told to stop or woken first.
+        */
+        while(!gfBgStop && !gfBgWake && (iErr != ETIMEDOUT))
+        {
+            iErr = pthread_cond_timedwait(&gBgCond, &gBgMutex, &ts);
+        }
+
+        if(!gfBgStop)
+        {
+            gfBgWake = false;
+
+            /*  Do not hold the mutex during the call, so that stopping the
+                task is not delayed by it.
+            */
+            (void)pthread_mutex_unlock(&gBgMutex);
+            gpfnBgTask();
+            (void)pthread_mutex_lock(&gBgMutex);
+        }
+    }
+
+    (void)pthread_mutex_unlock(&gBgMutex);
+
+    return NULL;
+}
+
+#endif
+
+
+#if (REDCONF_TASK_COUNT > 1U) && (REDOSCONF_TASK_SLEEP == 1)
+
+/** @brief Suspend the calling task.
+
+    The caller does not hold the file system mutex, so other tasks can use the
+    file system in the meantime.
+
+    @param ulMicrosecs  The number of microseconds to sleep.
+*/
+void RedOsTaskSleep(
+    uint32_t        ulMicrosecs)
+{
+    struct timespec ts;
+
+    ts.tv_sec = (time_t)(ulMicrosecs / 1000000U);
+    ts.tv_nsec = (long)((ulMicrosecs % 1000000U) * 1000U);
+
+    /*  Restart the sleep if it is interrupted by a signal.
+    */
+    while(nanosleep(&ts, &ts) != 0)
+    {
+        if(errno != EINTR)
+        {
+            break;
+        }
+    }
+}
+
+#endif
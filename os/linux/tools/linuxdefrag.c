@@ -0,0 +1,558 @@
+/*             ----> DO NOT REMOVE THE FOLLOWING NOTICE <----
+
+                  Copyright (c) 2014-2025 Tuxera US Inc.
+                      All Rights Reserved Worldwide.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; use version 2 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but "AS-IS," WITHOUT ANY WARRANTY; without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+/*  Businesses and individuals that for commercial or other reasons cannot
+    comply with the terms of the GPLv2 license must obtain a commercial
+    license before incorporating Reliance Edge into proprietary software
+    for distribution in any form.
+
+    Visit https://www.tuxera.com/products/tuxera-edge-fs/ for more information.
+*/
+/** @file
+    @brief Implements a Linux command-line front-end which reports file
+           fragmentation and defragments the files in a directory tree.
+
+    The front-end mounts the volume itself, through its own copy of the
+    Reliance Edge driver, so it operates on an offline image or device: nothing
+    else may have the volume mounted while it runs.  To defragment a volume
+    which is in use, the application which has it mounted calls red_defrag()
+    itself.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+
+#include <redfs.h>
+
+#if    (REDCONF_READ_ONLY == 0) && (REDCONF_API_POSIX == 1) && (REDCONF_API_POSIX_READDIR == 1) \
+    && (REDCONF_API_POSIX_DEFRAG == 1)
+
+#include <redposix.h>
+#include <redgetopt.h>
+#include <redtoolcmn.h>
+#include <redvolume.h>
+
+
+/*  Maximum length of a path, including the volume prefix.
+*/
+#define DEFRAG_PATH_MAX 1024U
+
+/*  Default threshold: files whose extents average fewer blocks than this are
+    defragmented.
+*/
+#define DEFRAG_THRESHOLD_DEFAULT 8UL
+
+
+/** @brief Options and running totals for a defragmentation pass.
+*/
+typedef struct
+{
+    const char     *pszVolume;      /**< Volume path prefix. */
+    uint32_t        ulThreshold;    /**< Minimum average extent length, in blocks. */
+    uint32_t        ulIdleMs;       /**< Milliseconds to sleep after each defragmented file. */
+    bool            fReportOnly;    /**< Whether to only report fragmentation. */
+    bool            fVerbose;       /**< Whether to report each file. */
+    uint32_t        ulFiles;        /**< Number of files examined. */
+    uint32_t        ulDefragged;    /**< Number of files defragmented. */
+    uint64_t        ullBlocks;      /**< Total allocated file data blocks. */
+    uint64_t        ullExtentsBefore; /**< Total extents before defragmentation. */
+    uint64_t        ullExtentsAfter;  /**< Total extents after defragmentation. */
+} DEFRAGPARAM;
+
+
+static int DefragDir(DEFRAGPARAM *pParam, char *pszPath, size_t nPathLen);
+static int DefragFile(DEFRAGPARAM *pParam, const char *pszPath);
+static void PrintAverage(uint64_t ullBlocks, uint64_t ullExtents);
+static bool ParseU32(const char *pszArg, uint32_t *pulValue);
+static void Usage(const char *pszProgramName, bool fError);
+
+
+/** @brief Entry point for the Reliance Edge defragmenter.
+
+    @param argc The size of the @p argv array.
+    @param argv The arguments to the program.
+
+    @return Zero on success, nonzero on failure.
+*/
+int main(
+    int             argc,
+    char           *argv[])
+{
+    int32_t         c;
+    const char     *pszDrive = NULL;
+    const char     *pszDir = "";
+    char            szPath[DEFRAG_PATH_MAX];
+    DEFRAGPARAM     param = {0};
+    uint8_t         bVolNum;
+    int             iRet;
+    const REDOPTION aLongopts[] =
+    {
+        { "dev", red_required_argument, NULL, 'D' },
+        { "threshold", red_required_argument, NULL, 't' },
+        { "idle", red_required_argument, NULL, 'i' },
+        { "report", red_no_argument, NULL, 'r' },
+        { "verbose", red_no_argument, NULL, 'v' },
+        { "help", red_no_argument, NULL, 'H' },
+        { NULL }
+    };
+
+    printf("Reliance Edge File System Defragmenter\n");
+
+    param.ulThreshold = DEFRAG_THRESHOLD_DEFAULT;
+
+    /*  If run without parameters, treat as a help request.
+    */
+    if(argc <= 1)
+    {
+        goto Help;
+    }
+
+    while((c = RedGetoptLong(argc, argv, "D:t:i:rvH", aLongopts, NULL)) != -1)
+    {
+        switch(c)
+        {
+            case 'D': /* --dev */
+                pszDrive = red_optarg;
+                break;
+            case 't': /* --threshold */
+                if(!ParseU32(red_optarg, &param.ulThreshold) || (param.ulThreshold == 0U))
+                {
+                    fprintf(stderr, "Invalid threshold: %s\n", red_optarg);
+                    goto BadOpt;
+                }
+                break;
+            case 'i': /* --idle */
+                if(!ParseU32(red_optarg, &param.ulIdleMs))
+                {
+                    fprintf(stderr, "Invalid idle time: %s\n", red_optarg);
+                    goto BadOpt;
+                }
+                break;
+            case 'r': /* --report */
+                param.fReportOnly = true;
+                break;
+            case 'v': /* --verbose */
+                param.fVerbose = true;
+                break;
+            case 'H': /* --help */
+                goto Help;
+            case '?': /* Unknown or ambiguous option */
+            case ':': /* Option missing required argument */
+            default:
+                goto BadOpt;
+        }
+    }
+
+    if(pszDrive == NULL)
+    {
+        fprintf(stderr, "Missing device name argument\n");
+        goto BadOpt;
+    }
+
+    /*  RedGetoptLong() has permuted argv to move all non-option arguments to
+        the end.  We expect to find a volume identifier, optionally followed by
+        a directory within the volume.
+    */
+    if(red_optind >= argc)
+    {
+        fprintf(stderr, "Missing volume argument\n");
+        goto BadOpt;
+    }
+
+    bVolNum = RedFindVolumeNumber(argv[red_optind]);
+    if(bVolNum == REDCONF_VOLUME_COUNT)
+    {
+        fprintf(stderr, "Error: \"%s\" is not a valid volume identifier.\n", argv[red_optind]);
+        goto BadOpt;
+    }
+
+    red_optind++; /* Move past volume parameter. */
+    if(red_optind < argc)
+    {
+        pszDir = argv[red_optind];
+        red_optind++;
+    }
+
+    if(red_optind < argc)
+    {
+        int32_t ii;
+
+        for(ii = red_optind; ii < argc; ii++)
+        {
+            fprintf(stderr, "Error: Unexpected command-line argument \"%s\".\n", argv[ii]);
+        }
+
+        goto BadOpt;
+    }
+
+    param.pszVolume = gaRedVolConf[bVolNum].pszPathPrefix;
+
+    iRet = snprintf(szPath, sizeof(szPath), "%s%c%s", param.pszVolume, REDCONF_PATH_SEPARATOR, pszDir);
+    if((iRet < 0) || ((size_t)iRet >= sizeof(szPath)))
+    {
+        fprintf(stderr, "Error: directory path is too long.\n");
+        goto BadOpt;
+    }
+
+    if(red_init() != 0)
+    {
+        fprintf(stderr, "Unexpected error %d from red_init()\n", (int)red_errno);
+        exit(red_errno);
+    }
+
+    if(RedOsBDevConfig(bVolNum, pszDrive) != 0)
+    {
+        fprintf(stderr, "Unexpected error from RedOsBDevConfig()\n");
+        exit(1);
+    }
+
+    if(red_mount(param.pszVolume) != 0)
+    {
+        fprintf(stderr, "Unexpected error %d from red_mount()\n", (int)red_errno);
+        exit(red_errno);
+    }
+
+    iRet = DefragDir(&param, szPath, (size_t)iRet);
+
+    if(red_umount(param.pszVolume) != 0)
+    {
+        fprintf(stderr, "Unexpected error %d from red_umount()\n", (int)red_errno);
+        iRet = -1;
+    }
+
+    printf("%lu files, %lu defragmented\n", (unsigned long)param.ulFiles, (unsigned long)param.ulDefragged);
+    printf("Before: %llu blocks in %llu extents, ",
+        (unsigned long long)param.ullBlocks, (unsigned long long)param.ullExtentsBefore);
+    PrintAverage(param.ullBlocks, param.ullExtentsBefore);
+    if(!param.fReportOnly)
+    {
+        printf("After:  %llu blocks in %llu extents, ",
+            (unsigned long long)param.ullBlocks, (unsigned long long)param.ullExtentsAfter);
+        PrintAverage(param.ullBlocks, param.ullExtentsAfter);
+    }
+
+    return (iRet == 0) ? 0 : 1;
+
+  Help:
+    Usage(argv[0U], false);
+    return 0; /* Unreachable, but keep it to suppress warnings */
+
+  BadOpt:
+    fprintf(stderr, "Invalid command line arguments\n");
+    Usage(argv[0U], true);
+    return 0; /* Unreachable, but keep it to suppress warnings */
+}
+
+
+/** @brief Report on, and defragment, every file in a directory tree.
+
+    @param pParam   The defragmentation options and totals.
+    @param pszPath  The path of the directory.  This is a buffer of
+                    ::DEFRAG_PATH_MAX bytes, to which the names of subdirectory
+                    entries are appended as the tree is walked; the original
+                    contents are restored before returning.
+    @param nPathLen The length of @p pszPath.
+
+    @return Zero on success, -1 on failure.
+*/
+static int DefragDir(
+    DEFRAGPARAM    *pParam,
+    char           *pszPath,
+    size_t          nPathLen)
+{
+    REDDIR         *pDir;
+    int             iRet = 0;
+
+    pDir = red_opendir(pszPath);
+    if(pDir == NULL)
+    {
+        fprintf(stderr, "Error %d opening directory \"%s\"\n", (int)red_errno, pszPath);
+        iRet = -1;
+    }
+    else
+    {
+        while(iRet == 0)
+        {
+            REDDIRENT  *pDirent;
+            int         iLen;
+
+            red_errno = 0;
+            pDirent = red_readdir(pDir);
+            if(pDirent == NULL)
+            {
+                if(red_errno != 0)
+                {
+                    fprintf(stderr, "Error %d reading directory \"%s\"\n", (int)red_errno, pszPath);
+                    iRet = -1;
+                }
+
+                break;
+            }
+
+            if(pszPath[nPathLen - 1U] == REDCONF_PATH_SEPARATOR)
+            {
+                iLen = snprintf(&pszPath[nPathLen], DEFRAG_PATH_MAX - nPathLen, "%s", pDirent->d_name);
+            }
+            else
+            {
+                iLen = snprintf(&pszPath[nPathLen], DEFRAG_PATH_MAX - nPathLen, "%c%s", REDCONF_PATH_SEPARATOR, pDirent->d_name);
+            }
+            if((iLen < 0) || ((size_t)iLen >= (DEFRAG_PATH_MAX - nPathLen)))
+            {
+                pszPath[nPathLen] = '\0';
+                fprintf(stderr, "Error: path too long in directory \"%s\"\n", pszPath);
+                iRet = -1;
+            }
+            else if(RED_S_ISDIR(pDirent->d_stat.st_mode))
+            {
+                iRet = DefragDir(pParam, pszPath, nPathLen + (size_t)iLen);
+            }
+            else if(RED_S_ISREG(pDirent->d_stat.st_mode))
+            {
+                iRet = DefragFile(pParam, pszPath);
+            }
+            else
+            {
+                /*  Symbolic links have no file data worth defragmenting.
+                */
+            }
+
+            pszPath[nPathLen] = '\0';
+        }
+
+        if(red_closedir(pDir) != 0)
+        {
+            fprintf(stderr, "Error %d closing directory \"%s\"\n", (int)red_errno, pszPath);
+            iRet = -1;
+        }
+    }
+
+    return iRet;
+}
+
+
+/** @brief Report on, and if it is fragmented, defragment a file.
+
+    @param pParam   The defragmentation options and totals.
+    @param pszPath  The path of the file.
+
+    @return Zero on success, -1 on failure.
+*/
+static int DefragFile(
+    DEFRAGPARAM    *pParam,
+    const char     *pszPath)
+{
+    int32_t         iFildes;
+    int             iRet = 0;
+
+    iFildes = red_open(pszPath, RED_O_RDWR);
+    if(iFildes < 0)
+    {
+        fprintf(stderr, "Error %d opening \"%s\"\n", (int)red_errno, pszPath);
+        iRet = -1;
+    }
+    else
+    {
+        REDFRAGSTAT fs;
+        uint32_t    ulExtents = 0U;
+
+        if(red_fragstat(iFildes, &fs) != 0)
+        {
+            fprintf(stderr, "Error %d from red_fragstat() on \"%s\"\n", (int)red_errno, pszPath);
+            iRet = -1;
+        }
+
+        if(iRet == 0)
+        {
+            ulExtents = fs.ulExtents;
+
+            pParam->ulFiles++;
+            pParam->ullBlocks += fs.ulBlocks;
+            pParam->ullExtentsBefore += fs.ulExtents;
+
+            /*  A file is fragmented if its extents are shorter, on average,
+                than the threshold.
+            */
+            if(    !pParam->fReportOnly
+                && (fs.ulExtents > 1U)
+                && ((fs.ulBlocks / fs.ulExtents) < pParam->ulThreshold))
+            {
+                if((red_defrag(iFildes) != 0) || (red_transact(pParam->pszVolume) != 0))
+                {
+                    fprintf(stderr, "Error %d defragmenting \"%s\"\n", (int)red_errno, pszPath);
+                    iRet = -1;
+                }
+                else if(red_fragstat(iFildes, &fs) != 0)
+                {
+                    fprintf(stderr, "Error %d from red_fragstat() on \"%s\"\n", (int)red_errno, pszPath);
+                    iRet = -1;
+                }
+                else
+                {
+                    pParam->ulDefragged++;
+
+                    /*  Give other users of the volume a chance to run.
+                    */
+                    if(pParam->ulIdleMs > 0U)
+                    {
+                        struct timespec ts;
+
+                        ts.tv_sec = (time_t)(pParam->ulIdleMs / 1000U);
+                        ts.tv_nsec = (long)(pParam->ulIdleMs % 1000U) * 1000000L;
+                        (void)nanosleep(&ts, NULL);
+                    }
+                }
+            }
+
+            pParam->ullExtentsAfter += fs.ulExtents;
+        }
+
+        if((iRet == 0) && pParam->fVerbose)
+        {
+            printf("%s: %lu blocks, %lu extents", pszPath, (unsigned long)fs.ulBlocks, (unsigned long)ulExtents);
+            if(fs.ulExtents != ulExtents)
+            {
+                printf(" -> %lu extents", (unsigned long)fs.ulExtents);
+            }
+            printf("\n");
+        }
+
+        if(red_close(iFildes) != 0)
+        {
+            fprintf(stderr, "Error %d closing \"%s\"\n", (int)red_errno, pszPath);
+            iRet = -1;
+        }
+    }
+
+    return iRet;
+}
+
+
+/** @brief Print the average extent length.
+
+    @param ullBlocks    The number of allocated blocks.
+    @param ullExtents   The number of extents.
+*/
+static void PrintAverage(
+    uint64_t    ullBlocks,
+    uint64_t    ullExtents)
+{
+    if(ullExtents == 0U)
+    {
+        printf("average extent length n/a\n");
+    }
+    else
+    {
+        uint64_t ullTenths = (ullBlocks * 10U) / ullExtents;
+
+        printf("average extent length %llu.%u blocks\n",
+            (unsigned long long)(ullTenths / 10U), (unsigned)(ullTenths % 10U));
+    }
+}
+
+
+/** @brief Parse an unsigned 32-bit decimal number.
+
+    @param pszArg   The string to parse.
+    @param pulValue On success, populated with the parsed value.
+
+    @return Whether @p pszArg was a valid number.
+*/
+static bool ParseU32(
+    const char     *pszArg,
+    uint32_t       *pulValue)
+{
+    unsigned long   ulVal;
+    char           *pszEnd;
+    bool            fValid;
+
+    errno = 0;
+    ulVal = strtoul(pszArg, &pszEnd, 10);
+    fValid = (ulVal != ULONG_MAX) && (errno == 0) && (*pszEnd == '\0') && (pszEnd != pszArg);
+  #if ULONG_MAX > UINT32_MAX
+    fValid = fValid && (ulVal <= UINT32_MAX);
+  #endif
+
+    if(fValid)
+    {
+        *pulValue = (uint32_t)ulVal;
+    }
+
+    return fValid;
+}
+
+
+/** @brief Print usage information and exit.
+
+    @param pszProgramName   The argv[0] from main().
+    @param fError           Whether this function is being invoked due to an
+                            invocation error.
+*/
+static void Usage(
+    const char *pszProgramName,
+    bool        fError)
+{
+    int         iExitStatus = fError ? 1 : 0;
+    FILE       *pOut = fError ? stderr : stdout;
+    static const char szUsage[] =
+"usage: %s VolumeID [dir] --dev=devname [--threshold=blocks] [--idle=ms]\n"
+"       [--report] [--verbose] [--help]\n"
+"Report fragmentation of, and defragment, the files in a Reliance Edge volume.\n"
+"The volume is mounted by this program, so it must be an offline image or\n"
+"device: it must not be mounted by anything else (such as the application\n"
+"which normally uses it) while this program runs.  To defragment a volume\n"
+"which is in use, the application must call red_defrag() itself.\n"
+"\n"
+"Where:\n"
+"  VolumeID\n"
+"      A volume number (e.g., 2) or a volume path prefix (e.g., VOL1: or /data)\n"
+"      of the volume to defragment.\n"
+"  dir\n"
+"      The directory tree to process, relative to the volume root.  If\n"
+"      unspecified, the whole volume is processed.\n"
+"  --dev=devname, -D devname\n"
+"      Specifies the device name.  This can be the path and name of a file disk\n"
+"      (e.g., red.bin); or an OS-specific reference to a device (on Linux, a\n"
+"      device file like /dev/sdb).\n"
+"  --threshold=blocks, -t blocks\n"
+"      Defragment files whose extents are shorter than this many blocks, on\n"
+"      average.  The default is %lu.\n"
+"  --idle=ms, -i ms\n"
+"      Sleep for this many milliseconds after defragmenting each file, so that\n"
+"      the work is spread out over time.  The default is 0.\n"
+"  --report, -r\n"
+"      Only report fragmentation; do not defragment.\n"
+"  --verbose, -v\n"
+"      Report the fragmentation of each file.\n"
+"  --help, -H\n"
+"      Prints this usage text and exits.\n\n";
+
+    fprintf(pOut, szUsage, pszProgramName, DEFRAG_THRESHOLD_DEFAULT);
+    exit(iExitStatus);
+}
+
+#else
+
+int main(void)
+{
+    fprintf(stderr, "reddefrag is not supported in this configuration.\n");
+    return 1;
+}
+
+#endif
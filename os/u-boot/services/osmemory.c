@@ -0,0 +1,74 @@
+/*             ----> DO NOT REMOVE THE FOLLOWING NOTICE <----
+
+                  Copyright (c) 2014-2025 Tuxera US Inc.
+                      All Rights Reserved Worldwide.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; use version 2 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but "AS-IS," WITHOUT ANY WARRANTY; without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+/*  Businesses and individuals that for commercial or other reasons cannot
+    comply with the terms of the GPLv2 license must obtain a commercial
+    license before incorporating Reliance Edge into proprietary software
+    for distribution in any form.
+
+    Visit https://www.tuxera.com/products/tuxera-edge-fs/ for more information.
+*/
+/** @file
+    @brief Implements memory allocation functions.
+*/
+#include <redfs.h>
+
+#if REDOSCONF_BUFFER_ALLOC == 1
+
+#include <common.h>
+#include <malloc.h>
+
+
+/** @brief Allocate memory for the block buffers.
+
+    @param ulSize       The number of bytes to allocate.
+    @param ulAlignment  The required alignment of the allocation, in bytes.
+                        Must be a power of two.
+
+    @return A pointer to the allocated memory, or `NULL` if the memory could
+            not be allocated.
+*/
+void *RedOsBufferAlloc(
+    uint32_t    ulSize,
+    uint32_t    ulAlignment)
+{
+    void       *pBuffer = NULL;
+
+    if((ulSize == 0U) || !IS_POWER_OF_2(ulAlignment))
+    {
+        REDERROR();
+    }
+    else
+    {
+        pBuffer = memalign(ulAlignment, ulSize);
+    }
+
+    return pBuffer;
+}
+
+
+/** @brief Free memory allocated by RedOsBufferAlloc().
+
+    @param pBuffer  The memory to free.
+*/
+void RedOsBufferFree(
+    void   *pBuffer)
+{
+    free(pBuffer);
+}
+
+#endif /* REDOSCONF_BUFFER_ALLOC == 1 */
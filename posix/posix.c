@@ -96,6 +96,7 @@
 #define HFLAG_WRITEABLE 0x04U   /* Handle is writeable. */
 #define HFLAG_APPENDING 0x08U   /* Handle was opened in append mode. */
 #define HFLAG_SYMLINK   0x10U   /* Handle is for a symbolic link. */
+#define HFLAG_SNAPSHOT  0x20U   /* Handle is in the view of the committed state. */
 
 #define HANDLE_PTR_IS_VALID(h) PTR_IS_ARRAY_ELEMENT((h), gaHandle, ARRAY_SIZE(gaHandle), sizeof(*(h)))
 
@@ -109,6 +110,7 @@
 
 #define OIFLAG_ORPHAN   0x01U   /* The link count of the inode is 0. */
 #define OIFLAG_RESERVED 0x02U   /* Space has been reserved for writing to the inode. */
+#define OIFLAG_SNAPSHOT 0x04U   /* The inode is in the view of the committed state. */
 
 #define OI_PTR_IS_VALID(oi) PTR_IS_ARRAY_ELEMENT((oi), gaOpenInos, ARRAY_SIZE(gaOpenInos), sizeof(*(oi)))
 
@@ -162,6 +164,69 @@ typedef struct
   #endif
 } TASKSLOT;
 
+/*  Whether a background task writes back dirty buffers, finishes asynchronous
+    transaction points, or makes interval transaction points, in between file
+    system operations.  This needs support from the OS services, and the FS
+    mutex to keep the background task out of the way of the tasks using the
+    file system.
+*/
+#if (REDOSCONF_BACKGROUND_TASK == 1) && (REDCONF_TASK_COUNT > 1U) && (REDCONF_READ_ONLY == 0) && ((REDCONF_BUFFER_CLEAN_LOW_WATER > 0U) || (REDCONF_TRANSACT_ASYNC == 1) || (REDCONF_TRANSACT_AUTO == 1))
+  #define POSIX_BACKGROUND 1
+#else
+  #define POSIX_BACKGROUND 0
+#endif
+
+#if REDCONF_TRANSACT_ASYNC == 1
+/*  How often, in microseconds, a task waiting for another task to finish an
+    asynchronous transaction point checks whether it has.
+*/
+#define ASYNC_COMMIT_POLL_US 100U
+
+/** @brief State of the asynchronous transaction point on a volume.
+
+    Either the background task or a task which needs the transaction point to
+    be finished writes the metaroot, whichever gets to it first.
+*/
+typedef struct
+{
+    bool        fWriting;   /**< Whether a task is writing the metaroot. */
+    REDSTATUS   iResult;    /**< Result of the last one finished, until reported by red_transact_poll(). */
+} ASYNCCOMMIT;
+#endif
+
+#if REDCONF_TRANSACT_AUTO == 1
+/** @brief How long a volume has had uncommitted changes, for the interval in
+           the automatic transaction policy.
+
+    The background task starts timing when it first sees that the volume is
+    branched; a transaction point made by anyone else restarts the timing.
+*/
+typedef struct
+{
+    bool            fTiming;            /**< Whether the volume was branched when last checked. */
+    uint32_t        ulTransactCount;    /**< VOLUME::ulTransactCount when timing started. */
+    REDTIMESTAMP    tsBranched;         /**< When timing started. */
+} AUTOTRANS;
+#endif
+
+#if REDCONF_TRANSACT_GROUP_WINDOW_US > 0U
+/** @brief A group of transaction point requests which will be satisfied by a
+           single transaction point.
+
+    The first task to request a transaction point opens the group and sleeps
+    for #REDCONF_TRANSACT_GROUP_WINDOW_US; tasks which request a transaction
+    point in the meantime sleep until the window closes.  The first task to run
+    once the window has closed commits the transaction point, which closes the
+    group.
+*/
+typedef struct
+{
+    bool            fOpen;              /**< Whether the group has been opened. */
+    uint32_t        ulTransactCount;    /**< VOLUME::ulTransactCount when the group was opened. */
+    REDTIMESTAMP    tsOpened;           /**< When the group was opened. */
+} TRANSGROUP;
+#endif
+
 /*-------------------------------------------------------------------
     Local Prototypes
 -------------------------------------------------------------------*/
@@ -184,8 +249,26 @@ static REDSTATUS HandleOpen(REDHANDLE *pHandle, uint32_t ulInode);
 static REDSTATUS HandleClose(REDHANDLE *pHandle, uint32_t ulTransFlag);
 static REDSTATUS OpenInoDeref(OPENINODE *pOpenIno, bool fFreeIfOrphaned, bool fPropagateOrphanError);
 static OPENINODE *OpenInoFind(uint8_t bVolNum, uint32_t ulInode, bool fAlloc);
+#if REDCONF_API_POSIX_SNAPSHOT == 1
+static OPENINODE *OpenInoAllocSnapshot(uint8_t bVolNum, uint32_t ulInode);
+static void ViewEnter(uint8_t bVolNum);
+#endif
 static REDSTATUS PosixEnter(void);
+static REDSTATUS PosixEnterRead(void);
 static void PosixLeave(void);
+#if REDCONF_TRANSACT_ASYNC == 1
+static void AsyncCommitWait(void);
+static void AsyncCommitFinish(uint8_t bVolNum);
+#endif
+#if REDCONF_TRANSACT_GROUP == 1
+static REDSTATUS TransactGroup(uint8_t bVolNum, uint32_t ulInode);
+#endif
+#if POSIX_BACKGROUND == 1
+static void PosixBackground(void);
+#endif
+#if REDCONF_TRANSACT_AUTO == 1
+static void AutoTransactInterval(uint8_t bVolNum);
+#endif
 #if DELETE_SUPPORTED
 static REDSTATUS InodeUnlinkCheck(uint32_t ulInode);
 #endif
@@ -225,6 +308,31 @@ static TASKSLOT gaTask[REDCONF_TASK_COUNT];         /* Array of task slots. */
 */
 static uint16_t gauGeneration[REDCONF_VOLUME_COUNT];
 
+#if REDCONF_TRANSACT_GROUP_WINDOW_US > 0U
+/*  Array of transaction point groups, one per volume.
+*/
+static TRANSGROUP gaTransGroup[REDCONF_VOLUME_COUNT];
+#endif
+
+#if REDCONF_TRANSACT_ASYNC == 1
+/*  Array of asynchronous transaction point states, one per volume.
+*/
+static ASYNCCOMMIT gaAsyncCommit[REDCONF_VOLUME_COUNT];
+#endif
+
+#if REDCONF_TRANSACT_AUTO == 1
+/*  Array of interval transaction point timers, one per volume.
+*/
+static AUTOTRANS gaAutoTrans[REDCONF_VOLUME_COUNT];
+#endif
+
+#if REDCONF_API_POSIX_SNAPSHOT == 1
+/*  Whether the current operation has entered the view of the committed state
+    of any volume, which PosixLeave() must leave.
+*/
+static bool gfViewEntered;
+#endif
+
 
 /*-------------------------------------------------------------------
     Public API
@@ -270,6 +378,15 @@ int32_t red_init(void)
           #endif
 
             gfPosixInited = true;
+
+          #if POSIX_BACKGROUND == 1
+            ret = RedOsBackgroundTaskStart(PosixBackground, REDCONF_BUFFER_WRITEBACK_INTERVAL_MS);
+            if(ret != 0)
+            {
+                gfPosixInited = false;
+                (void)RedCoreUninit();
+            }
+          #endif
         }
     }
 
@@ -303,6 +420,13 @@ int32_t red_uninit(void)
     {
         uint8_t bVolNum;
 
+      #if POSIX_BACKGROUND == 1
+        /*  Stop the background task before acquiring the FS mutex: it might be
+            waiting for the mutex, in which case it could never stop.
+        */
+        RedOsBackgroundTaskStop();
+      #endif
+
       #if REDCONF_TASK_COUNT > 1U
         /*  Not using PosixEnter() to acquire the mutex, since we don't want to
             try and register the calling task as a file system user.
@@ -347,6 +471,15 @@ int32_t red_uninit(void)
             */
             REDASSERT(ret == 0);
         }
+      #if POSIX_BACKGROUND == 1
+        else
+        {
+            /*  Still initialized, so resume the background task.  If that
+                fails, dirty buffers will still be written when needed.
+            */
+            (void)RedOsBackgroundTaskStart(PosixBackground, REDCONF_BUFFER_WRITEBACK_INTERVAL_MS);
+        }
+      #endif
     }
 
     return PosixReturn(ret);
@@ -534,6 +667,50 @@ int32_t red_sync(void)
 #endif
 
 
+#if REDOSCONF_BUFFER_ALLOC == 1
+/** @brief Change the number of block buffers.
+
+    The block buffers are reallocated with room for @p ulBufferCount buffers,
+    which can be more or fewer than before.  This allows the cache size to be
+    chosen at run time, rather than by #REDCONF_BUFFER_COUNT, which is only the
+    number of buffers allocated by red_init().
+
+    The buffer contents are discarded, so this is only allowed when none of the
+    buffers are dirty: that is, between transactions.  Before calling this
+    function, make sure that every mounted volume has been transacted since it
+    was last modified, for example by calling red_transact().
+
+    @param ulBufferCount    The new number of block buffers.
+
+    @return On success, zero is returned.  On error, -1 is returned and
+            #red_errno is set appropriately.
+
+    <b>Errno values</b>
+    - #RED_EBUSY: A mounted volume has changes which have not been transacted.
+    - #RED_EINVAL: @p ulBufferCount is less than the minimum number of buffers
+      required by the configuration, or is too large.
+    - #RED_ENOMEM: Insufficient memory for @p ulBufferCount buffers.  The
+      existing buffers are unchanged.
+    - #RED_EUSERS: Cannot become a file system user: too many users.
+*/
+int32_t red_bufresize(
+    uint32_t    ulBufferCount)
+{
+    REDSTATUS   ret;
+
+    ret = PosixEnter();
+    if(ret == 0)
+    {
+        ret = RedCoreBufferResize(ulBufferCount);
+
+        PosixLeave();
+    }
+
+    return PosixReturn(ret);
+}
+#endif
+
+
 /** @brief Mount a file system volume.
 
     Prepares the file system volume to be accessed.  Mount will fail if the
@@ -900,6 +1077,12 @@ int32_t red_format2(
     mount is the most recent committed state.  Nothing from the committed
     state is ever missing, and nothing from the working state is ever included.
 
+    If #REDCONF_TRANSACT_GROUP is enabled, calls made by several tasks at about
+    the same time share transaction points: a call which finds that another
+    task committed a transaction point after the call was made returns without
+    making one of its own.  Either way, every change made to the volume before
+    the call is committed when it returns successfully.
+
     @param pszVolume    A path prefix identifying the volume to transact.
 
     @return On success, zero is returned.  On error, -1 is returned and
@@ -920,12 +1103,23 @@ int32_t red_transact(
     ret = PosixEnter();
     if(ret == 0)
     {
+      #if REDCONF_TRANSACT_GROUP == 1
+        uint8_t bVolNum;
+
+        ret = RedPathVolumeLookup(pszVolume, &bVolNum);
+
+        if(ret == 0)
+        {
+            ret = TransactGroup(bVolNum, INODE_INVALID);
+        }
+      #else
         ret = RedPathVolumeLookup(pszVolume, NULL);
 
         if(ret == 0)
         {
             ret = RedCoreVolTransact();
         }
+      #endif
 
         PosixLeave();
     }
@@ -934,6 +1128,122 @@ int32_t red_transact(
 }
 
 
+#if REDCONF_TRANSACT_ASYNC == 1
+/** @brief Start committing a transaction point, without waiting for it.
+
+    Like red_transact(), except that this function returns once the working
+    state has been written, without waiting for the metaroot to be written and
+    the block device to be flushed.  The transaction point is finished by a
+    background task, or by the first operation which needs it finished.  Until
+    the transaction point is finished, file system operations which only read
+    (for example, red_read() when #REDCONF_ATIME is disabled, red_stat(), and
+    red_fstat()) proceed as usual, while operations which modify any volume
+    wait for it to finish.  If there is nothing to commit, no transaction point
+    is started.
+
+    Use red_transact_poll() to find out whether the transaction point has
+    finished, or to wait for it.
+
+    @param pszVolume    A path prefix identifying the volume to transact.
+
+    @return On success, zero is returned.  On error, -1 is returned and
+            #red_errno is set appropriately.
+
+    <b>Errno values</b>
+    - #RED_EINVAL: Volume is not mounted; or @p pszVolume is `NULL`.
+    - #RED_EIO: I/O error while writing the working state.
+    - #RED_ENOENT: @p pszVolume is not a valid volume path prefix.
+    - #RED_EUSERS: Cannot become a file system user: too many users.
+    - #RED_EROFS: The file system volume is read-only.
+*/
+int32_t red_transact_async(
+    const char *pszVolume)
+{
+    REDSTATUS   ret;
+
+    ret = PosixEnter();
+    if(ret == 0)
+    {
+        uint8_t bVolNum;
+
+        ret = RedPathVolumeLookup(pszVolume, &bVolNum);
+
+        if(ret == 0)
+        {
+            ret = RedCoreVolTransactStart();
+        }
+
+        if((ret == 0) && RedCoreVolCommitPending(bVolNum))
+        {
+            gaAsyncCommit[bVolNum].iResult = 0;
+            RedOsBackgroundTaskWake();
+        }
+
+        PosixLeave();
+    }
+
+    return PosixReturn(ret);
+}
+
+
+/** @brief Check on a transaction point started by red_transact_async().
+
+    @param pszVolume    A path prefix identifying the volume.
+    @param fWait        Whether to wait for the transaction point to finish, if
+                        it has not already.
+
+    @return Zero is returned if there is no unfinished transaction point on the
+            volume and the last one started by red_transact_async() (if any)
+            succeeded.  Otherwise, -1 is returned and #red_errno is set
+            appropriately.
+
+    <b>Errno values</b>
+    - #RED_EBUSY: @p fWait is false and the transaction point has not finished.
+    - #RED_EINVAL: @p pszVolume is `NULL`.
+    - #RED_EIO: I/O error while finishing the transaction point.  This is only
+      reported once.
+    - #RED_ENOENT: @p pszVolume is not a valid volume path prefix.
+    - #RED_EUSERS: Cannot become a file system user: too many users.
+*/
+int32_t red_transact_poll(
+    const char *pszVolume,
+    bool        fWait)
+{
+    REDSTATUS   ret;
+
+    ret = PosixEnterRead();
+    if(ret == 0)
+    {
+        uint8_t bVolNum;
+
+        ret = RedPathVolumeLookup(pszVolume, &bVolNum);
+
+        if((ret == 0) && fWait)
+        {
+            AsyncCommitWait();
+        }
+
+        if(ret == 0)
+        {
+            if(RedCoreVolCommitPending(bVolNum))
+            {
+                ret = -RED_EBUSY;
+            }
+            else
+            {
+                ret = gaAsyncCommit[bVolNum].iResult;
+                gaAsyncCommit[bVolNum].iResult = 0;
+            }
+        }
+
+        PosixLeave();
+    }
+
+    return PosixReturn(ret);
+}
+#endif /* REDCONF_TRANSACT_ASYNC == 1 */
+
+
 /** @brief Rollback to the previous transaction point.
 
     Reliance Edge is a transactional file system.  All modifications, of both
@@ -1009,6 +1319,135 @@ int32_t red_rollback(
 #endif /* REDCONF_READ_ONLY == 0 */
 
 
+#if REDCONF_API_POSIX_SNAPSHOT == 1
+/** @brief Open a read-only view of the committed state of a volume.
+
+    The view shows the volume as it was at the last transaction point, while
+    the working state goes on changing: this allows a consistent backup, or
+    checksums, to be taken without stopping the tasks which write to the
+    volume.  The returned file descriptor is for the root directory of the
+    view.  Files and directories opened with red_openat() via a relative path
+    from a directory in the view, and directory streams opened for them with
+    red_fdopendir(), are also in the view.  They can be read and examined, but
+    attempts to modify them fail with #RED_EROFS.  Absolute paths are always
+    resolved in the working state.
+
+    Transaction points go on being made while the view is open.  Blocks which
+    the view uses stay allocated after the working state frees them, so a
+    long-lived view makes the volume fill up sooner.  Inodes and imap nodes
+    alternate between two fixed locations, so when a transaction point would
+    let the working state overwrite one which the view uses, it is first
+    copied elsewhere, or "pinned".  #REDCONF_SNAPSHOT_PINS blocks are set aside
+    for this when the view is opened.  If the view needs more pins than that,
+    it is abandoned rather than holding up the working state: its blocks are
+    released, and reads in it fail with #RED_EIO until its last handle is
+    closed.
+
+    The view is closed when the last handle in it is closed.  While it is
+    open, calling this function again returns another handle in the same
+    view, even if transaction points have been made since.
+
+    @param pszVolume    A path prefix identifying the volume.
+
+    @return On success, a nonnegative file descriptor for the root directory of
+            the view is returned.  On error, -1 is returned and #red_errno is
+            set appropriately.
+
+    <b>Errno values</b>
+    - #RED_EACCES: #REDCONF_POSIX_OWNER_PERM is enabled and POSIX permissions
+      prohibit the current user from reading the root directory.
+    - #RED_EINVAL: Volume is not mounted; or @p pszVolume is `NULL`.
+    - #RED_EIO: A disk I/O error occurred; or the open view was abandoned.
+    - #RED_EMFILE: There are no available file descriptors.
+    - #RED_ENOENT: @p pszVolume is not a valid volume path prefix.
+    - #RED_ENOSPC: There are not enough free blocks to set aside for pinning.
+    - #RED_EUSERS: Cannot become a file system user: too many users.
+*/
+int32_t red_opensnapshot(
+    const char *pszVolume)
+{
+    int32_t     iFildes = -1; /* Init'd to quiet warnings. */
+    REDSTATUS   ret;
+
+    ret = PosixEnter();
+    if(ret == 0)
+    {
+        ret = RedPathVolumeLookup(pszVolume, NULL);
+
+        if((ret == 0) && !gpRedVolume->fMounted)
+        {
+            ret = -RED_EINVAL;
+        }
+
+        if(ret == 0)
+        {
+            REDHANDLE *pHandle = HandleFindFree();
+
+            if(pHandle == NULL)
+            {
+                ret = -RED_EMFILE;
+            }
+            else
+            {
+              #if REDCONF_POSIX_OWNER_PERM == 1
+                REDSTAT s;
+              #endif
+
+                /*  The view copies the committed state metaroot when it is
+                    opened, so open it before entering it.  The handle takes a
+                    reference of its own, so this one is dropped below.
+                */
+                ret = RedCoreViewOpen();
+                if(ret == 0)
+                {
+                    ViewEnter(gbRedVolNum);
+
+                  #if REDCONF_POSIX_OWNER_PERM == 1
+                    ret = RedCoreStat(INODE_ROOTDIR, &s);
+                    if(ret == 0)
+                    {
+                        ret = RedPermCheck(RED_R_OK, s.st_mode, s.st_uid, s.st_gid);
+                    }
+
+                    if(ret == 0)
+                  #endif
+                    {
+                        ret = HandleOpen(pHandle, INODE_ROOTDIR);
+                    }
+
+                    RedCoreViewClose();
+                }
+
+                if(ret == 0)
+                {
+                    pHandle->bFlags |= HFLAG_DIRECTORY | HFLAG_READABLE;
+
+                    iFildes = FildesPack((uint16_t)(pHandle - gaHandle), gbRedVolNum);
+                    if(iFildes == -1)
+                    {
+                        /*  It should be impossible to get here, unless there
+                            is memory corruption.
+                        */
+                        REDERROR();
+                        ret = -RED_EFUBAR;
+                    }
+                }
+            }
+        }
+
+        PosixLeave();
+    }
+
+    if(ret != 0)
+    {
+        iFildes = PosixReturn(ret);
+    }
+
+    return iFildes;
+}
+#endif /* REDCONF_API_POSIX_SNAPSHOT == 1 */
+
+
 #if REDCONF_READ_ONLY == 0
 /** @brief Update the transaction mask.
 
@@ -1098,7 +1537,7 @@ int32_t red_gettransmask(
 {
     REDSTATUS   ret;
 
-    ret = PosixEnter();
+    ret = PosixEnterRead();
     if(ret == 0)
     {
         ret = RedPathVolumeLookup(pszVolume, NULL);
@@ -1115,6 +1554,104 @@ int32_t red_gettransmask(
 }
 
 
+#if REDCONF_TRANSACT_AUTO == 1
+/** @brief Set the automatic transaction policy.
+
+    The policy supplements the transaction mask with thresholds: a transaction
+    point is made once the given number of blocks have been allocated, or bytes
+    of file data written, since the last transaction point; or once the volume
+    has had uncommitted changes for the given number of milliseconds.  A
+    threshold of zero is disabled.
+
+    The block and byte thresholds are checked after each operation which
+    changes the volume.  The interval is checked by the background task, every
+    #REDCONF_BUFFER_WRITEBACK_INTERVAL_MS milliseconds, so the interval
+    transaction point may come up to that much later than requested.
+
+    @param pszVolume    The path prefix of the volume whose transaction policy
+                        is being changed.
+    @param pPolicy      The automatic transaction policy to set.
+
+    @return On success, zero is returned.  On error, -1 is returned and
+            #red_errno is set appropriately.
+
+    <b>Errno values</b>
+    - #RED_EINVAL: Volume is not mounted; or @p pszVolume is `NULL`; or
+      @p pPolicy is `NULL`.
+    - #RED_ENOENT: @p pszVolume is not a valid volume path prefix.
+    - #RED_EROFS: The file system volume is read-only.
+    - #RED_EUSERS: Cannot become a file system user: too many users.
+*/
+int32_t red_settranspolicy(
+    const char             *pszVolume,
+    const REDTRANSPOLICY   *pPolicy)
+{
+    REDSTATUS               ret;
+
+    ret = PosixEnter();
+    if(ret == 0)
+    {
+        uint8_t bVolNum;
+
+        ret = RedPathVolumeLookup(pszVolume, &bVolNum);
+
+        if(ret == 0)
+        {
+            ret = RedCoreTransPolicySet(pPolicy);
+        }
+
+        if(ret == 0)
+        {
+            gaAutoTrans[bVolNum].fTiming = false;
+        }
+
+        PosixLeave();
+    }
+
+    return PosixReturn(ret);
+}
+
+
+/** @brief Read the automatic transaction policy.
+
+    @param pszVolume    The path prefix of the volume whose transaction policy
+                        is being retrieved.
+    @param pPolicy      Populated with the current automatic transaction
+                        policy for the volume.
+
+    @return On success, zero is returned.  On error, -1 is returned and
+            #red_errno is set appropriately.
+
+    <b>Errno values</b>
+    - #RED_EINVAL: Volume is not mounted; or @p pszVolume is `NULL`; or
+      @p pPolicy is `NULL`.
+    - #RED_ENOENT: @p pszVolume is not a valid volume path prefix.
+    - #RED_EUSERS: Cannot become a file system user: too many users.
+*/
+int32_t red_gettranspolicy(
+    const char     *pszVolume,
+    REDTRANSPOLICY *pPolicy)
+{
+    REDSTATUS       ret;
+
+    ret = PosixEnterRead();
+    if(ret == 0)
+    {
+        ret = RedPathVolumeLookup(pszVolume, NULL);
+
+        if(ret == 0)
+        {
+            ret = RedCoreTransPolicyGet(pPolicy);
+        }
+
+        PosixLeave();
+    }
+
+    return PosixReturn(ret);
+}
+#endif
+
+
 /** @brief Query file system status information.
 
     @p pszVolume should name a valid volume prefix or a valid root directory;
@@ -1139,7 +1676,7 @@ int32_t red_statvfs(
 {
     REDSTATUS   ret;
 
-    ret = PosixEnter();
+    ret = PosixEnterRead();
     if(ret == 0)
     {
         ret = RedPathVolumeLookup(pszVolume, NULL);
@@ -1156,6 +1693,111 @@ int32_t red_statvfs(
 }
 
 
+#if REDCONF_BUFFER_STATS == 1
+/** @brief Get buffer cache statistics for a volume.
+
+    The statistics count buffer lookups, hits, misses, and evictions; dirty
+    buffers written when evicted and when flushed; block device reads and
+    writes; and metadata CRC checks.  Each counter is kept separately for each
+    kind of block (file data and each metadata node type); see ::REDBUFSTATS
+    and the `RED_BUFSTAT_*` indices.
+
+    The counters accumulate from the time red_init() is called and are not
+    reset by mount or unmount.  To measure a particular operation, take the
+    difference of the statistics before and after it.
+
+    @param pszVolume    The path prefix of the volume whose statistics are to
+                        be returned.  The volume need not be mounted.
+    @param pStats       Populated with the buffer statistics for the volume.
+
+    @return On success, zero is returned.  On error, -1 is returned and
+            #red_errno is set appropriately.
+
+    <b>Errno values</b>
+    - #RED_EINVAL: @p pszVolume is `NULL`; or @p pStats is `NULL`; or the
+      driver is uninitialized.
+    - #RED_ENOENT: @p pszVolume is not a valid volume path prefix.
+    - #RED_EUSERS: Cannot become a file system user: too many users.
+*/
+int32_t red_bufstats(
+    const char     *pszVolume,
+    REDBUFSTATS    *pStats)
+{
+    REDSTATUS       ret;
+
+    ret = PosixEnterRead();
+    if(ret == 0)
+    {
+        ret = RedPathVolumeLookup(pszVolume, NULL);
+
+        if(ret == 0)
+        {
+            ret = RedCoreBufferStats(pStats);
+        }
+
+        PosixLeave();
+    }
+
+    return PosixReturn(ret);
+}
+#endif
+
+
+#if REDCONF_TRANSACT_STATS == 1
+/** @brief Get write amplification statistics for the most recent transaction
+           point on a volume.
+
+    The statistics count, for everything done to the working state between the
+    previous transaction point and the most recent one: the blocks which were
+    branched (copied to a new location before being modified), including imap
+    nodes toggled to their alternate location; the blocks which were newly
+    allocated; the blocks written to the block device, including file data and
+    the metaroot; the committed blocks which were freed; and the bytes written
+    to commit the metaroot.  The counters which are kept by kind of block are
+    indexed by the `RED_BUFSTAT_*` values; see ::REDTRANSTATS.
+
+    To find out what a particular operation costs, commit a transaction point
+    before and after it with red_transact(), then get the statistics.  If
+    REDTRANSTATS::ullSequence did not change, there was nothing to commit.
+
+    @param pszVolume    The path prefix of the volume whose statistics are to
+                        be returned.  The volume need not be mounted.
+    @param pStats       Populated with the transaction statistics for the
+                        volume.
+
+    @return On success, zero is returned.  On error, -1 is returned and
+            #red_errno is set appropriately.
+
+    <b>Errno values</b>
+    - #RED_EINVAL: @p pszVolume is `NULL`; or @p pStats is `NULL`; or the
+      driver is uninitialized.
+    - #RED_ENOENT: @p pszVolume is not a valid volume path prefix.
+    - #RED_EUSERS: Cannot become a file system user: too many users.
+*/
+int32_t red_transtats(
+    const char     *pszVolume,
+    REDTRANSTATS   *pStats)
+{
+    REDSTATUS       ret;
+
+    ret = PosixEnterRead();
+    if(ret == 0)
+    {
+        ret = RedPathVolumeLookup(pszVolume, NULL);
+
+        if(ret == 0)
+        {
+            ret = RedCoreTransactStats(pStats);
+        }
+
+        PosixLeave();
+    }
+
+    return PosixReturn(ret);
+}
+#endif
+
+
 #if DELETE_SUPPORTED && (REDCONF_DELETE_OPEN == 1)
 /** @brief Free inodes orphaned before the most recent mount.
 
@@ -1777,7 +2419,13 @@ int32_t red_readlink(
     uint32_t    ulLenRead = 0U;
     REDSTATUS   ret;
 
+  #if REDCONF_ATIME == 0
+    /*  Without access times, reading does not modify the volume.
+    */
+    ret = PosixEnterRead();
+  #else
     ret = PosixEnter();
+  #endif
     if(ret == 0)
     {
         if(ulBufferSize > (uint32_t)INT32_MAX)
@@ -3686,7 +4334,7 @@ int32_t red_fstatat(
 {
     REDSTATUS   ret;
 
-    ret = PosixEnter();
+    ret = PosixEnterRead();
     if(ret == 0)
     {
         if((ulFlags & RED_AT_SYMLINK_NOFOLLOW) != ulFlags)
@@ -3741,7 +4389,7 @@ int32_t red_fstat(
 {
     REDSTATUS   ret;
 
-    ret = PosixEnter();
+    ret = PosixEnterRead();
     if(ret == 0)
     {
         REDHANDLE *pHandle;
@@ -3965,15 +4613,23 @@ int32_t red_pwrite(
     data, directory contents, and metadata) to permanent storage.  This
     function will not return until the operation is complete.
 
-    In the current implementation, this function has global effect.  All dirty
-    buffers are flushed and a transaction point is committed.  Fsyncing one
-    file effectively fsyncs all files.
+    The changes are committed by a transaction point, which flushes all dirty
+    buffers and commits every change on the volume, so fsyncing one file
+    usually fsyncs all files.  However, if #REDCONF_TRANSACT_GROUP is enabled,
+    no transaction point is made when the changes to the file are already
+    committed: because the file has not been modified since the last
+    transaction point, or because another task committed a transaction point
+    after this call was made.  Changes to other files may then be left
+    uncommitted.  Renaming or linking the file, or unlinking one of its names,
+    modifies the file itself, even within the same directory, so fsyncing the
+    file commits such changes.  Creating, renaming, or deleting other entries
+    in the directory of the file does not modify the file; fsync the
+    directory to commit those.
 
     If fsync automatic transactions have been disabled, this function does
-    nothing and returns success.  In the current implementation, this is the
-    only real difference between this function and red_transact(): this
-    function can be configured to do nothing, whereas red_transact() is
-    unconditional.
+    nothing and returns success.  Otherwise, the only difference between this
+    function and red_transact() is that, with #REDCONF_TRANSACT_GROUP, this
+    function skips the transaction point when the file has not been modified.
 
     Applications written for portability should avoid assuming red_fsync()
     effects all files, and use red_fsync() on each file that needs to be
@@ -4011,9 +4667,14 @@ int32_t red_fsync(
       #endif
 
         /*  No core event for fsync, so this transaction flag needs to be
-            implemented here.
+            implemented here.  Nothing in the view of the committed state needs
+            to be synchronized.
         */
-        if(ret == 0)
+        if(    (ret == 0)
+          #if REDCONF_API_POSIX_SNAPSHOT == 1
+            && ((pHandle->bFlags & HFLAG_SNAPSHOT) == 0U)
+          #endif
+          )
         {
             uint32_t    ulTransMask;
 
@@ -4021,7 +4682,11 @@ int32_t red_fsync(
 
             if((ret == 0) && ((ulTransMask & RED_TRANSACT_FSYNC) != 0U))
             {
+              #if REDCONF_TRANSACT_GROUP == 1
+                ret = TransactGroup(pHandle->pOpenIno->bVolNum, pHandle->pOpenIno->ulInode);
+              #else
                 ret = RedCoreVolTransact();
+              #endif
             }
         }
 
@@ -4078,7 +4743,7 @@ int64_t red_lseek(
     REDSTATUS   ret;
     int64_t     llReturn = -1;  /* Init'd to quiet warnings. */
 
-    ret = PosixEnter();
+    ret = PosixEnterRead();
     if(ret == 0)
     {
         int64_t     llFrom = 0; /* Init'd to quiet warnings. */
@@ -4392,7 +5057,142 @@ int32_t red_freserve(
 
     return PosixReturn(ret);
 }
-#endif /* (REDCONF_READ_ONLY == 0) && (REDCONF_API_POSIX_FRESERVE == 1) */
+#endif /* (REDCONF_READ_ONLY == 0) && (REDCONF_API_POSIX_FRESERVE == 1) */
+
+
+#if REDCONF_API_POSIX_DEFRAG == 1
+/** @brief Get fragmentation statistics for a file.
+
+    The data of the file is examined to find how many extents it is stored in:
+    runs of file blocks which are contiguous on disk, each of which can be read
+    with a single block device request.  The average extent length is
+    REDFRAGSTAT::ulBlocks divided by REDFRAGSTAT::ulExtents.
+
+    Passing read-only file descriptors to this function is permitted.
+
+    @param iFildes  The file descriptor of the file to examine.
+    @param pStat    Populated with the fragmentation statistics of the file.
+
+    @return On success, zero is returned.  On error, -1 is returned and
+            #red_errno is set appropriately.
+
+    <b>Errno values</b>
+    - #RED_EBADF: The @p iFildes argument is not a valid file descriptor.
+    - #RED_EINVAL: @p pStat is `NULL`.
+    - #RED_EIO: A disk I/O error occurred.
+    - #RED_EISDIR: The @p iFildes is a file descriptor for a directory.
+    - #RED_EUSERS: Cannot become a file system user: too many users.
+*/
+int32_t red_fragstat(
+    int32_t         iFildes,
+    REDFRAGSTAT    *pStat)
+{
+    REDSTATUS       ret;
+
+    ret = PosixEnter();
+    if(ret == 0)
+    {
+        REDHANDLE *pHandle;
+
+        if(pStat == NULL)
+        {
+            ret = -RED_EINVAL;
+        }
+        else
+        {
+            ret = FildesToHandle(iFildes, FTYPE_FILE, &pHandle);
+        }
+
+      #if REDCONF_VOLUME_COUNT > 1U
+        if(ret == 0)
+        {
+            ret = RedCoreVolSetCurrent(pHandle->pOpenIno->bVolNum);
+        }
+      #endif
+
+        if(ret == 0)
+        {
+            ret = RedCoreFileExtents(pHandle->pOpenIno->ulInode, &pStat->ulExtents, &pStat->ulBlocks);
+        }
+
+        PosixLeave();
+    }
+
+    return PosixReturn(ret);
+}
+
+
+#if REDCONF_READ_ONLY == 0
+/** @brief Move the data of a file into contiguous blocks.
+
+    Since a block is never overwritten in place, a file which has been
+    rewritten becomes scattered over the volume, and reading it takes many
+    block device requests.  This function copies the data of the file into
+    newly allocated blocks, which are contiguous if there is a long enough run
+    of free blocks, and frees the old blocks.  If the data is already
+    contiguous, nothing is done.  The data of the file is not changed, and its
+    timestamps are not updated.
+
+    The move is atomic: until the next transaction point, the committed state
+    still refers to the old blocks, which are not reused.  There must be
+    enough free space for a second copy of the file data; the space used by
+    the old copy is returned to free space by the next transaction point.  For
+    automatic transactions, this function counts as a write.
+
+    Passing read-only file descriptors to this function is permitted.
+
+    This function works on a mounted volume while other file descriptors,
+    including ones for the same file, remain open, so an application can call
+    it during idle periods.  It only sees the volume as mounted by the calling
+    application's copy of the driver: a separate program such as the reddefrag
+    host tool mounts the volume itself, and so can only be used on an offline
+    image or device which nothing else has mounted.
+
+    @param iFildes  The file descriptor of the file to defragment.
+
+    @return On success, zero is returned.  On error, -1 is returned and
+            #red_errno is set appropriately.
+
+    <b>Errno values</b>
+    - #RED_EBADF: The @p iFildes argument is not a valid file descriptor.
+    - #RED_EIO: A disk I/O error occurred.
+    - #RED_EISDIR: The @p iFildes is a file descriptor for a directory.
+    - #RED_ENOSPC: Insufficient free space for a second copy of the file
+      data.  Nothing was moved.
+    - #RED_EROFS: The file system volume is read-only.
+    - #RED_EUSERS: Cannot become a file system user: too many users.
+*/
+int32_t red_defrag(
+    int32_t     iFildes)
+{
+    REDSTATUS   ret;
+
+    ret = PosixEnter();
+    if(ret == 0)
+    {
+        REDHANDLE *pHandle;
+
+        ret = FildesToHandle(iFildes, FTYPE_FILE, &pHandle);
+
+      #if REDCONF_VOLUME_COUNT > 1U
+        if(ret == 0)
+        {
+            ret = RedCoreVolSetCurrent(pHandle->pOpenIno->bVolNum);
+        }
+      #endif
+
+        if(ret == 0)
+        {
+            ret = RedCoreFileDefrag(pHandle->pOpenIno->ulInode);
+        }
+
+        PosixLeave();
+    }
+
+    return PosixReturn(ret);
+}
+#endif /* REDCONF_READ_ONLY == 0 */
+#endif /* REDCONF_API_POSIX_DEFRAG == 1 */
 
 
 #if REDCONF_API_POSIX_READDIR == 1
@@ -4574,6 +5374,13 @@ REDDIRENT *red_readdir(
         }
       #endif
 
+      #if REDCONF_API_POSIX_SNAPSHOT == 1
+        if((ret == 0) && ((pDirStream->bFlags & HFLAG_SNAPSHOT) != 0U))
+        {
+            ViewEnter(pDirStream->pOpenIno->bVolNum);
+        }
+      #endif
+
         if(ret == 0)
         {
             ret = RedCoreDirRead(pDirStream->pOpenIno->ulInode, &pDirStream->o.ulDirPosition, pDirStream->dirent.d_name, &pDirStream->dirent.d_ino);
@@ -5219,7 +6026,16 @@ static int32_t ReadSub(
     uint32_t    ulLenRead = 0U;
     REDSTATUS   ret;
 
+    /*  Without access time updates, a read modifies nothing.  While an
+        asynchronous transaction point is pending, every buffer is clean, so
+        buffers replaced by the read (including by read-ahead) are not written
+        back, and the read can proceed while the transaction point finishes.
+    */
+  #if REDCONF_ATIME == 0
+    ret = PosixEnterRead();
+  #else
     ret = PosixEnter();
+  #endif
     if(ret == 0)
     {
         if(ulLength > (uint32_t)INT32_MAX)
@@ -5994,6 +6810,9 @@ static REDSTATUS FildesClose(
 
     Also validates the file descriptor.
 
+    If the handle is in the view of the committed state, that view is entered,
+    so that the operation sees the committed state until PosixLeave().
+
     @param iFildes      The file descriptor for which to get a handle.
     @param expectedType The expected type of the file descriptor: one or more of
                         #FTYPE_DIR, #FTYPE_FILE, #FTYPE_SYMLINK.
@@ -6069,6 +6888,14 @@ static REDSTATUS FildesToHandle(
             if(ret == 0)
             {
                 *ppHandle = &gaHandle[uHandleIdx];
+
+              #if REDCONF_API_POSIX_SNAPSHOT == 1
+                if((gaHandle[uHandleIdx].bFlags & HFLAG_SNAPSHOT) != 0U)
+                {
+                    ViewEnter(bVolNum);
+                }
+              #endif
+
                 ret = 0;
             }
         }
@@ -6233,6 +7060,9 @@ static REDHANDLE *HandleFindFree(void)
 
 /** @brief Associate a handle with the given inode.
 
+    If the view of the committed state of the current volume has been entered,
+    the handle is in that view.
+
     @param pHandle  Pointer to the ::REDHANDLE to associate with @p ulInode.
     @param ulInode  The inode number to associate with ::REDHANDLE.
 
@@ -6254,9 +7084,30 @@ static REDSTATUS HandleOpen(
     }
     else
     {
-        OPENINODE *pOpenIno = OpenInoFind(gbRedVolNum, ulInode, true);
+        OPENINODE *pOpenIno = NULL;
+
+      #if REDCONF_API_POSIX_SNAPSHOT == 1
+        if(RedCoreViewIsEntered(gbRedVolNum))
+        {
+            ret = RedCoreViewOpen();
+            if(ret == 0)
+            {
+                pOpenIno = OpenInoAllocSnapshot(gbRedVolNum, ulInode);
+                pHandle->bFlags |= HFLAG_SNAPSHOT;
+            }
+        }
+        else
+      #endif
+        {
+            pOpenIno = OpenInoFind(gbRedVolNum, ulInode, true);
+        }
 
-        if(pOpenIno == NULL)
+        if(ret != 0)
+        {
+            /*  Propagate the error.
+            */
+        }
+        else if(pOpenIno == NULL)
         {
             /*  This should never happen.  There are the same number of open
                 inode structures as there are handles, and at most one open
@@ -6348,6 +7199,13 @@ static REDSTATUS HandleClose(
         {
             pHandle->pOpenIno = NULL;
 
+          #if REDCONF_API_POSIX_SNAPSHOT == 1
+            if((pHandle->bFlags & HFLAG_SNAPSHOT) != 0U)
+            {
+                RedCoreViewClose();
+            }
+          #endif
+
             /*  No core event for close, so close transactions and freeing of
                 orphans needs to be implemented here.
 
@@ -6397,7 +7255,12 @@ static OPENINODE *OpenInoFind(
     {
         OPENINODE *pThisOpenIno = &gaOpenInos[ulIdx];
 
-        if((pThisOpenIno->ulInode == ulInode) && (pThisOpenIno->bVolNum == bVolNum))
+        if(    (pThisOpenIno->ulInode == ulInode)
+            && (pThisOpenIno->bVolNum == bVolNum)
+          #if REDCONF_API_POSIX_SNAPSHOT == 1
+            && ((pThisOpenIno->bFlags & OIFLAG_SNAPSHOT) == 0U)
+          #endif
+           )
         {
             pOpenIno = pThisOpenIno;
             break;
@@ -6423,6 +7286,64 @@ static OPENINODE *OpenInoFind(
 }
 
 
+#if REDCONF_API_POSIX_SNAPSHOT == 1
+/** @brief Allocate an open inode for a handle in the view of the committed
+           state.
+
+    The inodes in the view are not the inodes of the working state, and nothing
+    needs to be shared between handles for them, so each such handle gets an
+    open inode of its own, which OpenInoFind() never returns.
+
+    @param bVolNum  The volume number of the volume that the inode resides on.
+    @param ulInode  The inode number.
+
+    @return Returns a pointer to the ::OPENINODE structure for the open inode.
+            Returns `NULL` only if there are no available open inodes, which is
+            an unexpected condition.
+*/
+static OPENINODE *OpenInoAllocSnapshot(
+    uint8_t     bVolNum,
+    uint32_t    ulInode)
+{
+    OPENINODE  *pOpenIno = NULL;
+    uint32_t    ulIdx;
+
+    for(ulIdx = 0U; ulIdx < ARRAY_SIZE(gaOpenInos); ulIdx++)
+    {
+        if(gaOpenInos[ulIdx].ulInode == INODE_INVALID)
+        {
+            pOpenIno = &gaOpenInos[ulIdx];
+
+            RedMemSet(pOpenIno, 0U, sizeof(*pOpenIno));
+
+            pOpenIno->ulInode = ulInode;
+            pOpenIno->bVolNum = bVolNum;
+            pOpenIno->bFlags = OIFLAG_SNAPSHOT;
+            break;
+        }
+    }
+
+    return pOpenIno;
+}
+
+
+/** @brief Enter the view of the committed state of a volume, until
+           PosixLeave().
+
+    Must be called from within the file system driver (between PosixEnter() or
+    PosixEnterRead() and PosixLeave()).
+
+    @param bVolNum  The volume number of the volume.
+*/
+static void ViewEnter(
+    uint8_t     bVolNum)
+{
+    RedCoreViewEnter(bVolNum);
+    gfViewEntered = true;
+}
+#endif /* REDCONF_API_POSIX_SNAPSHOT == 1 */
+
+
 /** @brief Dereference an open inode, closing it if it becomes unreferenced.
 
     @param pOpenIno                 The open inode to dereference.
@@ -6524,6 +7445,9 @@ static REDSTATUS OpenInoDeref(
 
 /** @brief Enter the file system driver.
 
+    If an asynchronous transaction point is being finished, waits for it: the
+    volumes must not be modified until it has finished.
+
     @return A negated ::REDSTATUS code indicating the operation result.
 
     @retval 0           Operation was successful.
@@ -6531,6 +7455,35 @@ static REDSTATUS OpenInoDeref(
     @retval -RED_EUSERS Cannot become a file system user: too many users.
 */
 static REDSTATUS PosixEnter(void)
+{
+    REDSTATUS ret;
+
+    ret = PosixEnterRead();
+
+  #if REDCONF_TRANSACT_ASYNC == 1
+    if(ret == 0)
+    {
+        AsyncCommitWait();
+    }
+  #endif
+
+    return ret;
+}
+
+
+/** @brief Enter the file system driver for an operation which does not modify
+           any volume.
+
+    Unlike PosixEnter(), does not wait for asynchronous transaction points to
+    finish.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EINVAL The file system driver is uninitialized.
+    @retval -RED_EUSERS Cannot become a file system user: too many users.
+*/
+static REDSTATUS PosixEnterRead(void)
 {
     REDSTATUS ret = 0;
 
@@ -6556,6 +7509,8 @@ static REDSTATUS PosixEnter(void)
 
 
 /** @brief Leave the file system driver.
+
+    Any view of the committed state entered by the operation is left.
 */
 static void PosixLeave(void)
 {
@@ -6564,12 +7519,319 @@ static void PosixLeave(void)
     */
     REDASSERT(gfPosixInited);
 
+  #if REDCONF_API_POSIX_SNAPSHOT == 1
+    if(gfViewEntered)
+    {
+        uint8_t bVolNum;
+
+        for(bVolNum = 0U; bVolNum < REDCONF_VOLUME_COUNT; bVolNum++)
+        {
+            RedCoreViewLeave(bVolNum);
+        }
+
+        gfViewEntered = false;
+    }
+  #endif
+
   #if REDCONF_TASK_COUNT > 1U
     RedOsMutexRelease();
   #endif
 }
 
 
+#if REDCONF_TRANSACT_GROUP == 1
+/** @brief Commit a transaction point, sharing it with concurrent requests.
+
+    A request is satisfied without a transaction point of its own if its
+    changes have already been committed: either because another task committed
+    a transaction point after the request was made, or because the inode has
+    not been modified since the last transaction point.  Requests which arrive
+    while a transaction point is being committed are thus satisfied by the
+    next one, rather than each committing its own.  If
+    #REDCONF_TRANSACT_GROUP_WINDOW_US is nonzero, requests also wait up to that
+    long for other requests to join them.
+
+    Must be called from within the file system driver (between PosixEnter()
+    and PosixLeave()).  While waiting, the file system mutex is released.
+
+    @param bVolNum  The volume to transact.  Must be the current volume.
+    @param ulInode  The inode whose changes must be committed; or
+                    #INODE_INVALID if all changes on the volume must be
+                    committed.
+
+    @return A negated ::REDSTATUS code indicating the operation result.
+
+    @retval 0           Operation was successful.
+    @retval -RED_EBADF  @p ulInode is not a valid inode.
+    @retval -RED_EINVAL The volume is not mounted.
+    @retval -RED_EIO    A disk I/O error occurred.
+    @retval -RED_EROFS  The file system volume is read-only.
+*/
+static REDSTATUS TransactGroup(
+    uint8_t     bVolNum,
+    uint32_t    ulInode)
+{
+    uint32_t    ulTransactCount = gaRedVolume[bVolNum].ulTransactCount;
+    bool        fDone = false;
+    REDSTATUS   ret = 0;
+
+    while((ret == 0) && !fDone)
+    {
+        bool fBranched = true;
+
+        if(!gaRedVolume[bVolNum].fMounted || gaRedVolume[bVolNum].fReadOnly)
+        {
+            /*  Let the core report the error.
+            */
+            ret = RedCoreVolTransact();
+            fDone = true;
+        }
+        else if(gaRedVolume[bVolNum].ulTransactCount != ulTransactCount)
+        {
+            /*  Another task committed a transaction point after this request
+                was made, which included the changes.
+            */
+            fDone = true;
+        }
+        else
+        {
+            ret = RedCoreIsBranched(ulInode, &fBranched);
+            fDone = !fBranched;
+        }
+
+      #if REDCONF_TRANSACT_GROUP_WINDOW_US > 0U
+        if((ret == 0) && !fDone)
+        {
+            TRANSGROUP *pGroup = &gaTransGroup[bVolNum];
+            uint64_t    ullWaited = 0U;
+
+            if(pGroup->fOpen && (pGroup->ulTransactCount == ulTransactCount))
+            {
+                ullWaited = RedOsTimePassed(pGroup->tsOpened);
+            }
+            else
+            {
+                pGroup->fOpen = true;
+                pGroup->ulTransactCount = ulTransactCount;
+                pGroup->tsOpened = RedOsTimestamp();
+            }
+
+            if(ullWaited < REDCONF_TRANSACT_GROUP_WINDOW_US)
+            {
+                RedOsMutexRelease();
+                RedOsTaskSleep((uint32_t)(REDCONF_TRANSACT_GROUP_WINDOW_US - ullWaited));
+                RedOsMutexAcquire();
+
+              #if REDCONF_TRANSACT_ASYNC == 1
+                AsyncCommitWait();
+              #endif
+
+              #if REDCONF_VOLUME_COUNT > 1U
+                ret = RedCoreVolSetCurrent(bVolNum);
+              #endif
+
+                /*  Check again whether the changes have been committed.
+                */
+                fBranched = false;
+            }
+        }
+      #endif
+
+        if((ret == 0) && fBranched && !fDone)
+        {
+            ret = RedCoreVolTransact();
+            fDone = true;
+        }
+    }
+
+    return ret;
+}
+#endif /* REDCONF_TRANSACT_GROUP == 1 */
+
+
+#if REDCONF_TRANSACT_ASYNC == 1
+/** @brief Wait for all asynchronous transaction points to finish.
+
+    Transaction points which no other task is finishing are finished by the
+    calling task, rather than waiting for the background task to get to them.
+
+    Must be called from within the file system driver (between PosixEnter() or
+    PosixEnterRead() and PosixLeave()).  While waiting, the file system mutex is
+    released, so the current volume must be set again afterward.
+*/
+static void AsyncCommitWait(void)
+{
+    uint8_t bVolNum = 0U;
+
+    while(bVolNum < REDCONF_VOLUME_COUNT)
+    {
+        if(!RedCoreVolCommitPending(bVolNum))
+        {
+            bVolNum++;
+        }
+        else if(!gaAsyncCommit[bVolNum].fWriting)
+        {
+            AsyncCommitFinish(bVolNum);
+        }
+        else
+        {
+            RedOsMutexRelease();
+            RedOsTaskSleep(ASYNC_COMMIT_POLL_US);
+            RedOsMutexAcquire();
+        }
+    }
+}
+
+
+/** @brief Finish the asynchronous transaction point on a volume.
+
+    The metaroot is written without holding the file system mutex, so that
+    other tasks can read from the volume in the meantime.  Nothing modifies the
+    volume until the transaction point is finished, and other tasks which need
+    it finished wait while ASYNCCOMMIT::fWriting is set, so the mutex is not needed.
+
+    Must be called from within the file system driver (between PosixEnter() or
+    PosixEnterRead() and PosixLeave()), with a commit pending on the volume which
+    no other task is writing.  The current volume is changed to @p bVolNum.
+
+    @param bVolNum  The volume number of the volume with the pending commit.
+*/
+static void AsyncCommitFinish(
+    uint8_t     bVolNum)
+{
+    ASYNCCOMMIT *pCommit = &gaAsyncCommit[bVolNum];
+    REDSTATUS   ret;
+
+    REDASSERT(RedCoreVolCommitPending(bVolNum));
+    REDASSERT(!pCommit->fWriting);
+
+    pCommit->fWriting = true;
+
+    RedOsMutexRelease();
+    ret = RedCoreVolTransactCommit(bVolNum);
+    RedOsMutexAcquire();
+
+  #if REDCONF_VOLUME_COUNT > 1U
+    /*  The commit must be finished regardless, and setting the current volume
+        cannot fail, since the volume number is valid.
+    */
+    (void)RedCoreVolSetCurrent(bVolNum);
+  #endif
+
+    pCommit->iResult = RedCoreVolTransactFinish(ret);
+    pCommit->fWriting = false;
+}
+#endif
+
+
+#if POSIX_BACKGROUND == 1
+/** @brief Periodic work done by the background task.
+
+    Asynchronous transaction points are finished, unless another task is
+    already finishing them.  Interval transaction points are made where the
+    automatic transaction policy calls for them.  Dirty buffers are written
+    back on each mounted, writable volume, so that tasks using the file system seldom have
+    to wait for a dirty buffer to be written before it can be reused.  Errors
+    from writing back are ignored: the buffers stay dirty, and the error will be
+    reported when they are written by a file system operation.
+
+    The background task is not a file system user: it takes the FS mutex
+    directly, like red_uninit(), rather than through PosixEnterRead(), so that
+    it does not use up one of the #REDCONF_TASK_COUNT task slots.
+*/
+static void PosixBackground(void)
+{
+    RedOsMutexAcquire();
+
+    if(gfPosixInited)
+    {
+        uint8_t bVolNum;
+
+        for(bVolNum = 0U; bVolNum < REDCONF_VOLUME_COUNT; bVolNum++)
+        {
+          #if REDCONF_TRANSACT_ASYNC == 1
+            if(RedCoreVolCommitPending(bVolNum) && !gaAsyncCommit[bVolNum].fWriting)
+            {
+                AsyncCommitFinish(bVolNum);
+            }
+          #endif
+
+          #if REDCONF_TRANSACT_AUTO == 1
+            AutoTransactInterval(bVolNum);
+          #endif
+
+          #if REDCONF_BUFFER_CLEAN_LOW_WATER > 0U
+            if(gaRedVolume[bVolNum].fMounted && !gaRedVolume[bVolNum].fReadOnly)
+            {
+              #if REDCONF_VOLUME_COUNT > 1U
+                if(RedCoreVolSetCurrent(bVolNum) == 0)
+              #endif
+                {
+                    (void)RedCoreVolWriteBack();
+                }
+            }
+          #endif
+        }
+    }
+
+    RedOsMutexRelease();
+}
+#endif
+
+
+#if REDCONF_TRANSACT_AUTO == 1
+/** @brief Make a transaction point if a volume has had uncommitted changes for
+           longer than the interval in its automatic transaction policy.
+
+    Must be called with the FS mutex held.  Errors are ignored: the changes
+    stay uncommitted, and the next check will try again.
+
+    @param bVolNum  The volume number of the volume to check.
+*/
+static void AutoTransactInterval(
+    uint8_t     bVolNum)
+{
+    AUTOTRANS  *pAuto = &gaAutoTrans[bVolNum];
+    uint32_t    ulIntervalMs = gaRedVolume[bVolNum].transPolicy.ulIntervalMs;
+    bool        fBranched = false;
+
+    if(    gaRedVolume[bVolNum].fMounted
+        && !gaRedVolume[bVolNum].fReadOnly
+        && (ulIntervalMs > 0U)
+      #if REDCONF_TRANSACT_ASYNC == 1
+        && !RedCoreVolCommitPending(bVolNum)
+      #endif
+      #if REDCONF_VOLUME_COUNT > 1U
+        && (RedCoreVolSetCurrent(bVolNum) == 0)
+      #endif
+        && (RedCoreIsBranched(INODE_INVALID, &fBranched) == 0)
+        && fBranched)
+    {
+        if(!pAuto->fTiming || (pAuto->ulTransactCount != gaRedVolume[bVolNum].ulTransactCount))
+        {
+            pAuto->fTiming = true;
+            pAuto->ulTransactCount = gaRedVolume[bVolNum].ulTransactCount;
+            pAuto->tsBranched = RedOsTimestamp();
+        }
+        else if(RedOsTimePassed(pAuto->tsBranched) >= ((uint64_t)ulIntervalMs * 1000U))
+        {
+            (void)RedCoreVolTransact();
+            pAuto->fTiming = false;
+        }
+        else
+        {
+            /*  Not uncommitted for long enough yet.
+            */
+        }
+    }
+    else
+    {
+        pAuto->fTiming = false;
+    }
+}
+#endif
+
+
 #if DELETE_SUPPORTED
 /** @brief Check whether an inode can be deleted.
 
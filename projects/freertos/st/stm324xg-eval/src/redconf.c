@@ -13,5 +13,5 @@
 
 const VOLCONF gaRedVolConf[REDCONF_VOLUME_COUNT] =
 {
-    { 512U, 1048576U, 0U, false, 1024U, 2U, "" }
+    { 512U, 1048576U, 0U, false, 1024U, 2U, "", 0U }
 };
@@ -0,0 +1,121 @@
+/*             ----> DO NOT REMOVE THE FOLLOWING NOTICE <----
+
+                  Copyright (c) 2014-2025 Tuxera US Inc.
+                      All Rights Reserved Worldwide.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; use version 2 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but "AS-IS," WITHOUT ANY WARRANTY; without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+/*  Businesses and individuals that for commercial or other reasons cannot
+    comply with the terms of the GPLv2 license must obtain a commercial
+    license before incorporating Reliance Edge into proprietary software
+    for distribution in any form.
+
+    Visit https://www.tuxera.com/products/tuxera-edge-fs/ for more information.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <redfs.h>
+#include <redtests.h>
+
+#if FSPERF_SUPPORTED
+
+#include <redposix.h>
+#include <redvolume.h>
+
+
+/** @brief Entry point for the fsperf test.
+*/
+int main(
+    int             argc,
+    char           *argv[])
+{
+    int             iRet;
+    PARAMSTATUS     pstatus;
+    FSPERFPARAM     param;
+    uint8_t         bVolNum;
+    const char     *pszDrive;
+
+    pstatus = FsperfParseParams(argc, argv, &param, &bVolNum, &pszDrive);
+    if(pstatus == PARAMSTATUS_OK)
+    {
+        const char *pszVolume = gaRedVolConf[bVolNum].pszPathPrefix;
+        int32_t     iErr;
+
+        iErr = red_init();
+        if(iErr == -1)
+        {
+            fprintf(stderr, "Unexpected error %d from red_init()\n", (int)red_errno);
+            exit(red_errno);
+        }
+
+        if(pszDrive != NULL)
+        {
+            REDSTATUS   ret;
+
+            ret = RedOsBDevConfig(bVolNum, pszDrive);
+            if(ret != 0)
+            {
+                fprintf(stderr, "Unexpected error %d from RedOsBDevConfig()\n", (int)ret);
+                exit(ret);
+            }
+        }
+
+        iErr = RedTestFmtOptionsPreserve(pszVolume);
+        if(iErr == -1)
+        {
+            fprintf(stderr, "Unexpected error %d from RedTestFmtOptionsPreserve()\n", (int)red_errno);
+            exit(red_errno);
+        }
+
+        iErr = red_mount(pszVolume);
+        if(iErr == -1)
+        {
+            fprintf(stderr, "Unexpected error %d from red_mount()\n", (int)red_errno);
+            exit(red_errno);
+        }
+
+        printf("fsperf begin...\n");
+        iRet = FsperfStart(&param);
+        printf("fsperf end, return %d\n", iRet);
+
+        iErr = red_umount(pszVolume);
+        if(iErr == -1)
+        {
+            fprintf(stderr, "Unexpected error %d from red_umount()\n", (int)red_errno);
+            exit(red_errno);
+        }
+    }
+    else if(pstatus == PARAMSTATUS_HELP)
+    {
+        iRet = 0; /* Help request: do nothing but indicate success. */
+    }
+    else
+    {
+        iRet = 1; /* Bad parameters: indicate failure. */
+    }
+
+    return iRet;
+}
+
+
+#else
+
+int main(void)
+{
+    fprintf(stderr, "fsperf test is not supported in this configuration.\n");
+    return 1;
+}
+
+#endif
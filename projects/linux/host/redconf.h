@@ -62,6 +62,11 @@
 #undef  REDCONF_API_POSIX_READDIR
 #define REDCONF_API_POSIX_READDIR 1
 
+/*  The defragmenter host tool needs red_fragstat() and red_defrag().
+*/
+#undef  REDCONF_API_POSIX_DEFRAG
+#define REDCONF_API_POSIX_DEFRAG 1
+
 /*  The image copier utility needs a handle for every level of directory depth.
     While Reliance Edge has no maximum directory depth or path depth, Windows
     limits paths to 260 bytes, and each level of depth eats up at least two
@@ -0,0 +1,451 @@
+/*             ----> DO NOT REMOVE THE FOLLOWING NOTICE <----
+
+                  Copyright (c) 2014-2025 Tuxera US Inc.
+                      All Rights Reserved Worldwide.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; use version 2 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but "AS-IS," WITHOUT ANY WARRANTY; without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+/*  Businesses and individuals that for commercial or other reasons cannot
+    comply with the terms of the GPLv2 license must obtain a commercial
+    license before incorporating Reliance Edge into proprietary software
+    for distribution in any form.
+
+    Visit https://www.tuxera.com/products/tuxera-edge-fs/ for more information.
+*/
+/** @file
+    @brief Implements a multi-threaded fsync benchmark for the Linux port.
+
+    Each thread appends to its own file, calling red_fsync() after every write,
+    like a task writing a log.  The number of fsync calls per second, the number
+    of transaction points actually committed, and percentiles of the fsync
+    latency are reported, along with the block device flushes and FUA writes
+    needed.  With #REDCONF_TRANSACT_GROUP, fsync calls from different threads
+    share transaction points.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+
+#include <redfs.h>
+
+#if (REDCONF_TASK_COUNT > 1U) && (REDCONF_API_POSIX == 1) && (REDCONF_READ_ONLY == 0) && (REDCONF_API_POSIX_FORMAT == 1)
+
+#include <redposix.h>
+#include <redgetopt.h>
+#include <redtoolcmn.h>
+#include <redvolume.h>
+#include <redbdev.h>
+
+
+#define FSYNCPERF_THREADS_MAX   8U
+#define FSYNCPERF_THREADS       4U
+#define FSYNCPERF_OPS           500U
+#define FSYNCPERF_WRITE_SIZE    256U
+#define FSYNCPERF_PATH_MAX      64U
+
+
+/** @brief Per-thread state.
+*/
+typedef struct
+{
+    pthread_t   thread;         /**< The thread. */
+    uint32_t    ulIndex;        /**< Index of the thread, used to name its file. */
+    uint64_t   *pullLatency;    /**< Latency of each fsync call, in microseconds. */
+    int32_t     iErrno;         /**< red_errno of the first failure, or zero. */
+} FSYNCTHREAD;
+
+
+static void *FsyncThread(void *pArg);
+static int CompareU64(const void *pA, const void *pB);
+static bool ParseU32(const char *pszArg, uint32_t *pulValue);
+static void Usage(const char *pszProgramName, bool fError);
+
+
+static const char *gpszVolume;
+static uint32_t gulOps = FSYNCPERF_OPS;
+static uint32_t gulWriteSize = FSYNCPERF_WRITE_SIZE;
+static pthread_barrier_t gBarrier;
+
+
+/** @brief Entry point for the fsync benchmark.
+
+    @param argc The size of the @p argv array.
+    @param argv The arguments to the program.
+
+    @return Zero on success, nonzero on failure.
+*/
+int main(
+    int             argc,
+    char           *argv[])
+{
+    int32_t         c;
+    const char     *pszDrive = NULL;
+    uint32_t        ulThreads = FSYNCPERF_THREADS;
+    FSYNCTHREAD     aThread[FSYNCPERF_THREADS_MAX];
+    uint64_t       *pullLatency;
+    uint8_t         bVolNum;
+    uint32_t        ulThread;
+    uint32_t        ulTotal;
+    uint64_t        ullMicrosecs;
+    REDTIMESTAMP    ts;
+    int             iRet = 0;
+  #if REDCONF_BDEV_STATS == 1
+    BDEVSTATS       bdevStats;
+  #endif
+  #if REDCONF_BUFFER_STATS == 1
+    REDBUFSTATS     stats;
+    uint64_t        ullCommits = 0U;
+  #endif
+    const REDOPTION aLongopts[] =
+    {
+        { "threads", red_required_argument, NULL, 't' },
+        { "ops", red_required_argument, NULL, 'n' },
+        { "size", red_required_argument, NULL, 's' },
+        { "dev", red_required_argument, NULL, 'D' },
+        { "help", red_no_argument, NULL, 'H' },
+        { NULL }
+    };
+
+    while((c = RedGetoptLong(argc, argv, "t:n:s:D:H", aLongopts, NULL)) != -1)
+    {
+        switch(c)
+        {
+            case 't': /* --threads */
+                if(!ParseU32(red_optarg, &ulThreads) || (ulThreads == 0U) || (ulThreads > FSYNCPERF_THREADS_MAX))
+                {
+                    fprintf(stderr, "Invalid thread count: %s\n", red_optarg);
+                    Usage(argv[0U], true);
+                }
+                break;
+            case 'n': /* --ops */
+                if(!ParseU32(red_optarg, &gulOps) || (gulOps == 0U))
+                {
+                    fprintf(stderr, "Invalid operation count: %s\n", red_optarg);
+                    Usage(argv[0U], true);
+                }
+                break;
+            case 's': /* --size */
+                if(!ParseU32(red_optarg, &gulWriteSize) || (gulWriteSize == 0U) || (gulWriteSize > REDCONF_BLOCK_SIZE))
+                {
+                    fprintf(stderr, "Invalid write size: %s\n", red_optarg);
+                    Usage(argv[0U], true);
+                }
+                break;
+            case 'D': /* --dev */
+                pszDrive = red_optarg;
+                break;
+            case 'H': /* --help */
+                Usage(argv[0U], false);
+                break;
+            case '?': /* Unknown or ambiguous option */
+            case ':': /* Option missing required argument */
+            default:
+                Usage(argv[0U], true);
+                break;
+        }
+    }
+
+    if(red_optind >= argc)
+    {
+        fprintf(stderr, "Missing volume argument\n");
+        Usage(argv[0U], true);
+    }
+
+    bVolNum = RedFindVolumeNumber(argv[red_optind]);
+    if(bVolNum == REDCONF_VOLUME_COUNT)
+    {
+        fprintf(stderr, "Error: \"%s\" is not a valid volume identifier.\n", argv[red_optind]);
+        Usage(argv[0U], true);
+    }
+
+    gpszVolume = gaRedVolConf[bVolNum].pszPathPrefix;
+
+    if(red_init() != 0)
+    {
+        fprintf(stderr, "Unexpected error %d from red_init()\n", (int)red_errno);
+        exit(red_errno);
+    }
+
+    if(pszDrive != NULL)
+    {
+        REDSTATUS ret = RedOsBDevConfig(bVolNum, pszDrive);
+
+        if(ret != 0)
+        {
+            fprintf(stderr, "Unexpected error %d from RedOsBDevConfig()\n", (int)ret);
+            exit(ret);
+        }
+    }
+
+    if((red_format(gpszVolume) != 0) || (red_mount(gpszVolume) != 0))
+    {
+        fprintf(stderr, "Unexpected error %d formatting and mounting the volume\n", (int)red_errno);
+        exit(red_errno);
+    }
+
+    ulTotal = ulThreads * gulOps;
+    pullLatency = malloc(sizeof(*pullLatency) * ulTotal);
+    if(pullLatency == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+
+    (void)pthread_barrier_init(&gBarrier, NULL, ulThreads + 1U);
+
+    for(ulThread = 0U; ulThread < ulThreads; ulThread++)
+    {
+        aThread[ulThread].ulIndex = ulThread;
+        aThread[ulThread].pullLatency = &pullLatency[ulThread * gulOps];
+        aThread[ulThread].iErrno = 0;
+
+        if(pthread_create(&aThread[ulThread].thread, NULL, FsyncThread, &aThread[ulThread]) != 0)
+        {
+            fprintf(stderr, "Unable to create thread %u\n", (unsigned)ulThread);
+            exit(1);
+        }
+    }
+
+  #if REDCONF_BUFFER_STATS == 1
+    if(red_bufstats(gpszVolume, &stats) == 0)
+    {
+        ullCommits = stats.aType[RED_BUFSTAT_METAROOT].ullIoWrites;
+    }
+  #endif
+
+    /*  Release the threads once they have all opened their files.
+    */
+    (void)pthread_barrier_wait(&gBarrier);
+  #if REDCONF_BDEV_STATS == 1
+    bdevStats = gaRedBdevStats[bVolNum];
+  #endif
+    ts = RedOsTimestamp();
+
+    for(ulThread = 0U; ulThread < ulThreads; ulThread++)
+    {
+        (void)pthread_join(aThread[ulThread].thread, NULL);
+
+        if(aThread[ulThread].iErrno != 0)
+        {
+            fprintf(stderr, "Thread %u failed with error %d\n", (unsigned)ulThread, (int)aThread[ulThread].iErrno);
+            iRet = 1;
+        }
+    }
+
+    ullMicrosecs = RedOsTimePassed(ts);
+
+  #if REDCONF_BUFFER_STATS == 1
+    if(red_bufstats(gpszVolume, &stats) == 0)
+    {
+        ullCommits = stats.aType[RED_BUFSTAT_METAROOT].ullIoWrites - ullCommits;
+    }
+  #endif
+
+    if(iRet == 0)
+    {
+        if(ullMicrosecs == 0U)
+        {
+            ullMicrosecs = 1U;
+        }
+
+        qsort(pullLatency, ulTotal, sizeof(*pullLatency), CompareU64);
+
+      #if REDCONF_TRANSACT_GROUP == 1
+        printf("fsyncperf: %u threads x %u fsyncs of %u-byte appends, group commit window %u us\n",
+            (unsigned)ulThreads, (unsigned)gulOps, (unsigned)gulWriteSize, (unsigned)REDCONF_TRANSACT_GROUP_WINDOW_US);
+      #else
+        printf("fsyncperf: %u threads x %u fsyncs of %u-byte appends, group commit disabled\n",
+            (unsigned)ulThreads, (unsigned)gulOps, (unsigned)gulWriteSize);
+      #endif
+        printf("fsyncperf: %u fsyncs in %llu us: %llu fsyncs/s\n",
+            (unsigned)ulTotal, (unsigned long long)ullMicrosecs, (unsigned long long)((ulTotal * 1000000ULL) / ullMicrosecs));
+      #if REDCONF_BUFFER_STATS == 1
+        printf("fsyncperf: %llu transaction points: %llu commits/s, %llu.%02u fsyncs per commit\n",
+            (unsigned long long)ullCommits, (unsigned long long)((ullCommits * 1000000ULL) / ullMicrosecs),
+            (unsigned long long)(ullCommits == 0U ? 0U : (ulTotal / ullCommits)),
+            (unsigned)(ullCommits == 0U ? 0U : (((ulTotal * 100ULL) / ullCommits) % 100U)));
+      #endif
+      #if REDCONF_BDEV_STATS == 1
+        printf("fsyncperf: %llu device flushes, %llu FUA writes\n",
+            (unsigned long long)(gaRedBdevStats[bVolNum].ullFlushes - bdevStats.ullFlushes),
+            (unsigned long long)(gaRedBdevStats[bVolNum].ullFuaWrites - bdevStats.ullFuaWrites));
+      #endif
+        printf("fsyncperf: fsync latency us: p50 %llu, p90 %llu, p99 %llu, max %llu\n",
+            (unsigned long long)pullLatency[(ulTotal * 50U) / 100U],
+            (unsigned long long)pullLatency[(ulTotal * 90U) / 100U],
+            (unsigned long long)pullLatency[(ulTotal * 99U) / 100U],
+            (unsigned long long)pullLatency[ulTotal - 1U]);
+    }
+
+    (void)pthread_barrier_destroy(&gBarrier);
+    free(pullLatency);
+
+    if(red_umount(gpszVolume) != 0)
+    {
+        fprintf(stderr, "Unexpected error %d from red_umount()\n", (int)red_errno);
+        iRet = 1;
+    }
+
+    return iRet;
+}
+
+
+/** @brief Thread which appends to a file, fsyncing after each write.
+
+    @param pArg The ::FSYNCTHREAD structure for the thread.
+
+    @return Always `NULL`.
+*/
+static void *FsyncThread(
+    void           *pArg)
+{
+    FSYNCTHREAD    *pThread = pArg;
+    char            szPath[FSYNCPERF_PATH_MAX];
+    static const uint8_t abData[REDCONF_BLOCK_SIZE] = {0U};
+    int32_t         iFildes;
+    uint32_t        ulOp;
+
+    (void)snprintf(szPath, sizeof(szPath), "%s%clog%u.dat", gpszVolume, REDCONF_PATH_SEPARATOR, (unsigned)pThread->ulIndex);
+
+    iFildes = red_open(szPath, RED_O_WRONLY | RED_O_CREAT | RED_O_TRUNC | RED_O_APPEND);
+    if(iFildes < 0)
+    {
+        pThread->iErrno = red_errno;
+    }
+
+    (void)pthread_barrier_wait(&gBarrier);
+
+    for(ulOp = 0U; (iFildes >= 0) && (ulOp < gulOps); ulOp++)
+    {
+        REDTIMESTAMP ts;
+
+        if(red_write(iFildes, abData, gulWriteSize) != (int32_t)gulWriteSize)
+        {
+            pThread->iErrno = red_errno;
+            break;
+        }
+
+        ts = RedOsTimestamp();
+
+        if(red_fsync(iFildes) != 0)
+        {
+            pThread->iErrno = red_errno;
+            break;
+        }
+
+        pThread->pullLatency[ulOp] = RedOsTimePassed(ts);
+    }
+
+    if((iFildes >= 0) && (red_close(iFildes) != 0) && (pThread->iErrno == 0))
+    {
+        pThread->iErrno = red_errno;
+    }
+
+    return NULL;
+}
+
+
+/** @brief Compare two uint64_t values, for qsort().
+*/
+static int CompareU64(
+    const void *pA,
+    const void *pB)
+{
+    uint64_t    ullA = *(const uint64_t *)pA;
+    uint64_t    ullB = *(const uint64_t *)pB;
+
+    return (ullA < ullB) ? -1 : ((ullA > ullB) ? 1 : 0);
+}
+
+
+/** @brief Parse an unsigned 32-bit decimal number.
+
+    @param pszArg   The string to parse.
+    @param pulValue On success, populated with the parsed value.
+
+    @return Whether @p pszArg was a valid number.
+*/
+static bool ParseU32(
+    const char     *pszArg,
+    uint32_t       *pulValue)
+{
+    unsigned long   ulVal;
+    char           *pszEnd;
+    bool            fValid;
+
+    errno = 0;
+    ulVal = strtoul(pszArg, &pszEnd, 10);
+    fValid = (ulVal != ULONG_MAX) && (errno == 0) && (*pszEnd == '\0') && (pszEnd != pszArg);
+  #if ULONG_MAX > UINT32_MAX
+    fValid = fValid && (ulVal <= UINT32_MAX);
+  #endif
+
+    if(fValid)
+    {
+        *pulValue = (uint32_t)ulVal;
+    }
+
+    return fValid;
+}
+
+
+/** @brief Print usage information and exit.
+
+    @param pszProgramName   The argv[0] from main().
+    @param fError           Whether this function is being invoked due to an
+                            invocation error.
+*/
+static void Usage(
+    const char *pszProgramName,
+    bool        fError)
+{
+    int         iExitStatus = fError ? 1 : 0;
+    FILE       *pOut = fError ? stderr : stdout;
+    static const char szUsage[] =
+"usage: %s VolumeID [--threads=count] [--ops=count] [--size=bytes] [--dev=devname]\n"
+"       [--help]\n"
+"Measure fsync throughput and latency with several threads appending to their\n"
+"own files.  The volume is formatted first.\n"
+"\n"
+"Where:\n"
+"  VolumeID\n"
+"      A volume number (e.g., 2) or a volume path prefix (e.g., VOL1: or /data)\n"
+"      of the volume to test.\n"
+"  --threads=count, -t count\n"
+"      Number of threads, up to %u.  The default is %u.\n"
+"  --ops=count, -n count\n"
+"      Number of write and fsync calls by each thread.  The default is %u.\n"
+"  --size=bytes, -s bytes\n"
+"      Size of each write, up to the block size.  The default is %u.\n"
+"  --dev=devname, -D devname\n"
+"      Specifies the device name.  This can be the path and name of a file disk\n"
+"      (e.g., red.bin); or \"ram\" for a RAM disk.\n"
+"  --help, -H\n"
+"      Prints this usage text and exits.\n\n";
+
+    fprintf(pOut, szUsage, pszProgramName, FSYNCPERF_THREADS_MAX, FSYNCPERF_THREADS, FSYNCPERF_OPS, FSYNCPERF_WRITE_SIZE);
+    exit(iExitStatus);
+}
+
+#else
+
+int main(void)
+{
+    fprintf(stderr, "fsyncperf is not supported in this configuration.\n");
+    return 1;
+}
+
+#endif
@@ -0,0 +1,6 @@
+/** @file
+*/
+
+/*  The performance tests use the same volume configuration as the target.
+*/
+#include "../redconf.c"
@@ -0,0 +1,116 @@
+/** @file
+*/
+
+/*  Inherit most settings from the target configuration.
+*/
+#include "../redconf.h"
+
+
+#ifndef PERF_REDCONF_H
+#define PERF_REDCONF_H
+
+
+/*  Enable the optional features that fsperf and fsyncperf measure, which are
+    disabled in the target configuration.  Some of these are overridden again
+    below.
+*/
+#undef  REDCONF_CRC_ALGORITHM
+#define REDCONF_CRC_ALGORITHM CRC_CLMUL
+#undef  REDCONF_API_POSIX_DEFRAG
+#define REDCONF_API_POSIX_DEFRAG 1
+#undef  REDCONF_API_POSIX_SNAPSHOT
+#define REDCONF_API_POSIX_SNAPSHOT 1
+#undef  REDCONF_BUFFER_STATS
+#define REDCONF_BUFFER_STATS 1
+#undef  REDCONF_BDEV_STATS
+#define REDCONF_BDEV_STATS 1
+#undef  REDCONF_TRANSACT_STATS
+#define REDCONF_TRANSACT_STATS 1
+#undef  REDCONF_BUFFER_CRC_INCREMENTAL
+#define REDCONF_BUFFER_CRC_INCREMENTAL 1
+#undef  REDCONF_IMAP_SUMMARY_NODES
+#define REDCONF_IMAP_SUMMARY_NODES 256U
+#undef  REDCONF_TRANSACT_GROUP
+#define REDCONF_TRANSACT_GROUP 1
+#undef  REDCONF_TRANSACT_ASYNC
+#define REDCONF_TRANSACT_ASYNC 1
+#undef  REDCONF_TRANSACT_AUTO
+#define REDCONF_TRANSACT_AUTO 1
+
+/*  Allow the buffer count to be set from the makefile (P_BUFFER_COUNT), so
+    that the buffer cache can be measured with different numbers of buffers.
+*/
+#ifdef PERF_BUFFER_COUNT
+#undef  REDCONF_BUFFER_COUNT
+#define REDCONF_BUFFER_COUNT PERF_BUFFER_COUNT
+#endif
+
+/*  Likewise for the size of the write-gather buffer (P_WRITE_GATHER_KB).
+*/
+#ifdef PERF_WRITE_GATHER_KB
+#undef  REDCONF_BUFFER_WRITE_GATHER_SIZE_KB
+#define REDCONF_BUFFER_WRITE_GATHER_SIZE_KB PERF_WRITE_GATHER_KB
+#endif
+
+/*  Likewise for the size of the read-ahead buffer (P_READ_AHEAD_BLOCKS).
+*/
+#ifdef PERF_READ_AHEAD_BLOCKS
+#undef  REDCONF_READ_AHEAD_BLOCKS
+#define REDCONF_READ_AHEAD_BLOCKS PERF_READ_AHEAD_BLOCKS
+#endif
+
+/*  Likewise for the number of clean buffers maintained by the background
+    write-back task (P_CLEAN_LOW_WATER).
+*/
+#ifdef PERF_CLEAN_LOW_WATER
+#undef  REDCONF_BUFFER_CLEAN_LOW_WATER
+#define REDCONF_BUFFER_CLEAN_LOW_WATER PERF_CLEAN_LOW_WATER
+#endif
+
+/*  Likewise for the size of the protected metadata segment (P_META_SEGMENT).
+*/
+#ifdef PERF_META_SEGMENT
+#undef  REDCONF_BUFFER_META_SEGMENT
+#define REDCONF_BUFFER_META_SEGMENT PERF_META_SEGMENT
+#endif
+
+/*  Likewise for incremental metadata node CRC updates (P_CRC_INCREMENTAL).
+*/
+#ifdef PERF_CRC_INCREMENTAL
+#undef  REDCONF_BUFFER_CRC_INCREMENTAL
+#define REDCONF_BUFFER_CRC_INCREMENTAL PERF_CRC_INCREMENTAL
+#endif
+
+/*  Likewise for the number of external imap nodes whose free blocks are
+    counted in RAM (P_IMAP_SUMMARY_NODES), and for the block size
+    (P_BLOCK_SIZE), since the volumes only have many imap nodes when the blocks
+    are small.
+*/
+#ifdef PERF_IMAP_SUMMARY_NODES
+#undef  REDCONF_IMAP_SUMMARY_NODES
+#define REDCONF_IMAP_SUMMARY_NODES PERF_IMAP_SUMMARY_NODES
+#endif
+#ifdef PERF_BLOCK_SIZE
+#undef  REDCONF_BLOCK_SIZE
+#define REDCONF_BLOCK_SIZE PERF_BLOCK_SIZE
+#endif
+
+/*  Overrides for group commit (P_TRANSACT_GROUP), and for how long a transaction
+    point waits for others to join it (P_TRANSACT_GROUP_WINDOW_US).
+*/
+#ifdef PERF_TRANSACT_GROUP
+#undef  REDCONF_TRANSACT_GROUP
+#define REDCONF_TRANSACT_GROUP PERF_TRANSACT_GROUP
+#endif
+#ifdef PERF_TRANSACT_GROUP_WINDOW_US
+#undef  REDCONF_TRANSACT_GROUP_WINDOW_US
+#define REDCONF_TRANSACT_GROUP_WINDOW_US PERF_TRANSACT_GROUP_WINDOW_US
+#endif
+
+/*  Assertions add overhead which would skew the measurements.
+*/
+#undef  REDCONF_ASSERTS
+#define REDCONF_ASSERTS 0
+
+
+#endif
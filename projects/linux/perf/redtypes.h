@@ -0,0 +1,6 @@
+/** @file
+    @brief Defines basic types used by Reliance Edge.
+
+    The performance tests use the same types as the target.
+*/
+#include "../redtypes.h"
@@ -13,5 +13,5 @@
 
 const VOLCONF gaRedVolConf[REDCONF_VOLUME_COUNT] =
 {
-    { 512U, 65536U, 0U, false, 1024U, 0U, "VOL0:" }
+    { 512U, 65536U, 0U, false, 1024U, 0U, "VOL0:", 0U }
 };
@@ -0,0 +1,3184 @@
+/*             ----> DO NOT REMOVE THE FOLLOWING NOTICE <----
+
+                  Copyright (c) 2014-2025 Tuxera US Inc.
+                      All Rights Reserved Worldwide.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; use version 2 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but "AS-IS," WITHOUT ANY WARRANTY; without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, see <https://www.gnu.org/licenses/>.
+*/
+/*  Businesses and individuals that for commercial or other reasons cannot
+    comply with the terms of the GPLv2 license must obtain a commercial
+    license before incorporating Reliance Edge into proprietary software
+    for distribution in any form.
+
+    Visit https://www.tuxera.com/products/tuxera-edge-fs/ for more information.
+*/
+/** @file
+    @brief File system performance tests.
+
+    Each test exercises one aspect of the file system implementation (e.g.,
+    the buffer cache) through the POSIX-like API and reports how long it took.
+    The tests are intended to be compared across builds with different
+    configurations, rather than to produce meaningful absolute numbers.
+*/
+#include <redfs.h>
+#include <redposix.h>
+#include <redtests.h>
+
+#if FSPERF_SUPPORTED
+
+#include <redvolume.h>
+#include <redbdev.h>
+#include <redcore.h>
+#include <redgetopt.h>
+#include <redtoolcmn.h>
+
+
+
+
+/*  Maximum length of the paths used by the tests.
+*/
+#define PERF_PATH_MAX 64U
+
+/*  Size of each write in the append test.  Chosen to be much smaller than the
+    block size, as is typical of logging applications.
+*/
+#define APPEND_SIZE 512U
+
+/*  Size of each read in the sequential read test, and the maximum size of the
+    file which it reads, in blocks.
+*/
+#define SEQREAD_SIZE 512U
+#define SEQREAD_BLOCKS 2048U
+
+/*  Number of small reads of the streamed file per metadata access in the mixed
+    test.
+*/
+#define MIXED_STREAM_READS 16U
+
+/*  Number of free blocks scattered across the volume by the full allocation
+    test.
+*/
+#define FULLALLOC_HOLES 8U
+
+/*  Size of each write and read in the extent test, in blocks, and the maximum
+    size of the file which it writes.
+*/
+#define EXTENT_IO_BLOCKS 64U
+#define EXTENT_FILE_BLOCKS 8192U
+
+/*  Maximum number of files written and deleted by the delete test.  The file
+    size is the same as the extent test.
+*/
+#define DELETE_FILES 16U
+
+/*  Number of files in each directory created by the create test.
+*/
+#define CREATE_DIR_FILES 100U
+
+/*  Number of files written together by the interleave test, and the maximum
+    size of each, in blocks.
+*/
+#define INTERLEAVE_FILES 4U
+#define INTERLEAVE_FILE_BLOCKS 1024U
+
+/*  Maximum number of transaction points committed by each half of the async
+    transact test, since each one waits for the block device at least twice;
+    and the number of blocks read after each transaction point.
+*/
+#define ASYNC_TRANSACTS 1000U
+#define ASYNC_READ_BLOCKS 64U
+
+/*  Maximum number of blocks written by each run of the auto transact test, and
+    the block and byte thresholds it sets in the transaction policy, in blocks.
+*/
+#define AUTO_WRITES 4096U
+#define AUTO_THRESHOLD_BLOCKS 64U
+
+/*  Number of files, and the maximum size of each in blocks, read through the
+    view of the committed state by the snapshot test.
+*/
+#define SNAPSHOT_FILES 8U
+#define SNAPSHOT_FILE_BLOCKS 128U
+
+/*  Maximum number of transaction points timed by each run of the snapshot
+    test's commit measurement, and of empty files created so that the view
+    uses many inodes.
+*/
+#define SNAPSHOT_COMMITS 1000U
+#define SNAPSHOT_EMPTY_FILES 1000U
+
+/*  Maximum number of fsync calls timed by the group fsync test.
+*/
+#define GROUPFSYNC_CALLS 1000U
+
+
+/*  Runs one of the tests.
+*/
+typedef int (*PERFTESTFN)(const FSPERFPARAM *pParam);
+
+/*  A test which can be selected on the command line.
+*/
+typedef struct
+{
+    const char *pszName;    /* Long option, also the prefix of the test's output. */
+    char        cOption;    /* Short option. */
+    PERFTESTFN  pfnTest;    /* Runs the test. */
+    const char *pszUsage;   /* Description for the usage text. */
+} PERFTEST;
+
+/*  Measurements of an operation.  PerfStart() records the counts when the
+    operation starts, and PerfEnd() replaces them with how much each count
+    changed during the operation.
+*/
+typedef struct
+{
+    REDTIMESTAMP    ts;             /* When the operation started. */
+    uint64_t        ullMicrosecs;   /* Elapsed time, set by PerfEnd(). */
+    uint32_t        ulTransacts;    /* Transaction points. */
+  #if REDCONF_BDEV_STATS == 1
+    BDEVSTATS       bdev;           /* Block device requests. */
+  #endif
+  #if REDCONF_BUFFER_STATS == 1
+    REDBUFSTATS     buf;            /* Buffer cache statistics. */
+  #endif
+} PERFSTATS;
+
+
+static int BufScaleTest(const FSPERFPARAM *pParam);
+static int AppendTest(const FSPERFPARAM *pParam);
+static int SeqReadTest(const FSPERFPARAM *pParam);
+static int MixedTest(const FSPERFPARAM *pParam);
+static int CrcTest(const FSPERFPARAM *pParam);
+static int MetaWriteTest(const FSPERFPARAM *pParam);
+static int FullAllocTest(const FSPERFPARAM *pParam);
+static int ExtentTest(const FSPERFPARAM *pParam);
+static int DeleteTest(const FSPERFPARAM *pParam);
+static int CreateTest(const FSPERFPARAM *pParam);
+static int InterleaveTest(const FSPERFPARAM *pParam);
+static int DefragTest(const FSPERFPARAM *pParam);
+static int AsyncTransactTest(const FSPERFPARAM *pParam);
+#if REDCONF_TRANSACT_ASYNC == 1
+static int AsyncTransactRun(const FSPERFPARAM *pParam, int32_t iWriteFildes, int32_t iReadFildes, bool fAsync);
+#endif
+static int AutoTransactTest(const FSPERFPARAM *pParam);
+#if REDCONF_TRANSACT_AUTO == 1
+static int AutoTransactRun(const FSPERFPARAM *pParam, uint32_t ulWrites, uint32_t ulTransMask, const REDTRANSPOLICY *pPolicy, const char *pszPolicy);
+#endif
+static int SnapshotTest(const FSPERFPARAM *pParam);
+#if REDCONF_API_POSIX_SNAPSHOT == 1
+static int SnapshotRead(int32_t iDirFildes, uint32_t ulBlocks, uint32_t *pulCrc);
+static int SnapshotCommit(const FSPERFPARAM *pParam, const char *pszMetric);
+#endif
+static int GroupFsyncTest(const FSPERFPARAM *pParam);
+#if (REDCONF_TRANSACT_GROUP == 1) && (REDCONF_API_POSIX_RENAME == 1)
+static int GroupFsyncStep(const FSPERFPARAM *pParam, int32_t iFildes, bool fCommit, const char *pszStep);
+#endif
+#if (REDCONF_API_POSIX_DEFRAG == 1) && (REDCONF_READ_ONLY == 0)
+static int DefragReadBack(const FSPERFPARAM *pParam, const char *pszPath, uint32_t ulBlocks, const char *pszState);
+#endif
+#if REDCONF_BUFFER_STATS == 1
+static void MetaHitsMisses(const char *pszVolume, uint64_t *pullHits, uint64_t *pullMisses);
+#endif
+static void PerfStart(const FSPERFPARAM *pParam, PERFSTATS *pStats);
+static void PerfEnd(const FSPERFPARAM *pParam, PERFSTATS *pStats);
+static int PerfStatFs(const FSPERFPARAM *pParam, const char *pszTest, REDSTATFS *pSfs);
+static int PerfOpen(const FSPERFPARAM *pParam, const char *pszTest, const char *pszName, uint32_t ulOpenMode, int32_t *piFildes);
+static void PerfRemove(const FSPERFPARAM *pParam, const char *pszName);
+static int PerfTransact(const FSPERFPARAM *pParam, const char *pszTest);
+static int PerfRemount(const FSPERFPARAM *pParam, const char *pszTest);
+static int PerfFileCreate(const FSPERFPARAM *pParam, const char *pszName, uint32_t ulBlocks, int32_t *piFildes);
+static void PerfPath(char *pszPath, const FSPERFPARAM *pParam, const char *pszName);
+static int PerfError(const char *pszTest, const char *pszFunction);
+static uint64_t PerfRatio(uint64_t ullNumerator, uint64_t ullDenominator);
+static void PerfReport(const char *pszTest, const char *pszMetric, uint64_t ullMicrosecs, uint32_t ulOps);
+static void usage(const char *pszProgName);
+
+
+/*  The tests, in the order in which they are run.  Bit N of
+    FSPERFPARAM::ulTests selects the test at index N.
+*/
+static const PERFTEST gaPerfTest[] =
+{
+    { "bufscale", 'b', BufScaleTest,
+        "      Measure the cost of reading blocks which are already buffered.  Run\n"
+        "      with different buffer counts to see how lookups scale.\n" },
+    { "append", 'a', AppendTest,
+        "      Measure small sequential appends to a file, and the number of block\n"
+        "      device writes needed to store them.  Run with different\n"
+        "      REDCONF_BUFFER_WRITE_GATHER_SIZE_KB values to see the effect of the\n"
+        "      write-gather buffer.\n" },
+    { "seqread", 'r', SeqReadTest,
+        "      Measure small sequential reads of a file, and the number of block device\n"
+        "      reads needed to load it.  Run with different REDCONF_READ_AHEAD_BLOCKS\n"
+        "      values to see the effect of read-ahead.\n" },
+    { "mixed", 'm', MixedTest,
+        "      Measure how often metadata is found in the buffers while a large file is\n"
+        "      read sequentially.  Run with different REDCONF_BUFFER_META_SEGMENT\n"
+        "      values to see the effect of the segmented LRU policy.\n" },
+    { "crc", 'c', CrcTest,
+        "      Measure the cost of computing the CRC of a metadata node.  Run with\n"
+        "      different REDCONF_CRC_ALGORITHM values to compare the algorithms.\n" },
+    { "metawrite", 'w', MetaWriteTest,
+        "      Measure small metadata updates: create, delete, and transact.  Run with\n"
+        "      different REDCONF_BUFFER_CRC_INCREMENTAL values to see the effect of\n"
+        "      incremental node CRC updates.\n" },
+    { "fullalloc", 'f', FullAllocTest,
+        "      Measure block allocation on a nearly full volume, where the imap must\n"
+        "      be searched for one of a few free blocks.\n" },
+    { "extent", 'e', ExtentTest,
+        "      Measure large writes to a file, and the number of block device reads\n"
+        "      needed to read it back with large reads, which shows how contiguous\n"
+        "      the file data was allocated.\n" },
+    { "delete", 'd', DeleteTest,
+        "      Measure deleting large files, and the number of imap buffer lookups\n"
+        "      needed to free their blocks.\n" },
+    { "create", 'n', CreateTest,
+        "      Measure creating files until almost all of the inodes are in use, and\n"
+        "      compare the time taken by the first and last creates.\n" },
+    { "interleave", 'l', InterleaveTest,
+        "      Measure appending to several files in turn, one block at a time, and\n"
+        "      the number of block device reads needed to read them back, which shows\n"
+        "      whether the files were kept contiguous.\n" },
+    { "defrag", 'g', DefragTest,
+        "      Measure reading a file whose blocks have been scattered by rewrites,\n"
+        "      then defragment it with red_defrag() and measure reading it again.\n" },
+    { "asynctransact", 't', AsyncTransactTest,
+        "      Measure how long transaction points keep the caller waiting, and how\n"
+        "      long a write, transact, and read cycle takes, with red_transact() and\n"
+        "      with red_transact_async().  Use a file disk, so that flushes take time.\n" },
+    { "autotransact", 'o', AutoTransactTest,
+        "      Measure appending blocks to a file with a transaction point after every\n"
+        "      write, and with the block and byte thresholds of red_settranspolicy().\n" },
+    { "snapshot", 'p', SnapshotTest,
+        "      Measure reading committed files through red_opensnapshot(), before and\n"
+        "      after they are overwritten, deleted, and replaced in the working state,\n"
+        "      and check that the view does not change.  Also measure transaction\n"
+        "      points with and without the view open.\n" },
+    { "groupfsync", 'y', GroupFsyncTest,
+        "      Measure red_fsync() of a file which has not been modified, which makes\n"
+        "      no transaction point with REDCONF_TRANSACT_GROUP, and check that every\n"
+        "      change to the file, including a rename, is still committed.\n" }
+};
+
+#define PERF_TEST_COUNT ARRAY_SIZE(gaPerfTest)
+
+
+/*  Scratch block used to read and write file data.
+*/
+static uint8_t gabBlock[REDCONF_BLOCK_SIZE];
+
+/*  Scratch buffer for the large writes and reads of the extent test.
+*/
+static uint8_t gabExtent[EXTENT_IO_BLOCKS * REDCONF_BLOCK_SIZE];
+
+
+/** @brief Parse parameters for fsperf.
+
+    @param argc         The number of arguments from main().
+    @param argv         The vector of arguments from main().
+    @param pParam       Populated with the fsperf parameters.
+    @param pbVolNum     If non-NULL, populated with the volume number.
+    @param ppszDevice   If non-NULL, populated with the device name argument or
+                        NULL if no device argument is provided.
+
+    @return The result of parsing the parameters.
+*/
+PARAMSTATUS FsperfParseParams(
+    int             argc,
+    char           *argv[],
+    FSPERFPARAM    *pParam,
+    uint8_t        *pbVolNum,
+    const char    **ppszDevice)
+{
+    int             c;
+    uint8_t         bVolNum;
+    uint32_t        ulTest;
+    char            szOptions[PERF_TEST_COUNT + sizeof("B:i:s:D:H")];
+    REDOPTION       aLongopts[PERF_TEST_COUNT + 6U] =
+    {
+        { "buffers", red_required_argument, NULL, 'B' },
+        { "iterations", red_required_argument, NULL, 'i' },
+        { "seed", red_required_argument, NULL, 's' },
+        { "dev", red_required_argument, NULL, 'D' },
+        { "help", red_no_argument, NULL, 'H' }
+    };
+
+    /*  The test options follow the common options, and the zero-initialized
+        entry after them terminates the table.
+    */
+    for(ulTest = 0U; ulTest < PERF_TEST_COUNT; ulTest++)
+    {
+        aLongopts[5U + ulTest].name = gaPerfTest[ulTest].pszName;
+        aLongopts[5U + ulTest].has_arg = red_no_argument;
+        aLongopts[5U + ulTest].val = gaPerfTest[ulTest].cOption;
+        szOptions[ulTest] = gaPerfTest[ulTest].cOption;
+    }
+
+    RedMemCpy(&szOptions[PERF_TEST_COUNT], "B:i:s:D:H", sizeof("B:i:s:D:H"));
+
+    /*  If run without parameters, treat as a help request.
+    */
+    if(argc <= 1)
+    {
+        goto Help;
+    }
+
+    /*  Assume no device argument to start with.
+    */
+    if(ppszDevice != NULL)
+    {
+        *ppszDevice = NULL;
+    }
+
+    /*  Set default parameters.
+    */
+    FsperfDefaultParams(pParam);
+
+    while((c = RedGetoptLong(argc, argv, szOptions, aLongopts, NULL)) != -1)
+    {
+        switch(c)
+        {
+            case 'B': /* --buffers */
+                pParam->ulBufferCount = RedAtoI(red_optarg);
+                break;
+            case 'i': /* --iterations */
+                pParam->ulIterations = RedAtoI(red_optarg);
+                break;
+            case 's': /* --seed */
+                pParam->ulSeed = RedAtoI(red_optarg);
+                break;
+            case 'D': /* --dev */
+                if(ppszDevice != NULL)
+                {
+                    *ppszDevice = red_optarg;
+                }
+                break;
+            case 'H': /* --help */
+                goto Help;
+            case '?': /* Unknown or ambiguous option */
+            case ':': /* Option missing required argument */
+                goto BadOpt;
+            default: /* A test option */
+                for(ulTest = 0U; ulTest < PERF_TEST_COUNT; ulTest++)
+                {
+                    if(c == gaPerfTest[ulTest].cOption)
+                    {
+                        pParam->ulTests |= 1UL << ulTest;
+                        break;
+                    }
+                }
+
+                if(ulTest == PERF_TEST_COUNT)
+                {
+                    goto BadOpt;
+                }
+                break;
+        }
+    }
+
+    /*  RedGetoptLong() has permuted argv to move all non-option arguments to
+        the end.  We expect to find a volume identifier.
+    */
+    if(red_optind >= argc)
+    {
+        RedPrintf("Missing volume argument\n");
+        goto BadOpt;
+    }
+
+    bVolNum = RedFindVolumeNumber(argv[red_optind]);
+    if(bVolNum == REDCONF_VOLUME_COUNT)
+    {
+        RedPrintf("Error: \"%s\" is not a valid volume identifier.\n", argv[red_optind]);
+        goto BadOpt;
+    }
+
+    if(pbVolNum != NULL)
+    {
+        *pbVolNum = bVolNum;
+    }
+
+    pParam->pszVolume = gaRedVolConf[bVolNum].pszPathPrefix;
+
+    red_optind++; /* Move past volume parameter. */
+    if(red_optind < argc)
+    {
+        int32_t ii;
+
+        for(ii = red_optind; ii < argc; ii++)
+        {
+            RedPrintf("Error: Unexpected command-line argument \"%s\".\n", argv[ii]);
+        }
+
+        goto BadOpt;
+    }
+
+    if(pParam->ulIterations == 0U)
+    {
+        RedPrintf("Error: the iteration count must be nonzero.\n");
+        goto BadOpt;
+    }
+
+  #if REDOSCONF_BUFFER_ALLOC == 0
+    if(pParam->ulBufferCount != 0U)
+    {
+        RedPrintf("Error: the buffer count cannot be changed in this configuration.\n");
+        goto BadOpt;
+    }
+  #endif
+
+    return PARAMSTATUS_OK;
+
+  BadOpt:
+
+    RedPrintf("%s - invalid parameters\n", argv[0U]);
+    usage(argv[0U]);
+    return PARAMSTATUS_BAD;
+
+  Help:
+
+    usage(argv[0U]);
+    return PARAMSTATUS_HELP;
+}
+
+
+/** @brief Set default fsperf parameters.
+
+    @param pParam   Populated with the default fsperf parameters.
+*/
+void FsperfDefaultParams(
+    FSPERFPARAM *pParam)
+{
+    RedMemSet(pParam, 0U, sizeof(*pParam));
+    pParam->ulIterations = 100000U;
+    pParam->ulSeed = 1U;
+}
+
+
+/** @brief Start fsperf.
+
+    If no tests were selected, all of them are run.  The volume must be
+    mounted.
+
+    @param pParam   fsperf parameters, either from FsperfParseParams() or
+                    constructed programmatically.
+
+    @return Zero on success, otherwise nonzero.
+*/
+int FsperfStart(
+    const FSPERFPARAM *pParam)
+{
+    uint32_t    ulTest;
+    int         iRet = 0;
+
+  #if REDOSCONF_BUFFER_ALLOC == 1
+    /*  The buffers can only be resized when none are dirty, so transact first.
+    */
+    if(    (pParam->ulBufferCount != 0U)
+        && ((red_transact(pParam->pszVolume) != 0) || (red_bufresize(pParam->ulBufferCount) != 0)))
+    {
+        RedPrintf("Unexpected error %d setting the buffer count to %lu\n", (int)red_errno, (unsigned long)pParam->ulBufferCount);
+        iRet = 1;
+    }
+  #endif
+
+    for(ulTest = 0U; (iRet == 0) && (ulTest < PERF_TEST_COUNT); ulTest++)
+    {
+        if((pParam->ulTests == 0U) || ((pParam->ulTests & (1UL << ulTest)) != 0U))
+        {
+            iRet = gaPerfTest[ulTest].pfnTest(pParam);
+        }
+    }
+
+    return iRet;
+}
+
+
+/** @brief Measure the cost of finding blocks which are already buffered.
+
+    A file about half the size of the buffer cache is read from in small,
+    randomly located pieces.  After the first pass, every block needed by the
+    reads should be buffered, so the time per read is dominated by the cost of
+    finding buffers.  Ideally, that cost does not depend on the number of
+    buffers: running this test with different buffer counts, either in builds
+    with different values for #REDCONF_BUFFER_COUNT or via the --buffers
+    option, should report roughly the same time per read.
+
+    @param pParam   fsperf parameters.
+
+    @return Zero on success, otherwise nonzero.
+*/
+static int BufScaleTest(
+    const FSPERFPARAM *pParam)
+{
+    uint32_t    ulBufferCount = (pParam->ulBufferCount == 0U) ? REDCONF_BUFFER_COUNT : pParam->ulBufferCount;
+    uint32_t    ulBlocks = (ulBufferCount / 2U) + 1U;
+    int32_t     iFildes;
+    int         iRet;
+
+    iRet = PerfFileCreate(pParam, "bufscale.dat", ulBlocks, &iFildes);
+    if(iRet == 0)
+    {
+        uint32_t    ulSeed = pParam->ulSeed;
+        uint32_t    ulPass;
+        PERFSTATS   stats;
+
+        /*  Two passes: the first warms up the buffers, the second is timed.
+        */
+        for(ulPass = 0U; (iRet == 0) && (ulPass < 2U); ulPass++)
+        {
+            uint32_t ulIter;
+
+            PerfStart(pParam, &stats);
+
+            for(ulIter = 0U; (iRet == 0) && (ulIter < pParam->ulIterations); ulIter++)
+            {
+                uint64_t ullOffset = (uint64_t)(RedRand32(&ulSeed) % ulBlocks) * REDCONF_BLOCK_SIZE;
+
+                if(red_pread(iFildes, gabBlock, 1U, ullOffset) != 1)
+                {
+                    iRet = PerfError("bufscale", "red_pread()");
+                }
+            }
+
+            PerfEnd(pParam, &stats);
+        }
+
+        if(iRet == 0)
+        {
+            RedPrintf("bufscale: %u buffers, %u block working set\n", (unsigned)ulBufferCount, (unsigned)ulBlocks);
+            PerfReport("bufscale", "buffered read", stats.ullMicrosecs, pParam->ulIterations);
+        }
+
+        (void)red_close(iFildes);
+    }
+
+    if(iRet == 0)
+    {
+        PerfRemove(pParam, "bufscale.dat");
+    }
+
+    return iRet;
+}
+
+
+/** @brief Measure small sequential appends.
+
+    A file is extended by many small writes, and then the volume is
+    transacted.  Each write modifies only part of a block, so the appended data
+    is accumulated in the buffers, which are written to disk when they are
+    repurposed or when the volume is transacted.  Besides the elapsed time, the
+    number of block device writes is reported: with the write-gather buffer
+    enabled, dirty buffers for consecutive blocks are written together, so
+    there should be far fewer writes, each writing more sectors.
+
+    The number of appends is the iteration count, limited so that the file
+    uses at most half of the free space on the volume.
+
+    @param pParam   fsperf parameters.
+
+    @return Zero on success, otherwise nonzero.
+*/
+static int AppendTest(
+    const FSPERFPARAM *pParam)
+{
+    uint32_t    ulAppends = pParam->ulIterations;
+    REDSTATFS   sfs;
+    int32_t     iFildes = -1;
+    int         iRet;
+
+    iRet = PerfStatFs(pParam, "append", &sfs);
+    if(iRet == 0)
+    {
+        ulAppends = (uint32_t)REDMIN(ulAppends, (((uint64_t)sfs.f_bfree * sfs.f_frsize) / 2U) / APPEND_SIZE);
+
+        iRet = PerfOpen(pParam, "append", "append.dat", RED_O_WRONLY | RED_O_CREAT | RED_O_TRUNC, &iFildes);
+    }
+
+    if(iRet == 0)
+    {
+        PERFSTATS   stats;
+        uint32_t    ulIter;
+
+        RedMemSet(gabBlock, 0xA5U, sizeof(gabBlock));
+
+        PerfStart(pParam, &stats);
+
+        for(ulIter = 0U; (iRet == 0) && (ulIter < ulAppends); ulIter++)
+        {
+            if(red_write(iFildes, gabBlock, APPEND_SIZE) != (int32_t)APPEND_SIZE)
+            {
+                iRet = PerfError("append", "red_write()");
+            }
+        }
+
+        if(iRet == 0)
+        {
+            iRet = PerfTransact(pParam, "append");
+        }
+
+        PerfEnd(pParam, &stats);
+
+        if(iRet == 0)
+        {
+            RedPrintf("append: %u byte appends, write-gather buffer %u KB\n", (unsigned)APPEND_SIZE,
+                (unsigned)REDCONF_BUFFER_WRITE_GATHER_SIZE_KB);
+            PerfReport("append", "small write", stats.ullMicrosecs, ulAppends);
+          #if REDCONF_BDEV_STATS == 1
+            RedPrintf("append: %llu device writes, %llu sectors written, %llu sectors/write\n",
+                (unsigned long long)stats.bdev.ullWrites, (unsigned long long)stats.bdev.ullSectorsWritten,
+                (unsigned long long)PerfRatio(stats.bdev.ullSectorsWritten, stats.bdev.ullWrites));
+          #endif
+        }
+
+        (void)red_close(iFildes);
+        PerfRemove(pParam, "append.dat");
+    }
+
+    return iRet;
+}
+
+
+/** @brief Measure small sequential reads.
+
+    A file much larger than the buffer cache is read from start to finish in
+    small pieces, so most of its blocks must be read from disk.  Besides the
+    elapsed time, the number of block device reads is reported: with read-ahead
+    enabled, the blocks ahead of the reader are read together, so there should
+    be far fewer reads, each reading more sectors.
+
+    The file is limited to half of the free space on the volume.
+
+    @param pParam   fsperf parameters.
+
+    @return Zero on success, otherwise nonzero.
+*/
+static int SeqReadTest(
+    const FSPERFPARAM *pParam)
+{
+    uint32_t    ulBlocks = SEQREAD_BLOCKS;
+    REDSTATFS   sfs;
+    int32_t     iFildes;
+    int         iRet;
+
+    iRet = PerfStatFs(pParam, "seqread", &sfs);
+    if(iRet == 0)
+    {
+        ulBlocks = (uint32_t)REDMIN(ulBlocks, sfs.f_bfree / 2U);
+
+        iRet = PerfFileCreate(pParam, "seqread.dat", ulBlocks, &iFildes);
+    }
+
+    if(iRet == 0)
+    {
+        /*  Reopen the file so that none of it is buffered.
+        */
+        (void)red_close(iFildes);
+
+        iRet = PerfRemount(pParam, "seqread");
+        if(iRet == 0)
+        {
+            iRet = PerfOpen(pParam, "seqread", "seqread.dat", RED_O_RDONLY, &iFildes);
+        }
+
+        if(iRet == 0)
+        {
+            uint32_t    ulReads = (ulBlocks * REDCONF_BLOCK_SIZE) / SEQREAD_SIZE;
+            uint32_t    ulIter;
+            PERFSTATS   stats;
+          #if REDCONF_READ_AHEAD_BLOCKS > 0U
+            uint8_t     bVolNum = RedFindVolumeNumber(pParam->pszVolume);
+            COREVOLUME  corevol = gaRedCoreVol[bVolNum];
+          #endif
+
+            PerfStart(pParam, &stats);
+
+            for(ulIter = 0U; (iRet == 0) && (ulIter < ulReads); ulIter++)
+            {
+                /*  PerfFileCreate() fills each block with its block offset.
+                */
+                if(red_read(iFildes, gabBlock, SEQREAD_SIZE) != (int32_t)SEQREAD_SIZE)
+                {
+                    iRet = PerfError("seqread", "red_read()");
+                }
+                else if(gabBlock[0U] != (uint8_t)((ulIter * SEQREAD_SIZE) / REDCONF_BLOCK_SIZE))
+                {
+                    RedPrintf("seqread: data mismatch at offset %lu\n", (unsigned long)(ulIter * SEQREAD_SIZE));
+                    iRet = 1;
+                }
+                else
+                {
+                    /*  Read verified.
+                    */
+                }
+            }
+
+            PerfEnd(pParam, &stats);
+
+            if(iRet == 0)
+            {
+                RedPrintf("seqread: %u byte reads, read-ahead buffer %u blocks\n", (unsigned)SEQREAD_SIZE,
+                    (unsigned)REDCONF_READ_AHEAD_BLOCKS);
+                PerfReport("seqread", "small read", stats.ullMicrosecs, ulReads);
+              #if REDCONF_BDEV_STATS == 1
+                RedPrintf("seqread: %llu device reads, %llu sectors read, %llu sectors/read\n",
+                    (unsigned long long)stats.bdev.ullReads, (unsigned long long)stats.bdev.ullSectorsRead,
+                    (unsigned long long)PerfRatio(stats.bdev.ullSectorsRead, stats.bdev.ullReads));
+              #endif
+              #if REDCONF_READ_AHEAD_BLOCKS > 0U
+                RedPrintf("seqread: %llu blocks read ahead, %llu hits, %llu wasted\n",
+                    (unsigned long long)(gaRedCoreVol[bVolNum].ullReadAheadBlocks - corevol.ullReadAheadBlocks),
+                    (unsigned long long)(gaRedCoreVol[bVolNum].ullReadAheadHits - corevol.ullReadAheadHits),
+                    (unsigned long long)(gaRedCoreVol[bVolNum].ullReadAheadWasted - corevol.ullReadAheadWasted));
+              #endif
+            }
+
+            (void)red_close(iFildes);
+        }
+    }
+
+    if(iRet == 0)
+    {
+        PerfRemove(pParam, "seqread.dat");
+    }
+
+    return iRet;
+}
+
+
+/** @brief Measure how well metadata stays buffered while file data streams.
+
+    A few small files are opened and their inodes are repeatedly examined with
+    red_fstat(), in between small sequential reads of a file which is much
+    larger than the buffer cache.  With a plain LRU policy, the streamed data
+    evicts the inodes of the small files; with the segmented LRU policy
+    (#REDCONF_BUFFER_META_SEGMENT), they stay buffered.  The metadata hit rate
+    for the small files is reported (if #REDCONF_BUFFER_STATS is enabled), along
+    with the elapsed time and the number of device reads.
+
+    @param pParam   fsperf parameters.
+
+    @return Zero on success, otherwise nonzero.
+*/
+static int MixedTest(
+    const FSPERFPARAM *pParam)
+{
+    uint32_t    ulFiles = REDMIN(REDMAX(REDCONF_BUFFER_COUNT / 4U, 1U), REDCONF_HANDLE_COUNT - 1U);
+    uint32_t    ulBlocks = SEQREAD_BLOCKS;
+    int32_t     aiFildes[REDMAX(REDCONF_BUFFER_COUNT / 4U, 1U)];
+    uint32_t    ulOpen = 0U;
+    char        szName[16U];
+    REDSTATFS   sfs;
+    int32_t     iStream = -1;
+    int         iRet;
+
+    iRet = PerfStatFs(pParam, "mixed", &sfs);
+    if(iRet == 0)
+    {
+        ulBlocks = (uint32_t)REDMIN(ulBlocks, sfs.f_bfree / 2U);
+
+        iRet = PerfFileCreate(pParam, "mixed.dat", ulBlocks, &iStream);
+    }
+
+    while((iRet == 0) && (ulOpen < ulFiles))
+    {
+        (void)RedSNPrintf(szName, sizeof(szName), "mixed%u.dat", (unsigned)ulOpen);
+
+        iRet = PerfFileCreate(pParam, szName, 1U, &aiFildes[ulOpen]);
+        if(iRet == 0)
+        {
+            ulOpen++;
+        }
+    }
+
+    if(iRet == 0)
+    {
+        uint32_t    ulSeed = pParam->ulSeed;
+        uint64_t    ullStreamPos = 0U;
+        uint64_t    ullStreamSize = (uint64_t)ulBlocks * REDCONF_BLOCK_SIZE;
+        uint64_t    ullHits = 0U;
+        uint64_t    ullMisses = 0U;
+        uint32_t    ulIter;
+        PERFSTATS   stats;
+
+        PerfStart(pParam, &stats);
+
+        for(ulIter = 0U; (iRet == 0) && (ulIter < pParam->ulIterations); ulIter++)
+        {
+            REDSTAT     st;
+            uint32_t    ulRead;
+
+            /*  Only the metadata accesses for the small files are counted, not
+                those for the streamed file.
+            */
+          #if REDCONF_BUFFER_STATS == 1
+            uint64_t    ullPrevHits;
+            uint64_t    ullPrevMisses;
+
+            MetaHitsMisses(pParam->pszVolume, &ullPrevHits, &ullPrevMisses);
+          #endif
+
+            if(red_fstat(aiFildes[RedRand32(&ulSeed) % ulFiles], &st) != 0)
+            {
+                iRet = PerfError("mixed", "red_fstat()");
+            }
+
+          #if REDCONF_BUFFER_STATS == 1
+            {
+                uint64_t ullCurHits;
+                uint64_t ullCurMisses;
+
+                MetaHitsMisses(pParam->pszVolume, &ullCurHits, &ullCurMisses);
+                ullHits += ullCurHits - ullPrevHits;
+                ullMisses += ullCurMisses - ullPrevMisses;
+            }
+          #endif
+
+            for(ulRead = 0U; (iRet == 0) && (ulRead < MIXED_STREAM_READS); ulRead++)
+            {
+                if(red_pread(iStream, gabBlock, SEQREAD_SIZE, ullStreamPos) != (int32_t)SEQREAD_SIZE)
+                {
+                    iRet = PerfError("mixed", "red_pread()");
+                }
+
+                ullStreamPos = (ullStreamPos + SEQREAD_SIZE) % ullStreamSize;
+            }
+        }
+
+        PerfEnd(pParam, &stats);
+
+        if(iRet == 0)
+        {
+            RedPrintf("mixed: %u buffers, %u protected for metadata, %u small files\n",
+                (unsigned)REDCONF_BUFFER_COUNT, (unsigned)REDCONF_BUFFER_META_SEGMENT, (unsigned)ulFiles);
+            PerfReport("mixed", "fstat + streamed reads", stats.ullMicrosecs, pParam->ulIterations);
+          #if REDCONF_BUFFER_STATS == 1
+            RedPrintf("mixed: metadata %llu hits, %llu misses, %llu%% hit rate\n",
+                (unsigned long long)ullHits, (unsigned long long)ullMisses,
+                (unsigned long long)PerfRatio(ullHits * 100U, ullHits + ullMisses));
+          #else
+            (void)ullHits;
+            (void)ullMisses;
+            RedPrintf("mixed: enable REDCONF_BUFFER_STATS for the metadata hit rate\n");
+          #endif
+          #if REDCONF_BDEV_STATS == 1
+            RedPrintf("mixed: %llu device reads\n", (unsigned long long)stats.bdev.ullReads);
+          #endif
+        }
+    }
+
+    if(iStream >= 0)
+    {
+        (void)red_close(iStream);
+        PerfRemove(pParam, "mixed.dat");
+    }
+
+    while(ulOpen > 0U)
+    {
+        ulOpen--;
+        (void)red_close(aiFildes[ulOpen]);
+        (void)RedSNPrintf(szName, sizeof(szName), "mixed%u.dat", (unsigned)ulOpen);
+        PerfRemove(pParam, szName);
+    }
+
+    return iRet;
+}
+
+
+/** @brief Measure the cost of computing the CRC of a metadata node.
+
+    RedCrcNode() is called on every metadata block read from disk and every
+    metadata block written, so its cost is a direct overhead on metadata I/O.
+    The result is checked against the standard check value and against a CRC
+    computed piecemeal (which exercises the short-buffer code), then the time
+    per node is reported.  Run with different #REDCONF_CRC_ALGORITHM values to
+    compare the algorithms.
+
+    @param pParam   fsperf parameters.
+
+    @return Zero on success, otherwise nonzero.
+*/
+static int CrcTest(
+    const FSPERFPARAM *pParam)
+{
+    static const char   szCheck[] = "123456789";
+    uint32_t            ulSeed = pParam->ulSeed;
+    uint32_t            ulNodeCrc;
+    uint32_t            ulPieceCrc = 0U;
+    uint32_t            ulOffset = 8U;
+    uint32_t            ulIdx;
+    int                 iRet = 0;
+
+    for(ulIdx = 0U; ulIdx < REDCONF_BLOCK_SIZE; ulIdx++)
+    {
+        gabBlock[ulIdx] = (uint8_t)RedRand32(&ulSeed);
+    }
+
+    /*  The metadata node CRC skips the signature and CRC fields.
+    */
+    ulNodeCrc = RedCrcNode(gabBlock);
+    while(ulOffset < REDCONF_BLOCK_SIZE)
+    {
+        uint32_t ulLen = REDMIN((RedRand32(&ulSeed) % 200U) + 1U, REDCONF_BLOCK_SIZE - ulOffset);
+
+        ulPieceCrc = RedCrc32Update(ulPieceCrc, &gabBlock[ulOffset], ulLen);
+        ulOffset += ulLen;
+    }
+
+    if(RedCrc32Update(0U, szCheck, sizeof(szCheck) - 1U) != 0xCBF43926U)
+    {
+        RedPrintf("crc: wrong CRC for the check string\n");
+        iRet = 1;
+    }
+    else if(ulNodeCrc != ulPieceCrc)
+    {
+        RedPrintf("crc: node CRC %08lx does not match piecewise CRC %08lx\n", (unsigned long)ulNodeCrc, (unsigned long)ulPieceCrc);
+        iRet = 1;
+    }
+    else
+    {
+        uint32_t    ulCrcSum = 0U;
+        PERFSTATS   stats;
+
+        PerfStart(pParam, &stats);
+
+        for(ulIdx = 0U; ulIdx < pParam->ulIterations; ulIdx++)
+        {
+            /*  Vary one byte so that the calls cannot be combined.
+            */
+            gabBlock[8U] = (uint8_t)ulIdx;
+            ulCrcSum += RedCrcNode(gabBlock);
+        }
+
+        PerfEnd(pParam, &stats);
+
+        PerfReport("crc", "RedCrcNode()", stats.ullMicrosecs, pParam->ulIterations);
+        RedPrintf("crc: %u byte nodes, %llu MB/s (checksum %08lx)\n", (unsigned)REDCONF_BLOCK_SIZE,
+            (unsigned long long)PerfRatio((uint64_t)pParam->ulIterations * REDCONF_BLOCK_SIZE, stats.ullMicrosecs),
+            (unsigned long)ulCrcSum);
+    }
+
+    return iRet;
+}
+
+
+/** @brief Measure the cost of small metadata updates.
+
+    Each iteration creates a file, deletes it, and commits a transaction.  This
+    modifies a few bytes in each of several metadata nodes (the parent directory
+    and its inode, the new inode, and the imap), all of which are finalized when
+    they are written, so the cost of computing node CRCs is a significant part
+    of the time per transaction.  Run with #REDCONF_BUFFER_CRC_INCREMENTAL
+    enabled and disabled to see the benefit of updating the CRCs from only the
+    modified bytes.
+
+    @param pParam   fsperf parameters.
+
+    @return Zero on success, otherwise nonzero.
+*/
+static int MetaWriteTest(
+    const FSPERFPARAM *pParam)
+{
+    char        szPath[PERF_PATH_MAX];
+    uint32_t    ulIter;
+    PERFSTATS   stats;
+    int         iRet;
+
+    PerfPath(szPath, pParam, "meta.dat");
+
+    iRet = PerfTransact(pParam, "metawrite");
+
+    PerfStart(pParam, &stats);
+
+    for(ulIter = 0U; (iRet == 0) && (ulIter < pParam->ulIterations); ulIter++)
+    {
+        int32_t iFildes;
+
+        iRet = PerfOpen(pParam, "metawrite", "meta.dat", RED_O_RDWR | RED_O_CREAT | RED_O_EXCL, &iFildes);
+        if(iRet == 0)
+        {
+            if(red_close(iFildes) != 0)
+            {
+                iRet = PerfError("metawrite", "red_close()");
+            }
+            else if(red_unlink(szPath) != 0)
+            {
+                iRet = PerfError("metawrite", "red_unlink()");
+            }
+            else
+            {
+                iRet = PerfTransact(pParam, "metawrite");
+            }
+        }
+    }
+
+    PerfEnd(pParam, &stats);
+
+    if(iRet == 0)
+    {
+        PerfReport("metawrite", "create + unlink + transact", stats.ullMicrosecs, pParam->ulIterations);
+
+      #if REDCONF_BUFFER_STATS == 1
+        {
+            uint64_t    ullFull = 0U;
+            uint64_t    ullIncremental = 0U;
+            uint32_t    ulType;
+
+            for(ulType = 0U; ulType < RED_BUFSTAT_TYPES; ulType++)
+            {
+                ullFull += stats.buf.aType[ulType].ullCrcFull;
+                ullIncremental += stats.buf.aType[ulType].ullCrcIncremental;
+            }
+
+            RedPrintf("metawrite: %llu node CRCs computed in full, %llu updated incrementally\n",
+                (unsigned long long)ullFull, (unsigned long long)ullIncremental);
+        }
+      #endif
+    }
+
+    return iRet;
+}
+
+
+/** @brief Measure the cost of allocating blocks on a nearly full volume.
+
+    The volume is filled, except for a few blocks, then blocks spread evenly
+    through the fill file are overwritten and committed, which leaves the few
+    free blocks scattered across the volume.  A small file is then repeatedly
+    overwritten and committed.  Each overwrite allocates new blocks, and each
+    allocation searches the imap from where the last one left off, so about
+    1/#FULLALLOC_HOLES of the imap is searched for every allocation.
+
+    @param pParam   fsperf parameters.
+
+    @return Zero on success, otherwise nonzero.
+*/
+static int FullAllocTest(
+    const FSPERFPARAM *pParam)
+{
+    uint32_t    ulFillBlocks = 0U;
+    int32_t     iFill = -1;
+    int32_t     iSmall = -1;
+    REDSTATFS   sfs;
+    int         iRet;
+
+    iRet = PerfStatFs(pParam, "fullalloc", &sfs);
+    if(iRet == 0)
+    {
+        /*  Leave room for the indirect nodes of the fill file, and for
+            overwriting the blocks which become the holes.
+        */
+        uint32_t ulOverhead = (uint32_t)(sfs.f_bfree / INDIR_ENTRIES) + (FULLALLOC_HOLES * 3U) + 8U;
+
+        if(sfs.f_bfree <= (ulOverhead + 1U))
+        {
+            RedPrintf("fullalloc: insufficient free space\n");
+            iRet = 1;
+        }
+        else
+        {
+            ulFillBlocks = (uint32_t)(sfs.f_bfree - ulOverhead);
+            iRet = PerfFileCreate(pParam, "full.dat", ulFillBlocks, &iFill);
+        }
+    }
+
+    if(iRet == 0)
+    {
+        uint32_t ulStride = ulFillBlocks / FULLALLOC_HOLES;
+        uint32_t ulHole;
+
+        /*  Overwriting a block moves it, and once committed, its old location
+            is free.
+        */
+        for(ulHole = 0U; (iRet == 0) && (ulHole < FULLALLOC_HOLES); ulHole++)
+        {
+            if(red_pwrite(iFill, gabBlock, sizeof(gabBlock), (uint64_t)ulHole * ulStride * REDCONF_BLOCK_SIZE) != (int32_t)sizeof(gabBlock))
+            {
+                iRet = PerfError("fullalloc", "red_pwrite()");
+            }
+        }
+
+        if(iRet == 0)
+        {
+            iRet = PerfFileCreate(pParam, "fullsm.dat", 1U, &iSmall);
+        }
+    }
+
+    if(iRet == 0)
+    {
+        uint32_t    ulIter;
+        PERFSTATS   stats;
+
+        PerfStart(pParam, &stats);
+
+        for(ulIter = 0U; (iRet == 0) && (ulIter < pParam->ulIterations); ulIter++)
+        {
+            RedMemSet(gabBlock, (uint8_t)ulIter, sizeof(gabBlock));
+
+            if(red_pwrite(iSmall, gabBlock, sizeof(gabBlock), 0U) != (int32_t)sizeof(gabBlock))
+            {
+                iRet = PerfError("fullalloc", "red_pwrite()");
+            }
+            else
+            {
+                iRet = PerfTransact(pParam, "fullalloc");
+            }
+        }
+
+        PerfEnd(pParam, &stats);
+
+        if((iRet == 0) && (PerfStatFs(pParam, "fullalloc", &sfs) == 0))
+        {
+            RedPrintf("fullalloc: %llu of %llu blocks free\n", (unsigned long long)sfs.f_bfree, (unsigned long long)sfs.f_blocks);
+            PerfReport("fullalloc", "overwrite + transact", stats.ullMicrosecs, pParam->ulIterations);
+          #if REDCONF_BUFFER_STATS == 1
+            RedPrintf("fullalloc: %llu imap node lookups (%llu read) per 100 ops\n",
+                (unsigned long long)((stats.buf.aType[RED_BUFSTAT_IMAP].ullLookups * 100U) / pParam->ulIterations),
+                (unsigned long long)((stats.buf.aType[RED_BUFSTAT_IMAP].ullMisses * 100U) / pParam->ulIterations));
+          #endif
+        }
+    }
+
+    if(iSmall >= 0)
+    {
+        (void)red_close(iSmall);
+        PerfRemove(pParam, "fullsm.dat");
+    }
+
+    if(iFill >= 0)
+    {
+        (void)red_close(iFill);
+        PerfRemove(pParam, "full.dat");
+    }
+
+    (void)red_transact(pParam->pszVolume);
+
+    return iRet;
+}
+
+
+/** @brief Measure large writes, and how contiguous the written data is.
+
+    A file is written in large pieces, then read back in pieces of the same
+    size after remounting, so that none of it is buffered.  Each contiguous
+    extent of the file data within a read is read from the block device with
+    one request, so the number of device reads shows how fragmented the file
+    data is: ideally, there is one device read per read.
+
+    The file is limited to half of the free space on the volume.
+
+    @param pParam   fsperf parameters.
+
+    @return Zero on success, otherwise nonzero.
+*/
+static int ExtentTest(
+    const FSPERFPARAM *pParam)
+{
+    uint32_t    ulIos = EXTENT_FILE_BLOCKS / EXTENT_IO_BLOCKS;
+    REDSTATFS   sfs;
+    int32_t     iFildes = -1;
+    uint32_t    ulIter;
+    PERFSTATS   stats;
+    int         iRet;
+
+    iRet = PerfStatFs(pParam, "extent", &sfs);
+    if(iRet == 0)
+    {
+        ulIos = (uint32_t)REDMIN(ulIos, (sfs.f_bfree / 2U) / EXTENT_IO_BLOCKS);
+
+        iRet = PerfOpen(pParam, "extent", "extent.dat", RED_O_WRONLY | RED_O_CREAT | RED_O_TRUNC, &iFildes);
+    }
+
+    if(iRet == 0)
+    {
+        PerfStart(pParam, &stats);
+
+        for(ulIter = 0U; (iRet == 0) && (ulIter < ulIos); ulIter++)
+        {
+            RedMemSet(gabExtent, (uint8_t)ulIter, sizeof(gabExtent));
+
+            if(red_write(iFildes, gabExtent, sizeof(gabExtent)) != (int32_t)sizeof(gabExtent))
+            {
+                iRet = PerfError("extent", "red_write()");
+            }
+        }
+
+        if(iRet == 0)
+        {
+            iRet = PerfTransact(pParam, "extent");
+        }
+
+        PerfEnd(pParam, &stats);
+
+        if(iRet == 0)
+        {
+            PerfReport("extent", "large write", stats.ullMicrosecs, ulIos);
+        }
+
+        (void)red_close(iFildes);
+    }
+
+    /*  Remount so that none of the file is buffered.
+    */
+    if(iRet == 0)
+    {
+        iRet = PerfRemount(pParam, "extent");
+    }
+
+    if(iRet == 0)
+    {
+        iRet = PerfOpen(pParam, "extent", "extent.dat", RED_O_RDONLY, &iFildes);
+    }
+
+    if(iRet == 0)
+    {
+        PerfStart(pParam, &stats);
+
+        for(ulIter = 0U; (iRet == 0) && (ulIter < ulIos); ulIter++)
+        {
+            if(red_read(iFildes, gabExtent, sizeof(gabExtent)) != (int32_t)sizeof(gabExtent))
+            {
+                iRet = PerfError("extent", "red_read()");
+            }
+            else if((gabExtent[0U] != (uint8_t)ulIter) || (gabExtent[sizeof(gabExtent) - 1U] != (uint8_t)ulIter))
+            {
+                RedPrintf("extent: data mismatch in read %lu\n", (unsigned long)ulIter);
+                iRet = 1;
+            }
+            else
+            {
+                /*  Read verified.
+                */
+            }
+        }
+
+        PerfEnd(pParam, &stats);
+
+      #if REDCONF_BDEV_STATS == 1
+        if(iRet == 0)
+        {
+            /*  The reads of the inode and indirect nodes are included, since
+                they are not distinguished in the device statistics.
+            */
+            RedPrintf("extent: %lu reads of %u blocks needed %llu device reads\n", (unsigned long)ulIos,
+                (unsigned)EXTENT_IO_BLOCKS, (unsigned long long)stats.bdev.ullReads);
+        }
+      #endif
+
+        (void)red_close(iFildes);
+    }
+
+    PerfRemove(pParam, "extent.dat");
+
+    return iRet;
+}
+
+
+/** @brief Measure deleting large files.
+
+    Each iteration writes a file in large pieces, so that its data is mostly
+    contiguous, then times deleting it and committing the delete.  The number
+    of imap buffer lookups shows how much of the cost of freeing the blocks is
+    spent updating the imap.
+
+    The number of files is limited to #DELETE_FILES, and each file is limited
+    to a quarter of the free space on the volume.
+
+    @param pParam   fsperf parameters.
+
+    @return Zero on success, otherwise nonzero.
+*/
+static int DeleteTest(
+    const FSPERFPARAM *pParam)
+{
+    uint32_t    ulFiles = REDMIN(pParam->ulIterations, DELETE_FILES);
+    uint32_t    ulIos = EXTENT_FILE_BLOCKS / EXTENT_IO_BLOCKS;
+    uint64_t    ullMicrosecs = 0U;
+  #if REDCONF_BUFFER_STATS == 1
+    uint64_t    ullLookups = 0U;
+  #endif
+    char        szPath[PERF_PATH_MAX];
+    REDSTATFS   sfs;
+    uint32_t    ulFile;
+    int         iRet;
+
+    PerfPath(szPath, pParam, "delete.dat");
+
+    iRet = PerfStatFs(pParam, "delete", &sfs);
+    if(iRet == 0)
+    {
+        ulIos = (uint32_t)REDMIN(ulIos, (sfs.f_bfree / 4U) / EXTENT_IO_BLOCKS);
+    }
+
+    for(ulFile = 0U; (iRet == 0) && (ulFile < ulFiles); ulFile++)
+    {
+        int32_t iFildes;
+
+        iRet = PerfOpen(pParam, "delete", "delete.dat", RED_O_WRONLY | RED_O_CREAT | RED_O_TRUNC, &iFildes);
+        if(iRet == 0)
+        {
+            uint32_t ulIter;
+
+            for(ulIter = 0U; (iRet == 0) && (ulIter < ulIos); ulIter++)
+            {
+                if(red_write(iFildes, gabExtent, sizeof(gabExtent)) != (int32_t)sizeof(gabExtent))
+                {
+                    iRet = PerfError("delete", "red_write()");
+                }
+            }
+
+            (void)red_close(iFildes);
+        }
+
+        if(iRet == 0)
+        {
+            iRet = PerfTransact(pParam, "delete");
+        }
+
+        if(iRet == 0)
+        {
+            PERFSTATS stats;
+
+            PerfStart(pParam, &stats);
+
+            if(red_unlink(szPath) != 0)
+            {
+                iRet = PerfError("delete", "red_unlink()");
+            }
+            else
+            {
+                iRet = PerfTransact(pParam, "delete");
+            }
+
+            PerfEnd(pParam, &stats);
+
+            ullMicrosecs += stats.ullMicrosecs;
+          #if REDCONF_BUFFER_STATS == 1
+            ullLookups += stats.buf.aType[RED_BUFSTAT_IMAP].ullLookups;
+          #endif
+        }
+    }
+
+    if((iRet == 0) && (ulFiles > 0U))
+    {
+        PerfReport("delete", "large file delete", ullMicrosecs, ulFiles);
+
+      #if REDCONF_BUFFER_STATS == 1
+        RedPrintf("delete: %lu files of %lu blocks: %llu imap lookups per delete\n", (unsigned long)ulFiles,
+            (unsigned long)(ulIos * EXTENT_IO_BLOCKS), (unsigned long long)(ullLookups / ulFiles));
+      #endif
+    }
+
+    return iRet;
+}
+
+
+/** @brief Measure creating files as the inodes of the volume are used up.
+
+    Files are created until almost all of the inodes are in use, and the time
+    taken by the first and last directories of creates is reported: ideally,
+    the last creates are no slower than the first.  Each directory holds
+    #CREATE_DIR_FILES files, so that looking up the names in the directories
+    does not dominate the time.  The files and directories are deleted after.
+
+    @param pParam   fsperf parameters.
+
+    @return Zero on success, otherwise nonzero.
+*/
+static int CreateTest(
+    const FSPERFPARAM *pParam)
+{
+  #if REDCONF_API_POSIX_MKDIR == 1
+    char        szPath[PERF_PATH_MAX];
+    char        szName[PERF_PATH_MAX];
+    REDSTATFS   sfs;
+    PERFSTATS   stats;
+    uint64_t    ullFirst = 0U;
+    uint64_t    ullLast = 0U;
+    uint32_t    ulFiles = 0U;
+    uint32_t    ulFile;
+    int         iRet;
+
+    iRet = PerfStatFs(pParam, "create", &sfs);
+    if(iRet == 0)
+    {
+        /*  Leave room for the directories and a couple of spare inodes, and
+            only create whole directories of files.
+        */
+        if(sfs.f_ffree > 2U)
+        {
+            ulFiles = (uint32_t)(sfs.f_ffree - 2U);
+            ulFiles -= (ulFiles + CREATE_DIR_FILES) / (CREATE_DIR_FILES + 1U);
+        }
+
+        ulFiles = REDMIN(ulFiles, pParam->ulIterations);
+        ulFiles -= ulFiles % CREATE_DIR_FILES;
+
+        if(ulFiles < (CREATE_DIR_FILES * 2U))
+        {
+            RedPrintf("create: skipped, too few free inodes: %lu\n", (unsigned long)sfs.f_ffree);
+            ulFiles = 0U;
+        }
+    }
+
+    for(ulFile = 0U; (iRet == 0) && (ulFile < ulFiles); ulFile++)
+    {
+        int32_t iFildes;
+
+        (void)RedSNPrintf(szName, sizeof(szName), "create.%lu", (unsigned long)(ulFile / CREATE_DIR_FILES));
+        PerfPath(szPath, pParam, szName);
+
+        if((ulFile % CREATE_DIR_FILES) == 0U)
+        {
+            PerfStart(pParam, &stats);
+
+            if(red_mkdir(szPath) != 0)
+            {
+                iRet = PerfError("create", "red_mkdir()");
+                break;
+            }
+        }
+
+        (void)RedSNPrintf(szName, sizeof(szName), "%s%cf%lu", szPath, REDCONF_PATH_SEPARATOR, (unsigned long)(ulFile % CREATE_DIR_FILES));
+
+        iFildes = red_open(szName, RED_O_WRONLY | RED_O_CREAT | RED_O_EXCL);
+        if(iFildes < 0)
+        {
+            iRet = PerfError("create", "red_open()");
+        }
+        else
+        {
+            (void)red_close(iFildes);
+
+            if(((ulFile + 1U) % CREATE_DIR_FILES) == 0U)
+            {
+                PerfEnd(pParam, &stats);
+                ullLast = stats.ullMicrosecs;
+                if(ulFile < CREATE_DIR_FILES)
+                {
+                    ullFirst = ullLast;
+                }
+
+                iRet = PerfTransact(pParam, "create");
+            }
+        }
+    }
+
+    if((iRet == 0) && (ulFiles > 0U))
+    {
+        RedPrintf("create: %lu files in %lu directories\n", (unsigned long)ulFiles, (unsigned long)(ulFiles / CREATE_DIR_FILES));
+        PerfReport("create", "first directory of creates", ullFirst, CREATE_DIR_FILES);
+        PerfReport("create", "last directory of creates", ullLast, CREATE_DIR_FILES);
+    }
+
+    /*  Delete whatever was created, whether or not the test succeeded.
+    */
+    while(ulFile > 0U)
+    {
+        ulFile--;
+
+        (void)RedSNPrintf(szName, sizeof(szName), "create.%lu", (unsigned long)(ulFile / CREATE_DIR_FILES));
+        PerfPath(szPath, pParam, szName);
+        (void)RedSNPrintf(szName, sizeof(szName), "%s%cf%lu", szPath, REDCONF_PATH_SEPARATOR, (unsigned long)(ulFile % CREATE_DIR_FILES));
+        (void)red_unlink(szName);
+
+        if((ulFile % CREATE_DIR_FILES) == 0U)
+        {
+            (void)red_unlink(szPath);
+        }
+    }
+
+    if(PerfTransact(pParam, "create") != 0)
+    {
+        iRet = 1;
+    }
+
+    return iRet;
+  #else
+    (void)pParam;
+
+    RedPrintf("create: skipped, requires REDCONF_API_POSIX_MKDIR\n");
+
+    return 0;
+  #endif
+}
+
+
+/** @brief Measure how contiguous files are when they are written together.
+
+    Several files are appended to one block at a time, in turn, as if by
+    several writers, then each file is read back in large pieces after
+    remounting.  As in the extent test, the number of device reads shows how
+    fragmented the file data is: if the blocks of the files were interleaved,
+    there is one device read per block.
+
+    The files are limited to half of the free space on the volume.
+
+    @param pParam   fsperf parameters.
+
+    @return Zero on success, otherwise nonzero.
+*/
+static int InterleaveTest(
+    const FSPERFPARAM *pParam)
+{
+    uint32_t    ulBlocks = INTERLEAVE_FILE_BLOCKS;
+    int32_t     aiFildes[INTERLEAVE_FILES];
+    char        aszName[INTERLEAVE_FILES][16U];
+    REDSTATFS   sfs;
+    PERFSTATS   stats;
+    uint32_t    ulFile;
+    uint32_t    ulIter;
+    int         iRet;
+
+    for(ulFile = 0U; ulFile < INTERLEAVE_FILES; ulFile++)
+    {
+        aiFildes[ulFile] = -1;
+        (void)RedSNPrintf(aszName[ulFile], sizeof(aszName[ulFile]), "ilv%lu.dat", (unsigned long)ulFile);
+    }
+
+    iRet = PerfStatFs(pParam, "interleave", &sfs);
+    if(iRet == 0)
+    {
+        ulBlocks = (uint32_t)REDMIN(ulBlocks, (sfs.f_bfree / 2U) / INTERLEAVE_FILES);
+    }
+
+    for(ulFile = 0U; (iRet == 0) && (ulFile < INTERLEAVE_FILES); ulFile++)
+    {
+        iRet = PerfOpen(pParam, "interleave", aszName[ulFile], RED_O_WRONLY | RED_O_CREAT | RED_O_TRUNC, &aiFildes[ulFile]);
+    }
+
+    if(iRet == 0)
+    {
+        PerfStart(pParam, &stats);
+
+        for(ulIter = 0U; (iRet == 0) && (ulIter < ulBlocks); ulIter++)
+        {
+            for(ulFile = 0U; (iRet == 0) && (ulFile < INTERLEAVE_FILES); ulFile++)
+            {
+                RedMemSet(gabBlock, (uint8_t)(ulIter + ulFile), sizeof(gabBlock));
+
+                if(red_write(aiFildes[ulFile], gabBlock, sizeof(gabBlock)) != (int32_t)sizeof(gabBlock))
+                {
+                    iRet = PerfError("interleave", "red_write()");
+                }
+            }
+        }
+
+        if(iRet == 0)
+        {
+            iRet = PerfTransact(pParam, "interleave");
+        }
+
+        PerfEnd(pParam, &stats);
+
+        if(iRet == 0)
+        {
+            PerfReport("interleave", "interleaved block write", stats.ullMicrosecs, ulBlocks * INTERLEAVE_FILES);
+        }
+    }
+
+    for(ulFile = 0U; ulFile < INTERLEAVE_FILES; ulFile++)
+    {
+        if(aiFildes[ulFile] >= 0)
+        {
+            (void)red_close(aiFildes[ulFile]);
+        }
+    }
+
+    /*  Remount so that none of the files are buffered.
+    */
+    if(iRet == 0)
+    {
+        iRet = PerfRemount(pParam, "interleave");
+    }
+
+    if(iRet == 0)
+    {
+        PerfStart(pParam, &stats);
+
+        for(ulFile = 0U; (iRet == 0) && (ulFile < INTERLEAVE_FILES); ulFile++)
+        {
+            int32_t iFildes = -1;
+
+            iRet = PerfOpen(pParam, "interleave", aszName[ulFile], RED_O_RDONLY, &iFildes);
+
+            for(ulIter = 0U; (iRet == 0) && (ulIter < ulBlocks); ulIter += EXTENT_IO_BLOCKS)
+            {
+                uint32_t ulLen = REDMIN(EXTENT_IO_BLOCKS, ulBlocks - ulIter) * REDCONF_BLOCK_SIZE;
+
+                if(red_read(iFildes, gabExtent, ulLen) != (int32_t)ulLen)
+                {
+                    iRet = PerfError("interleave", "red_read()");
+                }
+                else if((gabExtent[0U] != (uint8_t)(ulIter + ulFile)) || (gabExtent[ulLen - 1U] != (uint8_t)(ulIter + ulFile + (ulLen / REDCONF_BLOCK_SIZE) - 1U)))
+                {
+                    RedPrintf("interleave: data mismatch in file %lu at block %lu\n", (unsigned long)ulFile, (unsigned long)ulIter);
+                    iRet = 1;
+                }
+                else
+                {
+                    /*  Read verified.
+                    */
+                }
+            }
+
+            if(iFildes >= 0)
+            {
+                (void)red_close(iFildes);
+            }
+        }
+
+        PerfEnd(pParam, &stats);
+
+        if(iRet == 0)
+        {
+            PerfReport("interleave", "large read", stats.ullMicrosecs, INTERLEAVE_FILES * ((ulBlocks + EXTENT_IO_BLOCKS - 1U) / EXTENT_IO_BLOCKS));
+
+          #if REDCONF_BDEV_STATS == 1
+            /*  As in the extent test, this includes the inode and indirect
+                node reads.
+            */
+            RedPrintf("interleave: %lu files of %lu blocks needed %llu device reads, %llu blocks per read\n",
+                (unsigned long)INTERLEAVE_FILES, (unsigned long)ulBlocks, (unsigned long long)stats.bdev.ullReads,
+                (unsigned long long)PerfRatio((uint64_t)ulBlocks * INTERLEAVE_FILES, stats.bdev.ullReads));
+          #endif
+        }
+    }
+
+    for(ulFile = 0U; ulFile < INTERLEAVE_FILES; ulFile++)
+    {
+        PerfRemove(pParam, aszName[ulFile]);
+    }
+
+    (void)red_transact(pParam->pszVolume);
+
+    return iRet;
+}
+
+
+/** @brief Measure how well defragmenting a file restores its read speed.
+
+    A file is written in large pieces, so that it is contiguous, then every
+    other block of it is rewritten, which moves those blocks elsewhere.  The
+    file is read back with large reads after remounting, then defragmented
+    with red_defrag(), and read back again.  The extent counts from
+    red_fragstat() and the device reads of each read back are reported.
+
+    The file is limited to a quarter of the free space on the volume, since
+    defragmenting needs room for a second copy.
+
+    @param pParam   fsperf parameters.
+
+    @return Zero on success, otherwise nonzero.
+*/
+static int DefragTest(
+    const FSPERFPARAM *pParam)
+{
+  #if (REDCONF_API_POSIX_DEFRAG == 1) && (REDCONF_READ_ONLY == 0)
+    uint32_t    ulBlocks = EXTENT_FILE_BLOCKS;
+    char        szPath[PERF_PATH_MAX];
+    REDSTATFS   sfs;
+    int32_t     iFildes = -1;
+    uint32_t    ulIter;
+    int         iRet;
+
+    PerfPath(szPath, pParam, "defrag.dat");
+
+    iRet = PerfStatFs(pParam, "defrag", &sfs);
+    if(iRet == 0)
+    {
+        ulBlocks = (uint32_t)REDMIN(ulBlocks, sfs.f_bfree / 4U);
+        ulBlocks -= ulBlocks % EXTENT_IO_BLOCKS;
+
+        iRet = PerfOpen(pParam, "defrag", "defrag.dat", RED_O_RDWR | RED_O_CREAT | RED_O_TRUNC, &iFildes);
+    }
+
+    for(ulIter = 0U; (iRet == 0) && (ulIter < ulBlocks); ulIter += EXTENT_IO_BLOCKS)
+    {
+        uint32_t ulBlock;
+
+        for(ulBlock = 0U; ulBlock < EXTENT_IO_BLOCKS; ulBlock++)
+        {
+            RedMemSet(&gabExtent[ulBlock * REDCONF_BLOCK_SIZE], (uint8_t)(ulIter + ulBlock), REDCONF_BLOCK_SIZE);
+        }
+
+        if(red_write(iFildes, gabExtent, sizeof(gabExtent)) != (int32_t)sizeof(gabExtent))
+        {
+            iRet = PerfError("defrag", "red_write()");
+        }
+    }
+
+    if(iRet == 0)
+    {
+        iRet = PerfTransact(pParam, "defrag");
+    }
+
+    /*  Rewrite every other block with the same data: branching them moves
+        them out of the file's extent.
+    */
+    for(ulIter = 1U; (iRet == 0) && (ulIter < ulBlocks); ulIter += 2U)
+    {
+        RedMemSet(gabBlock, (uint8_t)ulIter, sizeof(gabBlock));
+
+        if(red_pwrite(iFildes, gabBlock, sizeof(gabBlock), (uint64_t)ulIter * REDCONF_BLOCK_SIZE) != (int32_t)sizeof(gabBlock))
+        {
+            iRet = PerfError("defrag", "red_pwrite()");
+        }
+    }
+
+    if(iFildes >= 0)
+    {
+        (void)red_close(iFildes);
+    }
+
+    if(iRet == 0)
+    {
+        iRet = PerfTransact(pParam, "defrag");
+    }
+
+    if(iRet == 0)
+    {
+        iRet = DefragReadBack(pParam, szPath, ulBlocks, "fragmented");
+    }
+
+    if(iRet == 0)
+    {
+        iRet = PerfOpen(pParam, "defrag", "defrag.dat", RED_O_RDONLY, &iFildes);
+    }
+
+    if(iRet == 0)
+    {
+        PERFSTATS stats;
+
+        PerfStart(pParam, &stats);
+
+        if(red_defrag(iFildes) != 0)
+        {
+            iRet = PerfError("defrag", "red_defrag()");
+        }
+        else
+        {
+            iRet = PerfTransact(pParam, "defrag");
+        }
+
+        PerfEnd(pParam, &stats);
+
+        if(iRet == 0)
+        {
+            PerfReport("defrag", "defragment + transact", stats.ullMicrosecs, 1U);
+        }
+
+        (void)red_close(iFildes);
+    }
+
+    if(iRet == 0)
+    {
+        iRet = DefragReadBack(pParam, szPath, ulBlocks, "defragmented");
+    }
+
+    (void)red_unlink(szPath);
+    (void)red_transact(pParam->pszVolume);
+
+    return iRet;
+  #else
+    (void)pParam;
+
+    RedPrintf("defrag: skipped, requires REDCONF_API_POSIX_DEFRAG\n");
+
+    return 0;
+  #endif
+}
+
+
+#if (REDCONF_API_POSIX_DEFRAG == 1) && (REDCONF_READ_ONLY == 0)
+/** @brief Read back and verify the file written by the defrag test.
+
+    The volume is remounted so that none of the file is buffered, then the file
+    is read with large reads.  Its extents, the time taken by the reads, and
+    the number of device reads which they needed are reported.
+
+    @param pParam   fsperf parameters.
+    @param pszPath  The path of the file.
+    @param ulBlocks The size of the file, in blocks: a multiple of
+                    #EXTENT_IO_BLOCKS.
+    @param pszState Describes the state of the file, for the report.
+
+    @return Zero on success, otherwise nonzero.
+*/
+static int DefragReadBack(
+    const FSPERFPARAM  *pParam,
+    const char         *pszPath,
+    uint32_t            ulBlocks,
+    const char         *pszState)
+{
+    int32_t             iFildes = -1;
+    int                 iRet;
+
+    iRet = PerfRemount(pParam, "defrag");
+    if(iRet == 0)
+    {
+        iFildes = red_open(pszPath, RED_O_RDONLY);
+        if(iFildes < 0)
+        {
+            iRet = PerfError("defrag", "red_open()");
+        }
+    }
+
+    if(iRet == 0)
+    {
+        PERFSTATS   stats;
+        REDFRAGSTAT fs;
+        uint32_t    ulIter;
+
+        PerfStart(pParam, &stats);
+
+        for(ulIter = 0U; (iRet == 0) && (ulIter < ulBlocks); ulIter += EXTENT_IO_BLOCKS)
+        {
+            uint32_t ulBlock;
+
+            if(red_read(iFildes, gabExtent, sizeof(gabExtent)) != (int32_t)sizeof(gabExtent))
+            {
+                iRet = PerfError("defrag", "red_read()");
+            }
+
+            for(ulBlock = 0U; (iRet == 0) && (ulBlock < EXTENT_IO_BLOCKS); ulBlock++)
+            {
+                if(gabExtent[(ulBlock * REDCONF_BLOCK_SIZE) + (REDCONF_BLOCK_SIZE - 1U)] != (uint8_t)(ulIter + ulBlock))
+                {
+                    RedPrintf("defrag: data mismatch at block %lu\n", (unsigned long)(ulIter + ulBlock));
+                    iRet = 1;
+                }
+            }
+        }
+
+        PerfEnd(pParam, &stats);
+
+        if(iRet == 0)
+        {
+            if(red_fragstat(iFildes, &fs) != 0)
+            {
+                iRet = PerfError("defrag", "red_fragstat()");
+            }
+            else
+            {
+              #if REDCONF_BDEV_STATS == 1
+                RedPrintf("defrag: %s: %lu blocks in %lu extents; %lu reads needed %llu device reads in %llu us\n",
+                    pszState, (unsigned long)fs.ulBlocks, (unsigned long)fs.ulExtents, (unsigned long)(ulBlocks / EXTENT_IO_BLOCKS),
+                    (unsigned long long)stats.bdev.ullReads, (unsigned long long)stats.ullMicrosecs);
+              #else
+                RedPrintf("defrag: %s: %lu blocks in %lu extents; %lu reads in %llu us\n",
+                    pszState, (unsigned long)fs.ulBlocks, (unsigned long)fs.ulExtents, (unsigned long)(ulBlocks / EXTENT_IO_BLOCKS),
+                    (unsigned long long)stats.ullMicrosecs);
+              #endif
+            }
+        }
+
+        (void)red_close(iFildes);
+    }
+
+    return iRet;
+}
+#endif
+
+
+/** @brief Measure how much of a transaction point can overlap with reads.
+
+    Each iteration writes a block, commits a transaction point, and reads
+    #ASYNC_READ_BLOCKS blocks of another file.  This is done first with
+    red_transact(), then with red_transact_async(), waiting for the
+    transaction point with red_transact_poll() after the reads.  The reads
+    are allowed while the asynchronous transaction point is being finished, so
+    they overlap with the device flushes and the metaroot write.  The time the
+    transaction point calls keep the caller waiting and the time per iteration
+    are reported for both.
+
+    @param pParam   fsperf parameters.
+
+    @return Zero on success, otherwise nonzero.
+*/
+static int AsyncTransactTest(
+    const FSPERFPARAM *pParam)
+{
+  #if REDCONF_TRANSACT_ASYNC == 1
+    int32_t     iWriteFildes = -1;
+    int32_t     iReadFildes = -1;
+    int         iRet;
+
+    iRet = PerfFileCreate(pParam, "async.dat", 1U, &iWriteFildes);
+
+    if(iRet == 0)
+    {
+        iRet = PerfFileCreate(pParam, "asyncrd.dat", ASYNC_READ_BLOCKS, &iReadFildes);
+    }
+
+    if(iRet == 0)
+    {
+        iRet = AsyncTransactRun(pParam, iWriteFildes, iReadFildes, false);
+    }
+
+    if(iRet == 0)
+    {
+        iRet = AsyncTransactRun(pParam, iWriteFildes, iReadFildes, true);
+    }
+
+    if(iWriteFildes >= 0)
+    {
+        (void)red_close(iWriteFildes);
+    }
+
+    if(iReadFildes >= 0)
+    {
+        (void)red_close(iReadFildes);
+    }
+
+    PerfRemove(pParam, "async.dat");
+    PerfRemove(pParam, "asyncrd.dat");
+    (void)red_transact(pParam->pszVolume);
+
+    return iRet;
+  #else
+    (void)pParam;
+
+    RedPrintf("asynctransact: skipped, requires REDCONF_TRANSACT_ASYNC\n");
+
+    return 0;
+  #endif
+}
+
+
+#if REDCONF_TRANSACT_ASYNC == 1
+/** @brief Run one half of the async transact test.
+
+    @param pParam       fsperf parameters.
+    @param iWriteFildes File descriptor for the file to write.
+    @param iReadFildes  File descriptor for the file to read.
+    @param fAsync       Whether to use red_transact_async().
+
+    @return Zero on success, otherwise nonzero.
+*/
+static int AsyncTransactRun(
+    const FSPERFPARAM  *pParam,
+    int32_t             iWriteFildes,
+    int32_t             iReadFildes,
+    bool                fAsync)
+{
+    const char         *pszTransact = fAsync ? "red_transact_async()" : "red_transact()";
+    uint32_t            ulIters = REDMIN(pParam->ulIterations, ASYNC_TRANSACTS);
+    uint64_t            ullCommitUs = 0U;
+    PERFSTATS           stats;
+    uint32_t            ulIter;
+    int                 iRet = 0;
+
+    PerfStart(pParam, &stats);
+
+    for(ulIter = 0U; (iRet == 0) && (ulIter < ulIters); ulIter++)
+    {
+        REDTIMESTAMP    tsCommit;
+        uint32_t        ulBlock;
+        int32_t         iCommitRet;
+
+        gabBlock[0U] = (uint8_t)ulIter;
+
+        if(red_pwrite(iWriteFildes, gabBlock, REDCONF_BLOCK_SIZE, 0U) != (int32_t)REDCONF_BLOCK_SIZE)
+        {
+            iRet = PerfError("asynctransact", "red_pwrite()");
+            break;
+        }
+
+        tsCommit = RedOsTimestamp();
+        iCommitRet = fAsync ? red_transact_async(pParam->pszVolume) : red_transact(pParam->pszVolume);
+        ullCommitUs += RedOsTimePassed(tsCommit);
+
+        if(iCommitRet != 0)
+        {
+            iRet = PerfError("asynctransact", pszTransact);
+            break;
+        }
+
+        for(ulBlock = 0U; (iRet == 0) && (ulBlock < ASYNC_READ_BLOCKS); ulBlock++)
+        {
+            if(red_pread(iReadFildes, gabBlock, REDCONF_BLOCK_SIZE, (uint64_t)ulBlock * REDCONF_BLOCK_SIZE) != (int32_t)REDCONF_BLOCK_SIZE)
+            {
+                iRet = PerfError("asynctransact", "red_pread()");
+            }
+        }
+
+        if((iRet == 0) && fAsync && (red_transact_poll(pParam->pszVolume, true) != 0))
+        {
+            iRet = PerfError("asynctransact", "red_transact_poll()");
+        }
+    }
+
+    PerfEnd(pParam, &stats);
+
+    if(iRet == 0)
+    {
+        PerfReport("asynctransact", fAsync ? "write + transact_async + read" : "write + transact + read", stats.ullMicrosecs, ulIters);
+        PerfReport("asynctransact", fAsync ? "caller waiting in transact_async" : "caller waiting in transact", ullCommitUs, ulIters);
+    }
+
+    return iRet;
+}
+#endif
+
+
+/** @brief Measure automatic transaction points made by the transaction policy.
+
+    Blocks are appended to a file, first with #RED_TRANSACT_WRITE in the
+    transaction mask, so that every write is followed by a transaction point;
+    then with only the byte threshold, and then only the block threshold, of
+    the transaction policy set to #AUTO_THRESHOLD_BLOCKS blocks.  The time per
+    write and the number of transaction points are reported for each.  The
+    transaction mask and policy are restored afterward.
+
+    @param pParam   fsperf parameters.
+
+    @return Zero on success, otherwise nonzero.
+*/
+static int AutoTransactTest(
+    const FSPERFPARAM *pParam)
+{
+  #if REDCONF_TRANSACT_AUTO == 1
+    uint32_t        ulWrites = REDMIN(pParam->ulIterations, AUTO_WRITES);
+    uint32_t        ulTransMask;
+    REDTRANSPOLICY  savedPolicy;
+    REDTRANSPOLICY  policy;
+    REDSTATFS       sfs;
+    int             iRet = 0;
+
+    if(    (red_gettransmask(pParam->pszVolume, &ulTransMask) != 0)
+        || (red_gettranspolicy(pParam->pszVolume, &savedPolicy) != 0))
+    {
+        RedPrintf("autotransact: unexpected error %d getting the transaction mode\n", (int)red_errno);
+        iRet = 1;
+    }
+    else
+    {
+        iRet = PerfStatFs(pParam, "autotransact", &sfs);
+    }
+
+    if(iRet == 0)
+    {
+        /*  Each write allocates a data block and, at each transaction point,
+            branches the metadata, so leave plenty of room.
+        */
+        ulWrites = (uint32_t)REDMIN(ulWrites, sfs.f_bfree / 4U);
+
+        RedMemSet(&policy, 0U, sizeof(policy));
+        iRet = AutoTransactRun(pParam, ulWrites, RED_TRANSACT_WRITE, &policy, "transact every write");
+
+        if(iRet == 0)
+        {
+            policy.ullWriteBytes = (uint64_t)AUTO_THRESHOLD_BLOCKS * REDCONF_BLOCK_SIZE;
+            iRet = AutoTransactRun(pParam, ulWrites, RED_TRANSACT_MANUAL, &policy, "byte threshold");
+        }
+
+        if(iRet == 0)
+        {
+            policy.ullWriteBytes = 0U;
+            policy.ulDirtyBlocks = AUTO_THRESHOLD_BLOCKS;
+            iRet = AutoTransactRun(pParam, ulWrites, RED_TRANSACT_MANUAL, &policy, "block threshold");
+        }
+
+        if(    (red_settransmask(pParam->pszVolume, ulTransMask) != 0)
+            || (red_settranspolicy(pParam->pszVolume, &savedPolicy) != 0))
+        {
+            RedPrintf("autotransact: unexpected error %d restoring the transaction mode\n", (int)red_errno);
+            iRet = 1;
+        }
+    }
+
+    return iRet;
+  #else
+    (void)pParam;
+
+    RedPrintf("autotransact: skipped, requires REDCONF_TRANSACT_AUTO\n");
+
+    return 0;
+  #endif
+}
+
+
+#if REDCONF_TRANSACT_AUTO == 1
+/** @brief Run one part of the auto transact test.
+
+    @param pParam       fsperf parameters.
+    @param ulWrites     The number of blocks to append.
+    @param ulTransMask  The transaction mask to use.
+    @param pPolicy      The transaction policy to use.
+    @param pszPolicy    Description of the transaction mode, for the report.
+
+    @return Zero on success, otherwise nonzero.
+*/
+static int AutoTransactRun(
+    const FSPERFPARAM      *pParam,
+    uint32_t                ulWrites,
+    uint32_t                ulTransMask,
+    const REDTRANSPOLICY   *pPolicy,
+    const char             *pszPolicy)
+{
+    int32_t                 iFildes = -1;
+    int                     iRet;
+
+    iRet = PerfOpen(pParam, "autotransact", "auto.dat", RED_O_WRONLY | RED_O_CREAT | RED_O_TRUNC, &iFildes);
+    if(iRet == 0)
+    {
+        iRet = PerfTransact(pParam, "autotransact");
+    }
+
+    if(    (iRet == 0)
+        && ((red_settransmask(pParam->pszVolume, ulTransMask) != 0) || (red_settranspolicy(pParam->pszVolume, pPolicy) != 0)))
+    {
+        RedPrintf("autotransact: unexpected error %d setting the transaction mode\n", (int)red_errno);
+        iRet = 1;
+    }
+
+    if(iRet == 0)
+    {
+        PERFSTATS   stats;
+        uint32_t    ulIter;
+
+        RedMemSet(gabBlock, 0x5AU, sizeof(gabBlock));
+
+        PerfStart(pParam, &stats);
+
+        for(ulIter = 0U; (iRet == 0) && (ulIter < ulWrites); ulIter++)
+        {
+            if(red_write(iFildes, gabBlock, REDCONF_BLOCK_SIZE) != (int32_t)REDCONF_BLOCK_SIZE)
+            {
+                iRet = PerfError("autotransact", "red_write()");
+            }
+        }
+
+        PerfEnd(pParam, &stats);
+
+        if(iRet == 0)
+        {
+            PerfReport("autotransact", pszPolicy, stats.ullMicrosecs, ulWrites);
+            RedPrintf("autotransact: %s: %lu transaction points for %lu block writes\n", pszPolicy,
+                (unsigned long)stats.ulTransacts, (unsigned long)ulWrites);
+        }
+    }
+
+    if(iFildes >= 0)
+    {
+        (void)red_close(iFildes);
+        PerfRemove(pParam, "auto.dat");
+    }
+
+    return iRet;
+}
+#endif
+
+
+/** @brief Measure reading the committed state through a snapshot view.
+
+    #SNAPSHOT_FILES files are written and committed, and a view of the
+    committed state is opened with red_opensnapshot().  The files are read
+    through the view; then, in the working state, half of them are overwritten
+    and the others deleted, a new file is created, and a transaction point is
+    made.  The files are read through the view again and must be unchanged.
+    This is done twice, so that the second round overwrites inodes which the
+    view uses, and may reuse its freed inode slots and blocks.
+
+    Up to #SNAPSHOT_EMPTY_FILES empty files are also created, so that the view
+    uses many inodes, and the time taken by a transaction point after a small
+    write is measured before the view is opened and while it is open.
+
+    @param pParam   fsperf parameters.
+
+    @return Zero on success, otherwise nonzero.
+*/
+static int SnapshotTest(
+    const FSPERFPARAM  *pParam)
+{
+  #if REDCONF_API_POSIX_SNAPSHOT == 1
+    char                szPath[PERF_PATH_MAX];
+    char                szName[16U];
+    uint32_t            ulBlocks = SNAPSHOT_FILE_BLOCKS;
+    uint32_t            ulEmptyFiles = SNAPSHOT_EMPTY_FILES;
+    uint32_t            ulFile;
+    uint32_t            ulBlock;
+    uint32_t            ulRound;
+    uint32_t            ulCrc = 0U;
+    uint32_t            ulViewCrc = 0U;
+    int32_t             iFildes;
+    int32_t             iSnapFildes = -1;
+    REDSTATFS           sfs;
+    PERFSTATS           stats;
+    int                 iRet;
+
+    iRet = PerfStatFs(pParam, "snapshot", &sfs);
+    if(iRet == 0)
+    {
+        /*  The overwrites in the working state cannot reuse the blocks of the
+            view, so leave room for the view and both rounds.
+        */
+        ulBlocks = (uint32_t)REDMIN(ulBlocks, sfs.f_bfree / (4U * SNAPSHOT_FILES));
+        ulEmptyFiles = (uint32_t)REDMIN(ulEmptyFiles, sfs.f_ffree / 2U);
+    }
+
+    for(ulFile = 0U; (iRet == 0) && (ulFile < SNAPSHOT_FILES); ulFile++)
+    {
+        (void)RedSNPrintf(szName, sizeof(szName), "snap%lu.dat", (unsigned long)ulFile);
+
+        iRet = PerfFileCreate(pParam, szName, ulBlocks, &iFildes);
+        if(iRet == 0)
+        {
+            (void)red_close(iFildes);
+        }
+    }
+
+    for(ulFile = 0U; (iRet == 0) && (ulFile < ulEmptyFiles); ulFile++)
+    {
+        (void)RedSNPrintf(szName, sizeof(szName), "snape%lu.dat", (unsigned long)ulFile);
+
+        iRet = PerfOpen(pParam, "snapshot", szName, RED_O_WRONLY | RED_O_CREAT | RED_O_TRUNC, &iFildes);
+        if(iRet == 0)
+        {
+            (void)red_close(iFildes);
+        }
+    }
+
+    if(iRet == 0)
+    {
+        iRet = SnapshotCommit(pParam, "write + transact, no view open");
+    }
+
+    if(iRet == 0)
+    {
+        iSnapFildes = red_opensnapshot(pParam->pszVolume);
+        if(iSnapFildes < 0)
+        {
+            iRet = PerfError("snapshot", "red_opensnapshot()");
+        }
+    }
+
+    if(iRet == 0)
+    {
+        PerfStart(pParam, &stats);
+        iRet = SnapshotRead(iSnapFildes, ulBlocks, &ulCrc);
+        PerfEnd(pParam, &stats);
+
+        if(iRet == 0)
+        {
+            PerfReport("snapshot", "read view, unchanged state", stats.ullMicrosecs, SNAPSHOT_FILES * ulBlocks);
+        }
+    }
+
+    if(iRet == 0)
+    {
+        iRet = SnapshotCommit(pParam, "write + transact, view open");
+    }
+
+    for(ulRound = 0U; (iRet == 0) && (ulRound < 2U); ulRound++)
+    {
+        /*  Overwrite the even numbered files and delete the odd numbered ones.
+        */
+        RedMemSet(gabBlock, (uint8_t)(0xA5U + ulRound), sizeof(gabBlock));
+
+        for(ulFile = 0U; (iRet == 0) && (ulFile < SNAPSHOT_FILES); ulFile++)
+        {
+            (void)RedSNPrintf(szName, sizeof(szName), "snap%lu.dat", (unsigned long)ulFile);
+
+            if((ulFile & 1U) != 0U)
+            {
+                if(ulRound == 0U)
+                {
+                    PerfPath(szPath, pParam, szName);
+                    if(red_unlink(szPath) != 0)
+                    {
+                        iRet = PerfError("snapshot", "red_unlink()");
+                    }
+                }
+            }
+            else
+            {
+                iRet = PerfOpen(pParam, "snapshot", szName, RED_O_WRONLY, &iFildes);
+                if(iRet == 0)
+                {
+                    for(ulBlock = 0U; (iRet == 0) && (ulBlock < ulBlocks); ulBlock++)
+                    {
+                        if(red_write(iFildes, gabBlock, sizeof(gabBlock)) != (int32_t)sizeof(gabBlock))
+                        {
+                            iRet = PerfError("snapshot", "red_write()");
+                        }
+                    }
+
+                    (void)red_close(iFildes);
+                }
+            }
+        }
+
+        if(iRet == 0)
+        {
+            (void)RedSNPrintf(szName, sizeof(szName), "snapnew%lu.dat", (unsigned long)ulRound);
+
+            iRet = PerfOpen(pParam, "snapshot", szName, RED_O_WRONLY | RED_O_CREAT | RED_O_TRUNC, &iFildes);
+            if(iRet == 0)
+            {
+                if(red_write(iFildes, gabBlock, sizeof(gabBlock)) != (int32_t)sizeof(gabBlock))
+                {
+                    iRet = PerfError("snapshot", "red_write()");
+                }
+
+                (void)red_close(iFildes);
+            }
+        }
+
+        /*  Transaction points are made while the view is open.
+        */
+        if(iRet == 0)
+        {
+            iRet = PerfTransact(pParam, "snapshot");
+        }
+
+        if(iRet == 0)
+        {
+            PerfStart(pParam, &stats);
+            iRet = SnapshotRead(iSnapFildes, ulBlocks, &ulViewCrc);
+            PerfEnd(pParam, &stats);
+
+            if(iRet == 0)
+            {
+                PerfReport("snapshot", "read view, changed state", stats.ullMicrosecs, SNAPSHOT_FILES * ulBlocks);
+
+                if(ulViewCrc != ulCrc)
+                {
+                    RedPrintf("snapshot: the view changed: CRC %08lx, expected %08lx\n", (unsigned long)ulViewCrc, (unsigned long)ulCrc);
+                    iRet = 1;
+                }
+            }
+        }
+    }
+
+    if(iRet == 0)
+    {
+        iRet = PerfOpen(pParam, "snapshot", "snap0.dat", RED_O_RDONLY, &iFildes);
+        if(iRet == 0)
+        {
+            if(    (red_read(iFildes, gabBlock, sizeof(gabBlock)) != (int32_t)sizeof(gabBlock))
+                || (gabBlock[0U] != 0xA6U))
+            {
+                RedPrintf("snapshot: the working state does not have the new data\n");
+                iRet = 1;
+            }
+
+            (void)red_close(iFildes);
+        }
+    }
+
+    if(iSnapFildes >= 0)
+    {
+        (void)red_close(iSnapFildes);
+    }
+
+    if(iRet == 0)
+    {
+        iRet = PerfTransact(pParam, "snapshot");
+    }
+
+    for(ulFile = 0U; ulFile < SNAPSHOT_FILES; ulFile++)
+    {
+        (void)RedSNPrintf(szName, sizeof(szName), "snap%lu.dat", (unsigned long)ulFile);
+        PerfRemove(pParam, szName);
+    }
+
+    for(ulRound = 0U; ulRound < 2U; ulRound++)
+    {
+        (void)RedSNPrintf(szName, sizeof(szName), "snapnew%lu.dat", (unsigned long)ulRound);
+        PerfRemove(pParam, szName);
+    }
+
+    for(ulFile = 0U; ulFile < ulEmptyFiles; ulFile++)
+    {
+        (void)RedSNPrintf(szName, sizeof(szName), "snape%lu.dat", (unsigned long)ulFile);
+        PerfRemove(pParam, szName);
+    }
+
+    (void)red_transact(pParam->pszVolume);
+
+    return iRet;
+  #else
+    (void)pParam;
+
+    RedPrintf("snapshot: skipped, requires REDCONF_API_POSIX_SNAPSHOT\n");
+
+    return 0;
+  #endif
+}
+
+
+#if REDCONF_API_POSIX_SNAPSHOT == 1
+/** @brief Read the files of the snapshot test through a directory descriptor.
+
+    @param iDirFildes   Descriptor for the directory containing the files.
+    @param ulBlocks     The size of each file, in blocks.
+    @param pulCrc       Populated with the CRC of the data read.
+
+    @return Zero on success, otherwise nonzero.
+*/
+static int SnapshotRead(
+    int32_t     iDirFildes,
+    uint32_t    ulBlocks,
+    uint32_t   *pulCrc)
+{
+    char        szName[16U];
+    uint32_t    ulFile;
+    uint32_t    ulBlock;
+    uint32_t    ulCrc = 0U;
+    int32_t     iFildes;
+    int         iRet = 0;
+
+    for(ulFile = 0U; (iRet == 0) && (ulFile < SNAPSHOT_FILES); ulFile++)
+    {
+        (void)RedSNPrintf(szName, sizeof(szName), "snap%lu.dat", (unsigned long)ulFile);
+
+        iFildes = red_openat(iDirFildes, szName, RED_O_RDONLY, 0U);
+        if(iFildes < 0)
+        {
+            iRet = PerfError("snapshot", "red_openat()");
+        }
+        else
+        {
+            for(ulBlock = 0U; (iRet == 0) && (ulBlock < ulBlocks); ulBlock++)
+            {
+                if(red_read(iFildes, gabBlock, sizeof(gabBlock)) != (int32_t)sizeof(gabBlock))
+                {
+                    iRet = PerfError("snapshot", "red_read()");
+                }
+                else
+                {
+                    ulCrc = RedCrc32Update(ulCrc, gabBlock, sizeof(gabBlock));
+                }
+            }
+
+            (void)red_close(iFildes);
+        }
+    }
+
+    *pulCrc = ulCrc;
+
+    return iRet;
+}
+
+
+/** @brief Measure transaction points for the snapshot test.
+
+    Each iteration overwrites the first block of the first file of the test and
+    makes a transaction point, which branches the inode of the file.
+
+    @param pParam       fsperf parameters.
+    @param pszMetric    Description of the state of the view, for the report.
+
+    @return Zero on success, otherwise nonzero.
+*/
+static int SnapshotCommit(
+    const FSPERFPARAM  *pParam,
+    const char         *pszMetric)
+{
+    uint32_t            ulCommits = REDMIN(pParam->ulIterations, SNAPSHOT_COMMITS);
+    int32_t             iFildes = -1;
+    int                 iRet;
+
+    iRet = PerfOpen(pParam, "snapshot", "snap0.dat", RED_O_WRONLY, &iFildes);
+    if(iRet == 0)
+    {
+        PERFSTATS   stats;
+        uint32_t    ulIter;
+
+        PerfStart(pParam, &stats);
+
+        for(ulIter = 0U; (iRet == 0) && (ulIter < ulCommits); ulIter++)
+        {
+            RedMemSet(gabBlock, (uint8_t)ulIter, sizeof(gabBlock));
+
+            if(red_pwrite(iFildes, gabBlock, sizeof(gabBlock), 0U) != (int32_t)sizeof(gabBlock))
+            {
+                iRet = PerfError("snapshot", "red_pwrite()");
+            }
+            else
+            {
+                iRet = PerfTransact(pParam, "snapshot");
+            }
+        }
+
+        PerfEnd(pParam, &stats);
+
+        if(iRet == 0)
+        {
+            PerfReport("snapshot", pszMetric, stats.ullMicrosecs, ulCommits);
+        }
+
+        (void)red_close(iFildes);
+    }
+
+    return iRet;
+}
+#endif
+
+
+/** @brief Measure fsync of an unmodified file, and check that skipping its
+           transaction point leaves nothing of the file uncommitted.
+
+    With #REDCONF_TRANSACT_GROUP, red_fsync() makes no transaction point when
+    the inode of the file has not been branched since the last one.  Two files
+    are created and committed, and every automatic transaction point except
+    #RED_TRANSACT_FSYNC is disabled.  Then, counting the transaction points:
+
+    - The other file is written before each fsync of the file, which must make
+      no transaction point.  These fsync calls are timed.
+    - The file is renamed within its directory; its fsync must commit.
+    - The file is written; its fsync must commit.
+    - The other file is extended; the fsync of the file must not commit.
+
+    The volume is then unmounted without a transaction point, as if power were
+    lost, and mounted again.  The file must have its new name and size, and
+    the other file must not have been extended.
+
+    @param pParam   fsperf parameters.
+
+    @return Zero on success, otherwise nonzero.
+*/
+static int GroupFsyncTest(
+    const FSPERFPARAM  *pParam)
+{
+  #if (REDCONF_TRANSACT_GROUP == 1) && (REDCONF_API_POSIX_RENAME == 1)
+    uint32_t            ulCalls = REDMIN(pParam->ulIterations, GROUPFSYNC_CALLS);
+    uint32_t            ulTransMask;
+    bool                fMaskSaved = false;
+    char                szPath[PERF_PATH_MAX];
+    char                szNewPath[PERF_PATH_MAX];
+    char                szOtherPath[PERF_PATH_MAX];
+    int32_t             iFildes = -1;
+    int32_t             iOtherFildes = -1;
+    REDSTAT             st;
+    int                 iRet;
+
+    PerfPath(szPath, pParam, "fsync.dat");
+    PerfPath(szNewPath, pParam, "fsyncnew.dat");
+    PerfPath(szOtherPath, pParam, "fsyncoth.dat");
+
+    iRet = PerfFileCreate(pParam, "fsync.dat", 1U, &iFildes);
+    if(iRet == 0)
+    {
+        iRet = PerfFileCreate(pParam, "fsyncoth.dat", 1U, &iOtherFildes);
+    }
+
+    if(iRet == 0)
+    {
+        fMaskSaved = (red_gettransmask(pParam->pszVolume, &ulTransMask) == 0);
+
+        if(!fMaskSaved || (red_settransmask(pParam->pszVolume, RED_TRANSACT_FSYNC) != 0))
+        {
+            RedPrintf("groupfsync: unexpected error %d setting the transaction mask\n", (int)red_errno);
+            iRet = 1;
+        }
+    }
+
+    if(iRet == 0)
+    {
+        uint32_t    ulTransacts = 0U;
+        uint64_t    ullMicrosecs = 0U;
+        uint32_t    ulCall;
+
+        RedMemSet(gabBlock, 0xA5U, sizeof(gabBlock));
+
+        for(ulCall = 0U; (iRet == 0) && (ulCall < ulCalls); ulCall++)
+        {
+            PERFSTATS stats;
+
+            if(red_pwrite(iOtherFildes, gabBlock, sizeof(gabBlock), REDCONF_BLOCK_SIZE) != (int32_t)sizeof(gabBlock))
+            {
+                iRet = PerfError("groupfsync", "red_pwrite()");
+            }
+            else
+            {
+                PerfStart(pParam, &stats);
+
+                if(red_fsync(iFildes) != 0)
+                {
+                    iRet = PerfError("groupfsync", "red_fsync()");
+                }
+
+                PerfEnd(pParam, &stats);
+
+                ullMicrosecs += stats.ullMicrosecs;
+                ulTransacts += stats.ulTransacts;
+            }
+        }
+
+        if((iRet == 0) && (ulTransacts != 0U))
+        {
+            RedPrintf("groupfsync: fsync of an unmodified file made a transaction point\n");
+            iRet = 1;
+        }
+
+        if(iRet == 0)
+        {
+            PerfReport("groupfsync", "fsync of an unmodified file", ullMicrosecs, ulCalls);
+        }
+    }
+
+    if((iRet == 0) && (red_rename(szPath, szNewPath) != 0))
+    {
+        iRet = PerfError("groupfsync", "red_rename()");
+    }
+
+    if(iRet == 0)
+    {
+        iRet = GroupFsyncStep(pParam, iFildes, true, "rename");
+    }
+
+    if((iRet == 0) && (red_pwrite(iFildes, gabBlock, sizeof(gabBlock), REDCONF_BLOCK_SIZE) != (int32_t)sizeof(gabBlock)))
+    {
+        iRet = PerfError("groupfsync", "red_pwrite()");
+    }
+
+    if(iRet == 0)
+    {
+        iRet = GroupFsyncStep(pParam, iFildes, true, "write");
+    }
+
+    if((iRet == 0) && (red_pwrite(iOtherFildes, gabBlock, sizeof(gabBlock), 2U * REDCONF_BLOCK_SIZE) != (int32_t)sizeof(gabBlock)))
+    {
+        iRet = PerfError("groupfsync", "red_pwrite()");
+    }
+
+    if(iRet == 0)
+    {
+        iRet = GroupFsyncStep(pParam, iFildes, false, "write to another file");
+    }
+
+    /*  With only #RED_TRANSACT_FSYNC in the transaction mask, neither closing
+        the files nor unmounting the volume makes a transaction point, so the
+        remount finds the state committed by the fsync calls.
+    */
+    if(iFildes >= 0)
+    {
+        (void)red_close(iFildes);
+    }
+
+    if(iOtherFildes >= 0)
+    {
+        (void)red_close(iOtherFildes);
+    }
+
+    if(iRet == 0)
+    {
+        iRet = PerfRemount(pParam, "groupfsync");
+    }
+
+    if(iRet == 0)
+    {
+        if((red_stat(szPath, &st) == 0) || (red_errno != RED_ENOENT))
+        {
+            RedPrintf("groupfsync: the file is still found under its old name\n");
+            iRet = 1;
+        }
+        else if((red_stat(szNewPath, &st) != 0) || (st.st_size != 2U * REDCONF_BLOCK_SIZE))
+        {
+            RedPrintf("groupfsync: the rename or write of the file was not committed\n");
+            iRet = 1;
+        }
+        else if((red_stat(szOtherPath, &st) != 0) || (st.st_size != 2U * REDCONF_BLOCK_SIZE))
+        {
+            RedPrintf("groupfsync: the other file does not have its committed size\n");
+            iRet = 1;
+        }
+        else
+        {
+            /*  Nothing to do: the committed state is as expected.
+            */
+        }
+    }
+
+    if(fMaskSaved && (red_settransmask(pParam->pszVolume, ulTransMask) != 0))
+    {
+        RedPrintf("groupfsync: unexpected error %d restoring the transaction mask\n", (int)red_errno);
+        iRet = 1;
+    }
+
+    (void)red_unlink(szPath);
+    (void)red_unlink(szNewPath);
+    (void)red_unlink(szOtherPath);
+
+    return iRet;
+  #else
+    (void)pParam;
+
+    RedPrintf("groupfsync: skipped, requires REDCONF_TRANSACT_GROUP and REDCONF_API_POSIX_RENAME\n");
+
+    return 0;
+  #endif
+}
+
+
+#if (REDCONF_TRANSACT_GROUP == 1) && (REDCONF_API_POSIX_RENAME == 1)
+/** @brief Fsync a file and check whether it made a transaction point.
+
+    @param pParam   fsperf parameters.
+    @param iFildes  The file descriptor to fsync.
+    @param fCommit  Whether the fsync must make a transaction point.
+    @param pszStep  Description of the change before the fsync, for errors.
+
+    @return Zero on success, otherwise nonzero.
+*/
+static int GroupFsyncStep(
+    const FSPERFPARAM  *pParam,
+    int32_t             iFildes,
+    bool                fCommit,
+    const char         *pszStep)
+{
+    PERFSTATS           stats;
+    int                 iRet;
+
+    PerfStart(pParam, &stats);
+    iRet = red_fsync(iFildes);
+    PerfEnd(pParam, &stats);
+
+    if(iRet != 0)
+    {
+        RedPrintf("groupfsync: unexpected error %d from red_fsync() after a %s\n", (int)red_errno, pszStep);
+        iRet = 1;
+    }
+    else if((stats.ulTransacts != 0U) != fCommit)
+    {
+        RedPrintf("groupfsync: fsync after a %s %s a transaction point\n", pszStep, fCommit ? "did not make" : "made");
+        iRet = 1;
+    }
+    else
+    {
+        /*  Nothing to do: the fsync behaved as expected.
+        */
+    }
+
+    return iRet;
+}
+#endif
+
+#if REDCONF_BUFFER_STATS == 1
+/** @brief Total the metadata buffer hits and misses for a volume.
+
+    @param pszVolume    The volume path prefix.
+    @param pullHits     Populated with the metadata buffer hits.
+    @param pullMisses   Populated with the metadata buffer misses.
+*/
+static void MetaHitsMisses(
+    const char *pszVolume,
+    uint64_t   *pullHits,
+    uint64_t   *pullMisses)
+{
+    REDBUFSTATS bs;
+    uint32_t    ulType;
+
+    *pullHits = 0U;
+    *pullMisses = 0U;
+
+    if(red_bufstats(pszVolume, &bs) == 0)
+    {
+        for(ulType = 0U; ulType < RED_BUFSTAT_TYPES; ulType++)
+        {
+            if(ulType != RED_BUFSTAT_DATA)
+            {
+                *pullHits += bs.aType[ulType].ullHits;
+                *pullMisses += bs.aType[ulType].ullMisses;
+            }
+        }
+    }
+}
+#endif
+
+
+/** @brief Start measuring an operation.
+
+    Records the block device requests (if #REDCONF_BDEV_STATS is enabled), the
+    buffer cache statistics (if #REDCONF_BUFFER_STATS is enabled), and the
+    transaction points made so far, then the time.
+
+    @param pParam   fsperf parameters.
+    @param pStats   Populated with the counts at the start of the operation.
+*/
+static void PerfStart(
+    const FSPERFPARAM  *pParam,
+    PERFSTATS          *pStats)
+{
+    uint8_t             bVolNum = RedFindVolumeNumber(pParam->pszVolume);
+
+    pStats->ullMicrosecs = 0U;
+    pStats->ulTransacts = gaRedVolume[bVolNum].ulTransactCount;
+  #if REDCONF_BDEV_STATS == 1
+    pStats->bdev = gaRedBdevStats[bVolNum];
+  #endif
+  #if REDCONF_BUFFER_STATS == 1
+    if(red_bufstats(pParam->pszVolume, &pStats->buf) != 0)
+    {
+        RedMemSet(&pStats->buf, 0U, sizeof(pStats->buf));
+    }
+  #endif
+    pStats->ts = RedOsTimestamp();
+}
+
+
+/** @brief Finish measuring an operation started with PerfStart().
+
+    @param pParam   fsperf parameters.
+    @param pStats   On entry, the counts recorded by PerfStart().  On exit, the
+                    elapsed time and how much each count changed.
+*/
+static void PerfEnd(
+    const FSPERFPARAM  *pParam,
+    PERFSTATS          *pStats)
+{
+    uint8_t             bVolNum = RedFindVolumeNumber(pParam->pszVolume);
+  #if REDCONF_BDEV_STATS == 1
+    const BDEVSTATS    *pBdev = &gaRedBdevStats[bVolNum];
+  #endif
+  #if REDCONF_BUFFER_STATS == 1
+    REDBUFSTATS         bs;
+    uint32_t            ulType;
+  #endif
+
+    pStats->ullMicrosecs = RedOsTimePassed(pStats->ts);
+    pStats->ulTransacts = gaRedVolume[bVolNum].ulTransactCount - pStats->ulTransacts;
+  #if REDCONF_BDEV_STATS == 1
+    pStats->bdev.ullReads = pBdev->ullReads - pStats->bdev.ullReads;
+    pStats->bdev.ullSectorsRead = pBdev->ullSectorsRead - pStats->bdev.ullSectorsRead;
+    pStats->bdev.ullWrites = pBdev->ullWrites - pStats->bdev.ullWrites;
+    pStats->bdev.ullSectorsWritten = pBdev->ullSectorsWritten - pStats->bdev.ullSectorsWritten;
+    pStats->bdev.ullFuaWrites = pBdev->ullFuaWrites - pStats->bdev.ullFuaWrites;
+    pStats->bdev.ullFlushes = pBdev->ullFlushes - pStats->bdev.ullFlushes;
+  #endif
+
+  #if REDCONF_BUFFER_STATS == 1
+    if(red_bufstats(pParam->pszVolume, &bs) != 0)
+    {
+        bs = pStats->buf;
+    }
+
+    for(ulType = 0U; ulType < RED_BUFSTAT_TYPES; ulType++)
+    {
+        REDBUFTYPESTATS        *pType = &pStats->buf.aType[ulType];
+        const REDBUFTYPESTATS  *pEnd = &bs.aType[ulType];
+
+        pType->ullLookups = pEnd->ullLookups - pType->ullLookups;
+        pType->ullHits = pEnd->ullHits - pType->ullHits;
+        pType->ullMisses = pEnd->ullMisses - pType->ullMisses;
+        pType->ullEvictions = pEnd->ullEvictions - pType->ullEvictions;
+        pType->ullEvictWrites = pEnd->ullEvictWrites - pType->ullEvictWrites;
+        pType->ullFlushWrites = pEnd->ullFlushWrites - pType->ullFlushWrites;
+        pType->ullIoReads = pEnd->ullIoReads - pType->ullIoReads;
+        pType->ullIoReadBlocks = pEnd->ullIoReadBlocks - pType->ullIoReadBlocks;
+        pType->ullIoWrites = pEnd->ullIoWrites - pType->ullIoWrites;
+        pType->ullIoWriteBlocks = pEnd->ullIoWriteBlocks - pType->ullIoWriteBlocks;
+        pType->ullCrcChecks = pEnd->ullCrcChecks - pType->ullCrcChecks;
+        pType->ullCrcFull = pEnd->ullCrcFull - pType->ullCrcFull;
+        pType->ullCrcIncremental = pEnd->ullCrcIncremental - pType->ullCrcIncremental;
+    }
+  #endif
+}
+
+
+/** @brief Get the file system statistics of the test volume.
+
+    @param pParam   fsperf parameters.
+    @param pszTest  The name of the test, for errors.
+    @param pSfs     Populated with the file system statistics.
+
+    @return Zero on success, otherwise nonzero.
+*/
+static int PerfStatFs(
+    const FSPERFPARAM  *pParam,
+    const char         *pszTest,
+    REDSTATFS          *pSfs)
+{
+    int                 iRet = 0;
+
+    if(red_statvfs(pParam->pszVolume, pSfs) != 0)
+    {
+        iRet = PerfError(pszTest, "red_statvfs()");
+    }
+
+    return iRet;
+}
+
+
+/** @brief Open a test file in the root of the test volume.
+
+    @param pParam       fsperf parameters.
+    @param pszTest      The name of the test, for errors.
+    @param pszName      The name of the test file.
+    @param ulOpenMode   The open flags for red_open().
+    @param piFildes     On success, populated with the file descriptor.
+
+    @return Zero on success, otherwise nonzero.
+*/
+static int PerfOpen(
+    const FSPERFPARAM  *pParam,
+    const char         *pszTest,
+    const char         *pszName,
+    uint32_t            ulOpenMode,
+    int32_t            *piFildes)
+{
+    char                szPath[PERF_PATH_MAX];
+    int32_t             iFildes;
+    int                 iRet = 0;
+
+    PerfPath(szPath, pParam, pszName);
+
+    iFildes = red_open(szPath, ulOpenMode);
+    if(iFildes < 0)
+    {
+        iRet = PerfError(pszTest, "red_open()");
+    }
+    else
+    {
+        *piFildes = iFildes;
+    }
+
+    return iRet;
+}
+
+
+/** @brief Delete a test file from the root of the test volume, ignoring
+           errors.
+
+    @param pParam   fsperf parameters.
+    @param pszName  The name of the test file.
+*/
+static void PerfRemove(
+    const FSPERFPARAM  *pParam,
+    const char         *pszName)
+{
+    char                szPath[PERF_PATH_MAX];
+
+    PerfPath(szPath, pParam, pszName);
+    (void)red_unlink(szPath);
+}
+
+
+/** @brief Commit a transaction point on the test volume.
+
+    @param pParam   fsperf parameters.
+    @param pszTest  The name of the test, for errors.
+
+    @return Zero on success, otherwise nonzero.
+*/
+static int PerfTransact(
+    const FSPERFPARAM  *pParam,
+    const char         *pszTest)
+{
+    int                 iRet = 0;
+
+    if(red_transact(pParam->pszVolume) != 0)
+    {
+        iRet = PerfError(pszTest, "red_transact()");
+    }
+
+    return iRet;
+}
+
+
+/** @brief Unmount and mount the test volume, so that nothing is buffered.
+
+    The test must have closed its files.
+
+    @param pParam   fsperf parameters.
+    @param pszTest  The name of the test, for errors.
+
+    @return Zero on success, otherwise nonzero.
+*/
+static int PerfRemount(
+    const FSPERFPARAM  *pParam,
+    const char         *pszTest)
+{
+    int                 iRet = 0;
+
+    if(red_umount(pParam->pszVolume) != 0)
+    {
+        iRet = PerfError(pszTest, "red_umount()");
+    }
+    else if(red_mount(pParam->pszVolume) != 0)
+    {
+        iRet = PerfError(pszTest, "red_mount()");
+    }
+    else
+    {
+        /*  Remounted.
+        */
+    }
+
+    return iRet;
+}
+
+
+/** @brief Create a test file, fill it with data, and commit it.
+
+    @param pParam   fsperf parameters.
+    @param pszName  The name of the file to create in the volume root.
+    @param ulBlocks The size of the file, in blocks.
+    @param piFildes On success, populated with a read/write file descriptor.
+
+    @return Zero on success, otherwise nonzero.
+*/
+static int PerfFileCreate(
+    const FSPERFPARAM  *pParam,
+    const char         *pszName,
+    uint32_t            ulBlocks,
+    int32_t            *piFildes)
+{
+    int32_t             iFildes;
+    int                 iRet;
+
+    iRet = PerfOpen(pParam, pszName, pszName, RED_O_RDWR | RED_O_CREAT | RED_O_TRUNC, &iFildes);
+    if(iRet == 0)
+    {
+        uint32_t ulBlock;
+
+        for(ulBlock = 0U; (iRet == 0) && (ulBlock < ulBlocks); ulBlock++)
+        {
+            RedMemSet(gabBlock, (uint8_t)ulBlock, sizeof(gabBlock));
+
+            if(red_write(iFildes, gabBlock, sizeof(gabBlock)) != (int32_t)sizeof(gabBlock))
+            {
+                iRet = PerfError(pszName, "red_write()");
+            }
+        }
+
+        if(iRet == 0)
+        {
+            iRet = PerfTransact(pParam, pszName);
+        }
+
+        if(iRet == 0)
+        {
+            *piFildes = iFildes;
+        }
+        else
+        {
+            (void)red_close(iFildes);
+        }
+    }
+
+    return iRet;
+}
+
+
+/** @brief Build the path of a test file in the root of the test volume.
+
+    @param pszPath  Populated with the path.  Must be PERF_PATH_MAX bytes.
+    @param pParam   fsperf parameters.
+    @param pszName  The name of the test file.
+*/
+static void PerfPath(
+    char               *pszPath,
+    const FSPERFPARAM  *pParam,
+    const char         *pszName)
+{
+    (void)RedSNPrintf(pszPath, PERF_PATH_MAX, "%s%c%s", pParam->pszVolume, REDCONF_PATH_SEPARATOR, pszName);
+}
+
+
+/** @brief Print an unexpected error from a file system call.
+
+    @param pszTest      The name of the test.
+    @param pszFunction  The call which failed, e.g. "red_open()".
+
+    @return One, for the test to return as its result.
+*/
+static int PerfError(
+    const char *pszTest,
+    const char *pszFunction)
+{
+    RedPrintf("%s: unexpected error %d from %s\n", pszTest, (int)red_errno, pszFunction);
+
+    return 1;
+}
+
+
+/** @brief Divide, returning zero if the denominator is zero.
+
+    @param ullNumerator     The numerator.
+    @param ullDenominator   The denominator.
+
+    @return The quotient, or zero.
+*/
+static uint64_t PerfRatio(
+    uint64_t    ullNumerator,
+    uint64_t    ullDenominator)
+{
+    return (ullDenominator == 0U) ? 0U : (ullNumerator / ullDenominator);
+}
+
+
+/** @brief Print the result of a timed operation.
+
+    @param pszTest      The name of the test.
+    @param pszMetric    What was timed.
+    @param ullMicrosecs The elapsed time, in microseconds.
+    @param ulOps        The number of operations performed in the elapsed
+                        time.
+*/
+static void PerfReport(
+    const char *pszTest,
+    const char *pszMetric,
+    uint64_t    ullMicrosecs,
+    uint32_t    ulOps)
+{
+    RedPrintf("%s: %s: %u ops in %llu us, %llu ns/op\n", pszTest, pszMetric, (unsigned)ulOps,
+        (unsigned long long)ullMicrosecs, (unsigned long long)PerfRatio(ullMicrosecs * 1000U, ulOps));
+}
+
+
+/** @brief Print usage information.
+
+    @param pszProgName  The name of the program.
+*/
+static void usage(
+    const char *pszProgName)
+{
+    uint32_t    ulTest;
+
+    RedPrintf("usage: %s VolumeID [Options]\n", pszProgName);
+    RedPrintf("File system performance tests.\n\n");
+    RedPrintf("Where:\n");
+    RedPrintf("  VolumeID\n");
+    RedPrintf("      A volume number (e.g., 2) or a volume path prefix (e.g., VOL1: or /data)\n");
+    RedPrintf("      of the volume to test.\n");
+    RedPrintf("And 'Options' are any of the following.  If no tests are specified, all\n");
+    RedPrintf("tests are run.\n");
+
+    for(ulTest = 0U; ulTest < PERF_TEST_COUNT; ulTest++)
+    {
+        RedPrintf("  --%s, -%c\n", gaPerfTest[ulTest].pszName, gaPerfTest[ulTest].cOption);
+        RedPrintf("%s", gaPerfTest[ulTest].pszUsage);
+    }
+
+    RedPrintf("  --buffers=count, -B count\n");
+    RedPrintf("      Changes the number of block buffers before running the tests.  Only\n");
+    RedPrintf("      supported when the OS services allocate the buffers at run time.\n");
+    RedPrintf("  --iterations=count, -i count\n");
+    RedPrintf("      Specifies the number of timed operations per test (default 100000).\n");
+    RedPrintf("  --seed=value, -s value\n");
+    RedPrintf("      Specifies the seed for the random number generator (default 1).\n");
+    RedPrintf("  --dev=devname, -D devname\n");
+    RedPrintf("      Specifies the device name.  This is typically only meaningful when\n");
+    RedPrintf("      running the test on a host machine.  This can be \"ram\" to test on a RAM\n");
+    RedPrintf("      disk, the path and name of a file disk (e.g., red.bin); or an OS-specific\n");
+    RedPrintf("      reference to a device (on Windows, a drive letter like G: or a device name\n");
+    RedPrintf("      like \\\\.\\PhysicalDrive7).\n");
+    RedPrintf("  --help, -H\n");
+    RedPrintf("      Prints this usage text and exits.\n\n");
+    RedPrintf("Warning: This test will format the volume -- destroying all existing data.\n\n");
+}
+
+#endif /* FSPERF_SUPPORTED */
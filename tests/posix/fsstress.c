@@ -288,6 +288,20 @@ typedef struct pathname {
     char *path;
 } pathname_t;
 
+#if REDCONF_TRANSACT_STATS == 1
+/*  Totals of the transaction statistics for one type of operation, for
+    --writeamp.
+*/
+typedef struct wastat {
+    uint32_t ops;
+    uint32_t commits;
+    uint64_t branched;
+    uint64_t allocated;
+    uint64_t almostfree;
+    uint64_t written[RED_BUFSTAT_TYPES];
+} wastat_t;
+#endif
+
 #define FT_DIR      0
 #define FT_DIRm     (1 << FT_DIR)
 #define FT_REG      1
@@ -367,6 +381,13 @@ static int rtpct;
 static unsigned long seed = 0;
 static ino_t top_ino;
 static int verbose = 0;
+#if REDCONF_TRANSACT_STATS == 1
+static int writeamp = 0;
+static const char *wavolume;
+static uint32_t wamask;
+static uint64_t waseq;
+static wastat_t wastats[OP_LAST];
+#endif
 
 static int delete_tree(const char *path);
 static void add_to_flist(int fd, int it, int parent);
@@ -402,6 +423,13 @@ static int stat64_path(pathname_t *name, REDSTAT *sbuf);
 static int truncate64_path(pathname_t *name, off64_t length);
 static int unlink_path(pathname_t *name);
 static void usage(const char *progname);
+#if REDCONF_TRANSACT_STATS == 1
+static void print_hundredths(uint64_t value);
+static void writeamp_begin(void);
+static void writeamp_end(void);
+static void writeamp_op(const opdesc_t *p);
+static void writeamp_report(void);
+#endif
 
 
 /** @brief Parse parameters for fsstress.
@@ -432,6 +460,7 @@ PARAMSTATUS FsstressParseParams(
         { "namepad", red_no_argument, NULL, 'r' },
         { "seed", red_required_argument, NULL, 's' },
         { "verbose", red_no_argument, NULL, 'v' },
+        { "writeamp", red_no_argument, NULL, 'w' },
         { "dev", red_required_argument, NULL, 'D' },
         { "help", red_no_argument, NULL, 'H' },
         { NULL }
@@ -455,7 +484,7 @@ PARAMSTATUS FsstressParseParams(
     */
     FsstressDefaultParams(pParam);
 
-    while((c = RedGetoptLong(argc, argv, "cl:n:rs:vD:H", aLongopts, NULL)) != -1)
+    while((c = RedGetoptLong(argc, argv, "cl:n:rs:vwD:H", aLongopts, NULL)) != -1)
     {
         switch(c)
         {
@@ -477,6 +506,9 @@ PARAMSTATUS FsstressParseParams(
             case 'v': /* --verbose */
                 pParam->fVerbose = true;
                 break;
+            case 'w': /* --writeamp */
+                pParam->fWriteAmp = true;
+                break;
             case 'D': /* --dev */
                 if(ppszDevice != NULL)
                 {
@@ -513,6 +545,8 @@ PARAMSTATUS FsstressParseParams(
         *pbVolNum = bVolNum;
     }
 
+    pParam->pszVolume = gaRedVolConf[bVolNum].pszPathPrefix;
+
     red_optind++; /* Move past volume parameter. */
     if(red_optind < argc)
     {
@@ -582,9 +616,21 @@ int FsstressStart(
     namerand = pParam->fNamePad ? 1 : 0;
     seed = pParam->ulSeed;
     verbose = pParam->fVerbose ? 1 : 0;
+#if REDCONF_TRANSACT_STATS == 1
+    writeamp = pParam->fWriteAmp ? 1 : 0;
+    wavolume = pParam->pszVolume;
+#else
+    if (pParam->fWriteAmp)
+        RedPrintf("writeamp: ignored, requires REDCONF_TRANSACT_STATS\n");
+#endif
 
     make_freq_table();
 
+#if REDCONF_TRANSACT_STATS == 1
+    if (writeamp)
+        writeamp_begin();
+#endif
+
     while ((loopcntr <= loops) || (loops == 0)) {
         if (RedSNPrintf(buf, sizeof(buf), "fss%x", getpid()) < 0) {
             RedPrintf("FsstressStart: error building name\n");
@@ -613,6 +659,11 @@ int FsstressStart(
         loopcntr++;
     }
 
+#if REDCONF_TRANSACT_STATS == 1
+    if (writeamp)
+        writeamp_end();
+#endif
+
     if (freq_table != NULL) {
         free(freq_table);
         freq_table = NULL;
@@ -821,6 +872,10 @@ static void doproc(void)
     for (opno = 0; opno < operations; opno++) {
         p = &ops[freq_table[random() % freq_table_size]];
         p->func(opno, random());
+#if REDCONF_TRANSACT_STATS == 1
+        if (writeamp)
+            writeamp_op(p);
+#endif
     }
     free(homedir);
 }
@@ -1336,6 +1391,12 @@ static void usage(const char *progname)
     RedPrintf("      Specifies the seed for the random number generator (default timestamp).\n");
     RedPrintf("  --verbose, -v\n");
     RedPrintf("      Specifies verbose mode (without this, test is very quiet).\n");
+    RedPrintf("  --writeamp, -w\n");
+    RedPrintf("      Commits a transaction point after every operation, with automatic\n");
+    RedPrintf("      transaction points disabled, and prints the blocks branched, allocated,\n");
+    RedPrintf("      and written for each type of operation, and the write amplification:\n");
+    RedPrintf("      the blocks written for each block of file data written.  Requires\n");
+    RedPrintf("      REDCONF_TRANSACT_STATS.\n");
     RedPrintf("  --dev=devname, -D devname\n");
     RedPrintf("      Specifies the device name.  This is typically only meaningful when\n");
     RedPrintf("      running the test on a host machine.  This can be \"ram\" to test on a RAM\n");
@@ -1862,4 +1923,120 @@ static void write_f(int opno, long r)
 }
 
 
+#if REDCONF_TRANSACT_STATS == 1
+/*  Start measuring write amplification: disable automatic transaction points,
+    so that each operation is committed by exactly one transaction point, made
+    by writeamp_op().
+*/
+static void writeamp_begin(void)
+{
+    REDTRANSTATS ts;
+
+    if (red_gettransmask(wavolume, &wamask) < 0 ||
+        red_settransmask(wavolume, RED_TRANSACT_MANUAL) < 0 ||
+        red_transact(wavolume) < 0 ||
+        red_transtats(wavolume, &ts) < 0) {
+        RedPrintf("writeamp: error %d starting\n", (int)red_errno);
+        _exit(1);
+    }
+    waseq = ts.ullSequence;
+    memset(wastats, 0, sizeof(wastats));
+}
+
+/*  Stop measuring write amplification, print the results, and restore the
+    transaction mask.
+*/
+static void writeamp_end(void)
+{
+    writeamp_report();
+    if (red_settransmask(wavolume, wamask) < 0)
+        RedPrintf("writeamp: error %d restoring the transaction mask\n",
+            (int)red_errno);
+}
+
+/*  Commit the operation just done and add the cost of the transaction point
+    to the totals for its type.  If the operation changed nothing, there is no
+    transaction point and it costs nothing.
+*/
+static void writeamp_op(const opdesc_t *p)
+{
+    REDTRANSTATS ts;
+    wastat_t *wp = &wastats[p->op];
+    int i;
+
+    wp->ops++;
+    if (red_transact(wavolume) < 0 || red_transtats(wavolume, &ts) < 0) {
+        RedPrintf("writeamp: error %d after %s\n", (int)red_errno, p->name);
+        return;
+    }
+    if (ts.ullSequence == waseq)
+        return;
+    waseq = ts.ullSequence;
+    wp->commits++;
+    wp->almostfree += ts.ulAlmostFreeBlocks;
+    for (i = 0; i < (int)RED_BUFSTAT_TYPES; i++) {
+        wp->branched += ts.aulBranched[i];
+        wp->allocated += ts.aulAllocated[i];
+        wp->written[i] += ts.aulWritten[i];
+    }
+}
+
+/*  Print a value scaled by 100 as a decimal with two places.
+*/
+static void print_hundredths(uint64_t value)
+{
+    RedPrintf(" %6llu.%02llu", (unsigned long long)(value / 100U),
+        (unsigned long long)(value % 100U));
+}
+
+/*  Print the write amplification totals for each type of operation.  The
+    per-operation averages include operations which changed nothing.  The
+    amplification is the number of blocks written, including metadata and the
+    metaroot, for each block of file data written.
+*/
+static void writeamp_report(void)
+{
+    opdesc_t *p;
+    wastat_t *wp;
+    uint64_t meta;
+    uint64_t total;
+    int i;
+
+    RedPrintf("writeamp: blocks per transaction point, by operation type\n");
+    RedPrintf("%-10s %7s %7s %9s %9s %9s %9s %9s %9s %9s %9s\n", "op", "ops",
+        "commits", "branched", "allocated", "afree", "data", "imap", "inode",
+        "other", "wr/op");
+    for (p = ops; p < ops_end; p++) {
+        wp = &wastats[p->op];
+        if (wp->ops == 0)
+            continue;
+        meta = 0;
+        for (i = 0; i < (int)RED_BUFSTAT_TYPES; i++) {
+            if (i != (int)RED_BUFSTAT_DATA)
+                meta += wp->written[i];
+        }
+        total = meta + wp->written[RED_BUFSTAT_DATA];
+        RedPrintf("%-10s %7lu %7lu %9llu %9llu %9llu %9llu %9llu %9llu %9llu",
+            p->name, (unsigned long)wp->ops, (unsigned long)wp->commits,
+            (unsigned long long)wp->branched,
+            (unsigned long long)wp->allocated,
+            (unsigned long long)wp->almostfree,
+            (unsigned long long)wp->written[RED_BUFSTAT_DATA],
+            (unsigned long long)wp->written[RED_BUFSTAT_IMAP],
+            (unsigned long long)wp->written[RED_BUFSTAT_INODE],
+            (unsigned long long)(meta - wp->written[RED_BUFSTAT_IMAP] -
+                wp->written[RED_BUFSTAT_INODE]));
+        print_hundredths((total * 100U) / wp->ops);
+        if (wp->written[RED_BUFSTAT_DATA] != 0) {
+            RedPrintf("  amplification");
+            print_hundredths((total * 100U) /
+                wp->written[RED_BUFSTAT_DATA]);
+        }
+        RedPrintf("\n");
+    }
+    RedPrintf("(branched, allocated, afree: blocks; data, imap, inode, other: "
+        "blocks written; other includes the metaroot)\n");
+}
+#endif
+
 #endif /* FSSTRESS_SUPPORTED */
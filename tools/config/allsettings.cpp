@@ -204,7 +204,8 @@ QString AllSettings::FormatHeaderOutput()
 
     currValue = (allSettings.cmssCrc->GetValue().startsWith("bitwise", Qt::CaseInsensitive)
                  ? crcBitwise : (allSettings.cmssCrc->GetValue().startsWith("sarwate", Qt::CaseInsensitive)
-                                 ? crcSarwate : crcSlice));
+                                 ? crcSarwate : (allSettings.cmssCrc->GetValue().startsWith("carry-less", Qt::CaseInsensitive)
+                                                 ? crcClmul : crcSlice)));
     toReturn += outputLine(macroNameCrc, currValue);
 
     addBoolSetting(toReturn, allSettings.cbsInodeBlockCount);
@@ -547,6 +548,10 @@ void AllSettings::ParseHeaderToSettings(const QString &text,
         {
             allSettings.cmssCrc->SetValue("Slice by 8 - largest, fastest");
         }
+        else if(QString::compare(crcStrValue, crcClmul) == 0)
+        {
+            allSettings.cmssCrc->SetValue("Carry-less multiply - x86-64 hardware, slice by 8 fallback");
+        }
         else
         {
             notParsed += macroNameCrc;
@@ -907,6 +912,7 @@ const QString cstdStringH = "<string.h>";
 const QString crcBitwise = "CRC_BITWISE";
 const QString crcSarwate = "CRC_SARWATE";
 const QString crcSlice = "CRC_SLICEBY8";
+const QString crcClmul = "CRC_CLMUL";
 
 // Extern global allSettings instance
 AllSettings allSettings;
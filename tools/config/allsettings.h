@@ -262,6 +262,7 @@ extern const QString cstdStringH;
 extern const QString crcBitwise;
 extern const QString crcSarwate;
 extern const QString crcSlice;
+extern const QString crcClmul;
 
 ///
 /// \brief  Global ::AllSettings object.
@@ -163,6 +163,7 @@ ConfigWindow::ConfigWindow(QWidget *parent) :
                                         ui->cbEnableRetries,
                                         ui->sbBlockIoRetries,
                                         ui->widgetBlockIoRetries,
+                                        ui->sbBufferReserve,
                                         ui->btnAddVol,
                                         ui->btnRemoveCurrVol,
                                         ui->listVolumes,
@@ -174,7 +175,8 @@ ConfigWindow::ConfigWindow(QWidget *parent) :
                                         ui->wbtnInodeCount,
                                         ui->wbtnAtomicWrite,
                                         ui->wbtnDiscardsSupported,
-                                        ui->wbtnIoRetries);
+                                        ui->wbtnIoRetries,
+                                        ui->wbtnBufferReserve);
 
     wbtns.append(ui->wbtnAutomaticDiscards);
     wbtns.append(ui->wbtnFstrim);
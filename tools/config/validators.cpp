@@ -323,6 +323,38 @@ Validity validateVolIoRetries(unsigned long value, QString &msg)
     return Valid;
 }
 
+///
+/// \brief  Validator for a VolumeSettings::Volume::stBufferReserve.
+///
+///         The single volume warning is skipped if ::volumeSettings is not
+///         initialized. Requires that ::allSettings be initialized.
+///
+Validity validateVolBufferReserve(unsigned long value, QString &msg)
+{
+    Q_ASSERT(allSettings.sbsAllocatedBuffers != NULL);
+
+    if(value > 65535)
+    {
+        msg = "No more than 65535 buffers can be reserved.";
+        return Invalid;
+    }
+
+    if(value > allSettings.sbsAllocatedBuffers->GetValue())
+    {
+        msg = "Cannot reserve more buffers than are allocated.";
+        return Invalid;
+    }
+
+    if((value != 0) && (volumeSettings != NULL)
+        && (volumeSettings->GetVolumes()->count() < 2))
+    {
+        msg = "Reserved buffers have no effect unless there is more than one volume.";
+        return Warning;
+    }
+
+    return Valid;
+}
+
 ///
 /// \brief  Validator for the number of volumes added in the <i>Volumes</i> tab
 ///
@@ -689,14 +721,16 @@ Validity validateCrc(QString value, QString &msg)
 {
     if(QString::compare(value, crcBitwise) == 0
             || QString::compare(value, crcSarwate) == 0
-            || QString::compare(value, crcSlice) == 0)
+            || QString::compare(value, crcSlice) == 0
+            || QString::compare(value, crcClmul) == 0)
     {
         //Actual values
         return Valid;
     }
     else if(value.startsWith("bitwise", Qt::CaseInsensitive)
             || value.startsWith("sarwate", Qt::CaseInsensitive)
-            || value.startsWith("slice by 8", Qt::CaseInsensitive))
+            || value.startsWith("slice by 8", Qt::CaseInsensitive)
+            || value.startsWith("carry-less", Qt::CaseInsensitive))
     {
         //UI values
         return Valid;
@@ -704,7 +738,7 @@ Validity validateCrc(QString value, QString &msg)
     else
     {
         Q_ASSERT(false); // The associated QComboBox should not allow this.
-        msg = "CRC must be one of CRC_BITWISE, CRC_SARWATE, or CRC_SLICEBY8.";
+        msg = "CRC must be one of CRC_BITWISE, CRC_SARWATE, CRC_SLICEBY8, or CRC_CLMUL.";
         return Invalid;
     }
 }
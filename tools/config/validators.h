@@ -51,6 +51,7 @@ Validity validateHandleCount(unsigned long value, QString &msg);
 
 Validity validateBlockSize(unsigned long value, QString &msg);
 Validity validateVolIoRetries(unsigned long value, QString &msg);
+Validity validateVolBufferReserve(unsigned long value, QString &msg);
 Validity validateVolumeCount(unsigned long value, QString &msg);
 
 Validity validateVolName(QString value, QString &msg);
@@ -39,7 +39,8 @@ VolumeSettings::Volume::Volume(QString name,
                                WarningBtn *wbtnInodeCount,
                                WarningBtn *wbtnAtomicWrite,
                                WarningBtn *wbtnDiscardSupport,
-                               WarningBtn *wbtnBlockIoRetries)
+                               WarningBtn *wbtnBlockIoRetries,
+                               WarningBtn *wbtnBufferReserve)
     : stName("", name, validateVolName, wbtnPathPrefix),
       stSectorSize("", 512, validateVolSectorSize, wbtnSectorSize),
       stSectorCount("", 1024, validateVolSectorCount, wbtnVolSize),
@@ -47,7 +48,8 @@ VolumeSettings::Volume::Volume(QString name,
       stAtomicWrite("", gpszUnsupported, validateSupportedUnsupported, wbtnAtomicWrite),
       stDiscardSupport("", gpszUnsupported, validateDiscardSupport, wbtnDiscardSupport),
       stInodeCount("", 100, validateVolInodeCount, wbtnInodeCount),
-      stBlockIoRetries("", 0, validateVolIoRetries, wbtnBlockIoRetries)
+      stBlockIoRetries("", 0, validateVolIoRetries, wbtnBlockIoRetries),
+      stBufferReserve("", 0, validateVolBufferReserve, wbtnBufferReserve)
 {
     Q_ASSERT(allSettings.sbsAllocatedBuffers != NULL);
     stSectorCount.notifyList.append(allSettings.sbsAllocatedBuffers);
@@ -99,6 +101,11 @@ IntSetting *VolumeSettings::Volume::GetStBlockIoRetries()
     return &stBlockIoRetries;
 }
 
+IntSetting *VolumeSettings::Volume::GetStBufferReserve()
+{
+    return &stBufferReserve;
+}
+
 bool VolumeSettings::Volume::NeedsExternalImap()
 {
     // Formulas taken from RedCoreInit
@@ -243,6 +250,7 @@ VolumeSettings::VolumeSettings(QLineEdit *pathPrefixBox,
                                QCheckBox *enableRetriesCheck,
                                QSpinBox *numRetriesBox,
                                QWidget *numRetriesWidget,
+                               QSpinBox *bufferReserveBox,
                                QPushButton *addButton,
                                QPushButton *removeButton,
                                QListWidget *volumesList,
@@ -254,7 +262,8 @@ VolumeSettings::VolumeSettings(QLineEdit *pathPrefixBox,
                                WarningBtn *inodeCountWarn,
                                WarningBtn *atomicWriteWarn,
                                WarningBtn *discardSupportWarn,
-                               WarningBtn *ioRetriesWarn)
+                               WarningBtn *ioRetriesWarn,
+                               WarningBtn *bufferReserveWarn)
     : stVolumeCount(macroNameVolumeCount, 1, validateVolumeCount),
       volTick(0),
       lePathPrefix(pathPrefixBox),
@@ -272,6 +281,7 @@ VolumeSettings::VolumeSettings(QLineEdit *pathPrefixBox,
       cbEnableRetries(enableRetriesCheck),
       sbNumRetries(numRetriesBox),
       widgetNumRetries(numRetriesWidget),
+      sbBufferReserve(bufferReserveBox),
       btnAdd(addButton),
       btnRemSelected(removeButton),
       listVolumes(volumesList),
@@ -283,7 +293,8 @@ VolumeSettings::VolumeSettings(QLineEdit *pathPrefixBox,
       wbtnSectorSize(sectorSizeWarn),
       wbtnAtomicWrite(atomicWriteWarn),
       wbtnDiscardSupport(discardSupportWarn),
-      wbtnIoRetries(ioRetriesWarn)
+      wbtnIoRetries(ioRetriesWarn),
+      wbtnBufferReserve(bufferReserveWarn)
 {
     Q_ASSERT(allSettings.rbtnsUsePosix != NULL);
     usePosix = allSettings.rbtnsUsePosix->GetValue();
@@ -315,6 +326,8 @@ VolumeSettings::VolumeSettings(QLineEdit *pathPrefixBox,
             this, SLOT(cbEnableRetries_stateChanged(int)));
     connect(sbNumRetries, SIGNAL(valueChanged(QString)),
             this, SLOT(sbNumRetries_valueChanged(QString)));
+    connect(sbBufferReserve, SIGNAL(valueChanged(QString)),
+            this, SLOT(sbBufferReserve_valueChanged(QString)));
     connect(listVolumes, SIGNAL(currentRowChanged(int)),
             this, SLOT(listVolumes_currentRowChanged(int)));
     connect(btnAdd, SIGNAL(clicked()),
@@ -387,6 +400,7 @@ void VolumeSettings::SetActiveVolume(int index)
     allSettings.cmisBlockSize->notifyList.append(volumes[index]->GetStInodeCount());
     allSettings.rbtnsUsePosix->notifyList.append(volumes[index]->GetStInodeCount());
     allSettings.rbtnsUsePosix->notifyList.append(volumes[index]->GetStName());
+    allSettings.sbsAllocatedBuffers->notifyList.append(volumes[index]->GetStBufferReserve());
 
     // Update the UI fields to reflect the new active volume.
     //
@@ -464,6 +478,8 @@ void VolumeSettings::SetActiveVolume(int index)
         sbNumRetries->setValue(ioRetriesValue);
     }
 
+    sbBufferReserve->setValue(volumes[index]->GetStBufferReserve()->GetValue());
+
     listVolumes->setCurrentRow(index);
 }
 
@@ -473,7 +489,7 @@ void VolumeSettings::AddVolume()
 
     volumes.append(new Volume(name, wbtnPathPrefix, wbtnSectorSize, wbtnVolSize, wbtnVolOff,
                               wbtnInodeCount, wbtnAtomicWrite, wbtnDiscardSupport,
-                              wbtnIoRetries));
+                              wbtnIoRetries, wbtnBufferReserve));
     volTick++;
 
     if(!usePosix)
@@ -534,6 +550,7 @@ void VolumeSettings::GetErrors(QStringList &errors, QStringList &warnings)
         AllSettings::CheckError(volumes[i]->GetStAtomicWrite(), errors, warnings);
         AllSettings::CheckError(volumes[i]->GetStDiscardSupport(), errors, warnings);
         AllSettings::CheckError(volumes[i]->GetStBlockIoRetries(), errors, warnings);
+        AllSettings::CheckError(volumes[i]->GetStBufferReserve(), errors, warnings);
     }
     if(activeIndex != rememberIndex)
     {
@@ -549,6 +566,7 @@ void VolumeSettings::GetErrors(QStringList &errors, QStringList &warnings)
         volumes[activeIndex]->GetStAtomicWrite()->Notify();
         volumes[activeIndex]->GetStDiscardSupport()->Notify();
         volumes[activeIndex]->GetStBlockIoRetries()->Notify();
+        volumes[activeIndex]->GetStBufferReserve()->Notify();
     }
 }
 
@@ -678,6 +696,10 @@ const VOLCONF gaRedVolConf[REDCONF_VOLUME_COUNT] =\n\
                     + QString("\"");
         }
 
+        toReturn += QString(", ")
+                + QString::number(volumes[i]->GetStBufferReserve()->GetValue())
+                + QString("U");
+
         if(i == volumes.count() - 1)
         {
             toReturn += QString(" }\n");
@@ -735,13 +757,34 @@ void VolumeSettings::ParseCodefile(const QString &text,
         QString currStr = rem.captured(1);
         currPos = rem.capturedEnd(0);
 
+        QString pathPrefix;
+
+        // The path prefix is the only quoted value. It is followed by the
+        // buffer reservation, so take it out of currStr before looking for
+        // the other values.
+        rem = pathPrefixEpx.match(currStr);
+        if(!rem.hasMatch() || rem.lastCapturedIndex() < 2)
+        {
+            // It's normal for this to be missing if the file
+            // was not exported in POSIX mode. Use a default
+            // name if not found.
+            pathPrefix = QString("VOL")
+                    + QString::number(currVolIndex)
+                    + QString(":");
+        }
+        else
+        {
+            pathPrefix = rem.captured(2);
+            currStr.remove(rem.capturedStart(0), rem.capturedLength(0));
+        }
+
         // The position in currStr to start looking for the next value
         int currVolPos = 0;
 
         // List of unparsed values of the settings of the current volume
         QStringList strValues;
 
-        for(int i = 0; i < 7; i++)
+        for(int i = 0; i < 8; i++)
         {
             rem = valueExp.match(currStr, currVolPos);
             if(!rem.hasMatch() || rem.lastCapturedIndex() < 2)
@@ -762,23 +805,6 @@ void VolumeSettings::ParseCodefile(const QString &text,
             break;
         }
 
-        QString pathPrefix;
-
-        rem = pathPrefixEpx.match(currStr, currVolPos);
-        if(!rem.hasMatch() || rem.lastCapturedIndex() < 2)
-        {
-            // It's normal for this to be missing if the file
-            // was not exported in POSIX mode. Use a default
-            // name if not found.
-            pathPrefix = QString("VOL")
-                    + QString::number(currVolIndex)
-                    + QString(":");
-        }
-        else
-        {
-            pathPrefix = rem.captured(2);
-        }
-
         Volume * newVol = new Volume(pathPrefix,
                                      wbtnPathPrefix,
                                      wbtnSectorSize,
@@ -787,7 +813,8 @@ void VolumeSettings::ParseCodefile(const QString &text,
                                      wbtnInodeCount,
                                      wbtnAtomicWrite,
                                      wbtnDiscardSupport,
-                                     wbtnIoRetries);
+                                     wbtnIoRetries,
+                                     wbtnBufferReserve);
 
         if((QString::compare(strValues[0], "SECTOR_SIZE_AUTO") == 0) ||
             (QString::compare(strValues[0], "0U") == 0) ||
@@ -852,27 +879,36 @@ void VolumeSettings::ParseCodefile(const QString &text,
         }
 
         // The discard supported setting is set in Reliance Edge v1.1
-        // and above only if REDCONF_DISCARDS is enabled.
-        // For now, it's safe to check strValues.count(), but in the
-        // future we may need to check whether discards are globally
-        // supported before parsing per-volume.
-        if(strValues.count() > 6)
+        // and above only if REDCONF_DISCARDS is enabled. The buffer
+        // reservation, which comes after it, is never true or false, so
+        // the two can be told apart by value.
+        int reserveIndex = 6;
+
+        if((strValues.count() > 6)
+            && ((QString::compare(strValues[6], "true") == 0)
+                || (QString::compare(strValues[6], "false") == 0)))
         {
+            reserveIndex = 7;
+
             // Special case parse and set
             if(QString::compare(strValues[6], "true") == 0)
             {
                 newVol->GetStDiscardSupport()->SetValue(gpszSupported);
             }
-            else if(QString::compare(strValues[6], "false") == 0)
-            {
-                newVol->GetStDiscardSupport()->SetValue(gpszUnsupported);
-            }
             else
             {
-                notParsed += pathPrefix + QString(" discards supported");
+                newVol->GetStDiscardSupport()->SetValue(gpszUnsupported);
             }
         }
 
+        // Files from older versions have no buffer reservation; leave it at
+        // the default of 0.
+        if(strValues.count() > reserveIndex)
+        {
+            parseAndSet(newVol->GetStBufferReserve(), strValues[reserveIndex], notParsed,
+                    pathPrefix + QString(" reserved buffers"));
+        }
+
         newVolumes.append(newVol);
         currVolIndex++;
     }
@@ -985,6 +1021,8 @@ void VolumeSettings::deselectVolume(int index)
             .removeOne(volumes[index]->GetStInodeCount());
     allSettings.rbtnsUsePosix->notifyList
             .removeOne(volumes[index]->GetStName());
+    allSettings.sbsAllocatedBuffers->notifyList
+            .removeOne(volumes[index]->GetStBufferReserve());
 }
 
 // Helper function for ParseCodeFile
@@ -1248,6 +1286,22 @@ void VolumeSettings::sbNumRetries_valueChanged(const QString & text)
     }
 }
 
+void VolumeSettings::sbBufferReserve_valueChanged(const QString &value)
+{
+    // Asserts that the vol index is ok
+    if(!checkCurrentIndex()) return;
+
+    try
+    {
+        volumes[activeIndex]->GetStBufferReserve()->ProcessInput(value);
+    }
+    catch(...)
+    {
+        Q_ASSERT(false);
+        return;
+    }
+}
+
 void VolumeSettings::listVolumes_currentRowChanged(int row)
 {
     if(row < 0 || row == activeIndex)
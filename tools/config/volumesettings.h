@@ -70,7 +70,8 @@ public:
                WarningBtn *wbtnInodeCount,
                WarningBtn *wbtnAtomicWrite,
                WarningBtn *wbtnDiscardSupport,
-               WarningBtn *wbtnBlockIoRetries);
+               WarningBtn *wbtnBlockIoRetries,
+               WarningBtn *wbtnBufferReserve);
         StrSetting *GetStName();
         IntSetting *GetStSectorSize();
         IntSetting *GetStSectorCount();
@@ -79,6 +80,7 @@ public:
         StrSetting *GetStAtomicWrite();
         StrSetting *GetStDiscardSupport();
         IntSetting *GetStBlockIoRetries();
+        IntSetting *GetStBufferReserve();
         bool NeedsExternalImap();
         bool NeedsInternalImap();
         bool IsAutoSectorSize();
@@ -97,6 +99,7 @@ public:
         StrSetting stDiscardSupport;
         IntSetting stInodeCount;
         IntSetting stBlockIoRetries;
+        IntSetting stBufferReserve;
         bool fAutoSectorSize = true;
         bool fAutoSectorCount = true;
         bool fAutoInodeCount = true;
@@ -122,6 +125,7 @@ public:
                    QCheckBox *enableRetriesCheck,
                    QSpinBox *numRetriesBox,
                    QWidget *numRetriesWidget,
+                   QSpinBox *bufferReserveBox,
                    QPushButton *addButton,
                    QPushButton *removeButton,
                    QListWidget *volumesList,
@@ -133,7 +137,8 @@ public:
                    WarningBtn *inodeCountWarn,
                    WarningBtn *atomicWriteWarn,
                    WarningBtn *discardSupportWarn,
-                   WarningBtn *ioRetriesWarn);
+                   WarningBtn *ioRetriesWarn,
+                   WarningBtn *bufferReserveWarn);
     ~VolumeSettings();
 
     ///
@@ -286,6 +291,7 @@ private:
     QCheckBox *cbEnableRetries;
     QSpinBox *sbNumRetries;
     QWidget *widgetNumRetries;  // Enabled only when cbEnableRetries is checked.
+    QSpinBox *sbBufferReserve;
     QPushButton *btnAdd;
     QPushButton *btnRemSelected;
     QListWidget *listVolumes;
@@ -299,6 +305,7 @@ private:
     WarningBtn *wbtnAtomicWrite;
     WarningBtn *wbtnDiscardSupport;
     WarningBtn *wbtnIoRetries;
+    WarningBtn *wbtnBufferReserve;
 
 private slots:
     void lePathPrefix_textChanged(const QString &text);
@@ -313,6 +320,7 @@ private slots:
     void cmbDiscardSupport_currentIndexChanged(int index);
     void cbEnableRetries_stateChanged(int state);
     void sbNumRetries_valueChanged(const QString & text);
+    void sbBufferReserve_valueChanged(const QString &value);
     void listVolumes_currentRowChanged(int row);
     void btnAdd_clicked();
     void btnRemSelected_clicked();
@@ -28,6 +28,12 @@
 #include <redfs.h>
 
 
+static uint32_t BitFind(const uint8_t *pbBitmap1, const uint8_t *pbBitmap2, uint32_t ulStart, uint32_t ulEnd, bool fSet);
+static uint64_t BitLoad64(const uint8_t *pbBitmap, uint32_t ulByte, uint32_t ulEndByte);
+static uint32_t BitClz64(uint64_t ullValue);
+static uint32_t BitPopCount64(uint64_t ullValue);
+
+
 /** @brief Query the state of a bit in a bitmap.
 
     Bits are counted from most significant to least significant.  Thus, the mask
@@ -98,3 +104,355 @@ void RedBitClear(
         pbBitmap[ulBit >> 3U] &= ~(0x80U >> (ulBit & 7U));
     }
 }
+
+
+/** @brief Find the first bit in a range which is clear in one or two bitmaps.
+
+    Bits are counted from most significant to least significant, as with
+    RedBitGet().  The bitmaps are examined 64 bits at a time, so this is much
+    faster than calling RedBitGet() for each bit when most bits are set.
+
+    @param pbBitmap1    Pointer to the first bitmap.
+    @param pbBitmap2    Pointer to the second bitmap, which is ORed with the
+                        first; or NULL to examine only @p pbBitmap1.
+    @param ulStart      The first bit to examine.
+    @param ulEnd        The bit following the last bit to examine.  No bytes of
+                        the bitmaps beyond the one which contains bit
+                        @p ulEnd minus one are accessed.
+
+    @return The first bit in the range [@p ulStart, @p ulEnd) which is clear in
+            both bitmaps; or @p ulEnd if there is no such bit.
+*/
+uint32_t RedBitFindClear(
+    const uint8_t  *pbBitmap1,
+    const uint8_t  *pbBitmap2,
+    uint32_t        ulStart,
+    uint32_t        ulEnd)
+{
+    return BitFind(pbBitmap1, pbBitmap2, ulStart, ulEnd, false);
+}
+
+
+/** @brief Find the first bit in a range which is set in either of one or two
+           bitmaps.
+
+    This is the counterpart of RedBitFindClear(), and likewise examines the
+    bitmaps 64 bits at a time.
+
+    @param pbBitmap1    Pointer to the first bitmap.
+    @param pbBitmap2    Pointer to the second bitmap, which is ORed with the
+                        first; or NULL to examine only @p pbBitmap1.
+    @param ulStart      The first bit to examine.
+    @param ulEnd        The bit following the last bit to examine.  No bytes of
+                        the bitmaps beyond the one which contains bit
+                        @p ulEnd minus one are accessed.
+
+    @return The first bit in the range [@p ulStart, @p ulEnd) which is set in
+            either bitmap; or @p ulEnd if there is no such bit.
+*/
+uint32_t RedBitFindSet(
+    const uint8_t  *pbBitmap1,
+    const uint8_t  *pbBitmap2,
+    uint32_t        ulStart,
+    uint32_t        ulEnd)
+{
+    return BitFind(pbBitmap1, pbBitmap2, ulStart, ulEnd, true);
+}
+
+
+/** @brief Set or clear a range of bits in a bitmap.
+
+    Bits are counted from most significant to least significant, as with
+    RedBitGet().  Whole bytes within the range are set or cleared at once.
+
+    @param pbBitmap Pointer to the bitmap.
+    @param ulStart  The first bit to set or clear.
+    @param ulEnd    The bit following the last bit to set or clear.
+    @param fSet     Whether to set the bits (true) or clear them (false).
+*/
+void RedBitRangeSet(
+    uint8_t    *pbBitmap,
+    uint32_t    ulStart,
+    uint32_t    ulEnd,
+    bool        fSet)
+{
+    if((pbBitmap == NULL) || (ulStart > ulEnd))
+    {
+        REDERROR();
+    }
+    else if(ulStart < ulEnd)
+    {
+        uint32_t    ulStartByte = ulStart >> 3U;
+        uint32_t    ulLastByte = (ulEnd - 1U) >> 3U;
+        uint8_t     bStartMask = (uint8_t)(0xFFU >> (ulStart & 7U));
+        uint8_t     bLastMask = (uint8_t)(0xFFU << (7U - ((ulEnd - 1U) & 7U)));
+
+        if(ulStartByte == ulLastByte)
+        {
+            bStartMask &= bLastMask;
+        }
+
+        if(fSet)
+        {
+            pbBitmap[ulStartByte] |= bStartMask;
+        }
+        else
+        {
+            pbBitmap[ulStartByte] &= (uint8_t)~bStartMask;
+        }
+
+        if(ulLastByte > ulStartByte)
+        {
+            RedMemSet(&pbBitmap[ulStartByte + 1U], fSet ? UINT8_MAX : 0U, ulLastByte - (ulStartByte + 1U));
+
+            if(fSet)
+            {
+                pbBitmap[ulLastByte] |= bLastMask;
+            }
+            else
+            {
+                pbBitmap[ulLastByte] &= (uint8_t)~bLastMask;
+            }
+        }
+    }
+    else
+    {
+        /*  Empty range, nothing to do.
+        */
+    }
+}
+
+
+/** @brief Count the bits in a range of a bitmap which are set.
+
+    @param pbBitmap Pointer to the bitmap.
+    @param ulStart  The first bit to examine.
+    @param ulEnd    The bit following the last bit to examine.  No bytes of the
+                    bitmap beyond the one which contains bit @p ulEnd minus one
+                    are accessed.
+
+    @return The number of bits in the range [@p ulStart, @p ulEnd) which are
+            set.
+*/
+uint32_t RedBitCount(
+    const uint8_t  *pbBitmap,
+    uint32_t        ulStart,
+    uint32_t        ulEnd)
+{
+    uint32_t        ulCount = 0U;
+
+    if((pbBitmap == NULL) || (ulStart > ulEnd))
+    {
+        REDERROR();
+    }
+    else
+    {
+        uint32_t ulEndByte = (ulEnd + 7U) >> 3U;
+        uint32_t ulWordBit = ulStart & ~63U;
+
+        while(ulWordBit < ulEnd)
+        {
+            uint64_t ullBits = BitLoad64(pbBitmap, ulWordBit >> 3U, ulEndByte);
+
+            if(ulWordBit < ulStart)
+            {
+                ullBits &= UINT64_MAX >> (ulStart - ulWordBit);
+            }
+
+            if((ulEnd - ulWordBit) < 64U)
+            {
+                ullBits &= ~(UINT64_MAX >> (ulEnd - ulWordBit));
+            }
+
+            ulCount += BitPopCount64(ullBits);
+            ulWordBit += 64U;
+        }
+    }
+
+    return ulCount;
+}
+
+
+/** @brief Find the first bit in a range of one or two ORed bitmaps which has
+           the given value.
+
+    @param pbBitmap1    Pointer to the first bitmap.
+    @param pbBitmap2    Pointer to the second bitmap, or NULL.
+    @param ulStart      The first bit to examine.
+    @param ulEnd        The bit following the last bit to examine.
+    @param fSet         Whether to find a set bit (true) or a clear bit (false).
+
+    @return The first bit in the range [@p ulStart, @p ulEnd) with the value
+            @p fSet; or @p ulEnd if there is no such bit.
+*/
+static uint32_t BitFind(
+    const uint8_t  *pbBitmap1,
+    const uint8_t  *pbBitmap2,
+    uint32_t        ulStart,
+    uint32_t        ulEnd,
+    bool            fSet)
+{
+    uint32_t        ulFound = ulEnd;
+
+    if((pbBitmap1 == NULL) || (ulStart > ulEnd))
+    {
+        REDERROR();
+    }
+    else
+    {
+        uint32_t ulEndByte = (ulEnd + 7U) >> 3U;
+        uint32_t ulWordBit = ulStart & ~63U;
+
+        while(ulWordBit < ulEnd)
+        {
+            uint64_t ullMatch = BitLoad64(pbBitmap1, ulWordBit >> 3U, ulEndByte);
+
+            if(pbBitmap2 != NULL)
+            {
+                ullMatch |= BitLoad64(pbBitmap2, ulWordBit >> 3U, ulEndByte);
+            }
+
+            if(!fSet)
+            {
+                ullMatch = ~ullMatch;
+            }
+
+            /*  Ignore the bits outside of the range.
+            */
+            if(ulWordBit < ulStart)
+            {
+                ullMatch &= UINT64_MAX >> (ulStart - ulWordBit);
+            }
+
+            if((ulEnd - ulWordBit) < 64U)
+            {
+                ullMatch &= ~(UINT64_MAX >> (ulEnd - ulWordBit));
+            }
+
+            if(ullMatch != 0U)
+            {
+                ulFound = ulWordBit + BitClz64(ullMatch);
+                break;
+            }
+
+            ulWordBit += 64U;
+        }
+    }
+
+    return ulFound;
+}
+
+
+/** @brief Load 64 bits of a bitmap, such that the first bit is the most
+           significant bit of the result.
+
+    @param pbBitmap     Pointer to the bitmap.
+    @param ulByte       The byte offset to load from.
+    @param ulEndByte    The number of bytes in the bitmap which may be
+                        accessed.  Bytes beyond this are loaded as 0xFF.
+
+    @return The 64 bits at @p ulByte.
+*/
+static uint64_t BitLoad64(
+    const uint8_t  *pbBitmap,
+    uint32_t        ulByte,
+    uint32_t        ulEndByte)
+{
+    uint64_t        ullValue = 0U;
+    uint32_t        ulIdx;
+
+    if((ulEndByte - ulByte) >= 8U)
+    {
+        /*  Compilers recognize this as a big-endian load.
+        */
+        ullValue = ((uint64_t)pbBitmap[ulByte] << 56U)
+                 | ((uint64_t)pbBitmap[ulByte + 1U] << 48U)
+                 | ((uint64_t)pbBitmap[ulByte + 2U] << 40U)
+                 | ((uint64_t)pbBitmap[ulByte + 3U] << 32U)
+                 | ((uint64_t)pbBitmap[ulByte + 4U] << 24U)
+                 | ((uint64_t)pbBitmap[ulByte + 5U] << 16U)
+                 | ((uint64_t)pbBitmap[ulByte + 6U] << 8U)
+                 | (uint64_t)pbBitmap[ulByte + 7U];
+    }
+    else
+    {
+        for(ulIdx = 0U; ulIdx < 8U; ulIdx++)
+        {
+            ullValue <<= 8U;
+            ullValue |= ((ulByte + ulIdx) < ulEndByte) ? pbBitmap[ulByte + ulIdx] : UINT8_MAX;
+        }
+    }
+
+    return ullValue;
+}
+
+
+/** @brief Count the leading zero bits in a 64-bit value.
+
+    @param ullValue The value to examine.  Must be nonzero.
+
+    @return The number of zero bits above the most significant set bit.
+*/
+static uint32_t BitClz64(
+    uint64_t    ullValue)
+{
+    uint32_t    ulCount;
+
+    REDASSERT(ullValue != 0U);
+
+  #if defined(__GNUC__)
+    ulCount = (uint32_t)__builtin_clzll(ullValue);
+  #else
+    {
+        uint64_t ullRemaining = ullValue;
+        uint32_t ulShift = 32U;
+
+        ulCount = 0U;
+
+        /*  Binary search for the most significant set bit.
+        */
+        while(ulShift > 0U)
+        {
+            if((ullRemaining >> (64U - ulShift)) == 0U)
+            {
+                ulCount += ulShift;
+                ullRemaining <<= ulShift;
+            }
+
+            ulShift >>= 1U;
+        }
+    }
+  #endif
+
+    return ulCount;
+}
+
+
+/** @brief Count the set bits in a 64-bit value.
+
+    @param ullValue The value to examine.
+
+    @return The number of bits in @p ullValue which are set.
+*/
+static uint32_t BitPopCount64(
+    uint64_t    ullValue)
+{
+    uint32_t    ulCount;
+
+  #if defined(__GNUC__)
+    ulCount = (uint32_t)__builtin_popcountll(ullValue);
+  #else
+    {
+        uint64_t ullBits = ullValue;
+
+        /*  Sum adjacent bits, then pairs, then nibbles, then add up the bytes.
+        */
+        ullBits = ullBits - ((ullBits >> 1U) & 0x5555555555555555U);
+        ullBits = (ullBits & 0x3333333333333333U) + ((ullBits >> 2U) & 0x3333333333333333U);
+        ullBits = (ullBits + (ullBits >> 4U)) & 0x0F0F0F0F0F0F0F0FU;
+        ulCount = (uint32_t)((ullBits * 0x0101010101010101U) >> 56U);
+    }
+  #endif
+
+    return ulCount;
+}
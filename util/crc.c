@@ -39,9 +39,28 @@
 #define CRC_BITWISE     (0U)
 #define CRC_SARWATE     (1U)
 #define CRC_SLICEBY8    (2U)
+#define CRC_CLMUL       (3U)
 
 
-#if REDCONF_CRC_ALGORITHM == CRC_BITWISE
+/*  CRC_CLMUL folds the data with the x86-64 PCLMULQDQ (carry-less multiply)
+    instruction, if the CPU supports it, and otherwise uses the slice-by-8
+    algorithm.  The choice is made at run time using CPUID.  For other
+    processors and compilers, CRC_CLMUL is the same as CRC_SLICEBY8.
+*/
+#if (REDCONF_CRC_ALGORITHM == CRC_CLMUL) && ((defined(__GNUC__) && defined(__x86_64__)) || defined(_M_X64))
+  #define CLMUL_SUPPORTED 1
+  #if defined(__GNUC__)
+    #include <cpuid.h>
+    #define CLMUL_TARGET __attribute__((target("pclmul")))
+  #else
+    #include <intrin.h>
+    #define CLMUL_TARGET
+  #endif
+  #include <wmmintrin.h>
+#else
+  #define CLMUL_SUPPORTED 0
+#endif
+
 
 /*  The following is representative of the polynomial accepted by CCITT 32-bit
     and in IEEE 802.3, Ethernet 2 specification.
@@ -54,6 +73,12 @@
 #define CCITT_32_POLYNOMIAL (0xEDB88320U)
 
 
+static uint32_t Crc32MultModP(uint32_t ulA, uint32_t ulB);
+
+
+#if REDCONF_CRC_ALGORITHM == CRC_BITWISE
+
+
 /** @brief Compute a CRC32 for the given data buffer.
 
     For CCITT-32 compliance, the initial CRC must be set to 0.  To CRC multiple
@@ -183,13 +208,11 @@ uint32_t RedCrc32Update(
     return ulCrc32;
 }
 
-#elif REDCONF_CRC_ALGORITHM == CRC_SLICEBY8
-
+#elif (REDCONF_CRC_ALGORITHM == CRC_SLICEBY8) || (REDCONF_CRC_ALGORITHM == CRC_CLMUL)
 
-/** @brief Compute a CRC32 for the given data buffer.
 
-    For CCITT-32 compliance, the initial CRC must be set to 0.  To CRC multiple
-    buffers, call this function with the previously returned CRC value.
+/** @brief Compute a CRC32 for the given data buffer with the slice-by-8
+           algorithm.
 
     @param ulInitCrc32  Starting CRC value.
     @param pBuffer      Data buffer to calculate the CRC from.
@@ -197,7 +220,7 @@ uint32_t RedCrc32Update(
 
     @return The updated CRC value.
 */
-uint32_t RedCrc32Update(
+static uint32_t Crc32SliceBy8(
     uint32_t    ulInitCrc32,
     const void *pBuffer,
     uint32_t    ulLength)
@@ -564,13 +587,335 @@ uint32_t RedCrc32Update(
     return ulCrc32;
 }
 
+
+#if CLMUL_SUPPORTED == 1
+
+/*  The buffer is folded 64 bytes at a time, so shorter buffers are left to the
+    slice-by-8 algorithm.
+*/
+#define CLMUL_MIN_LENGTH    64U
+
+/*  CPUID leaf 1, ECX bit 1: PCLMULQDQ instruction supported.
+*/
+#define CPUID1_ECX_PCLMULQDQ 0x00000002U
+
+/*  Run-time detection states for the PCLMULQDQ instruction.
+*/
+#define CLMUL_UNKNOWN       0U
+#define CLMUL_PRESENT       1U
+#define CLMUL_ABSENT        2U
+
+
+/** @brief Determine whether the CPU supports the PCLMULQDQ instruction.
+
+    The CPUID instruction is slow (especially in a virtual machine), so it is
+    only executed the first time; the result is remembered.  If two tasks race
+    to check, both arrive at (and store) the same answer.
+
+    @return Whether the PCLMULQDQ instruction may be used.
+*/
+static bool Crc32ClmulPresent(void)
+{
+    static uint8_t  bClmul = CLMUL_UNKNOWN;
+
+    if(bClmul == CLMUL_UNKNOWN)
+    {
+        uint32_t    ulEcx;
+
+      #if defined(__GNUC__)
+        unsigned    uEax;
+        unsigned    uEbx;
+        unsigned    uEcx;
+        unsigned    uEdx;
+
+        ulEcx = (__get_cpuid(1U, &uEax, &uEbx, &uEcx, &uEdx) != 0) ? (uint32_t)uEcx : 0U;
+      #else
+        int         aiCpuInfo[4U];
+
+        __cpuid(aiCpuInfo, 1);
+        ulEcx = (uint32_t)aiCpuInfo[2U];
+      #endif
+
+        bClmul = ((ulEcx & CPUID1_ECX_PCLMULQDQ) != 0U) ? CLMUL_PRESENT : CLMUL_ABSENT;
+    }
+
+    return bClmul == CLMUL_PRESENT;
+}
+
+
+/** @brief Fold a buffer into a CRC32 using carry-less multiplication.
+
+    This is the algorithm from Intel's white paper "Fast CRC Computation for
+    Generic Polynomials Using PCLMULQDQ Instruction", for the bit-reflected
+    0xEDB88320 polynomial.  Four 128-bit accumulators are folded forward 64
+    bytes at a time, then folded into one, then reduced to 32 bits with a
+    Barrett reduction.  The folding constants are x^(4*128+32) mod P,
+    x^(4*128-32) mod P, x^(128+32) mod P, x^(128-32) mod P, and x^64 mod P,
+    each bit-reflected; the last pair is P itself and floor(x^64 / P).
+
+    Unlike RedCrc32Update(), the CRC value is neither inverted on entry nor on
+    return.
+
+    @param ulCrc32  The current (uninverted) CRC value.
+    @param pbBuffer Data buffer to calculate the CRC from.
+    @param ulLength Number of bytes of data in the given buffer.  Must be a
+                    multiple of 16 and at least #CLMUL_MIN_LENGTH.
+
+    @return The updated (uninverted) CRC value.
+*/
+CLMUL_TARGET
+static uint32_t Crc32Clmul(
+    uint32_t        ulCrc32,
+    const uint8_t  *pbBuffer,
+    uint32_t        ulLength)
+{
+    const __m128i   xK1K2 = _mm_set_epi64x(0x01C6E41596LL, 0x0154442BD4LL);
+    const __m128i   xK3K4 = _mm_set_epi64x(0x00CCAA009ELL, 0x01751997D0LL);
+    const __m128i   xK5 = _mm_set_epi64x(0LL, 0x0163CD6124LL);
+    const __m128i   xPolyMu = _mm_set_epi64x(0x01F7011641LL, 0x01DB710641LL);
+    const __m128i   xMask32 = _mm_set_epi32(0, -1, 0, -1);
+    const uint8_t  *pbPos = pbBuffer;
+    uint32_t        ulRemaining = ulLength;
+    __m128i         x0;
+    __m128i         x1;
+    __m128i         x2;
+    __m128i         x3;
+    __m128i         x4;
+    __m128i         xTmp;
+
+    REDASSERT(((ulLength & 15U) == 0U) && (ulLength >= CLMUL_MIN_LENGTH));
+
+    x1 = _mm_loadu_si128((const __m128i *)(const void *)&pbPos[0U]);
+    x2 = _mm_loadu_si128((const __m128i *)(const void *)&pbPos[16U]);
+    x3 = _mm_loadu_si128((const __m128i *)(const void *)&pbPos[32U]);
+    x4 = _mm_loadu_si128((const __m128i *)(const void *)&pbPos[48U]);
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)ulCrc32));
+    pbPos = &pbPos[64U];
+    ulRemaining -= 64U;
+
+    /*  Fold the four accumulators forward over each 64 bytes.
+    */
+    while(ulRemaining >= 64U)
+    {
+        __m128i x5 = _mm_clmulepi64_si128(x1, xK1K2, 0x00);
+        __m128i x6 = _mm_clmulepi64_si128(x2, xK1K2, 0x00);
+        __m128i x7 = _mm_clmulepi64_si128(x3, xK1K2, 0x00);
+        __m128i x8 = _mm_clmulepi64_si128(x4, xK1K2, 0x00);
+
+        x1 = _mm_clmulepi64_si128(x1, xK1K2, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, xK1K2, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, xK1K2, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, xK1K2, 0x11);
+
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i *)(const void *)&pbPos[0U]));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i *)(const void *)&pbPos[16U]));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i *)(const void *)&pbPos[32U]));
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i *)(const void *)&pbPos[48U]));
+
+        pbPos = &pbPos[64U];
+        ulRemaining -= 64U;
+    }
+
+    /*  Fold the four accumulators into one.
+    */
+    xTmp = _mm_clmulepi64_si128(x1, xK3K4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, xK3K4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), xTmp);
+
+    xTmp = _mm_clmulepi64_si128(x1, xK3K4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, xK3K4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), xTmp);
+
+    xTmp = _mm_clmulepi64_si128(x1, xK3K4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, xK3K4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), xTmp);
+
+    /*  Fold in any remaining 16-byte blocks.
+    */
+    while(ulRemaining >= 16U)
+    {
+        xTmp = _mm_clmulepi64_si128(x1, xK3K4, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, xK3K4, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128((const __m128i *)(const void *)pbPos)), xTmp);
+
+        pbPos = &pbPos[16U];
+        ulRemaining -= 16U;
+    }
+
+    /*  Fold 128 bits down to 64.
+    */
+    x2 = _mm_clmulepi64_si128(x1, xK3K4, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, xMask32);
+    x1 = _mm_clmulepi64_si128(x1, xK5, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    /*  Barrett reduction to 32 bits.
+    */
+    x2 = _mm_and_si128(x1, xMask32);
+    x2 = _mm_clmulepi64_si128(x2, xPolyMu, 0x10);
+    x2 = _mm_and_si128(x2, xMask32);
+    x2 = _mm_clmulepi64_si128(x2, xPolyMu, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    x0 = _mm_srli_si128(x1, 4);
+
+    return (uint32_t)_mm_cvtsi128_si32(x0);
+}
+
+#endif /* CLMUL_SUPPORTED == 1 */
+
+
+/** @brief Compute a CRC32 for the given data buffer.
+
+    For CCITT-32 compliance, the initial CRC must be set to 0.  To CRC multiple
+    buffers, call this function with the previously returned CRC value.
+
+    @param ulInitCrc32  Starting CRC value.
+    @param pBuffer      Data buffer to calculate the CRC from.
+    @param ulLength     Number of bytes of data in the given buffer.
+
+    @return The updated CRC value.
+*/
+uint32_t RedCrc32Update(
+    uint32_t    ulInitCrc32,
+    const void *pBuffer,
+    uint32_t    ulLength)
+{
+    uint32_t    ulCrc32;
+
+  #if CLMUL_SUPPORTED == 1
+    if((pBuffer != NULL) && (ulLength >= CLMUL_MIN_LENGTH) && Crc32ClmulPresent())
+    {
+        const uint8_t  *pbBuffer = pBuffer;
+        uint32_t        ulFoldLen = ulLength & ~15U;
+
+        /*  The slice-by-8 code finishes off the last few bytes, if the length
+            is not a multiple of 16.  It inverts the CRC on entry and on
+            return, while Crc32Clmul() does neither, hence the inversions.
+        */
+        ulCrc32 = Crc32Clmul(~ulInitCrc32, pbBuffer, ulFoldLen);
+        ulCrc32 = Crc32SliceBy8(~ulCrc32, &pbBuffer[ulFoldLen], ulLength - ulFoldLen);
+    }
+    else
+  #endif
+    {
+        ulCrc32 = Crc32SliceBy8(ulInitCrc32, pBuffer, ulLength);
+    }
+
+    return ulCrc32;
+}
+
 #else
 
-#error "REDCONF_CRC_ALGORITHM must be set to CRC_BITWISE, CRC_SARWATE, or CRC_SLICEBY8"
+#error "REDCONF_CRC_ALGORITHM must be set to CRC_BITWISE, CRC_SARWATE, CRC_SLICEBY8, or CRC_CLMUL"
 
 #endif
 
 
+/** @brief Combine the CRC32s of two adjacent buffers.
+
+    Given the CRC of buffer A and the CRC of buffer B, this computes the CRC of
+    A followed by B, without looking at the data.  In particular, combining a
+    CRC with a zero @p ulCrc2 has the effect of shifting it @p ulLength2 bytes
+    toward the end of a longer buffer.  This is used to update the CRC of a
+    metadata node when only small parts of it have changed: since the CRC is
+    linear, the change in the node CRC is the change in the CRC of each
+    modified range, shifted by the number of bytes which follow the range.
+
+    @param ulCrc1       The CRC of the first buffer.
+    @param ulCrc2       The CRC of the second buffer.
+    @param ulLength2    The length, in bytes, of the second buffer.
+
+    @return The CRC of the two buffers concatenated.
+*/
+uint32_t RedCrc32Combine(
+    uint32_t    ulCrc1,
+    uint32_t    ulCrc2,
+    uint32_t    ulLength2)
+{
+    /*  x^(2^n) modulo the polynomial, for n = 0 through 31, bit-reflected.
+    */
+    static const uint32_t aulX2N[32U] =
+    {
+        0x40000000U, 0x20000000U, 0x08000000U, 0x00800000U,
+        0x00008000U, 0xEDB88320U, 0xB1E6B092U, 0xA06A2517U,
+        0xED627DAEU, 0x88D14467U, 0xD7BBFE6AU, 0xEC447F11U,
+        0x8E7EA170U, 0x6427800EU, 0x4D47BAE0U, 0x09FE548FU,
+        0x83852D0FU, 0x30362F1AU, 0x7B5A9CC3U, 0x31FEC169U,
+        0x9FEC022AU, 0x6C8DEDC4U, 0x15D6874DU, 0x5FDE7A4EU,
+        0xBAD90E37U, 0x2E4E5EEFU, 0x4EABA214U, 0xA8A472C0U,
+        0x429A969EU, 0x148D302AU, 0xC40BA6D0U, 0xC4E22C3CU,
+    };
+
+    uint32_t    ulCrc = ulCrc2;
+
+    /*  Shifting zero yields zero, so skip the work.
+    */
+    if(ulCrc1 != 0U)
+    {
+        uint32_t    ulX8N = 0x80000000U; /* x^0 */
+        uint32_t    ulRemaining = ulLength2;
+        uint32_t    ulPower = 3U; /* Each byte is x^8, or x^(2^3). */
+
+        /*  Compute x^(8 * ulLength2) by multiplying together the powers of two
+            which make it up.
+        */
+        while(ulRemaining != 0U)
+        {
+            if((ulRemaining & 1U) != 0U)
+            {
+                ulX8N = Crc32MultModP(aulX2N[ulPower & 31U], ulX8N);
+            }
+
+            ulRemaining >>= 1U;
+            ulPower++;
+        }
+
+        ulCrc ^= Crc32MultModP(ulX8N, ulCrc1);
+    }
+
+    return ulCrc;
+}
+
+
+/** @brief Multiply two polynomials modulo the CRC32 polynomial.
+
+    Both polynomials, and the result, are bit-reflected, like the CRC itself.
+
+    @param ulA  The first polynomial.
+    @param ulB  The second polynomial.
+
+    @return @p ulA times @p ulB modulo the polynomial.
+*/
+static uint32_t Crc32MultModP(
+    uint32_t    ulA,
+    uint32_t    ulB)
+{
+    uint32_t    ulBits = ulA;
+    uint32_t    ulProduct = 0U;
+    uint32_t    ulShifted = ulB;
+
+    /*  The most significant bit is x^0.  Stop as soon as there are no more
+        terms in @p ulA, which is quick for low powers of x.
+    */
+    while(ulBits != 0U)
+    {
+        if((ulBits & 0x80000000U) != 0U)
+        {
+            ulProduct ^= ulShifted;
+        }
+
+        ulBits <<= 1U;
+        ulShifted = ((ulShifted & 1U) != 0U) ? ((ulShifted >> 1U) ^ CCITT_32_POLYNOMIAL) : (ulShifted >> 1U);
+    }
+
+    return ulProduct;
+}
+
+
 /** @brief Compute a CRC32 for a metadata node buffer.
 
     @param pBuffer  The metadata node buffer for which to compute a CRC.  Must